@@ -0,0 +1,766 @@
+/**
+ * Benchmarks for the uVec library.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#include "bench.h"
+#include "uvec_concurrent.h"
+#include "uvec_incremental.h"
+#include "uvec_mapped.h"
+#include <stdlib.h>
+
+// Element types
+
+typedef struct Blob64 {
+    uint64_t key;
+    unsigned char pad[56];
+} Blob64;
+
+typedef struct Blob256 {
+    uint64_t key;
+    unsigned char pad[248];
+} Blob256;
+
+#define blob_equal(a, b) ((a).key == (b).key)
+#define blob_less(a, b) ((a).key < (b).key)
+
+UVEC_INIT_IDENTIFIABLE(uint32_t)
+UVEC_INIT_IDENTIFIABLE(uint64_t)
+UVEC_INIT_COMPARABLE(Blob64, blob_equal, blob_less)
+UVEC_INIT_COMPARABLE(Blob256, blob_equal, blob_less)
+
+#define BENCH_INIT_BACKENDS(T)                                                                      \
+    UVEC_INIT_CONCURRENT(T)                                                                         \
+    UVEC_INIT_INCREMENTAL(T)                                                                        \
+    UVEC_INIT_IO(T)                                                                                 \
+    UVEC_INIT_MAPPED(T)
+
+BENCH_INIT_BACKENDS(uint32_t)
+BENCH_INIT_BACKENDS(uint64_t)
+BENCH_INIT_BACKENDS(Blob64)
+BENCH_INIT_BACKENDS(Blob256)
+
+static inline uint32_t bench_item_uint32_t(uint64_t key) { return (uint32_t)key; }
+static inline uint64_t bench_item_uint64_t(uint64_t key) { return key; }
+static inline Blob64 bench_item_Blob64(uint64_t key) { Blob64 b = { .key = key }; return b; }
+static inline Blob256 bench_item_Blob256(uint64_t key) { Blob256 b = { .key = key }; return b; }
+
+#define bench_key_uint32_t(item) ((uint64_t)(item))
+#define bench_key_uint64_t(item) (item)
+#define bench_key_Blob64(item) ((item).key)
+#define bench_key_Blob256(item) ((item).key)
+
+// Operations suite
+
+/// Maximum number of operations per repetition for non-constant time operations.
+#define BENCH_BATCH 1024u
+
+/**
+ * Defines the operations suite for the specified type.
+ *
+ * Keys are even, so that odd keys can be used to search for missing elements.
+ * Operations that work on the whole vector (append_array, copy, sort...) count as one
+ * operation per repetition; push and pop are timed over the whole vector, while
+ * insert_at, remove_at and index_of_sorted are timed over a batch of calls.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define BENCH_DEF_OPS(T)                                                                            \
+                                                                                                    \
+static int bench_cmp_##T(void const *a, void const *b) {                                            \
+    uint64_t const ka = bench_key_##T(*(T const *)a);                                               \
+    uint64_t const kb = bench_key_##T(*(T const *)b);                                               \
+    return (ka > kb) - (ka < kb);                                                                   \
+}                                                                                                   \
+                                                                                                    \
+static T bench_copy_##T(T item) {                                                                   \
+    return item;                                                                                    \
+}                                                                                                   \
+                                                                                                    \
+static void bench_ops_##T(Bench *b, uint64_t count) {                                               \
+    if (!bench_fits(b, sizeof(T), count, 4)) return;                                                \
+                                                                                                    \
+    uvec_uint const n = (uvec_uint)count;                                                           \
+    uvec_uint const k = n < BENCH_BATCH ? n : BENCH_BATCH;                                          \
+    size_t const size = sizeof(T);                                                                  \
+    T const missing = bench_item_##T(1);                                                            \
+    uint64_t seed = 0x9E3779B97F4A7C15ULL ^ count;                                                  \
+    uint64_t acc = 0;                                                                               \
+    double t_sort = 0, t_qsort = 0;                                                                 \
+                                                                                                    \
+    UVec_##T *src = uvec_alloc(T), *v = uvec_alloc(T), *keys = uvec_alloc(T), *sorted = NULL;       \
+    if (!(src && v && keys)) goto end;                                                              \
+    if (uvec_reserve_capacity(T, src, n) || uvec_reserve_capacity(T, v, n + k) ||                   \
+        uvec_reserve_capacity(T, keys, k)) goto end;                                                \
+                                                                                                    \
+    for (uvec_uint i = 0; i < n; ++i) src->storage[i] = bench_item_##T(bench_rand(&seed) << 1u);    \
+    src->count = n;                                                                                 \
+    if (!(sorted = uvec_copy(T, src))) goto end;                                                    \
+    uvec_sort(T, sorted);                                                                           \
+    for (uvec_uint i = 0; i < k; ++i) keys->storage[i] = sorted->storage[bench_rand(&seed) % n];    \
+    keys->count = k;                                                                                \
+    uvec_append_array(T, v, src->storage, n);                                                       \
+                                                                                                    \
+    if (bench_enabled(b, "push")) {                                                                 \
+        bench_measure(b, "ops", "push", size, n, n, , {                                             \
+            UVec_##T p = uvec_init(T);                                                              \
+            for (uvec_uint i = 0; i < n; ++i) uvec_push(T, &p, src->storage[i]);                    \
+            acc += p.count;                                                                         \
+            uvec_deinit(p);                                                                         \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "pop")) {                                                                  \
+        bench_measure(b, "ops", "pop", size, n, n, v->count = n, {                                  \
+            for (uvec_uint i = 0; i < n; ++i) acc += bench_key_##T(uvec_pop(T, v));                 \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "insert_at")) {                                                            \
+        bench_measure(b, "ops", "insert_at", size, n, k, v->count = n, {                            \
+            for (uvec_uint i = 0; i < k; ++i) uvec_insert_at(T, v, n / 2, keys->storage[i]);        \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "remove_at")) {                                                            \
+        bench_measure(b, "ops", "remove_at", size, n, k, v->count = n, {                            \
+            for (uvec_uint i = 0; i < k; ++i) {                                                     \
+                acc += bench_key_##T(uvec_remove_at(T, v, v->count / 2));                           \
+            }                                                                                       \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "append_array")) {                                                         \
+        bench_measure(b, "ops", "append_array", size, n, 1, v->count = 0, {                         \
+            uvec_append_array(T, v, src->storage, n);                                               \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "copy")) {                                                                 \
+        bench_measure(b, "ops", "copy", size, n, 1, , {                                             \
+            UVec_##T *c = uvec_copy(T, src);                                                        \
+            acc += uvec_count(c);                                                                   \
+            uvec_free(T, c);                                                                        \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "deep_copy")) {                                                            \
+        bench_measure(b, "ops", "deep_copy", size, n, 1, , {                                        \
+            UVec_##T *c = uvec_deep_copy(T, src, bench_copy_##T);                                   \
+            acc += uvec_count(c);                                                                   \
+            uvec_free(T, c);                                                                        \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "index_of")) {                                                             \
+        bench_measure(b, "ops", "index_of", size, n, 1, , {                                         \
+            acc += uvec_index_of(T, src, missing);                                                  \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "index_of_sorted")) {                                                      \
+        bench_measure(b, "ops", "index_of_sorted", size, n, k, , {                                  \
+            for (uvec_uint i = 0; i < k; ++i) {                                                     \
+                acc += uvec_index_of_sorted(T, sorted, keys->storage[i]);                           \
+            }                                                                                       \
+        });                                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "reverse")) {                                                              \
+        v->count = n;                                                                               \
+        bench_measure(b, "ops", "reverse", size, n, 1, , uvec_reverse(T, v));                       \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "min")) {                                                                  \
+        bench_measure(b, "ops", "min", size, n, 1, , acc += uvec_index_of_min(T, src));             \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "max")) {                                                                  \
+        bench_measure(b, "ops", "max", size, n, 1, , acc += uvec_index_of_max(T, src));             \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "sort")) {                                                                 \
+        bench_measure(b, "ops", "sort", size, n, 1, {                                               \
+            memcpy(v->storage, src->storage, n * size);                                             \
+            v->count = n;                                                                           \
+        }, uvec_sort(T, v));                                                                        \
+        t_sort = (double)b->ns / (double)b->reps;                                                   \
+    }                                                                                               \
+                                                                                                    \
+    if (bench_enabled(b, "qsort")) {                                                                \
+        bench_measure(b, "ops", "qsort", size, n, 1, {                                              \
+            memcpy(v->storage, src->storage, n * size);                                             \
+            v->count = n;                                                                           \
+        }, uvec_qsort(T, v, bench_cmp_##T));                                                        \
+        t_qsort = (double)b->ns / (double)b->reps;                                                  \
+    }                                                                                               \
+                                                                                                    \
+    if (t_sort > 0 && t_qsort > 0) {                                                                \
+        fprintf(stderr, "sort vs qsort (elem_size %zu, count %llu): %.2fx\n",                       \
+                size, (unsigned long long)count, t_qsort / t_sort);                                 \
+    }                                                                                               \
+                                                                                                    \
+    bench_sink = acc;                                                                               \
+                                                                                                    \
+end:                                                                                                \
+    uvec_free(T, src);                                                                              \
+    uvec_free(T, v);                                                                                \
+    uvec_free(T, keys);                                                                             \
+    uvec_free(T, sorted);                                                                           \
+}
+
+BENCH_DEF_OPS(uint32_t)
+BENCH_DEF_OPS(uint64_t)
+BENCH_DEF_OPS(Blob64)
+BENCH_DEF_OPS(Blob256)
+
+// Sort suite
+
+/// Key type with counted comparisons, used to count comparisons and swaps of each sort.
+typedef uint64_t BenchKey;
+
+/// Number of comparisons performed by sorts of BenchKey vectors.
+static uint64_t bench_comparisons;
+
+#define bench_key_equal(a, b) ((a) == (b))
+#define bench_key_less(a, b) (++bench_comparisons, (a) < (b))
+
+UVEC_INIT_COMPARABLE(BenchKey, bench_key_equal, bench_key_less)
+
+static int bench_cmp_BenchKey(void const *a, void const *b) {
+    BenchKey const ka = *(BenchKey const *)a, kb = *(BenchKey const *)b;
+    ++bench_comparisons;
+    return (ka > kb) - (ka < kb);
+}
+
+/// Sort variants.
+static char const *const bench_sorts[] = { "sort", "qsort" };
+#define BENCH_SORTS (sizeof(bench_sorts) / sizeof(*bench_sorts))
+
+/// Input distributions.
+static char const *const bench_inputs[] = {
+    "random", "sorted", "reversed", "organ_pipe", "sawtooth", "few_unique", "all_equal",
+    "med3_killer"
+};
+#define BENCH_INPUTS (sizeof(bench_inputs) / sizeof(*bench_inputs))
+
+/// Sorts exceeding this many comparisons per n log2(n) are flagged as quadratic.
+#define BENCH_QUADRATIC_FACTOR 8u
+
+/// Minimum count for quadratic blowup detection.
+#define BENCH_QUADRATIC_MIN_COUNT 1024u
+
+/**
+ * Fills an array with keys drawn from the specified distribution.
+ *
+ * @param keys [uint64_t*] Array.
+ * @param n [uint64_t] Number of keys.
+ * @param input [unsigned] Distribution index.
+ * @param seed [uint64_t*] Generator state.
+ */
+static void bench_fill_input(uint64_t *keys, uint64_t n, unsigned input, uint64_t *seed) {
+    uint64_t const half = n / 2, period = n / 16 ? n / 16 : 1;
+
+    switch (input) {
+        case 0: for (uint64_t i = 0; i < n; ++i) keys[i] = bench_rand(seed); break;
+        case 1: for (uint64_t i = 0; i < n; ++i) keys[i] = i; break;
+        case 2: for (uint64_t i = 0; i < n; ++i) keys[i] = n - i; break;
+        case 3: for (uint64_t i = 0; i < n; ++i) keys[i] = i < half ? i : n - i; break;
+        case 4: for (uint64_t i = 0; i < n; ++i) keys[i] = i % period; break;
+        case 5: for (uint64_t i = 0; i < n; ++i) keys[i] = bench_rand(seed) % 16; break;
+        case 6: for (uint64_t i = 0; i < n; ++i) keys[i] = 42; break;
+        default:
+            // Musser's median-of-3 killer sequence.
+            for (uint64_t i = 1; i <= half; ++i) {
+                if (i % 2) {
+                    keys[i - 1] = i;
+                    keys[i] = half + i;
+                }
+                keys[half + i - 1] = 2 * i;
+            }
+            if (n % 2) keys[n - 1] = n;
+            break;
+    }
+}
+
+/**
+ * Returns the integer base 2 logarithm of the specified number.
+ *
+ * @param n [uint64_t] Number.
+ * @return [uint64_t] Logarithm, at least 1.
+ */
+static uint64_t bench_log2(uint64_t n) {
+    uint64_t log = 0;
+    while (n >>= 1u) ++log;
+    return log ? log : 1;
+}
+
+/**
+ * Defines the sort suite for the specified type.
+ *
+ * Comparisons and swaps are counted by sorting the same keys as BenchKey elements,
+ * which share the sorting algorithm but not the element size. Swaps are only
+ * available for uvec_sort. Once a variant is flagged as quadratic for an input,
+ * it is skipped for larger counts.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define BENCH_DEF_SORT(T)                                                                           \
+                                                                                                    \
+static void bench_sort_##T(Bench *b) {                                                              \
+    bool blowup[BENCH_SORTS][BENCH_INPUTS] = { { false } };                                         \
+    size_t const size = sizeof(T);                                                                  \
+                                                                                                    \
+    for (uint64_t count = b->min_count; count; count = bench_next_count(b, count)) {                \
+        if (!bench_fits(b, size + sizeof(BenchKey), count, 2)) break;                               \
+                                                                                                    \
+        uvec_uint const n = (uvec_uint)count;                                                       \
+        uint64_t seed = 0x9E3779B97F4A7C15ULL ^ count;                                              \
+        UVec_##T *src = uvec_alloc(T), *v = uvec_alloc(T);                                          \
+        UVec_BenchKey *keys = uvec_alloc(BenchKey), *kv = uvec_alloc(BenchKey);                     \
+                                                                                                    \
+        if (!(src && v && keys && kv) ||                                                            \
+            uvec_reserve_capacity(T, src, n) || uvec_reserve_capacity(T, v, n) ||                   \
+            uvec_reserve_capacity(BenchKey, keys, n) || uvec_reserve_capacity(BenchKey, kv, n)) {   \
+            goto next;                                                                              \
+        }                                                                                           \
+                                                                                                    \
+        for (unsigned in = 0; in < BENCH_INPUTS; ++in) {                                            \
+            if (!bench_in_list(b->inputs, bench_inputs[in])) continue;                              \
+                                                                                                    \
+            bench_fill_input(keys->storage, n, in, &seed);                                          \
+            for (uvec_uint i = 0; i < n; ++i) {                                                     \
+                src->storage[i] = bench_item_##T(keys->storage[i]);                                 \
+                keys->storage[i] = bench_key_##T(src->storage[i]);                                  \
+            }                                                                                       \
+            src->count = keys->count = n;                                                           \
+                                                                                                    \
+            for (unsigned s = 0; s < BENCH_SORTS; ++s) {                                            \
+                if (!bench_enabled(b, bench_sorts[s]) || blowup[s][in]) continue;                   \
+                                                                                                    \
+                memcpy(kv->storage, keys->storage, n * sizeof(BenchKey));                           \
+                kv->count = n;                                                                      \
+                bench_comparisons = bench_swaps = 0;                                                \
+                                                                                                    \
+                if (s == 0) {                                                                       \
+                    uvec_sort(BenchKey, kv);                                                        \
+                } else {                                                                            \
+                    uvec_qsort(BenchKey, kv, bench_cmp_BenchKey);                                   \
+                }                                                                                   \
+                                                                                                    \
+                BenchRow row = {                                                                    \
+                    .suite = "sort", .op = bench_sorts[s], .input = bench_inputs[in],               \
+                    .elem_size = size, .count = n, .ops = 1,                                        \
+                    .comparisons = bench_comparisons, .swaps = s == 0 ? bench_swaps : BENCH_NA      \
+                };                                                                                  \
+                                                                                                    \
+                if (n >= BENCH_QUADRATIC_MIN_COUNT &&                                               \
+                    row.comparisons / n / bench_log2(n) >= BENCH_QUADRATIC_FACTOR) {                \
+                    row.flags = "quadratic";                                                        \
+                    blowup[s][in] = true;                                                           \
+                }                                                                                   \
+                                                                                                    \
+                if (s == 0) {                                                                       \
+                    bench_run(b, {                                                                  \
+                        memcpy(v->storage, src->storage, n * size);                                 \
+                        v->count = n;                                                               \
+                    }, uvec_sort(T, v));                                                            \
+                } else {                                                                            \
+                    bench_run(b, {                                                                  \
+                        memcpy(v->storage, src->storage, n * size);                                 \
+                        v->count = n;                                                               \
+                    }, uvec_qsort(T, v, bench_cmp_##T));                                            \
+                }                                                                                   \
+                                                                                                    \
+                row.reps = b->reps;                                                                 \
+                row.ns = b->ns;                                                                     \
+                memcpy(row.counters, b->counters, sizeof(row.counters));                            \
+                bench_report(b, &row);                                                              \
+                                                                                                    \
+                if (blowup[s][in]) {                                                                \
+                    fprintf(stderr, "%s on %s input (elem_size %zu, count %llu) is quadratic, "     \
+                            "skipping larger counts\n", bench_sorts[s], bench_inputs[in], size,     \
+                            (unsigned long long)count);                                             \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+    next:                                                                                           \
+        uvec_free(T, src);                                                                          \
+        uvec_free(T, v);                                                                            \
+        uvec_free(BenchKey, keys);                                                                  \
+        uvec_free(BenchKey, kv);                                                                    \
+    }                                                                                               \
+}
+
+BENCH_DEF_SORT(uint32_t)
+BENCH_DEF_SORT(uint64_t)
+BENCH_DEF_SORT(Blob64)
+BENCH_DEF_SORT(Blob256)
+
+// Latency suite
+
+/// Growth backends.
+typedef enum BenchBackend {
+    BENCH_REALLOC,
+    BENCH_RESERVED,
+    BENCH_INCREMENTAL,
+    BENCH_CONCURRENT,
+    BENCH_MAPPED,
+    BENCH_BACKENDS
+} BenchBackend;
+
+static char const *const bench_backends[BENCH_BACKENDS] = {
+    "realloc", "reserved", "incremental", "concurrent", "mapped"
+};
+
+/// Operations of the latency suite.
+typedef enum BenchLatencyOp {
+    BENCH_PUSH,
+    BENCH_APPEND,
+    BENCH_INSERT_SORTED,
+    BENCH_LATENCY_OPS
+} BenchLatencyOp;
+
+static char const *const bench_latency_ops[BENCH_LATENCY_OPS] = {
+    "push", "append", "insert_sorted"
+};
+
+/// Number of elements appended by each append operation.
+#define BENCH_APPEND_CHUNK 16u
+
+/// Minimum number of samples per measurement, so that p99.99 is backed by ten samples.
+#define BENCH_LATENCY_SAMPLES 100000u
+
+/// Maximum count for insert_sorted, whose total cost is quadratic.
+#define BENCH_SORTED_MAX_COUNT 65536u
+
+/// Operations whose worst case exceeds the mean latency by this factor are flagged as spikes.
+#define BENCH_SPIKE_FACTOR 1000u
+
+/**
+ * Fills a vector by pushing or appending elements, timing each operation.
+ * The push and append expressions may refer to the index 'i' of the first element
+ * to insert and, for appends, to the number 'm' of elements to append.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param h [BenchHist*] Latency histogram.
+ * @param ret [uvec_ret] Variable receiving the result of the last operation.
+ * @param n [uvec_uint] Number of elements.
+ * @param op [BenchLatencyOp] Operation.
+ * @param push [expression] Push expression.
+ * @param append [expression] Append expression.
+ */
+#define bench_fill(b, h, ret, n, op, push, append) do {                                             \
+    uvec_uint const p_step = (op) == BENCH_APPEND ? BENCH_APPEND_CHUNK : 1;                         \
+    for (uvec_uint i = 0; i < (n) && !(ret); i += p_step) {                                         \
+        uvec_uint const m = (n) - i < p_step ? (n) - i : p_step;                                    \
+        if ((op) == BENCH_APPEND) bench_record(b, h, ret = (append));                               \
+        else bench_record(b, h, ret = (push));                                                      \
+        (void)m;                                                                                    \
+    }                                                                                               \
+} while (0)
+
+/**
+ * Defines the latency suite for the specified type.
+ *
+ * Each repetition fills an empty vector of the selected backend with 'count' elements,
+ * timing every operation; repetitions continue until enough samples have been collected.
+ * The ns_per_op column reports the mean latency, and rows whose worst case exceeds it
+ * by BENCH_SPIKE_FACTOR are flagged as spikes. insert_sorted is only available
+ * for UVec backends, up to BENCH_SORTED_MAX_COUNT elements.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define BENCH_DEF_LATENCY(T)                                                                        \
+                                                                                                    \
+static uvec_ret bench_fill_##T(Bench *b, BenchHist *h, T const *items, uvec_uint n,                 \
+                               unsigned backend, unsigned op) {                                     \
+    uvec_ret ret = UVEC_OK;                                                                         \
+                                                                                                    \
+    if (backend == BENCH_INCREMENTAL) {                                                             \
+        UVecIncremental_##T *iv = uvec_incremental_alloc(T);                                        \
+        if (!iv) return UVEC_ERR;                                                                   \
+        bench_fill(b, h, ret, n, op, uvec_incremental_push(T, iv, items[i]),                        \
+                   uvec_incremental_append_array(T, iv, items + i, m));                             \
+        uvec_incremental_free(T, iv);                                                               \
+    } else if (backend == BENCH_CONCURRENT) {                                                       \
+        UVecConcurrent_##T *cv = uvec_concurrent_alloc(T);                                          \
+        if (!cv) return UVEC_ERR;                                                                   \
+        bench_fill(b, h, ret, n, op, uvec_concurrent_push(T, cv, items[i]),                         \
+                   uvec_concurrent_append_array(T, cv, items + i, m));                              \
+        uvec_concurrent_free(T, cv);                                                                \
+    } else if (backend == BENCH_MAPPED) {                                                           \
+        UVecMapped_##T *mv = uvec_mapped_open(T, b->path, UVEC_MAPPED_CREATE);                      \
+        if (!mv) return UVEC_ERR;                                                                   \
+        bench_fill(b, h, ret, n, op, uvec_mapped_push(T, mv, items[i]),                             \
+                   uvec_mapped_append_array(T, mv, items + i, m));                                  \
+        if (uvec_mapped_close(T, mv)) ret = UVEC_ERR;                                               \
+    } else {                                                                                        \
+        UVec_##T v = uvec_init(T);                                                                  \
+        if (backend == BENCH_RESERVED) ret = uvec_reserve_capacity(T, &v, n);                       \
+        if (op == BENCH_INSERT_SORTED) {                                                            \
+            bench_fill(b, h, ret, n, op, uvec_insert_sorted(T, &v, items[i], NULL), UVEC_ERR);      \
+        } else {                                                                                    \
+            bench_fill(b, h, ret, n, op, uvec_push(T, &v, items[i]),                                \
+                       uvec_append_array(T, &v, items + i, m));                                     \
+        }                                                                                           \
+        uvec_deinit(v);                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    return ret;                                                                                     \
+}                                                                                                   \
+                                                                                                    \
+static void bench_latency_##T(Bench *b, BenchHist *h) {                                             \
+    size_t const size = sizeof(T);                                                                  \
+                                                                                                    \
+    for (uint64_t count = b->min_count; count; count = bench_next_count(b, count)) {                \
+        if (!bench_fits(b, size, count, 4)) break;                                                  \
+                                                                                                    \
+        uvec_uint const n = (uvec_uint)count;                                                       \
+        uint64_t seed = 0x9E3779B97F4A7C15ULL ^ count;                                              \
+        UVec_##T *src = uvec_alloc(T);                                                              \
+                                                                                                    \
+        if (!src || uvec_reserve_capacity(T, src, n)) {                                             \
+            uvec_free(T, src);                                                                      \
+            break;                                                                                  \
+        }                                                                                           \
+                                                                                                    \
+        for (uvec_uint i = 0; i < n; ++i) src->storage[i] = bench_item_##T(bench_rand(&seed));      \
+        src->count = n;                                                                             \
+                                                                                                    \
+        for (unsigned be = 0; be < BENCH_BACKENDS; ++be) {                                          \
+            if (!bench_in_list(b->backends, bench_backends[be])) continue;                          \
+            if (be == BENCH_MAPPED && !b->path) continue;                                           \
+                                                                                                    \
+            for (unsigned op = 0; op < BENCH_LATENCY_OPS; ++op) {                                   \
+                if (!bench_enabled(b, bench_latency_ops[op])) continue;                             \
+                if (op == BENCH_INSERT_SORTED &&                                                    \
+                    (be > BENCH_RESERVED || n > BENCH_SORTED_MAX_COUNT)) continue;                  \
+                                                                                                    \
+                uint64_t const start = bench_now();                                                 \
+                uint64_t reps = 0;                                                                  \
+                uvec_ret ret;                                                                       \
+                bench_hist_reset(h);                                                                \
+                                                                                                    \
+                do {                                                                                \
+                    ret = bench_fill_##T(b, h, src->storage, n, be, op);                            \
+                    ++reps;                                                                         \
+                } while (!ret && (h->count < BENCH_LATENCY_SAMPLES ||                               \
+                                  bench_now() - start < b->target_ns));                             \
+                                                                                                    \
+                if (ret) {                                                                          \
+                    fprintf(stderr, "%s on %s backend failed (elem_size %zu, count %llu)\n",        \
+                            bench_latency_ops[op], bench_backends[be], size,                        \
+                            (unsigned long long)count);                                             \
+                    continue;                                                                       \
+                }                                                                                   \
+                                                                                                    \
+                BenchRow row = {                                                                    \
+                    .suite = "latency", .op = bench_latency_ops[op], .backend = bench_backends[be], \
+                    .elem_size = size, .count = n, .reps = reps, .ops = h->count / reps,            \
+                    .ns = h->sum, .comparisons = BENCH_NA, .swaps = BENCH_NA, .hist = h             \
+                };                                                                                  \
+                                                                                                    \
+                for (unsigned i = 0; i < BENCH_COUNTERS; ++i) row.counters[i] = BENCH_NA;           \
+                if (h->max / BENCH_SPIKE_FACTOR > h->sum / h->count) row.flags = "spike";           \
+                bench_report(b, &row);                                                              \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        uvec_free(T, src);                                                                          \
+    }                                                                                               \
+}
+
+BENCH_DEF_LATENCY(uint32_t)
+BENCH_DEF_LATENCY(uint64_t)
+BENCH_DEF_LATENCY(Blob64)
+BENCH_DEF_LATENCY(Blob256)
+
+// Driver
+
+static size_t const bench_sizes[] = { 4, 8, 64, 256 };
+#define BENCH_SIZES (sizeof(bench_sizes) / sizeof(*bench_sizes))
+
+static void bench_ops(Bench *b, unsigned size_idx) {
+    for (uint64_t count = b->min_count; count; count = bench_next_count(b, count)) {
+        switch (size_idx) {
+            case 0: bench_ops_uint32_t(b, count); break;
+            case 1: bench_ops_uint64_t(b, count); break;
+            case 2: bench_ops_Blob64(b, count); break;
+            default: bench_ops_Blob256(b, count); break;
+        }
+    }
+}
+
+static void bench_sort(Bench *b, unsigned size_idx) {
+    switch (size_idx) {
+        case 0: bench_sort_uint32_t(b); break;
+        case 1: bench_sort_uint64_t(b); break;
+        case 2: bench_sort_Blob64(b); break;
+        default: bench_sort_Blob256(b); break;
+    }
+}
+
+static void bench_latency(Bench *b, unsigned size_idx) {
+    BenchHist *h = malloc(sizeof(*h));
+    if (!h) return;
+
+    switch (size_idx) {
+        case 0: bench_latency_uint32_t(b, h); break;
+        case 1: bench_latency_uint64_t(b, h); break;
+        case 2: bench_latency_Blob64(b, h); break;
+        default: bench_latency_Blob256(b, h); break;
+    }
+
+    free(h);
+}
+
+static bool bench_make_path(char *path, size_t size) {
+    char const *dir = getenv("TMPDIR");
+    if (!(dir && *dir)) dir = "/tmp";
+    if (snprintf(path, size, "%s/uvec-bench-XXXXXX", dir) >= (int)size) return false;
+
+    int const fd = mkstemp(path);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+
+static bool bench_parse_sizes(Bench *b, char const *str) {
+    b->sizes = 0;
+
+    for (char *end; *str; str = *end ? end + 1 : end) {
+        unsigned long const size = strtoul(str, &end, 10);
+        if (end == str || (*end && *end != ',')) return false;
+
+        unsigned i = 0;
+        for (; i < BENCH_SIZES && bench_sizes[i] != size; ++i);
+        if (i == BENCH_SIZES) return false;
+        b->sizes |= 1u << i;
+    }
+
+    return b->sizes;
+}
+
+static void bench_usage(char const *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --format csv|json  Output format (default: csv).\n"
+            "  --suites LIST      Comma-separated list of suites among ops, sort, latency\n"
+            "                     (default: all).\n"
+            "  --ops LIST         Comma-separated list of operations (default: all).\n"
+            "  --inputs LIST      Comma-separated list of sort inputs (default: all).\n"
+            "  --backends LIST    Comma-separated list of latency backends (default: all).\n"
+            "  --sizes LIST       Comma-separated list of element sizes among 4, 8, 64, 256.\n"
+            "  --min-count N      Minimum number of elements (default: 16).\n"
+            "  --max-count N      Maximum number of elements (default: 100000000).\n"
+            "  --memory BYTES     Memory budget (default: half of the physical memory).\n"
+            "  --time-ms MS       Minimum duration of each measurement (default: 50).\n"
+            "  --perf             Collect hardware counters via perf_event_open, if available.\n"
+            "Operations: push, pop, insert_at, remove_at, append_array, copy, deep_copy,\n"
+            "            index_of, index_of_sorted, reverse, min, max, sort, qsort,\n"
+            "            append, insert_sorted.\n"
+            "Sort inputs: random, sorted, reversed, organ_pipe, sawtooth, few_unique,\n"
+            "             all_equal, med3_killer.\n"
+            "Latency backends: realloc, reserved, incremental, concurrent, mapped.\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    Bench b = {
+        .format = BENCH_CSV,
+        .min_count = 16,
+        .max_count = 100000000,
+        .memory = bench_default_memory(),
+        .target_ns = BENCH_TARGET_NS,
+        .sizes = (1u << BENCH_SIZES) - 1,
+    };
+
+    bool perf = false;
+    bench_perf_init(&b.perf);
+
+    for (int i = 1; i < argc; ++i) {
+        char const *opt = argv[i], *arg = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = arg != NULL;
+        uint64_t ms;
+
+        if (!strcmp(opt, "--perf")) {
+            perf = true;
+            continue;
+        }
+
+        if (!strcmp(opt, "--format") && arg) {
+            if (!strcmp(arg, "csv")) b.format = BENCH_CSV;
+            else if (!strcmp(arg, "json")) b.format = BENCH_JSON;
+            else valid = false;
+        } else if (!strcmp(opt, "--suites") && arg) {
+            b.suites = arg;
+        } else if (!strcmp(opt, "--ops") && arg) {
+            b.ops = arg;
+        } else if (!strcmp(opt, "--inputs") && arg) {
+            b.inputs = arg;
+        } else if (!strcmp(opt, "--backends") && arg) {
+            b.backends = arg;
+        } else if (!strcmp(opt, "--sizes") && arg) {
+            valid = bench_parse_sizes(&b, arg);
+        } else if (!strcmp(opt, "--min-count") && arg) {
+            valid = bench_parse_uint(arg, &b.min_count);
+        } else if (!strcmp(opt, "--max-count") && arg) {
+            valid = bench_parse_uint(arg, &b.max_count);
+        } else if (!strcmp(opt, "--memory") && arg) {
+            valid = bench_parse_uint(arg, &b.memory);
+        } else if (!strcmp(opt, "--time-ms") && arg) {
+            if ((valid = bench_parse_uint(arg, &ms))) b.target_ns = ms * 1000000u;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            bench_usage(argv[0]);
+            return strcmp(opt, "--help") ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        ++i;
+    }
+
+    if (b.min_count > b.max_count) b.min_count = b.max_count;
+
+    if (perf && !bench_perf_open(&b.perf)) {
+        fprintf(stderr, "Hardware counters unavailable, reporting timing only.\n");
+    }
+
+    bool const latency = bench_in_list(b.suites, "latency");
+    char path[4096];
+
+    if (latency) {
+        b.timer_ns = bench_timer_overhead();
+
+        if (bench_in_list(b.backends, "mapped")) {
+            if (bench_make_path(path, sizeof(path))) {
+                b.path = path;
+            } else {
+                fprintf(stderr, "Cannot create a temporary file, skipping the mapped backend.\n");
+            }
+        }
+    }
+
+    bench_begin(&b);
+
+    for (unsigned s = 0; s < BENCH_SIZES; ++s) {
+        if (!(b.sizes & (1u << s))) continue;
+        if (bench_in_list(b.suites, "ops")) bench_ops(&b, s);
+        if (bench_in_list(b.suites, "sort")) bench_sort(&b, s);
+        if (latency) bench_latency(&b, s);
+    }
+
+    bench_end(&b);
+    if (b.path) unlink(b.path);
+    bench_perf_close(&b.perf);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,456 @@
+/**
+ * Benchmark harness for the uVec library.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_BENCH_H
+#define UVEC_BENCH_H
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+
+#ifndef UVEC_SORT_SWAP_HOOK
+/// Number of swaps performed by uvec_sort.
+static uint64_t bench_swaps;
+#define UVEC_SORT_SWAP_HOOK() (++bench_swaps)
+#endif
+
+#include "bench_hist.h"
+#include "bench_perf.h"
+#include "uvec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/// @name Types
+
+/// Output format.
+typedef enum BenchFormat {
+    BENCH_CSV,
+    BENCH_JSON
+} BenchFormat;
+
+/// Benchmark configuration and output state.
+typedef struct Bench {
+    BenchFormat format;
+    uint64_t min_count;
+    uint64_t max_count;
+    uint64_t memory;
+    uint64_t target_ns;
+    unsigned sizes;
+    char const *suites;
+    char const *ops;
+    char const *inputs;
+    char const *backends;
+    char const *path;
+    uint64_t timer_ns;
+    unsigned rows;
+    BenchPerf perf;
+    uint64_t reps;
+    uint64_t ns;
+    uint64_t counters[BENCH_COUNTERS];
+} Bench;
+
+/// Benchmark result.
+typedef struct BenchRow {
+    char const *suite;
+    char const *op;
+    char const *input;
+    char const *backend;
+    size_t elem_size;
+    uint64_t count;
+    uint64_t reps;
+    uint64_t ops;
+    uint64_t ns;
+    uint64_t comparisons;
+    uint64_t swaps;
+    uint64_t counters[BENCH_COUNTERS];
+    BenchHist const *hist;
+    char const *flags;
+} BenchRow;
+
+/// @name Constants
+
+/// Maximum number of repetitions of a measurement.
+#define BENCH_MAX_REPS ((uint64_t)1 << 32u)
+
+/// Default minimum duration of a measurement.
+#define BENCH_TARGET_NS 50000000u
+
+/// Marks unavailable counters.
+#define BENCH_NA UINT64_MAX
+
+/// @name Utilities
+
+/// Prevents the compiler from optimizing away or reordering memory accesses.
+#if defined __GNUC__ || defined __clang__
+    #define bench_clobber() __asm__ volatile("" ::: "memory")
+#else
+    #define bench_clobber() ((void)0)
+#endif
+
+/// Sink for benchmark results, so that computations are not optimized away.
+static volatile uint64_t bench_sink;
+
+/**
+ * Returns the value of a monotonic clock.
+ *
+ * @return [uint64_t] Time in nanoseconds.
+ */
+static inline uint64_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Returns the next pseudo-random number of a xorshift64* generator.
+ *
+ * @param state [uint64_t*] Generator state, must not be zero.
+ * @return [uint64_t] Pseudo-random number.
+ */
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12u;
+    x ^= x << 25u;
+    x ^= x >> 27u;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Returns the number of repetitions for the next calibration round.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param reps [uint64_t] Current number of repetitions.
+ * @param ns [uint64_t] Duration of the current repetitions.
+ * @return [uint64_t] Number of repetitions.
+ */
+static inline uint64_t bench_next_reps(Bench const *b, uint64_t reps, uint64_t ns) {
+    uint64_t factor = ns ? b->target_ns / ns + 1 : 100;
+    if (factor < 2) factor = 2;
+    if (factor > 100) factor = 100;
+    reps *= factor;
+    return reps > BENCH_MAX_REPS ? BENCH_MAX_REPS : reps;
+}
+
+/**
+ * Checks whether a name appears in a comma-separated list.
+ *
+ * @param list [char const*] List, NULL matches any name.
+ * @param name [char const*] Name.
+ * @return [bool] True if the name is in the list.
+ */
+static inline bool bench_in_list(char const *list, char const *name) {
+    if (!list) return true;
+    size_t const len = strlen(name);
+
+    for (char const *p = list; *p;) {
+        char const *end = strchr(p, ',');
+        size_t const plen = end ? (size_t)(end - p) : strlen(p);
+        if (plen == len && !strncmp(p, name, len)) return true;
+        if (!end) break;
+        p = end + 1;
+    }
+
+    return false;
+}
+
+/**
+ * Checks whether the specified operation has been selected.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param op [char const*] Operation name.
+ * @return [bool] True if the operation should be benchmarked.
+ */
+static inline bool bench_enabled(Bench const *b, char const *op) {
+    return bench_in_list(b->ops, op);
+}
+
+/**
+ * Returns the element count following the specified one.
+ * Counts grow geometrically from the minimum count, and always end with the maximum count.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param count [uint64_t] Current count.
+ * @return [uint64_t] Next count, or zero if the current count is the maximum.
+ */
+static inline uint64_t bench_next_count(Bench const *b, uint64_t count) {
+    if (count >= b->max_count) return 0;
+    return count <= b->max_count / 16 ? count * 16 : b->max_count;
+}
+
+/**
+ * Checks whether a working set fits in the memory budget.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param size [size_t] Element size.
+ * @param count [uint64_t] Number of elements.
+ * @param copies [unsigned] Number of copies of the elements in the working set.
+ * @return [bool] True if the working set fits.
+ */
+static inline bool bench_fits(Bench const *b, size_t size, uint64_t count, unsigned copies) {
+    return count <= UVEC_UINT_MAX && count <= b->memory / size / copies;
+}
+
+/**
+ * Returns the default memory budget, half of the physical memory if available.
+ *
+ * @return [uint64_t] Memory budget in bytes.
+ */
+static inline uint64_t bench_default_memory(void) {
+#if defined _SC_PHYS_PAGES && defined _SC_PAGESIZE
+    long const pages = sysconf(_SC_PHYS_PAGES), page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) return (uint64_t)pages * (uint64_t)page_size / 2;
+#endif
+    return (uint64_t)1 << 30u;
+}
+
+/**
+ * Parses a positive integer command line argument.
+ *
+ * @param str [char const*] Argument.
+ * @param[out] out [uint64_t*] Parsed value.
+ * @return [bool] True on success, false if the argument is not a positive integer.
+ */
+static inline bool bench_parse_uint(char const *str, uint64_t *out) {
+    char *end;
+    unsigned long long const value = strtoull(str, &end, 10);
+    if (end == str || *end || !value) return false;
+    *out = value;
+    return true;
+}
+
+/**
+ * Starts the output.
+ *
+ * @param b [Bench*] Benchmark.
+ */
+static inline void bench_begin(Bench *b) {
+    b->rows = 0;
+
+    if (b->format == BENCH_CSV) {
+        printf("suite,op,input,backend,elem_size,count,reps,ns_per_op,ns_per_elem,");
+        printf("comparisons,swaps");
+        for (unsigned i = 0; i < BENCH_PERCENTILES; ++i) printf(",%s", bench_percentile_names[i]);
+        printf(",max_ns");
+        for (unsigned i = 0; i < BENCH_COUNTERS; ++i) printf(",%s", bench_counter_names[i]);
+        printf(",flags\n");
+    } else {
+        printf("[");
+    }
+}
+
+/**
+ * Ends the output.
+ *
+ * @param b [Bench*] Benchmark.
+ */
+static inline void bench_end(Bench *b) {
+    if (b->format == BENCH_JSON) printf("%s]\n", b->rows ? "\n" : "");
+    fflush(stdout);
+}
+
+/**
+ * Prints a counter.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param key [char const*] Counter name.
+ * @param value [uint64_t] Counter value, or BENCH_NA.
+ */
+static inline void bench_print_counter(Bench const *b, char const *key, uint64_t value) {
+    if (b->format == BENCH_CSV) {
+        if (value == BENCH_NA) printf(",");
+        else printf(",%llu", (unsigned long long)value);
+    } else {
+        if (value == BENCH_NA) printf(", \"%s\": null", key);
+        else printf(", \"%s\": %llu", key, (unsigned long long)value);
+    }
+}
+
+/**
+ * Prints a hardware counter, averaged per operation.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param key [char const*] Counter name.
+ * @param value [uint64_t] Counter value, or BENCH_NA.
+ * @param ops [uint64_t] Total number of operations.
+ */
+static inline void bench_print_rate(Bench const *b, char const *key, uint64_t value, uint64_t ops) {
+    if (b->format == BENCH_CSV) {
+        if (value == BENCH_NA) printf(",");
+        else printf(",%.2f", (double)value / (double)ops);
+    } else {
+        if (value == BENCH_NA) printf(", \"%s\": null", key);
+        else printf(", \"%s\": %.2f", key, (double)value / (double)ops);
+    }
+}
+
+/**
+ * Prints the latency percentiles of a measurement.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param hist [BenchHist const*] Latency histogram, or NULL if unavailable.
+ */
+static inline void bench_print_latency(Bench const *b, BenchHist const *hist) {
+    for (unsigned i = 0; i < BENCH_PERCENTILES; ++i) {
+        uint64_t const value = hist ? bench_hist_percentile(hist, bench_percentiles[i]) : BENCH_NA;
+        bench_print_counter(b, bench_percentile_names[i], value);
+    }
+    bench_print_counter(b, "max_ns", hist ? hist->max : BENCH_NA);
+}
+
+/**
+ * Reports a measurement.
+ *
+ * @param b [Bench*] Benchmark.
+ * @param row [BenchRow const*] Measurement.
+ */
+static inline void bench_report(Bench *b, BenchRow const *row) {
+    double const per_op = (double)row->ns / (double)row->reps / (double)row->ops;
+    double const per_elem = row->count ? per_op / (double)row->count : 0.0;
+    char const *input = row->input ? row->input : "";
+    char const *backend = row->backend ? row->backend : "";
+    char const *flags = row->flags ? row->flags : "";
+
+    if (b->format == BENCH_CSV) {
+        printf("%s,%s,%s,%s,%zu,%llu,%llu,%.3f,%.5f", row->suite, row->op, input, backend,
+               row->elem_size, (unsigned long long)row->count, (unsigned long long)row->reps,
+               per_op, per_elem);
+        bench_print_counter(b, "comparisons", row->comparisons);
+        bench_print_counter(b, "swaps", row->swaps);
+        bench_print_latency(b, row->hist);
+        for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+            bench_print_rate(b, bench_counter_names[i], row->counters[i], row->reps * row->ops);
+        }
+        printf(",%s\n", flags);
+    } else {
+        printf("%s\n  {\"suite\": \"%s\", \"op\": \"%s\", \"input\": \"%s\", \"backend\": \"%s\", "
+               "\"elem_size\": %zu, \"count\": %llu, \"reps\": %llu, \"ns_per_op\": %.3f, "
+               "\"ns_per_elem\": %.5f", b->rows ? "," : "", row->suite, row->op, input, backend,
+               row->elem_size, (unsigned long long)row->count, (unsigned long long)row->reps,
+               per_op, per_elem);
+        bench_print_counter(b, "comparisons", row->comparisons);
+        bench_print_counter(b, "swaps", row->swaps);
+        bench_print_latency(b, row->hist);
+        for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+            bench_print_rate(b, bench_counter_names[i], row->counters[i], row->reps * row->ops);
+        }
+        printf(", \"flags\": \"%s\"}", flags);
+    }
+
+    b->rows++;
+    fflush(stdout);
+}
+
+/**
+ * Times the specified number of repetitions of a block of code.
+ *
+ * @param ns [uint64_t] Variable receiving the duration.
+ * @param reps [uint64_t] Number of repetitions.
+ * @param code [code] Code.
+ */
+#define bench_time(ns, reps, code) do {                                                             \
+    uint64_t const p_start = bench_now();                                                           \
+    for (uint64_t p_r = 0; p_r < (reps); ++p_r) {                                                   \
+        code;                                                                                       \
+        bench_clobber();                                                                            \
+    }                                                                                               \
+    ns = bench_now() - p_start;                                                                     \
+} while (0)
+
+/**
+ * Returns the overhead of reading the clock, as the minimum duration
+ * of an empty block timed via bench_now.
+ *
+ * @return [uint64_t] Overhead in nanoseconds.
+ */
+static inline uint64_t bench_timer_overhead(void) {
+    uint64_t overhead = UINT64_MAX;
+
+    for (unsigned i = 0; i < 1000; ++i) {
+        uint64_t const start = bench_now();
+        uint64_t const ns = bench_now() - start;
+        if (ns < overhead) overhead = ns;
+    }
+
+    return overhead;
+}
+
+/**
+ * Times a single execution of a block of code, recording its latency
+ * net of the overhead of reading the clock.
+ *
+ * @param b [Bench const*] Benchmark.
+ * @param hist [BenchHist*] Latency histogram.
+ * @param code [code] Code.
+ */
+#define bench_record(b, hist, code) do {                                                            \
+    uint64_t const p_start = bench_now();                                                           \
+    code;                                                                                           \
+    uint64_t const p_ns = bench_now() - p_start;                                                    \
+    bench_hist_record(hist, p_ns > (b)->timer_ns ? p_ns - (b)->timer_ns : 0);                       \
+} while (0)
+
+/**
+ * Runs a block of code, repeating it until the measurement lasts long enough.
+ * The duration and hardware counters of the setup code, measured separately, are subtracted.
+ * The number of repetitions, the total duration and the hardware counters are stored
+ * in the 'reps', 'ns' and 'counters' fields of the benchmark.
+ *
+ * @param b [Bench*] Benchmark.
+ * @param setup [code] Setup code, executed before each repetition.
+ * @param code [code] Measured code.
+ */
+#define bench_run(b, setup, code) do {                                                              \
+    uint64_t p_reps = 1, p_ns, p_base, p_counters[BENCH_COUNTERS];                                  \
+                                                                                                    \
+    while (true) {                                                                                  \
+        bench_perf_start(&(b)->perf);                                                               \
+        bench_time(p_ns, p_reps, { setup; code; });                                                 \
+        bench_perf_stop(&(b)->perf, (b)->counters);                                                 \
+        if (p_ns >= (b)->target_ns || p_reps >= BENCH_MAX_REPS) break;                              \
+        p_reps = bench_next_reps(b, p_reps, p_ns);                                                  \
+    }                                                                                               \
+                                                                                                    \
+    bench_perf_start(&(b)->perf);                                                                   \
+    bench_time(p_base, p_reps, { setup; });                                                         \
+    bench_perf_stop(&(b)->perf, p_counters);                                                        \
+    bench_perf_subtract((b)->counters, p_counters);                                                 \
+    (b)->reps = p_reps;                                                                             \
+    (b)->ns = p_ns > p_base ? p_ns - p_base : 0;                                                    \
+} while (0)
+
+/**
+ * Measures and reports a block of code.
+ *
+ * @param b [Bench*] Benchmark.
+ * @param suite_name [char const*] Suite name.
+ * @param op_name [char const*] Operation name.
+ * @param item_size [size_t] Element size.
+ * @param item_count [uint64_t] Number of elements.
+ * @param op_count [uint64_t] Number of operations per repetition.
+ * @param setup [code] Setup code, executed before each repetition.
+ * @param code [code] Measured code.
+ */
+#define bench_measure(b, suite_name, op_name, item_size, item_count, op_count, setup, code) do {    \
+    bench_run(b, setup, code);                                                                      \
+    BenchRow p_row = {                                                                              \
+        .suite = (suite_name), .op = (op_name), .elem_size = (item_size),                           \
+        .count = (item_count), .reps = (b)->reps, .ops = (op_count), .ns = (b)->ns,                 \
+        .comparisons = BENCH_NA, .swaps = BENCH_NA                                                  \
+    };                                                                                              \
+    memcpy(p_row.counters, (b)->counters, sizeof(p_row.counters));                                  \
+    bench_report(b, &p_row);                                                                        \
+} while (0)
+
+#endif // UVEC_BENCH_H
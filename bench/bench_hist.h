@@ -0,0 +1,142 @@
+/**
+ * Latency histograms for the uVec benchmarks.
+ *
+ * Histograms are log-linear, as in HdrHistogram: each power of two range is split into
+ * a fixed number of equally sized buckets, so that any recorded value, up to UINT64_MAX,
+ * is reported with a relative error below 1% in constant memory and time.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_BENCH_HIST_H
+#define UVEC_BENCH_HIST_H
+
+#include <stdint.h>
+#include <string.h>
+
+/// @name Constants
+
+/// Base 2 logarithm of the number of values recorded exactly (also the precision in bits).
+#define BENCH_HIST_BITS 8u
+
+/// Number of buckets per power of two range, above the exactly recorded values.
+#define BENCH_HIST_HALF (1u << (BENCH_HIST_BITS - 1u))
+
+/// Number of buckets.
+#define BENCH_HIST_BUCKETS ((64u - BENCH_HIST_BITS + 2u) * BENCH_HIST_HALF)
+
+/// Number of reported percentiles.
+#define BENCH_PERCENTILES 6u
+
+/// Reported percentiles.
+static double const bench_percentiles[BENCH_PERCENTILES] = {
+    50.0, 90.0, 99.0, 99.9, 99.99, 99.999
+};
+
+/// Names of the reported percentiles.
+static char const *const bench_percentile_names[BENCH_PERCENTILES] = {
+    "p50_ns", "p90_ns", "p99_ns", "p99_9_ns", "p99_99_ns", "p99_999_ns"
+};
+
+/// @name Types
+
+/// Latency histogram.
+typedef struct BenchHist {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[BENCH_HIST_BUCKETS];
+} BenchHist;
+
+/// @name Functions
+
+/**
+ * Returns the index of the most significant set bit of the specified value.
+ *
+ * @param value [uint64_t] Value, must not be zero.
+ * @return [unsigned] Index of the most significant set bit.
+ */
+static inline unsigned bench_hist_msb(uint64_t value) {
+#if defined __GNUC__ || defined __clang__
+    return 63u - (unsigned)__builtin_clzll(value);
+#else
+    unsigned msb = 0;
+    while (value >>= 1u) ++msb;
+    return msb;
+#endif
+}
+
+/**
+ * Returns the bucket of the specified value.
+ *
+ * @param value [uint64_t] Value.
+ * @return [unsigned] Bucket index.
+ */
+static inline unsigned bench_hist_index(uint64_t value) {
+    if (value < (1u << BENCH_HIST_BITS)) return (unsigned)value;
+    unsigned const shift = bench_hist_msb(value) - BENCH_HIST_BITS + 1u;
+    return shift * BENCH_HIST_HALF + (unsigned)(value >> shift);
+}
+
+/**
+ * Returns the highest value recorded in the specified bucket.
+ *
+ * @param idx [unsigned] Bucket index.
+ * @return [uint64_t] Highest value.
+ */
+static inline uint64_t bench_hist_value(unsigned idx) {
+    if (idx < (1u << BENCH_HIST_BITS)) return idx;
+    unsigned const shift = idx / BENCH_HIST_HALF - 1u;
+    return (((uint64_t)(idx - shift * BENCH_HIST_HALF) + 1u) << shift) - 1u;
+}
+
+/**
+ * Clears the specified histogram.
+ *
+ * @param h [BenchHist*] Histogram.
+ */
+static inline void bench_hist_reset(BenchHist *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+/**
+ * Records a value.
+ *
+ * @param h [BenchHist*] Histogram.
+ * @param value [uint64_t] Value.
+ */
+static inline void bench_hist_record(BenchHist *h, uint64_t value) {
+    h->buckets[bench_hist_index(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value > h->max) h->max = value;
+}
+
+/**
+ * Returns the value at the specified percentile.
+ *
+ * @param h [BenchHist const*] Histogram.
+ * @param percentile [double] Percentile, between 0 and 100.
+ * @return [uint64_t] Value at the percentile, or zero if the histogram is empty.
+ */
+static inline uint64_t bench_hist_percentile(BenchHist const *h, double percentile) {
+    double const rank_f = percentile / 100.0 * (double)h->count;
+    uint64_t rank = (uint64_t)rank_f;
+    if ((double)rank < rank_f || !rank) ++rank;
+
+    uint64_t seen = 0;
+
+    for (unsigned i = 0; seen < h->count; ++i) {
+        if ((seen += h->buckets[i]) < rank) continue;
+        uint64_t const value = bench_hist_value(i);
+        return value < h->max ? value : h->max;
+    }
+
+    return h->max;
+}
+
+#endif // UVEC_BENCH_HIST_H
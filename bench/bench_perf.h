@@ -0,0 +1,198 @@
+/**
+ * Hardware performance counters for the uVec benchmarks, based on perf_event_open.
+ *
+ * Counters are optional: those that cannot be opened (unsupported platform, missing PMU,
+ * insufficient privileges) are reported as unavailable, and benchmarks fall back to timing.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_BENCH_PERF_H
+#define UVEC_BENCH_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined __linux__ && defined __has_include
+    #if __has_include(<linux/perf_event.h>)
+        #include <linux/perf_event.h>
+        #include <sys/ioctl.h>
+        #include <sys/syscall.h>
+        #include <unistd.h>
+        #ifdef __NR_perf_event_open
+            #define BENCH_HAS_PERF 1
+        #endif
+    #endif
+#endif
+
+#ifndef BENCH_HAS_PERF
+    #define BENCH_HAS_PERF 0
+#endif
+
+/// @name Types
+
+/// Hardware counters.
+typedef enum BenchCounter {
+    BENCH_CYCLES,
+    BENCH_INSTRUCTIONS,
+    BENCH_L1D_MISSES,
+    BENCH_LLC_MISSES,
+    BENCH_BRANCH_MISSES,
+    BENCH_DTLB_MISSES,
+    BENCH_COUNTERS
+} BenchCounter;
+
+/// Counter collector.
+typedef struct BenchPerf {
+    int fd[BENCH_COUNTERS];
+} BenchPerf;
+
+/// @name Constants
+
+/// Counter names.
+static char const *const bench_counter_names[BENCH_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+/// @name Functions
+
+/**
+ * Initializes the collector, with all counters unavailable.
+ *
+ * @param p [BenchPerf*] Collector.
+ */
+static inline void bench_perf_init(BenchPerf *p) {
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) p->fd[i] = -1;
+}
+
+/**
+ * Subtracts baseline counter values.
+ *
+ * @param values [uint64_t*] Counter values.
+ * @param base [uint64_t const*] Baseline counter values.
+ */
+static inline void bench_perf_subtract(uint64_t *values, uint64_t const *base) {
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        if (values[i] == UINT64_MAX) continue;
+        if (base[i] == UINT64_MAX) values[i] = UINT64_MAX;
+        else values[i] = values[i] > base[i] ? values[i] - base[i] : 0;
+    }
+}
+
+#if BENCH_HAS_PERF
+
+/// Builds a hardware cache event configuration for read misses.
+#define p_bench_cache_miss(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u))
+
+/**
+ * Opens the counters. Counters that cannot be opened are marked as unavailable.
+ *
+ * @param p [BenchPerf*] Collector.
+ * @return [bool] True if at least one counter is available.
+ */
+static inline bool bench_perf_open(BenchPerf *p) {
+    static struct { uint32_t type; uint64_t config; } const events[BENCH_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, p_bench_cache_miss(PERF_COUNT_HW_CACHE_L1D) },
+        { PERF_TYPE_HW_CACHE, p_bench_cache_miss(PERF_COUNT_HW_CACHE_LL) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, p_bench_cache_miss(PERF_COUNT_HW_CACHE_DTLB) },
+    };
+
+    bool available = false;
+
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        p->fd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (p->fd[i] >= 0) available = true;
+    }
+
+    return available;
+}
+
+/**
+ * Closes the counters.
+ *
+ * @param p [BenchPerf*] Collector.
+ */
+static inline void bench_perf_close(BenchPerf *p) {
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        if (p->fd[i] >= 0) close(p->fd[i]);
+        p->fd[i] = -1;
+    }
+}
+
+/**
+ * Resets and starts the counters.
+ *
+ * @param p [BenchPerf*] Collector.
+ */
+static inline void bench_perf_start(BenchPerf *p) {
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        if (p->fd[i] < 0) continue;
+        ioctl(p->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(p->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/**
+ * Stops the counters and reads their values, scaled to account for multiplexing.
+ *
+ * @param p [BenchPerf*] Collector.
+ * @param[out] values [uint64_t*] Counter values, UINT64_MAX if unavailable.
+ */
+static inline void bench_perf_stop(BenchPerf *p, uint64_t *values) {
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        if (p->fd[i] >= 0) ioctl(p->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) {
+        uint64_t data[3];
+        values[i] = UINT64_MAX;
+
+        if (p->fd[i] < 0) continue;
+        if (read(p->fd[i], data, sizeof(data)) != (ssize_t)sizeof(data) || !data[2]) continue;
+
+        values[i] = data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+    }
+}
+
+#else
+
+static inline bool bench_perf_open(BenchPerf *p) {
+    bench_perf_init(p);
+    return false;
+}
+
+static inline void bench_perf_close(BenchPerf *p) {
+    (void)p;
+}
+
+static inline void bench_perf_start(BenchPerf *p) {
+    (void)p;
+}
+
+static inline void bench_perf_stop(BenchPerf *p, uint64_t *values) {
+    (void)p;
+    for (unsigned i = 0; i < BENCH_COUNTERS; ++i) values[i] = UINT64_MAX;
+}
+
+#endif
+
+#endif // UVEC_BENCH_PERF_H
@@ -0,0 +1,43 @@
+/**
+ * C interface to the std::vector baseline of the competitive benchmark.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_BENCH_STD_H
+#define UVEC_BENCH_STD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Declares the std::vector workloads for the specified type.
+ * Vectors are passed around as opaque pointers to std::vector<T> instances.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DECL_STD(T)                                                                           \
+    void *bench_std_new_##T(T const *items, size_t n);                                              \
+    void bench_std_delete_##T(void *v);                                                             \
+    void bench_std_assign_##T(void *v, T const *items, size_t n);                                   \
+    uint64_t bench_std_push_##T(T const *items, size_t n);                                          \
+    uint64_t bench_std_iterate_##T(void const *v);                                                  \
+    size_t bench_std_search_##T(void const *v, T item);                                             \
+    void bench_std_sort_##T(void *v);
+
+BENCH_DECL_STD(uint32_t)
+BENCH_DECL_STD(uint64_t)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UVEC_BENCH_STD_H
@@ -0,0 +1,436 @@
+/**
+ * Competitive benchmark of uVec against other vector libraries.
+ *
+ * Runs the same push, iterate, search and sort workloads on uVec and, if available
+ * at build time, on klib's kvec (BENCH_HAS_KVEC), stb_ds arrays (BENCH_HAS_STB_DS)
+ * and a C++ std::vector baseline (BENCH_HAS_STD_VECTOR). kvec and stb_ds do not provide
+ * a sort, so their vectors are sorted via qsort, as a C user would do.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+
+// uvec_sort is not instrumented, so that all libraries run comparable code.
+#define UVEC_SORT_SWAP_HOOK() ((void)0)
+
+#include "bench.h"
+
+// Libraries
+
+/// Libraries.
+typedef enum BenchLib {
+    BENCH_UVEC,
+    BENCH_KVEC,
+    BENCH_STB_DS,
+    BENCH_STD_VECTOR,
+    BENCH_LIBS
+} BenchLib;
+
+static char const *const bench_libs[BENCH_LIBS] = { "uvec", "kvec", "stb_ds", "std_vector" };
+
+/// Workloads.
+typedef enum BenchWorkload {
+    BENCH_PUSH,
+    BENCH_ITERATE,
+    BENCH_SEARCH,
+    BENCH_SORT,
+    BENCH_WORKLOADS
+} BenchWorkload;
+
+static char const *const bench_workloads[BENCH_WORKLOADS] = { "push", "iterate", "search", "sort" };
+
+/**
+ * Measures a workload, given code for each of them.
+ *
+ * @param b [Bench*] Benchmark.
+ * @param workload [BenchWorkload] Workload.
+ * @param setup_sort [code] Code that restores the unsorted vector.
+ * @param push [code] Push workload.
+ * @param iterate [code] Iterate workload.
+ * @param search [code] Search workload.
+ * @param sort [code] Sort workload.
+ */
+#define bench_workload(b, workload, setup_sort, push, iterate, search, sort) do {                   \
+    switch (workload) {                                                                             \
+        case BENCH_PUSH: bench_run(b, , push); break;                                               \
+        case BENCH_ITERATE: bench_run(b, , iterate); break;                                         \
+        case BENCH_SEARCH: bench_run(b, , search); break;                                           \
+        default: bench_run(b, setup_sort, sort); break;                                             \
+    }                                                                                               \
+} while (0)
+
+/**
+ * Defines the uVec workloads for the specified type.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DEF_UVEC(T)                                                                           \
+                                                                                                    \
+UVEC_INIT_IDENTIFIABLE(T)                                                                           \
+                                                                                                    \
+static bool bench_uvec_##T(Bench *b, unsigned workload, T const *items, uvec_uint n) {              \
+    T const missing = 1;                                                                            \
+    uint64_t acc = 0;                                                                               \
+    UVec_##T *v = uvec_alloc(T);                                                                    \
+                                                                                                    \
+    if (!v || uvec_append_array(T, v, items, n)) {                                                  \
+        uvec_free(T, v);                                                                            \
+        return false;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    bench_workload(b, workload, memcpy(v->storage, items, n * sizeof(T)), {                         \
+        UVec_##T p = uvec_init(T);                                                                  \
+        for (uvec_uint i = 0; i < n; ++i) uvec_push(T, &p, items[i]);                               \
+        acc += p.count;                                                                             \
+        uvec_deinit(p);                                                                             \
+    }, uvec_foreach(T, v, item, acc += item), acc += uvec_index_of(T, v, missing),                  \
+       uvec_sort(T, v));                                                                            \
+                                                                                                    \
+    bench_sink = acc;                                                                               \
+    uvec_free(T, v);                                                                                \
+    return true;                                                                                    \
+}
+
+#define bench_uvec_func(T) bench_uvec_##T
+
+#ifdef BENCH_HAS_KVEC
+
+#include "kvec.h"
+
+/**
+ * Defines the kvec workloads for the specified type.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DEF_KVEC(T)                                                                           \
+                                                                                                    \
+typedef kvec_t(T) BenchKvec_##T;                                                                    \
+                                                                                                    \
+static bool bench_kvec_##T(Bench *b, unsigned workload, T const *items, uvec_uint n) {              \
+    T const missing = 1;                                                                            \
+    uint64_t acc = 0;                                                                               \
+    BenchKvec_##T v;                                                                                \
+    kv_init(v);                                                                                     \
+    kv_resize(T, v, n);                                                                             \
+    if (!v.a) return false;                                                                         \
+    memcpy(v.a, items, n * sizeof(T));                                                              \
+    v.n = n;                                                                                        \
+                                                                                                    \
+    bench_workload(b, workload, memcpy(v.a, items, n * sizeof(T)), {                                \
+        BenchKvec_##T p;                                                                            \
+        kv_init(p);                                                                                 \
+        for (uvec_uint i = 0; i < n; ++i) kv_push(T, p, items[i]);                                  \
+        acc += kv_size(p);                                                                          \
+        kv_destroy(p);                                                                              \
+    }, {                                                                                            \
+        size_t const len = kv_size(v);                                                              \
+        for (size_t i = 0; i < len; ++i) acc += kv_A(v, i);                                         \
+    }, {                                                                                            \
+        size_t const len = kv_size(v);                                                              \
+        size_t i = 0;                                                                               \
+        while (i < len && kv_A(v, i) != missing) ++i;                                               \
+        acc += i;                                                                                   \
+    }, qsort(v.a, n, sizeof(T), bench_cmp_##T));                                                    \
+                                                                                                    \
+    bench_sink = acc;                                                                               \
+    kv_destroy(v);                                                                                  \
+    return true;                                                                                    \
+}
+
+#define bench_kvec_func(T) bench_kvec_##T
+
+#else
+
+#define BENCH_DEF_KVEC(T)
+#define bench_kvec_func(T) NULL
+
+#endif // BENCH_HAS_KVEC
+
+#ifdef BENCH_HAS_STB_DS
+
+#define STB_DS_IMPLEMENTATION
+#include "stb_ds.h"
+
+/**
+ * Defines the stb_ds workloads for the specified type.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DEF_STB_DS(T)                                                                         \
+                                                                                                    \
+static bool bench_stb_ds_##T(Bench *b, unsigned workload, T const *items, uvec_uint n) {            \
+    T const missing = 1;                                                                            \
+    uint64_t acc = 0;                                                                               \
+    T *v = NULL;                                                                                    \
+    arrsetlen(v, n);                                                                                \
+    if (!v) return false;                                                                           \
+    memcpy(v, items, n * sizeof(T));                                                                \
+                                                                                                    \
+    bench_workload(b, workload, memcpy(v, items, n * sizeof(T)), {                                  \
+        T *p = NULL;                                                                                \
+        for (uvec_uint i = 0; i < n; ++i) arrput(p, items[i]);                                      \
+        acc += (uint64_t)arrlen(p);                                                                 \
+        arrfree(p);                                                                                 \
+    }, {                                                                                            \
+        size_t const len = (size_t)arrlen(v);                                                       \
+        for (size_t i = 0; i < len; ++i) acc += v[i];                                               \
+    }, {                                                                                            \
+        size_t const len = (size_t)arrlen(v);                                                       \
+        size_t i = 0;                                                                               \
+        while (i < len && v[i] != missing) ++i;                                                     \
+        acc += i;                                                                                   \
+    }, qsort(v, n, sizeof(T), bench_cmp_##T));                                                      \
+                                                                                                    \
+    bench_sink = acc;                                                                               \
+    arrfree(v);                                                                                     \
+    return true;                                                                                    \
+}
+
+#define bench_stb_ds_func(T) bench_stb_ds_##T
+
+#else
+
+#define BENCH_DEF_STB_DS(T)
+#define bench_stb_ds_func(T) NULL
+
+#endif // BENCH_HAS_STB_DS
+
+#ifdef BENCH_HAS_STD_VECTOR
+
+#include "bench_std.h"
+
+/**
+ * Defines the std::vector workloads for the specified type.
+ * Each workload is a single call into the C++ translation unit, whose overhead
+ * is only noticeable for the smallest vectors.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DEF_STD_VECTOR(T)                                                                     \
+                                                                                                    \
+static bool bench_std_vector_##T(Bench *b, unsigned workload, T const *items, uvec_uint n) {        \
+    T const missing = 1;                                                                            \
+    uint64_t acc = 0;                                                                               \
+    void *v = bench_std_new_##T(items, n);                                                          \
+    if (!v) return false;                                                                           \
+                                                                                                    \
+    bench_workload(b, workload, bench_std_assign_##T(v, items, n),                                  \
+                   acc += bench_std_push_##T(items, n), acc += bench_std_iterate_##T(v),            \
+                   acc += bench_std_search_##T(v, missing), bench_std_sort_##T(v));                 \
+                                                                                                    \
+    bench_sink = acc;                                                                               \
+    bench_std_delete_##T(v);                                                                        \
+    return true;                                                                                    \
+}
+
+#define bench_std_vector_func(T) bench_std_vector_##T
+
+#else
+
+#define BENCH_DEF_STD_VECTOR(T)
+#define bench_std_vector_func(T) NULL
+
+#endif // BENCH_HAS_STD_VECTOR
+
+// Comparison suite
+
+/**
+ * Defines the comparison suite for the specified type.
+ *
+ * Each library provides a function that measures a workload, storing the measurement
+ * in the 'reps', 'ns' and 'counters' fields of the benchmark, and returning false
+ * if its vectors could not be allocated; unavailable libraries have a NULL function.
+ * Keys are even, so that searches for the odd key 1 scan the whole vector.
+ * Push is timed per element, while the other workloads count as one operation per repetition.
+ * The time of each library relative to uVec is printed to stderr.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_DEF_COMPARE(T)                                                                        \
+                                                                                                    \
+typedef bool (*BenchLibFunc_##T)(Bench *b, unsigned workload, T const *items, uvec_uint n);         \
+                                                                                                    \
+static inline int bench_cmp_##T(void const *a, void const *b) {                                     \
+    T const ka = *(T const *)a, kb = *(T const *)b;                                                 \
+    return (ka > kb) - (ka < kb);                                                                   \
+}                                                                                                   \
+                                                                                                    \
+BENCH_DEF_UVEC(T)                                                                                   \
+BENCH_DEF_KVEC(T)                                                                                   \
+BENCH_DEF_STB_DS(T)                                                                                 \
+BENCH_DEF_STD_VECTOR(T)                                                                             \
+                                                                                                    \
+static BenchLibFunc_##T const bench_funcs_##T[BENCH_LIBS] = {                                       \
+    bench_uvec_func(T), bench_kvec_func(T), bench_stb_ds_func(T), bench_std_vector_func(T)          \
+};                                                                                                  \
+                                                                                                    \
+static void bench_compare_##T(Bench *b, uint64_t count) {                                           \
+    if (!bench_fits(b, sizeof(T), count, 4)) return;                                                \
+                                                                                                    \
+    uvec_uint const n = (uvec_uint)count;                                                           \
+    size_t const size = sizeof(T);                                                                  \
+    uint64_t seed = 0x9E3779B97F4A7C15ULL ^ count;                                                  \
+    T *items = malloc(n * size);                                                                    \
+    if (!items) return;                                                                             \
+    for (uvec_uint i = 0; i < n; ++i) items[i] = (T)(bench_rand(&seed) << 1u);                      \
+                                                                                                    \
+    for (unsigned w = 0; w < BENCH_WORKLOADS; ++w) {                                                \
+        if (!bench_enabled(b, bench_workloads[w])) continue;                                        \
+        double base = 0;                                                                            \
+                                                                                                    \
+        for (unsigned lib = 0; lib < BENCH_LIBS; ++lib) {                                           \
+            BenchLibFunc_##T const func = bench_funcs_##T[lib];                                     \
+            if (!(func && bench_in_list(b->backends, bench_libs[lib]))) continue;                   \
+                                                                                                    \
+            if (!func(b, w, items, n)) {                                                            \
+                fprintf(stderr, "%s on %s failed (elem_size %zu, count %llu)\n",                    \
+                        bench_workloads[w], bench_libs[lib], size, (unsigned long long)count);      \
+                continue;                                                                           \
+            }                                                                                       \
+                                                                                                    \
+            BenchRow row = {                                                                        \
+                .suite = "compare", .op = bench_workloads[w], .backend = bench_libs[lib],           \
+                .elem_size = size, .count = n, .reps = b->reps,                                     \
+                .ops = w == BENCH_PUSH ? n : 1, .ns = b->ns,                                        \
+                .comparisons = BENCH_NA, .swaps = BENCH_NA                                          \
+            };                                                                                      \
+                                                                                                    \
+            memcpy(row.counters, b->counters, sizeof(row.counters));                                \
+            bench_report(b, &row);                                                                  \
+                                                                                                    \
+            double const t = (double)b->ns / (double)b->reps;                                       \
+                                                                                                    \
+            if (lib == BENCH_UVEC) {                                                                \
+                base = t;                                                                           \
+            } else if (base > 0 && t > 0) {                                                         \
+                fprintf(stderr, "%s, uvec vs %s (elem_size %zu, count %llu): %.2fx\n",              \
+                        bench_workloads[w], bench_libs[lib], size, (unsigned long long)count,       \
+                        t / base);                                                                  \
+            }                                                                                       \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    free(items);                                                                                    \
+}
+
+BENCH_DEF_COMPARE(uint32_t)
+BENCH_DEF_COMPARE(uint64_t)
+
+// Driver
+
+static size_t const bench_sizes[] = { 4, 8 };
+#define BENCH_SIZES (sizeof(bench_sizes) / sizeof(*bench_sizes))
+
+static bool bench_parse_sizes(Bench *b, char const *str) {
+    b->sizes = 0;
+
+    for (char *end; *str; str = *end ? end + 1 : end) {
+        unsigned long const size = strtoul(str, &end, 10);
+        if (end == str || (*end && *end != ',')) return false;
+
+        unsigned i = 0;
+        for (; i < BENCH_SIZES && bench_sizes[i] != size; ++i);
+        if (i == BENCH_SIZES) return false;
+        b->sizes |= 1u << i;
+    }
+
+    return b->sizes;
+}
+
+static void bench_usage(char const *name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --format csv|json  Output format (default: csv).\n"
+            "  --ops LIST         Comma-separated list of workloads (default: all).\n"
+            "  --libs LIST        Comma-separated list of libraries (default: all).\n"
+            "  --sizes LIST       Comma-separated list of element sizes among 4, 8.\n"
+            "  --min-count N      Minimum number of elements (default: 16).\n"
+            "  --max-count N      Maximum number of elements (default: 100000000).\n"
+            "  --memory BYTES     Memory budget (default: half of the physical memory).\n"
+            "  --time-ms MS       Minimum duration of each measurement (default: 50).\n"
+            "  --perf             Collect hardware counters via perf_event_open, if available.\n"
+            "Workloads: push, iterate, search, sort.\n"
+            "Libraries:",
+            name);
+
+    for (unsigned lib = 0; lib < BENCH_LIBS; ++lib) {
+        if (bench_funcs_uint32_t[lib]) fprintf(stderr, " %s", bench_libs[lib]);
+    }
+
+    fprintf(stderr, " (as available at build time).\n");
+}
+
+int main(int argc, char *argv[]) {
+    Bench b = {
+        .format = BENCH_CSV,
+        .min_count = 16,
+        .max_count = 100000000,
+        .memory = bench_default_memory(),
+        .target_ns = BENCH_TARGET_NS,
+        .sizes = (1u << BENCH_SIZES) - 1,
+    };
+
+    bool perf = false;
+    bench_perf_init(&b.perf);
+
+    for (int i = 1; i < argc; ++i) {
+        char const *opt = argv[i], *arg = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = arg != NULL;
+        uint64_t ms;
+
+        if (!strcmp(opt, "--perf")) {
+            perf = true;
+            continue;
+        }
+
+        if (!strcmp(opt, "--format") && arg) {
+            if (!strcmp(arg, "csv")) b.format = BENCH_CSV;
+            else if (!strcmp(arg, "json")) b.format = BENCH_JSON;
+            else valid = false;
+        } else if (!strcmp(opt, "--ops") && arg) {
+            b.ops = arg;
+        } else if (!strcmp(opt, "--libs") && arg) {
+            b.backends = arg;
+        } else if (!strcmp(opt, "--sizes") && arg) {
+            valid = bench_parse_sizes(&b, arg);
+        } else if (!strcmp(opt, "--min-count") && arg) {
+            valid = bench_parse_uint(arg, &b.min_count);
+        } else if (!strcmp(opt, "--max-count") && arg) {
+            valid = bench_parse_uint(arg, &b.max_count);
+        } else if (!strcmp(opt, "--memory") && arg) {
+            valid = bench_parse_uint(arg, &b.memory);
+        } else if (!strcmp(opt, "--time-ms") && arg) {
+            if ((valid = bench_parse_uint(arg, &ms))) b.target_ns = ms * 1000000u;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            bench_usage(argv[0]);
+            return strcmp(opt, "--help") ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        ++i;
+    }
+
+    if (b.min_count > b.max_count) b.min_count = b.max_count;
+
+    if (perf && !bench_perf_open(&b.perf)) {
+        fprintf(stderr, "Hardware counters unavailable, reporting timing only.\n");
+    }
+
+    bench_begin(&b);
+
+    for (uint64_t count = b.min_count; count; count = bench_next_count(&b, count)) {
+        if (b.sizes & 1u) bench_compare_uint32_t(&b, count);
+        if (b.sizes & 2u) bench_compare_uint64_t(&b, count);
+    }
+
+    bench_end(&b);
+    bench_perf_close(&b.perf);
+    return EXIT_SUCCESS;
+}
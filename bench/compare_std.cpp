@@ -0,0 +1,62 @@
+/**
+ * std::vector baseline of the competitive benchmark.
+ *
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#include "bench_std.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+
+/**
+ * Implements the std::vector workloads for the specified type.
+ *
+ * @param T [symbol] Element type.
+ */
+#define BENCH_IMPL_STD(T)                                                                           \
+                                                                                                    \
+void *bench_std_new_##T(T const *items, size_t n) {                                                 \
+    try {                                                                                           \
+        return new std::vector<T>(items, items + n);                                                \
+    } catch (std::bad_alloc const &) {                                                              \
+        return NULL;                                                                                \
+    }                                                                                               \
+}                                                                                                   \
+                                                                                                    \
+void bench_std_delete_##T(void *v) {                                                                \
+    delete static_cast<std::vector<T> *>(v);                                                        \
+}                                                                                                   \
+                                                                                                    \
+void bench_std_assign_##T(void *v, T const *items, size_t n) {                                      \
+    static_cast<std::vector<T> *>(v)->assign(items, items + n);                                     \
+}                                                                                                   \
+                                                                                                    \
+uint64_t bench_std_push_##T(T const *items, size_t n) {                                             \
+    std::vector<T> vec;                                                                             \
+    for (size_t i = 0; i < n; ++i) vec.push_back(items[i]);                                         \
+    return vec.size();                                                                              \
+}                                                                                                   \
+                                                                                                    \
+uint64_t bench_std_iterate_##T(void const *v) {                                                     \
+    uint64_t acc = 0;                                                                               \
+    for (T item : *static_cast<std::vector<T> const *>(v)) acc += item;                             \
+    return acc;                                                                                     \
+}                                                                                                   \
+                                                                                                    \
+size_t bench_std_search_##T(void const *v, T item) {                                                \
+    std::vector<T> const &vec = *static_cast<std::vector<T> const *>(v);                            \
+    return (size_t)(std::find(vec.begin(), vec.end(), item) - vec.begin());                         \
+}                                                                                                   \
+                                                                                                    \
+void bench_std_sort_##T(void *v) {                                                                  \
+    std::vector<T> &vec = *static_cast<std::vector<T> *>(v);                                        \
+    std::sort(vec.begin(), vec.end());                                                              \
+}
+
+BENCH_IMPL_STD(uint32_t)
+BENCH_IMPL_STD(uint64_t)
@@ -53,13 +53,89 @@ typedef enum uvec_ret {
     UVEC_NO,
 
     /**
-     * The operation failed due to an error.
-     * As of right now, it can only happen if memory cannot be allocated.
+     * The operation failed due to an error, such as a failed memory allocation
+     * or, for I/O functions, a failed system call (errno is preserved).
      */
     UVEC_ERR,
 
 } uvec_ret;
 
+/**
+ * Per-type operation statistics, collected when UVEC_STATS is defined.
+ *
+ * @public @memberof UVec
+ */
+typedef struct UVecStats {
+
+    /// Number of storage reallocations.
+    uint64_t reallocs;
+
+    /// Bytes requested by storage reallocations.
+    uint64_t realloc_bytes;
+
+    /// Bytes moved by element insertions and removals.
+    uint64_t moved_bytes;
+
+    /// Comparisons performed by sorting and sorted search.
+    uint64_t comparisons;
+
+    /// Elements scanned by linear search.
+    uint64_t scanned;
+
+} UVecStats;
+
+/**
+ * Events reported to trace callbacks when UVEC_STATS is defined.
+ *
+ * @public @memberof UVec
+ */
+typedef enum uvec_stats_event {
+
+    /// Storage reallocation, the amount is the number of requested bytes.
+    UVEC_STATS_REALLOC,
+
+    /// Element insertion or removal, the amount is the number of moved bytes.
+    UVEC_STATS_MOVE,
+
+    /// Sorting or sorted search, the amount is the number of comparisons.
+    UVEC_STATS_COMPARE,
+
+    /// Linear search, the amount is the number of scanned elements.
+    UVEC_STATS_SCAN,
+
+} uvec_stats_event;
+
+/**
+ * Trace callback, invoked by instrumented operations when UVEC_STATS is defined.
+ *
+ * @param type [char const*] Vector type name.
+ * @param event [uvec_stats_event] Event.
+ * @param amount [uint64_t] Event amount.
+ * @param ctx [void*] User context.
+ *
+ * @public @memberof UVec
+ */
+typedef void (*uvec_stats_trace_func)(char const *type, uvec_stats_event event, uint64_t amount,
+                                      void *ctx);
+
+/**
+ * Memory usage of live vectors, reported when UVEC_REGISTRY is defined.
+ *
+ * @public @memberof UVec
+ */
+typedef struct UVecMemoryUsage {
+
+    /// Number of live vectors.
+    uint64_t vectors;
+
+    /// Bytes allocated for storage.
+    uint64_t allocated_bytes;
+
+    /// Bytes occupied by elements.
+    uint64_t used_bytes;
+
+} UVecMemoryUsage;
+
 // #############
 // # Constants #
 // #############
@@ -84,6 +160,17 @@ typedef enum uvec_ret {
 /// Quicksort stack size.
 #define P_UVEC_SORT_STACK_SIZE 64
 
+/**
+ * Invoked whenever uvec_sort swaps two elements. Can be defined before including
+ * the header in order to instrument sorting, e.g. to count swaps in benchmarks.
+ */
+#ifndef UVEC_SORT_SWAP_HOOK
+    #define UVEC_SORT_SWAP_HOOK() ((void)0)
+#endif
+
+/// Number of times a spinlock is polled before yielding the processor.
+#define P_UVEC_SPIN_LIMIT 64
+
 // ###############
 // # Private API #
 // ###############
@@ -92,6 +179,15 @@ typedef enum uvec_ret {
 #define P_UVEC_CONCAT(a, b) P_UVEC_CONCAT_INNER(a, b)
 #define P_UVEC_CONCAT_INNER(a, b) a##b
 
+/**
+ * Rounds the specified size up to a multiple of the cache line size.
+ *
+ * @param size [size_t] Size.
+ * @return [size_t] Rounded size.
+ */
+#define p_uvec_cache_align(size) \
+    (((size) + UVEC_CACHE_LINE_SIZE - 1) / UVEC_CACHE_LINE_SIZE * UVEC_CACHE_LINE_SIZE)
+
 /// Cross-platform 'inline' specifier.
 #ifndef p_uvec_inline
     #ifdef _MSC_VER
@@ -135,6 +231,732 @@ typedef enum uvec_ret {
     #define UVEC_FREE free
 #endif
 
+/// Atomic operations.
+#if defined __GNUC__ || defined __clang__
+    #define P_UVEC_HAS_ATOMICS 1
+    #define P_UVEC_ATOMIC(T) T
+    #define P_UVEC_MO_RELAXED __ATOMIC_RELAXED
+    #define P_UVEC_MO_ACQUIRE __ATOMIC_ACQUIRE
+    #define P_UVEC_MO_RELEASE __ATOMIC_RELEASE
+    #define P_UVEC_MO_ACQ_REL __ATOMIC_ACQ_REL
+    #define P_UVEC_MO_SEQ_CST __ATOMIC_SEQ_CST
+    #define p_uvec_atomic_init(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+    #define p_uvec_atomic_load(ptr, mo) __atomic_load_n(ptr, mo)
+    #define p_uvec_atomic_store(ptr, val, mo) __atomic_store_n(ptr, val, mo)
+    #define p_uvec_atomic_exchange(ptr, val, mo) __atomic_exchange_n(ptr, val, mo)
+    #define p_uvec_atomic_fetch_add(ptr, val, mo) __atomic_fetch_add(ptr, val, mo)
+    #define p_uvec_atomic_fetch_sub(ptr, val, mo) __atomic_fetch_sub(ptr, val, mo)
+    #define p_uvec_atomic_cas(ptr, exp_ptr, val, mo_succ, mo_fail) \
+        __atomic_compare_exchange_n(ptr, exp_ptr, val, false, mo_succ, mo_fail)
+    #define p_uvec_atomic_fence(mo) __atomic_thread_fence(mo)
+#elif defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L && !defined __STDC_NO_ATOMICS__
+    #include <stdatomic.h>
+    #define P_UVEC_HAS_ATOMICS 1
+    #define P_UVEC_ATOMIC(T) _Atomic(T)
+    #define P_UVEC_MO_RELAXED memory_order_relaxed
+    #define P_UVEC_MO_ACQUIRE memory_order_acquire
+    #define P_UVEC_MO_RELEASE memory_order_release
+    #define P_UVEC_MO_ACQ_REL memory_order_acq_rel
+    #define P_UVEC_MO_SEQ_CST memory_order_seq_cst
+    #define p_uvec_atomic_init(ptr, val) atomic_init(ptr, val)
+    #define p_uvec_atomic_load(ptr, mo) atomic_load_explicit(ptr, mo)
+    #define p_uvec_atomic_store(ptr, val, mo) atomic_store_explicit(ptr, val, mo)
+    #define p_uvec_atomic_exchange(ptr, val, mo) atomic_exchange_explicit(ptr, val, mo)
+    #define p_uvec_atomic_fetch_add(ptr, val, mo) atomic_fetch_add_explicit(ptr, val, mo)
+    #define p_uvec_atomic_fetch_sub(ptr, val, mo) atomic_fetch_sub_explicit(ptr, val, mo)
+    #define p_uvec_atomic_cas(ptr, exp_ptr, val, mo_succ, mo_fail) \
+        atomic_compare_exchange_strong_explicit(ptr, exp_ptr, val, mo_succ, mo_fail)
+    #define p_uvec_atomic_fence(mo) atomic_thread_fence(mo)
+#endif
+
+/// Thread-local storage specifier, if available.
+#if defined __GNUC__ || defined __clang__
+    #define P_UVEC_THREAD_LOCAL __thread
+#elif defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L && !defined __STDC_NO_THREADS__
+    #define P_UVEC_THREAD_LOCAL _Thread_local
+#endif
+
+/// Yields the processor, if supported by the platform.
+#if defined __unix__ || defined __APPLE__
+    #include <sched.h>
+    #define p_uvec_yield() ((void)sched_yield())
+#else
+    #define p_uvec_yield() ((void)0)
+#endif
+
+#ifdef P_UVEC_HAS_ATOMICS
+
+/**
+ * Acquires a spinlock.
+ *
+ * @param lock [P_UVEC_ATOMIC(bool)*] Lock.
+ */
+p_uvec_static_inline void p_uvec_spin_lock(P_UVEC_ATOMIC(bool) *lock) {
+    while (p_uvec_atomic_exchange(lock, true, P_UVEC_MO_ACQUIRE)) {
+        for (unsigned i = 1; p_uvec_atomic_load(lock, P_UVEC_MO_RELAXED); ++i) {
+            if (i % P_UVEC_SPIN_LIMIT == 0) p_uvec_yield();
+        }
+    }
+}
+
+/**
+ * Releases a spinlock.
+ *
+ * @param lock [P_UVEC_ATOMIC(bool)*] Lock.
+ */
+#define p_uvec_spin_unlock(lock) p_uvec_atomic_store(lock, false, P_UVEC_MO_RELEASE)
+
+#endif
+
+/**
+ * Copy-on-write support.
+ *
+ * When UVEC_COW is defined, vectors share their storage with their copies,
+ * and the actual copy is deferred until one of them is mutated. Storage must only be
+ * modified through the API, as writing to it directly bypasses this mechanism.
+ */
+#ifdef UVEC_COW
+
+    #ifndef P_UVEC_HAS_ATOMICS
+        #error "UVEC_COW requires atomic operations, which are not available on this compiler."
+    #endif
+
+    /// Reference count of shared storage.
+    typedef P_UVEC_ATOMIC(size_t) p_uvec_cow_refs;
+
+    /// Additional vector fields.
+    #define P_UVEC_COW_FIELDS p_uvec_cow_refs *refs;
+
+    /**
+     * Marks the storage referenced by 'refs' as shared by one more vector.
+     *
+     * @param refs [p_uvec_cow_refs **] Reference count of the storage.
+     * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+     */
+    p_uvec_static_inline uvec_ret p_uvec_cow_retain(p_uvec_cow_refs **refs) {
+        if (*refs) {
+            p_uvec_atomic_fetch_add(*refs, 1, P_UVEC_MO_RELAXED);
+        } else {
+            p_uvec_cow_refs *new_refs = UVEC_MALLOC(sizeof(*new_refs));
+            if (!new_refs) return UVEC_ERR;
+            p_uvec_atomic_init(new_refs, 2);
+            *refs = new_refs;
+        }
+        return UVEC_OK;
+    }
+
+    /**
+     * Gives up a reference to shared storage.
+     *
+     * @param refs [p_uvec_cow_refs **] Reference count of the storage, reset to NULL.
+     * @return [bool] True if the storage is not referenced anymore and must be freed.
+     */
+    p_uvec_static_inline bool p_uvec_cow_release_refs(p_uvec_cow_refs **refs) {
+        p_uvec_cow_refs *r = *refs;
+        if (!r) return true;
+        *refs = NULL;
+        if (p_uvec_atomic_fetch_sub(r, 1, P_UVEC_MO_ACQ_REL) != 1) return false;
+        UVEC_FREE(r);
+        return true;
+    }
+
+    /**
+     * Ensures the caller is the sole owner of the specified storage, copying it if needed.
+     *
+     * @param storage [void *] Storage.
+     * @param refs [p_uvec_cow_refs **] Reference count of the storage, reset to NULL on success.
+     * @param count [uvec_uint] Number of elements in the storage.
+     * @param allocated [uvec_uint] Number of allocated elements.
+     * @param size [size_t] Element size.
+     * @return [void *] Storage owned by the caller, or the original storage if memory
+     *                  could not be allocated, in which case 'refs' is left untouched.
+     */
+    p_uvec_static_inline void* p_uvec_cow_detach(void *storage, p_uvec_cow_refs **refs,
+                                                 uvec_uint count, uvec_uint allocated, size_t size) {
+        if (p_uvec_atomic_load(*refs, P_UVEC_MO_ACQUIRE) != 1) {
+            void *new_storage = UVEC_MALLOC(allocated * size);
+            if (!new_storage) return storage;
+            memcpy(new_storage, storage, count * size);
+            if (p_uvec_cow_release_refs(refs)) UVEC_FREE(storage);
+            return new_storage;
+        }
+
+        UVEC_FREE(*refs);
+        *refs = NULL;
+        return storage;
+    }
+
+    /**
+     * Ensures the storage of the specified vector is not shared, copying it if needed.
+     *
+     * @param vec [UVec(T)*] Vector instance.
+     * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+     */
+    #define p_uvec_cow_unshare(vec) (                                                               \
+        (vec)->refs ? (                                                                             \
+            (vec)->storage = p_uvec_cow_detach((vec)->storage, &(vec)->refs, (vec)->count,          \
+                                               (vec)->allocated, sizeof(*(vec)->storage)),          \
+            (vec)->refs ? UVEC_ERR : UVEC_OK                                                        \
+        ) : UVEC_OK                                                                                 \
+    )
+
+    /**
+     * Shares the storage of a vector with another, empty vector.
+     *
+     * @param vec [UVec(T) const*] Vector whose storage should be shared.
+     * @param copy [UVec(T)*] Empty vector.
+     * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the storage cannot be shared,
+     *                    otherwise UVEC_ERR.
+     */
+    #define p_uvec_cow_share(vec, copy) (                                                           \
+        !(vec)->count ? UVEC_NO :                                                                   \
+        p_uvec_cow_retain((p_uvec_cow_refs **)&(vec)->refs) ? UVEC_ERR : (                          \
+            (copy)->allocated = (vec)->allocated,                                                   \
+            (copy)->count = (vec)->count,                                                           \
+            (copy)->storage = (vec)->storage,                                                       \
+            (copy)->refs = (vec)->refs,                                                             \
+            UVEC_OK                                                                                 \
+        )                                                                                           \
+    )
+
+    /**
+     * Gives up the reference to the storage of the specified vector.
+     *
+     * @param vec [UVec(T)*] Vector instance.
+     * @return [bool] True if the storage is not referenced anymore and must be freed.
+     */
+    #define p_uvec_cow_release(vec) p_uvec_cow_release_refs(&(vec)->refs)
+
+    /**
+     * Checks whether the storage of the specified vector is shared.
+     *
+     * @param vec [UVec(T) const*] Vector instance.
+     * @return [bool] True if the storage is shared, false otherwise.
+     */
+    #define p_uvec_cow_is_shared(vec) ((vec)->refs != NULL)
+
+#else
+
+    #define P_UVEC_COW_FIELDS
+    #define p_uvec_cow_is_shared(vec) false
+    #define p_uvec_cow_unshare(vec) UVEC_OK
+    #define p_uvec_cow_share(vec, copy) UVEC_NO
+    #define p_uvec_cow_release(vec) true
+
+#endif
+
+/**
+ * Statistics support.
+ *
+ * When UVEC_STATS is defined, generated functions record reallocations, moved bytes,
+ * comparisons and scanned elements in per-type counters, and report them to an optional
+ * per-type trace callback. Each thread updates its own counters, which are linked in a
+ * per-type list so that they can be aggregated. Otherwise, instrumentation compiles to nothing.
+ */
+#ifdef UVEC_STATS
+
+    #ifndef P_UVEC_HAS_ATOMICS
+        #error "UVEC_STATS requires atomic operations, which are not available on this compiler."
+    #endif
+
+    /// Number of counters in UVecStats.
+    #define P_UVEC_STATS_COUNTERS 5
+
+    /// Counters of a thread (or of all threads, if thread-local storage is not available).
+    typedef struct p_uvec_stats_slot {
+        P_UVEC_ATOMIC(uint64_t) counters[P_UVEC_STATS_COUNTERS];
+        struct p_uvec_stats_slot *next;
+    } p_uvec_stats_slot;
+
+    /// Statistics of a vector type.
+    typedef struct p_uvec_stats_state {
+        P_UVEC_ATOMIC(p_uvec_stats_slot *) head;
+        uvec_stats_trace_func trace;
+        void *ctx;
+    } p_uvec_stats_state;
+
+    /**
+     * Returns the counters of the calling thread, registering them on first use.
+     *
+     * @param state [p_uvec_stats_state *] Statistics of the vector type.
+     * @param local [p_uvec_stats_slot **] Thread-local counters, or NULL if thread-local
+     *                                     storage is not available.
+     * @return [p_uvec_stats_slot *] Counters, or NULL if they could not be allocated.
+     */
+    p_uvec_static_inline p_uvec_stats_slot* p_uvec_stats_acquire(p_uvec_stats_state *state,
+                                                                 p_uvec_stats_slot **local) {
+        p_uvec_stats_slot *slot = local ? *local : p_uvec_atomic_load(&state->head,
+                                                                      P_UVEC_MO_ACQUIRE);
+        if (slot) return slot;
+
+        if (!(slot = UVEC_MALLOC(sizeof(*slot)))) return NULL;
+        for (unsigned i = 0; i < P_UVEC_STATS_COUNTERS; ++i) {
+            p_uvec_atomic_init(&slot->counters[i], 0);
+        }
+
+        p_uvec_stats_slot *head = p_uvec_atomic_load(&state->head, P_UVEC_MO_RELAXED);
+
+        do {
+            if (!local && head) {
+                UVEC_FREE(slot);
+                return head;
+            }
+            slot->next = head;
+        } while (!p_uvec_atomic_cas(&state->head, &head, slot,
+                                    P_UVEC_MO_RELEASE, P_UVEC_MO_RELAXED));
+
+        if (local) *local = slot;
+        return slot;
+    }
+
+    /**
+     * Adds the specified amount to a counter.
+     * With thread-local storage, counters only have one writer and are updated without
+     * read-modify-write operations.
+     *
+     * @param counter [P_UVEC_ATOMIC(uint64_t) *] Counter.
+     * @param amount [uint64_t] Amount.
+     */
+    #ifdef P_UVEC_THREAD_LOCAL
+        #define p_uvec_stats_bump(counter, amount)                                                  \
+            p_uvec_atomic_store(counter, p_uvec_atomic_load(counter, P_UVEC_MO_RELAXED) + (amount), \
+                                P_UVEC_MO_RELAXED)
+    #else
+        #define p_uvec_stats_bump(counter, amount)                                                  \
+            ((void)p_uvec_atomic_fetch_add(counter, amount, P_UVEC_MO_RELAXED))
+    #endif
+
+    /**
+     * Records an event.
+     *
+     * @param state [p_uvec_stats_state *] Statistics of the vector type.
+     * @param local [p_uvec_stats_slot **] Thread-local counters, or NULL.
+     * @param type [char const *] Vector type name.
+     * @param event [uvec_stats_event] Event.
+     * @param amount [uint64_t] Event amount.
+     */
+    p_uvec_static_inline void p_uvec_stats_record(p_uvec_stats_state *state,
+                                                  p_uvec_stats_slot **local, char const *type,
+                                                  uvec_stats_event event, uint64_t amount) {
+        p_uvec_stats_slot *slot = p_uvec_stats_acquire(state, local);
+
+        if (slot) {
+            if (event == UVEC_STATS_REALLOC) p_uvec_stats_bump(&slot->counters[0], 1);
+            p_uvec_stats_bump(&slot->counters[event + 1], amount);
+        }
+
+        if (state->trace) state->trace(type, event, amount, state->ctx);
+    }
+
+    /**
+     * Sums the specified counters.
+     *
+     * @param slot [p_uvec_stats_slot *] First counters.
+     * @param all [bool] If true, sums the counters of all the following slots as well.
+     * @return [UVecStats] Statistics.
+     */
+    p_uvec_static_inline UVecStats p_uvec_stats_sum(p_uvec_stats_slot *slot, bool all) {
+        uint64_t c[P_UVEC_STATS_COUNTERS] = { 0 };
+
+        for (; slot; slot = all ? slot->next : NULL) {
+            for (unsigned i = 0; i < P_UVEC_STATS_COUNTERS; ++i) {
+                c[i] += p_uvec_atomic_load(&slot->counters[i], P_UVEC_MO_RELAXED);
+            }
+        }
+
+        return (UVecStats) {
+            .reallocs = c[0], .realloc_bytes = c[1], .moved_bytes = c[2],
+            .comparisons = c[3], .scanned = c[4]
+        };
+    }
+
+    /// Thread-local counters of a vector type.
+    #ifdef P_UVEC_THREAD_LOCAL
+        #define P_UVEC_STATS_LOCAL_DEF(T) \
+            static P_UVEC_THREAD_LOCAL p_uvec_stats_slot *p_uvec_stats_local_##T;
+        #define p_uvec_stats_local(T) (&p_uvec_stats_local_##T)
+    #else
+        #define P_UVEC_STATS_LOCAL_DEF(T)
+        #define p_uvec_stats_local(T) NULL
+    #endif
+
+    /**
+     * Generates statistics function declarations for the specified vector type.
+     *
+     * @param T [symbol] Vector type.
+     * @param SCOPE [scope] Scope of the declarations.
+     */
+    #define P_UVEC_DECL_STATS(T, SCOPE)                                                             \
+        SCOPE UVecStats uvec_stats_snapshot_##T(void);                                              \
+        SCOPE UVecStats uvec_stats_local_##T(void);                                                 \
+        SCOPE void uvec_stats_set_trace_##T(uvec_stats_trace_func func, void *ctx);
+
+    /**
+     * Generates statistics function definitions for the specified vector type.
+     *
+     * @param T [symbol] Vector type.
+     * @param SCOPE [scope] Scope of the definitions.
+     */
+    #define P_UVEC_IMPL_STATS(T, SCOPE)                                                             \
+                                                                                                    \
+        static p_uvec_stats_state p_uvec_stats_##T;                                                 \
+        P_UVEC_STATS_LOCAL_DEF(T)                                                                   \
+                                                                                                    \
+        static inline void p_uvec_stats_record_##T(uvec_stats_event event, uint64_t amount) {       \
+            p_uvec_stats_record(&p_uvec_stats_##T, p_uvec_stats_local(T), #T, event, amount);       \
+        }                                                                                           \
+                                                                                                    \
+        SCOPE UVecStats uvec_stats_snapshot_##T(void) {                                             \
+            return p_uvec_stats_sum(p_uvec_atomic_load(&p_uvec_stats_##T.head, P_UVEC_MO_ACQUIRE),  \
+                                    true);                                                          \
+        }                                                                                           \
+                                                                                                    \
+        SCOPE UVecStats uvec_stats_local_##T(void) {                                                \
+            p_uvec_stats_slot **local = p_uvec_stats_local(T);                                      \
+            if (!local) return uvec_stats_snapshot_##T();                                           \
+            return p_uvec_stats_sum(*local, false);                                                 \
+        }                                                                                           \
+                                                                                                    \
+        SCOPE void uvec_stats_set_trace_##T(uvec_stats_trace_func func, void *ctx) {                \
+            p_uvec_stats_##T.ctx = ctx;                                                             \
+            p_uvec_stats_##T.trace = func;                                                          \
+        }
+
+    /**
+     * Records an event for the specified vector type.
+     *
+     * @param T [symbol] Vector type.
+     * @param event [uvec_stats_event] Event.
+     * @param amount [uint64_t] Event amount.
+     */
+    #define p_uvec_stats(T, event, amount) P_UVEC_CONCAT(p_uvec_stats_record_, T)(event, amount)
+
+    /**
+     * Declares a local event counter.
+     *
+     * @param name [symbol] Counter name.
+     */
+    #define p_uvec_stats_counter(name) uint64_t name = 0
+
+    /**
+     * Increments a local event counter, then evaluates an expression.
+     *
+     * @param name [symbol] Counter name.
+     * @param exp [expression] Expression.
+     * @return Value of the expression.
+     */
+    #define p_uvec_stats_count(name, exp) (++(name), (exp))
+
+#else
+
+    #define P_UVEC_DECL_STATS(T, SCOPE)
+    #define P_UVEC_IMPL_STATS(T, SCOPE)
+    #define p_uvec_stats(T, event, amount) ((void)0)
+    #define p_uvec_stats_counter(name) ((void)0)
+    #define p_uvec_stats_count(name, exp) (exp)
+
+#endif
+
+/**
+ * Registry support.
+ *
+ * When UVEC_REGISTRY is defined, live vectors are tracked by address in a process-wide registry,
+ * from uvec_alloc (or their first growth, for vectors initialized via uvec_init) to uvec_free
+ * (or uvec_deinit), so that their memory usage can be inspected and reclaimed.
+ * Otherwise, tracking compiles to nothing.
+ */
+#ifdef UVEC_REGISTRY
+
+    #ifndef P_UVEC_HAS_ATOMICS
+        #error "UVEC_REGISTRY requires atomic operations, which are not available on this compiler."
+    #endif
+
+    #include <stdio.h>
+
+    /// Minimum number of registry slots.
+    #define P_UVEC_REGISTRY_MIN_SLOTS 64
+
+    /// Number of vectors listed by uvec_memory_report as the largest wasters.
+    #define P_UVEC_REGISTRY_TOP 10
+
+    /// Number of capacity histogram buckets.
+    #define P_UVEC_REGISTRY_BUCKETS (sizeof(uvec_uint) * 8 + 1)
+
+    /// Memory usage of a registered vector.
+    typedef struct p_uvec_registry_info {
+        uvec_uint allocated;
+        uvec_uint count;
+        bool shared;
+    } p_uvec_registry_info;
+
+    /// Vector type descriptor.
+    typedef struct p_uvec_registry_type {
+        char const *name;
+        size_t size;
+        p_uvec_registry_info (*info)(void const *vec);
+        uvec_ret (*shrink)(void *vec);
+    } p_uvec_registry_type;
+
+    /// Registry entry.
+    typedef struct p_uvec_registry_entry {
+        void const *vec;
+        p_uvec_registry_type const *type;
+        uint64_t epoch;
+        bool owned;
+    } p_uvec_registry_entry;
+
+    /// Registry of live vectors: an open addressing hash table, protected by a spinlock.
+    typedef struct p_uvec_registry {
+        P_UVEC_ATOMIC(bool) lock;
+        size_t count;
+        size_t used;
+        size_t capacity;
+        uint64_t epoch;
+        p_uvec_registry_entry *entries;
+    } p_uvec_registry;
+
+    /// Process-wide registry, shared across translation units if weak symbols are supported.
+    #if defined __GNUC__ || defined __clang__
+        __attribute__((weak)) p_uvec_registry p_uvec_registry_global;
+    #else
+        static p_uvec_registry p_uvec_registry_global;
+    #endif
+
+    /// Marker of removed registry entries.
+    #define P_UVEC_REGISTRY_REMOVED ((void const *)&p_uvec_registry_global)
+
+    /**
+     * Checks whether the specified registry entry holds a vector.
+     *
+     * @param e [p_uvec_registry_entry const *] Entry.
+     * @return [bool] True if the entry holds a vector, false otherwise.
+     */
+    #define p_uvec_registry_is_live(e) ((e)->vec && (e)->vec != P_UVEC_REGISTRY_REMOVED)
+
+    /**
+     * Checks whether the specified registry entry holds a vector that can be inspected
+     * and shrunk, i.e. one that is not owned by a library container.
+     *
+     * @param e [p_uvec_registry_entry const *] Entry.
+     * @return [bool] True if the entry holds a tracked vector, false otherwise.
+     */
+    #define p_uvec_registry_is_tracked(e) (p_uvec_registry_is_live(e) && !(e)->owned)
+
+    /**
+     * Returns the entry of the specified vector, or the entry it should be stored in.
+     *
+     * @param r [p_uvec_registry *] Registry, which must have at least one empty entry.
+     * @param vec [void const *] Vector.
+     * @return [p_uvec_registry_entry *] Entry.
+     */
+    p_uvec_static_inline p_uvec_registry_entry* p_uvec_registry_find(p_uvec_registry *r,
+                                                                     void const *vec) {
+        size_t mask = r->capacity - 1;
+        size_t i = (size_t)(((uint64_t)(uintptr_t)vec * 0x9E3779B97F4A7C15ull) >> 32u) & mask;
+        p_uvec_registry_entry *removed = NULL;
+
+        for (;; i = (i + 1) & mask) {
+            p_uvec_registry_entry *e = &r->entries[i];
+            if (e->vec == vec) return e;
+            if (!e->vec) return removed ? removed : e;
+            if (!removed && e->vec == P_UVEC_REGISTRY_REMOVED) removed = e;
+        }
+    }
+
+    /**
+     * Ensures the registry can store one more vector, rehashing it if needed.
+     *
+     * @param r [p_uvec_registry *] Registry.
+     * @return [bool] True on success, false if memory could not be allocated.
+     */
+    p_uvec_static_inline bool p_uvec_registry_reserve(p_uvec_registry *r) {
+        if ((r->used + 1) * 4 <= r->capacity * 3) return true;
+
+        size_t capacity = P_UVEC_REGISTRY_MIN_SLOTS;
+        while (capacity * 3 < (r->count + 1) * 8) capacity *= 2;
+
+        p_uvec_registry_entry *entries = UVEC_MALLOC(capacity * sizeof(*entries));
+        if (!entries) return false;
+        memset(entries, 0, capacity * sizeof(*entries));
+
+        p_uvec_registry_entry *old_entries = r->entries;
+        size_t old_capacity = r->capacity;
+        r->entries = entries;
+        r->capacity = capacity;
+        r->used = r->count;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            p_uvec_registry_entry *e = &old_entries[i];
+            if (p_uvec_registry_is_live(e)) *p_uvec_registry_find(r, e->vec) = *e;
+        }
+
+        UVEC_FREE(old_entries);
+        return true;
+    }
+
+    /**
+     * Returns the entry of the specified vector, adding it to the registry if needed.
+     *
+     * @param r [p_uvec_registry *] Registry.
+     * @param vec [void const *] Vector.
+     * @return [p_uvec_registry_entry *] Entry, or NULL if memory could not be allocated.
+     */
+    p_uvec_static_inline p_uvec_registry_entry* p_uvec_registry_add(p_uvec_registry *r,
+                                                                    void const *vec) {
+        p_uvec_registry_entry *e = r->entries ? p_uvec_registry_find(r, vec) : NULL;
+        if (e && e->vec == vec) return e;
+        if (!p_uvec_registry_reserve(r)) return NULL;
+
+        e = p_uvec_registry_find(r, vec);
+        if (!e->vec) r->used++;
+        r->count++;
+        *e = (p_uvec_registry_entry) { .vec = vec, .type = NULL, .epoch = r->epoch };
+        return e;
+    }
+
+    /**
+     * Registers a vector, or marks it as active if it is already registered.
+     * Vectors that cannot be registered due to memory exhaustion are not tracked.
+     *
+     * @param type [p_uvec_registry_type const *] Vector type.
+     * @param vec [void const *] Vector.
+     */
+    p_uvec_static_inline void p_uvec_registry_insert(p_uvec_registry_type const *type,
+                                                     void const *vec) {
+        p_uvec_registry *r = &p_uvec_registry_global;
+        p_uvec_spin_lock(&r->lock);
+
+        p_uvec_registry_entry *e = p_uvec_registry_add(r, vec);
+
+        if (e) {
+            e->type = type;
+            e->epoch = r->epoch;
+        }
+
+        p_uvec_spin_unlock(&r->lock);
+    }
+
+    /**
+     * Marks a vector as owned by a library container, which synchronizes accesses to it
+     * on its own: the vector stays registered until de-initialized or freed, but it is
+     * neither inspected nor shrunk.
+     *
+     * @param vec [void const *] Vector.
+     * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+     */
+    p_uvec_static_inline uvec_ret p_uvec_registry_own(void const *vec) {
+        p_uvec_registry *r = &p_uvec_registry_global;
+        p_uvec_spin_lock(&r->lock);
+
+        p_uvec_registry_entry *e = p_uvec_registry_add(r, vec);
+        if (e) e->owned = true;
+
+        p_uvec_spin_unlock(&r->lock);
+        return e ? UVEC_OK : UVEC_ERR;
+    }
+
+    /**
+     * Unregisters a vector.
+     *
+     * @param vec [void const *] Vector.
+     */
+    p_uvec_static_inline void p_uvec_registry_remove(void const *vec) {
+        p_uvec_registry *r = &p_uvec_registry_global;
+        p_uvec_spin_lock(&r->lock);
+
+        if (r->entries) {
+            p_uvec_registry_entry *e = p_uvec_registry_find(r, vec);
+
+            if (e->vec == vec) {
+                e->vec = P_UVEC_REGISTRY_REMOVED;
+
+                if (!--r->count) {
+                    UVEC_FREE(r->entries);
+                    r->entries = NULL;
+                    r->capacity = r->used = 0;
+                }
+            }
+        }
+
+        p_uvec_spin_unlock(&r->lock);
+    }
+
+    /// Registered vector, as listed by uvec_memory_report.
+    typedef struct p_uvec_registry_item {
+        void const *vec;
+        p_uvec_registry_type const *type;
+        p_uvec_registry_info info;
+        bool idle;
+    } p_uvec_registry_item;
+
+    /// Memory usage of a vector type, as listed by uvec_memory_report.
+    typedef struct p_uvec_registry_summary {
+        char const *name;
+        UVecMemoryUsage usage;
+        uint64_t buckets[P_UVEC_REGISTRY_BUCKETS];
+    } p_uvec_registry_summary;
+
+    /**
+     * Returns the unused capacity of a registered vector.
+     *
+     * @param item [p_uvec_registry_item const *] Vector.
+     * @return [uint64_t] Unused capacity (B).
+     */
+    #define p_uvec_registry_unused(item) \
+        ((uint64_t)((item)->info.allocated - (item)->info.count) * (item)->type->size)
+
+    /**
+     * Returns the fraction of unused capacity, as a percentage.
+     *
+     * @param u [UVecMemoryUsage] Memory usage.
+     * @return [double] Percentage of unused capacity.
+     */
+    #define p_uvec_registry_unused_pct(u) \
+        ((u).allocated_bytes ? 100.0 * (double)((u).allocated_bytes - (u).used_bytes) /           \
+                               (double)(u).allocated_bytes : 0.0)
+
+    /**
+     * Generates the registry descriptor of the specified vector type.
+     *
+     * @param T [symbol] Vector type.
+     * @param SCOPE [scope] Scope of the vector functions.
+     */
+    #define P_UVEC_IMPL_REGISTRY(T, SCOPE)                                                          \
+                                                                                                    \
+        SCOPE uvec_ret uvec_shrink_##T(UVec_##T *vec);                                              \
+                                                                                                    \
+        static p_uvec_registry_info p_uvec_registry_info_##T(void const *vec) {                     \
+            UVec_##T const *v = vec;                                                                \
+            return (p_uvec_registry_info) {                                                         \
+                .allocated = v->allocated, .count = v->count, .shared = p_uvec_cow_is_shared(v)     \
+            };                                                                                      \
+        }                                                                                           \
+                                                                                                    \
+        static uvec_ret p_uvec_registry_shrink_##T(void *vec) {                                     \
+            return uvec_shrink_##T(vec);                                                            \
+        }                                                                                           \
+                                                                                                    \
+        static p_uvec_registry_type const p_uvec_registry_type_##T = {                              \
+            #T, sizeof(T), p_uvec_registry_info_##T, p_uvec_registry_shrink_##T                     \
+        };
+
+    /**
+     * Registers a vector of the specified type, or marks it as active.
+     *
+     * @param T [symbol] Vector type.
+     * @param vec [UVec(T) const*] Vector instance.
+     */
+    #define p_uvec_registry_track(T, vec) p_uvec_registry_insert(&p_uvec_registry_type_##T, vec)
+
+#else
+
+    #define P_UVEC_IMPL_REGISTRY(T, SCOPE)
+    #define p_uvec_registry_track(T, vec) ((void)0)
+    #define p_uvec_registry_own(vec) UVEC_OK
+    #define p_uvec_registry_remove(vec) ((void)0)
+
+#endif
+
 /**
  * Changes the specified unsigned integer into the next power of two.
  *
@@ -160,6 +982,22 @@ typedef enum uvec_ret {
     )
 #endif
 
+/**
+ * Returns the base 2 logarithm of the specified unsigned integer, rounded down.
+ *
+ * @param x [uvec_uint] Unsigned integer (must be greater than zero).
+ * @return [unsigned] Logarithm.
+ */
+#if defined __GNUC__ || defined __clang__
+    #define p_uvec_uint_log2(x) ((unsigned)(63 - __builtin_clzll((unsigned long long)(x))))
+#else
+    p_uvec_static_inline unsigned p_uvec_uint_log2(uvec_uint x) {
+        unsigned log = 0;
+        while (x >>= 1) ++log;
+        return log;
+    }
+#endif
+
 /**
  * Identity macro.
  *
@@ -189,6 +1027,7 @@ typedef enum uvec_ret {
         uvec_uint allocated;                                                                        \
         uvec_uint count;                                                                            \
         T *storage;                                                                                 \
+        P_UVEC_COW_FIELDS                                                                           \
         /** @endcond */                                                                             \
     } UVec_##T;
 
@@ -214,6 +1053,7 @@ typedef enum uvec_ret {
     SCOPE uvec_ret uvec_insert_at_##T(UVec_##T *vec, uvec_uint idx, T item);                        \
     SCOPE void uvec_remove_all_##T(UVec_##T *vec);                                                  \
     SCOPE void uvec_reverse_##T(UVec_##T *vec);                                                     \
+    P_UVEC_DECL_STATS(T, SCOPE)                                                                     \
     /** @endcond */
 
 /**
@@ -248,6 +1088,10 @@ typedef enum uvec_ret {
     SCOPE uvec_uint uvec_index_of_sorted_##T(UVec_##T const *vec, T item);                          \
     SCOPE uvec_ret uvec_insert_sorted_##T(UVec_##T *vec, T item, uvec_uint *idx);                   \
     SCOPE uvec_ret uvec_insert_sorted_unique_##T(UVec_##T *vec, T item, uvec_uint *idx);            \
+    SCOPE uvec_ret uvec_merge_sorted_k_##T(UVec_##T *dst, UVec_##T * const *runs, unsigned k);      \
+    SCOPE void p_uvec_merge_k_##T(T *out, T const **heads, T const **ends, unsigned k,              \
+                                  unsigned *tree);                                                  \
+    SCOPE bool p_uvec_compare_##T(T lhs, T rhs);                                                    \
     /** @endcond */
 
 /**
@@ -258,6 +1102,9 @@ typedef enum uvec_ret {
  */
 #define P_UVEC_IMPL(T, SCOPE)                                                                       \
                                                                                                     \
+    P_UVEC_IMPL_STATS(T, SCOPE)                                                                     \
+    P_UVEC_IMPL_REGISTRY(T, SCOPE)                                                                  \
+                                                                                                    \
     static inline uvec_ret uvec_expand_if_required_##T(UVec_##T *vec) {                             \
         if (vec->count < vec->allocated) return UVEC_OK;                                            \
                                                                                                     \
@@ -265,32 +1112,41 @@ typedef enum uvec_ret {
                                                                                                     \
         T* new_storage = UVEC_REALLOC(vec->storage, sizeof(T) * new_allocated);                     \
         if (!new_storage) return UVEC_ERR;                                                          \
+        p_uvec_stats(T, UVEC_STATS_REALLOC, sizeof(T) * new_allocated);                             \
                                                                                                     \
         vec->allocated = new_allocated;                                                             \
         vec->storage = new_storage;                                                                 \
+        p_uvec_registry_track(T, vec);                                                              \
                                                                                                     \
         return UVEC_OK;                                                                             \
     }                                                                                               \
                                                                                                     \
     SCOPE UVec_##T* uvec_alloc_##T(void) {                                                          \
         UVec_##T *vec = UVEC_MALLOC(sizeof(*vec));                                                  \
-        if (vec) *vec = (UVec_##T) { .allocated = 0, .count = 0, .storage = NULL };                 \
+        if (vec) {                                                                                  \
+            *vec = (UVec_##T) { .allocated = 0, .count = 0, .storage = NULL };                      \
+            p_uvec_registry_track(T, vec);                                                          \
+        }                                                                                           \
         return vec;                                                                                 \
     }                                                                                               \
                                                                                                     \
     SCOPE void uvec_free_##T(UVec_##T *vec) {                                                       \
         if (!vec) return;                                                                           \
-        if (vec->allocated) UVEC_FREE(vec->storage);                                                \
+        p_uvec_registry_remove(vec);                                                                \
+        if (vec->allocated && p_uvec_cow_release(vec)) UVEC_FREE(vec->storage);                     \
         UVEC_FREE(vec);                                                                             \
     }                                                                                               \
                                                                                                     \
     SCOPE uvec_ret uvec_reserve_capacity_##T(UVec_##T *vec, uvec_uint capacity) {                   \
         if (vec->allocated < capacity) {                                                            \
+            if (p_uvec_cow_unshare(vec)) return UVEC_ERR;                                           \
             p_uvec_uint_next_power_2(capacity);                                                     \
             T* new_storage = UVEC_REALLOC(vec->storage, sizeof(T) * capacity);                      \
             if (!new_storage) return UVEC_ERR;                                                      \
+            p_uvec_stats(T, UVEC_STATS_REALLOC, sizeof(T) * capacity);                              \
             vec->allocated = capacity;                                                              \
             vec->storage = new_storage;                                                             \
+            p_uvec_registry_track(T, vec);                                                          \
         }                                                                                           \
         return UVEC_OK;                                                                             \
     }                                                                                               \
@@ -301,7 +1157,7 @@ typedef enum uvec_ret {
         uvec_uint old_count = vec->count;                                                           \
         uvec_uint new_count = old_count + n;                                                        \
                                                                                                     \
-        if (uvec_reserve_capacity_##T(vec, new_count)) return UVEC_ERR;                             \
+        if (p_uvec_cow_unshare(vec) || uvec_reserve_capacity_##T(vec, new_count)) return UVEC_ERR;  \
                                                                                                     \
         vec->count = new_count;                                                                     \
         memcpy(&(vec->storage[old_count]), array, n * sizeof(T));                                   \
@@ -311,8 +1167,12 @@ typedef enum uvec_ret {
                                                                                                     \
     SCOPE UVec_##T* uvec_copy_##T(UVec_##T const *vec) {                                            \
         UVec_##T* copy = uvec_alloc_##T();                                                          \
+        if (!copy) return NULL;                                                                     \
+                                                                                                    \
+        uvec_ret ret = p_uvec_cow_share(vec, copy);                                                 \
+        if (ret == UVEC_NO) ret = uvec_append_array_##T(copy, vec->storage, vec->count);            \
                                                                                                     \
-        if (copy && uvec_append_array_##T(copy, vec->storage, vec->count)) {                        \
+        if (ret) {                                                                                  \
             uvec_free_##T(copy);                                                                    \
             copy = NULL;                                                                            \
         }                                                                                           \
@@ -349,14 +1209,17 @@ typedef enum uvec_ret {
             p_uvec_uint_next_power_2(new_allocated);                                                \
                                                                                                     \
             if (new_allocated < vec->allocated) {                                                   \
+                if (p_uvec_cow_unshare(vec)) return UVEC_ERR;                                       \
                 T* new_storage = UVEC_REALLOC(vec->storage, sizeof(T) * new_allocated);             \
                 if (!new_storage) return UVEC_ERR;                                                  \
+                p_uvec_stats(T, UVEC_STATS_REALLOC, sizeof(T) * new_allocated);                     \
                                                                                                     \
                 vec->allocated = new_allocated;                                                     \
                 vec->storage = new_storage;                                                         \
             }                                                                                       \
-        } else {                                                                                    \
-            UVEC_FREE(vec->storage);                                                                \
+        } else if (vec->allocated) {                                                                \
+            if (p_uvec_cow_release(vec)) UVEC_FREE(vec->storage);                                   \
+            vec->storage = NULL;                                                                    \
             vec->allocated = 0;                                                                     \
         }                                                                                           \
                                                                                                     \
@@ -364,7 +1227,7 @@ typedef enum uvec_ret {
     }                                                                                               \
                                                                                                     \
     SCOPE uvec_ret uvec_push_##T(UVec_##T *vec, T item) {                                           \
-        if (uvec_expand_if_required_##T(vec)) return UVEC_ERR;                                      \
+        if (p_uvec_cow_unshare(vec) || uvec_expand_if_required_##T(vec)) return UVEC_ERR;           \
         vec->storage[vec->count++] = item;                                                          \
         return UVEC_OK;                                                                             \
     }                                                                                               \
@@ -378,8 +1241,10 @@ typedef enum uvec_ret {
         T item = vec->storage[idx];                                                                 \
                                                                                                     \
         if (idx < count - 1) {                                                                      \
+            if (p_uvec_cow_unshare(vec)) return item;                                               \
             size_t block_size = (count - idx - 1) * sizeof(T);                                      \
             memmove(&(vec->storage[idx]), &(vec->storage[idx + 1]), block_size);                    \
+            p_uvec_stats(T, UVEC_STATS_MOVE, block_size);                                           \
         }                                                                                           \
                                                                                                     \
         vec->count--;                                                                               \
@@ -387,11 +1252,12 @@ typedef enum uvec_ret {
     }                                                                                               \
                                                                                                     \
     SCOPE uvec_ret uvec_insert_at_##T(UVec_##T *vec, uvec_uint idx, T item) {                       \
-        if (uvec_expand_if_required_##T(vec)) return UVEC_ERR;                                      \
+        if (p_uvec_cow_unshare(vec) || uvec_expand_if_required_##T(vec)) return UVEC_ERR;           \
                                                                                                     \
         if (idx < vec->count) {                                                                     \
             size_t block_size = (vec->count - idx) * sizeof(T);                                     \
             memmove(&(vec->storage[idx + 1]), &(vec->storage[idx]), block_size);                    \
+            p_uvec_stats(T, UVEC_STATS_MOVE, block_size);                                           \
         }                                                                                           \
                                                                                                     \
         vec->storage[idx] = item;                                                                   \
@@ -405,6 +1271,7 @@ typedef enum uvec_ret {
     }                                                                                               \
                                                                                                     \
     SCOPE void uvec_reverse_##T(UVec_##T *vec) {                                                    \
+        if (p_uvec_cow_unshare(vec)) return;                                                        \
         uvec_uint count = vec->count;                                                               \
                                                                                                     \
         for (uvec_uint i = 0; i < count / 2; ++i) {                                                 \
@@ -427,15 +1294,23 @@ typedef enum uvec_ret {
                                                                                                     \
     SCOPE uvec_uint uvec_index_of_##T(UVec_##T const *vec, T item) {                                \
         for (uvec_uint i = 0; i < vec->count; ++i) {                                                \
-            if (equal_func(vec->storage[i], item)) return i;                                        \
+            if (equal_func(vec->storage[i], item)) {                                                \
+                p_uvec_stats(T, UVEC_STATS_SCAN, i + 1);                                            \
+                return i;                                                                           \
+            }                                                                                       \
         }                                                                                           \
+        p_uvec_stats(T, UVEC_STATS_SCAN, vec->count);                                               \
         return UVEC_INDEX_NOT_FOUND;                                                                \
     }                                                                                               \
                                                                                                     \
     SCOPE uvec_uint uvec_index_of_reverse_##T(UVec_##T const *vec, T item) {                        \
         for (uvec_uint i = vec->count; i-- != 0;) {                                                 \
-            if (equal_func(vec->storage[i], item)) return i;                                        \
+            if (equal_func(vec->storage[i], item)) {                                                \
+                p_uvec_stats(T, UVEC_STATS_SCAN, vec->count - i);                                   \
+                return i;                                                                           \
+            }                                                                                       \
         }                                                                                           \
+        p_uvec_stats(T, UVEC_STATS_SCAN, vec->count);                                               \
         return UVEC_INDEX_NOT_FOUND;                                                                \
     }                                                                                               \
                                                                                                     \
@@ -501,6 +1376,10 @@ typedef enum uvec_ret {
  */
 #define P_UVEC_IMPL_COMPARABLE(T, SCOPE, equal_func, compare_func)                                  \
                                                                                                     \
+    SCOPE bool p_uvec_compare_##T(T lhs, T rhs) {                                                   \
+        return compare_func(lhs, rhs);                                                              \
+    }                                                                                               \
+                                                                                                    \
     SCOPE uvec_uint uvec_index_of_min_##T(UVec_##T const *vec) {                                    \
         if (!vec->count) return UVEC_INDEX_NOT_FOUND;                                               \
                                                                                                     \
@@ -526,9 +1405,11 @@ typedef enum uvec_ret {
     }                                                                                               \
                                                                                                     \
     SCOPE void uvec_sort_range_##T(UVec_##T *vec, uvec_uint start, uvec_uint len) {                 \
+        if (p_uvec_cow_unshare(vec)) return;                                                        \
         T *array = vec->storage + start;                                                            \
         start = 0;                                                                                  \
         uvec_uint pos = 0, seed = 31, stack[P_UVEC_SORT_STACK_SIZE];                                \
+        p_uvec_stats_counter(comparisons);                                                          \
                                                                                                     \
         while (true) {                                                                              \
             for (; start + 1 < len; ++len) {                                                        \
@@ -540,10 +1421,13 @@ typedef enum uvec_ret {
                                                                                                     \
                 for (uvec_uint right = start - 1;;) {                                               \
                     p_uvec_analyzer_assert(false);                                                  \
-                    for (++right; compare_func(array[right], pivot); ++right);                      \
-                    for (--len; compare_func(pivot, array[len]); --len);                            \
+                    for (++right; p_uvec_stats_count(comparisons,                                   \
+                                                     compare_func(array[right], pivot)); ++right);  \
+                    for (--len; p_uvec_stats_count(comparisons,                                     \
+                                                   compare_func(pivot, array[len])); --len);        \
                     if (right >= len) break;                                                        \
                                                                                                     \
+                    UVEC_SORT_SWAP_HOOK();                                                          \
                     T temp = array[right];                                                          \
                     array[right] = array[len];                                                      \
                     array[len] = temp;                                                              \
@@ -554,24 +1438,28 @@ typedef enum uvec_ret {
             start = len;                                                                            \
             len = stack[--pos];                                                                     \
         }                                                                                           \
+                                                                                                    \
+        p_uvec_stats(T, UVEC_STATS_COMPARE, comparisons);                                           \
     }                                                                                               \
                                                                                                     \
     SCOPE uvec_uint uvec_insertion_index_sorted_##T(UVec_##T const *vec, T item) {                  \
         T const *array = vec->storage;                                                              \
         uvec_uint const linear_search_thresh = UVEC_CACHE_LINE_SIZE / sizeof(T);                    \
         uvec_uint r = vec->count, l = 0;                                                            \
+        p_uvec_stats_counter(comparisons);                                                          \
                                                                                                     \
         while (r - l > linear_search_thresh) {                                                      \
             uvec_uint m = l + (r - l) / 2;                                                          \
                                                                                                     \
-            if (compare_func(array[m], item)) {                                                     \
+            if (p_uvec_stats_count(comparisons, compare_func(array[m], item))) {                    \
                 l = m + 1;                                                                          \
             } else {                                                                                \
                 r = m;                                                                              \
             }                                                                                       \
         }                                                                                           \
                                                                                                     \
-        for (; l < r && compare_func(array[l], item); ++l);                                         \
+        for (; l < r && p_uvec_stats_count(comparisons, compare_func(array[l], item)); ++l);        \
+        p_uvec_stats(T, UVEC_STATS_COMPARE, comparisons);                                           \
         return l;                                                                                   \
     }                                                                                               \
                                                                                                     \
@@ -594,6 +1482,66 @@ typedef enum uvec_ret {
         } else {                                                                                    \
             return UVEC_NO;                                                                         \
         }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool p_uvec_merge_beats_##T(T const **heads, T const **ends,                      \
+                                              unsigned a, unsigned b) {                             \
+        if (heads[a] == ends[a]) return false;                                                      \
+        if (heads[b] == ends[b]) return true;                                                       \
+        return a < b ? !compare_func(*heads[b], *heads[a]) : compare_func(*heads[a], *heads[b]);    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void p_uvec_merge_k_##T(T *out, T const **heads, T const **ends, unsigned k,              \
+                                  unsigned *tree) {                                                 \
+        unsigned *winners = tree + k;                                                               \
+        for (unsigned i = 0; i < k; ++i) winners[k + i] = i;                                        \
+                                                                                                    \
+        for (unsigned n = k - 1; n > 0; --n) {                                                      \
+            unsigned l = winners[2 * n], r = winners[2 * n + 1];                                    \
+            bool left = p_uvec_merge_beats_##T(heads, ends, l, r);                                  \
+            tree[n] = left ? r : l;                                                                 \
+            winners[n] = left ? l : r;                                                              \
+        }                                                                                           \
+                                                                                                    \
+        unsigned w = k > 1 ? winners[1] : 0;                                                        \
+                                                                                                    \
+        while (heads[w] != ends[w]) {                                                               \
+            *out++ = *heads[w]++;                                                                   \
+                                                                                                    \
+            for (unsigned n = (k + w) / 2; n > 0; n /= 2) {                                         \
+                if (p_uvec_merge_beats_##T(heads, ends, tree[n], w)) {                              \
+                    unsigned loser = w;                                                             \
+                    w = tree[n];                                                                    \
+                    tree[n] = loser;                                                                \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_merge_sorted_k_##T(UVec_##T *dst, UVec_##T * const *runs, unsigned k) {     \
+        uvec_uint total = 0;                                                                        \
+        for (unsigned i = 0; i < k; ++i) total += runs[i]->count;                                   \
+                                                                                                    \
+        if (!total) return UVEC_OK;                                                                 \
+        if (p_uvec_cow_unshare(dst) || uvec_reserve_capacity_##T(dst, dst->count + total)) {        \
+            return UVEC_ERR;                                                                        \
+        }                                                                                           \
+                                                                                                    \
+        T const **heads = UVEC_MALLOC(k * (2 * sizeof(*heads) + 3 * sizeof(unsigned)));             \
+        if (!heads) return UVEC_ERR;                                                                \
+                                                                                                    \
+        T const **ends = heads + k;                                                                 \
+        unsigned *tree = (unsigned *)(ends + k);                                                    \
+                                                                                                    \
+        for (unsigned i = 0; i < k; ++i) {                                                          \
+            heads[i] = ends[i] = runs[i]->storage;                                                  \
+            if (runs[i]->count) ends[i] += runs[i]->count;                                          \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_merge_k_##T(dst->storage + dst->count, heads, ends, k, tree);                        \
+        dst->count += total;                                                                        \
+        UVEC_FREE(heads);                                                                           \
+        return UVEC_OK;                                                                             \
     }
 
 // ##############
@@ -831,6 +1779,10 @@ typedef enum uvec_ret {
  * @param vec [UVec(T)*] Vector to copy.
  * @return [UVec(T)*] Copied vector instance, or NULL on error.
  *
+ * @note In copy-on-write mode (UVEC_COW), the copy shares its storage with the original vector,
+ *       and the elements are only copied once either vector is mutated.
+ *       Copying the same vector from multiple threads at the same time is not supported.
+ *
  * @public @related UVec
  */
 #define uvec_copy(T, vec) P_UVEC_CONCAT(uvec_copy_, T)(vec)
@@ -878,8 +1830,9 @@ typedef enum uvec_ret {
  * @public @related UVec
  */
 #define uvec_deinit(vec) do {                                                                       \
+    p_uvec_registry_remove(&(vec));                                                                 \
     if ((vec).storage) {                                                                            \
-        UVEC_FREE((vec).storage);                                                                   \
+        if (p_uvec_cow_release(&(vec))) UVEC_FREE((vec).storage);                                   \
         (vec).storage = NULL;                                                                       \
     }                                                                                               \
     (vec).count = (vec).allocated = 0;                                                              \
@@ -942,9 +1895,13 @@ typedef enum uvec_ret {
  * @param idx [uvec_uint] Index.
  * @param item [T] Replacement element.
  *
+ * @note In copy-on-write mode (UVEC_COW), the element is not replaced
+ *       if the shared storage cannot be copied.
+ *
  * @public @related UVec
  */
-#define uvec_set(vec, idx, item) ((vec)->storage[(idx)] = (item))
+#define uvec_set(vec, idx, item) \
+    (p_uvec_cow_unshare(vec) == UVEC_OK ? ((vec)->storage[(idx)] = (item)) : (item))
 
 /**
  * Returns the first element in the vector.
@@ -1021,6 +1978,10 @@ typedef enum uvec_ret {
  * @param idx [uvec_uint] Index of the element to remove.
  * @return [T] Removed element.
  *
+ * @note In copy-on-write mode (UVEC_COW), the element is returned but not removed
+ *       if the shared storage cannot be copied, which callers can detect
+ *       as the vector count does not change.
+ *
  * @public @related UVec
  */
 #define uvec_remove_at(T, vec, idx) P_UVEC_CONCAT(uvec_remove_at_, T)(vec, idx)
@@ -1406,6 +2367,25 @@ typedef enum uvec_ret {
 #define uvec_insert_sorted_unique(T, vec, item, idx) \
     P_UVEC_CONCAT(uvec_insert_sorted_unique_, T)(vec, item, idx)
 
+/**
+ * Merges the specified sorted vectors, appending the result to the destination vector.
+ * Elements are selected via a tournament (loser) tree, so each one requires at most
+ * log2(k) comparisons, and capacity is reserved only once.
+ * Performance: O(n log k)
+ *
+ * @param T [symbol] Vector type.
+ * @param dst [UVec(T)*] Destination vector, must not be one of the merged vectors.
+ * @param runs [UVec(T)**] Sorted vectors.
+ * @param k [unsigned] Number of sorted vectors.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The merge is stable: equivalent elements keep their relative order,
+ *       and those from earlier vectors come first.
+ *
+ * @public @related UVec
+ */
+#define uvec_merge_sorted_k(T, dst, runs, k) P_UVEC_CONCAT(uvec_merge_sorted_k_, T)(dst, runs, k)
+
 /// @name Higher order
 
 /**
@@ -1441,7 +2421,7 @@ typedef enum uvec_ret {
  */
 #define uvec_qsort(T, vec, comp_func) do {                                                          \
     UVec(T) *p_v_##comp_func = (vec);                                                               \
-    if (p_v_##comp_func)                                                                            \
+    if (p_v_##comp_func && !p_uvec_cow_unshare(p_v_##comp_func))                                    \
         qsort((p_v_##comp_func)->storage, (p_v_##comp_func)->count, sizeof(T), comp_func);          \
 } while(0)
 
@@ -1460,9 +2440,252 @@ typedef enum uvec_ret {
  */
 #define uvec_qsort_range(T, vec, start, len, comp_func) do {                                        \
     UVec(T) *p_v_##comp_func = (vec);                                                               \
-    if (p_v_##comp_func)                                                                            \
+    if (p_v_##comp_func && !p_uvec_cow_unshare(p_v_##comp_func))                                    \
         qsort((p_v_##comp_func)->storage + (start), len, sizeof(T), comp_func);                     \
 } while(0)
 
+/// @name Statistics
+
+/**
+ * Returns the statistics of the specified vector type, aggregated across all threads.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecStats] Statistics.
+ *
+ * @note Requires UVEC_STATS. Counters are never reset: compute the difference between
+ *       two snapshots in order to measure a specific interval.
+ *
+ * @public @related UVec
+ */
+#define uvec_stats_snapshot(T) P_UVEC_CONCAT(uvec_stats_snapshot_, T)()
+
+/**
+ * Returns the statistics of the specified vector type collected by the calling thread.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecStats] Statistics.
+ *
+ * @note Requires UVEC_STATS. Without thread-local storage support, this is equivalent
+ *       to uvec_stats_snapshot.
+ *
+ * @public @related UVec
+ */
+#define uvec_stats_local(T) P_UVEC_CONCAT(uvec_stats_local_, T)()
+
+/**
+ * Sets the trace callback of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param func [uvec_stats_trace_func] Callback, or NULL to disable tracing.
+ * @param ctx [void*] User context, passed to the callback.
+ *
+ * @note Requires UVEC_STATS. The callback is invoked by the thread performing the operation,
+ *       and must not be changed while other threads operate on vectors of the same type.
+ *
+ * @public @related UVec
+ */
+#define uvec_stats_set_trace(T, func, ctx) P_UVEC_CONCAT(uvec_stats_set_trace_, T)(func, ctx)
+
+
+/// @name Registry
+
+#ifdef UVEC_REGISTRY
+
+/**
+ * Returns the memory usage of live vectors.
+ *
+ * @param type [char const*] Vector type name (e.g. "int"), or NULL for all types.
+ * @return [UVecMemoryUsage] Memory usage.
+ *
+ * @note Requires UVEC_REGISTRY. Storage shared by copy-on-write copies is counted
+ *       for each vector, and registered vectors must not be mutated concurrently.
+ *       Vectors owned by containers (e.g. UVecLog, UVecSharded, UVecCollector, UVecRcu)
+ *       synchronize accesses on their own, and are therefore excluded.
+ *
+ * @public @related UVec
+ */
+p_uvec_static_inline UVecMemoryUsage uvec_memory_usage(char const *type) {
+    UVecMemoryUsage usage = { 0 };
+    p_uvec_registry *r = &p_uvec_registry_global;
+    p_uvec_spin_lock(&r->lock);
+
+    for (size_t i = 0; i < r->capacity; ++i) {
+        p_uvec_registry_entry *e = &r->entries[i];
+        if (!p_uvec_registry_is_tracked(e) || (type && strcmp(type, e->type->name))) continue;
+
+        p_uvec_registry_info info = e->type->info(e->vec);
+        usage.vectors++;
+        usage.allocated_bytes += (uint64_t)info.allocated * e->type->size;
+        usage.used_bytes += (uint64_t)info.count * e->type->size;
+    }
+
+    p_uvec_spin_unlock(&r->lock);
+    return usage;
+}
+
+/**
+ * Prints a report of the memory usage of live vectors, including allocated and used bytes
+ * per type, capacity histograms and the vectors with the largest unused capacity.
+ *
+ * @param stream [FILE*] Output stream.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Requires UVEC_REGISTRY. Storage shared by copy-on-write copies is counted
+ *       for each vector, and registered vectors must not be mutated concurrently.
+ *       Vectors owned by containers (e.g. UVecLog, UVecSharded, UVecCollector, UVecRcu)
+ *       synchronize accesses on their own, and are therefore excluded.
+ *
+ * @public @related UVec
+ */
+p_uvec_static_inline uvec_ret uvec_memory_report(FILE *stream) {
+    p_uvec_registry *r = &p_uvec_registry_global;
+    p_uvec_spin_lock(&r->lock);
+
+    size_t count = r->count;
+    size_t size = (count ? count : 1) * (sizeof(p_uvec_registry_item) +
+                                         sizeof(p_uvec_registry_summary));
+    p_uvec_registry_item *items = UVEC_MALLOC(size);
+
+    if (!items) {
+        p_uvec_spin_unlock(&r->lock);
+        return UVEC_ERR;
+    }
+
+    p_uvec_registry_summary *summaries = (p_uvec_registry_summary *)(void *)(items + count);
+    count = 0;
+
+    for (size_t i = 0; i < r->capacity; ++i) {
+        p_uvec_registry_entry *e = &r->entries[i];
+        if (!p_uvec_registry_is_tracked(e)) continue;
+        items[count++] = (p_uvec_registry_item) {
+            .vec = e->vec, .type = e->type, .info = e->type->info(e->vec),
+            .idle = e->epoch < r->epoch
+        };
+    }
+
+    p_uvec_spin_unlock(&r->lock);
+
+    p_uvec_registry_item const *top[P_UVEC_REGISTRY_TOP];
+    size_t types = 0, top_count = 0;
+    UVecMemoryUsage total = { 0 };
+
+    for (size_t i = 0; i < count; ++i) {
+        p_uvec_registry_item const *item = &items[i];
+        uint64_t allocated = (uint64_t)item->info.allocated * item->type->size;
+        uint64_t used = (uint64_t)item->info.count * item->type->size;
+        p_uvec_registry_summary *s = summaries;
+
+        while (s < summaries + types && strcmp(s->name, item->type->name)) ++s;
+
+        if (s == summaries + types) {
+            memset(s, 0, sizeof(*s));
+            s->name = item->type->name;
+            types++;
+        }
+
+        s->usage.vectors++;
+        s->usage.allocated_bytes += allocated;
+        s->usage.used_bytes += used;
+        s->buckets[item->info.allocated ? p_uvec_uint_log2(item->info.allocated) + 1 : 0]++;
+
+        total.vectors++;
+        total.allocated_bytes += allocated;
+        total.used_bytes += used;
+
+        // Insertion into the largest wasters, sorted by decreasing unused capacity.
+        size_t pos = top_count;
+        if (top_count < P_UVEC_REGISTRY_TOP) top_count++;
+
+        for (; pos && p_uvec_registry_unused(top[pos - 1]) < allocated - used; --pos) {
+            if (pos < P_UVEC_REGISTRY_TOP) top[pos] = top[pos - 1];
+        }
+
+        if (pos < P_UVEC_REGISTRY_TOP) top[pos] = item;
+    }
+
+    fprintf(stream, "Vectors: %llu, allocated: %llu B, used: %llu B, unused: %.1f%%\n\n",
+            (unsigned long long)total.vectors, (unsigned long long)total.allocated_bytes,
+            (unsigned long long)total.used_bytes, p_uvec_registry_unused_pct(total));
+
+    fprintf(stream, "%-24s %10s %16s %16s %8s\n",
+            "Type", "Vectors", "Allocated (B)", "Used (B)", "Unused");
+
+    for (size_t i = 0; i < types; ++i) {
+        UVecMemoryUsage u = summaries[i].usage;
+        fprintf(stream, "%-24s %10llu %16llu %16llu %7.1f%%\n", summaries[i].name,
+                (unsigned long long)u.vectors, (unsigned long long)u.allocated_bytes,
+                (unsigned long long)u.used_bytes, p_uvec_registry_unused_pct(u));
+    }
+
+    for (size_t i = 0; i < types; ++i) {
+        fprintf(stream, "\nCapacity histogram (%s):\n", summaries[i].name);
+
+        for (unsigned b = 0; b < P_UVEC_REGISTRY_BUCKETS; ++b) {
+            unsigned long long n = summaries[i].buckets[b];
+            if (!n) continue;
+
+            if (b) {
+                unsigned long long low = 1ull << (b - 1);
+                fprintf(stream, "  %20llu - %-20llu %10llu\n", low, (low - 1) * 2 + 1, n);
+            } else {
+                fprintf(stream, "  %20u   %-20s %10llu\n", 0u, "", n);
+            }
+        }
+    }
+
+    if (top_count) fprintf(stream, "\nLargest wasters:\n");
+
+    for (size_t i = 0; i < top_count; ++i) {
+        p_uvec_registry_item const *item = top[i];
+        fprintf(stream, "  %p %-24s allocated: %llu B, used: %llu B%s%s\n", item->vec,
+                item->type->name, (unsigned long long)item->info.allocated * item->type->size,
+                (unsigned long long)item->info.count * item->type->size,
+                item->idle ? ", idle" : "", item->info.shared ? ", shared" : "");
+    }
+
+    UVEC_FREE(items);
+    return ferror(stream) ? UVEC_ERR : UVEC_OK;
+}
+
+/**
+ * Shrinks the live vectors that have not grown since the previous call, and whose
+ * unused capacity is at least 'min_unused' bytes. Meant to be invoked periodically,
+ * or when the process is under memory pressure.
+ *
+ * @param min_unused [size_t] Minimum unused capacity (B).
+ * @return [size_t] Reclaimed bytes.
+ *
+ * @note Requires UVEC_REGISTRY. Since vectors are idle if they have not grown since
+ *       the previous call, the first call does not shrink any vector. Vectors whose storage
+ *       is shared by copy-on-write copies are not shrunk either, and registered vectors
+ *       must not be accessed concurrently. Vectors owned by containers (e.g. UVecLog,
+ *       UVecSharded, UVecCollector, UVecRcu) synchronize accesses on their own,
+ *       and are therefore excluded.
+ *
+ * @public @related UVec
+ */
+p_uvec_static_inline size_t uvec_shrink_all_idle(size_t min_unused) {
+    size_t reclaimed = 0;
+    p_uvec_registry *r = &p_uvec_registry_global;
+    p_uvec_spin_lock(&r->lock);
+
+    for (size_t i = 0; i < r->capacity; ++i) {
+        p_uvec_registry_entry *e = &r->entries[i];
+        if (!p_uvec_registry_is_tracked(e) || e->epoch >= r->epoch) continue;
+
+        p_uvec_registry_type const *type = e->type;
+        p_uvec_registry_info info = type->info(e->vec);
+        if (info.shared || (size_t)(info.allocated - info.count) * type->size < min_unused) continue;
+        if (type->shrink((void *)e->vec)) continue;
+
+        reclaimed += (size_t)(info.allocated - type->info(e->vec).allocated) * type->size;
+    }
+
+    r->epoch++;
+    p_uvec_spin_unlock(&r->lock);
+    return reclaimed;
+}
+
+#endif
 
 #endif // UVEC_H
@@ -0,0 +1,1036 @@
+/**
+ * uVec - asynchronous persistence.
+ *
+ * Loads and stores many serialized vectors concurrently, so that the storage device
+ * is kept busy instead of serving one blocking write at a time. On Linux, requests
+ * are submitted in batches through io_uring; elsewhere, or if io_uring is unavailable,
+ * they are served by a pool of threads performing positioned reads and writes.
+ * Vectors are transferred through staging buffers aligned for direct I/O,
+ * so file descriptors opened with O_DIRECT are supported.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_ASYNC_H
+#define UVEC_ASYNC_H
+
+#include "uvec_io.h"
+#include <pthread.h>
+
+#if defined __linux__ && defined P_UVEC_HAS_ATOMICS && defined __has_include
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+        #include <sys/uio.h>
+        #if defined __NR_io_uring_setup && defined __NR_io_uring_enter
+            #define P_UVEC_HAS_URING 1
+        #endif
+    #endif
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * Function called when an asynchronous operation completes.
+ *
+ * @param ctx [void*] Context passed when the operation was submitted.
+ * @param ret [uvec_ret] Result of the operation.
+ */
+typedef void (*uvec_async_func)(void *ctx, uvec_ret ret);
+
+/// Flags for creating asynchronous I/O contexts.
+typedef enum uvec_async_flags {
+
+    /// Use io_uring if available, otherwise a thread pool.
+    UVEC_ASYNC_DEFAULT = 0,
+
+    /// Always use a thread pool.
+    UVEC_ASYNC_THREADS = 1 << 0
+
+} uvec_async_flags;
+
+/// Stage of an asynchronous operation.
+typedef enum p_uvec_async_stage {
+    P_UVEC_ASYNC_STORE,
+    P_UVEC_ASYNC_HEADER,
+    P_UVEC_ASYNC_DATA
+} p_uvec_async_stage;
+
+/**
+ * Asynchronous load or store of a vector. Loads first read a single block,
+ * which holds the header and possibly the whole vector, and then the rest of the storage.
+ */
+typedef struct p_uvec_async_op {
+    struct p_uvec_async_op *next;
+    unsigned char *mem;
+    unsigned char *buf;
+    size_t len;
+    size_t need;
+    size_t done;
+    off_t offset;
+    int fd;
+    p_uvec_async_stage stage;
+    bool direct;
+    bool swap;
+    uvec_ret ret;
+    size_t size;
+    uvec_uint count;
+    uint64_t checksum;
+    void *vec;
+    uvec_ret (*append)(void *vec, void const *data, uvec_uint n);
+    uvec_async_func func;
+    void *ctx;
+#ifdef P_UVEC_HAS_URING
+    struct iovec iov;
+#endif
+} p_uvec_async_op;
+
+#ifdef P_UVEC_HAS_URING
+
+/// Memory-mapped io_uring instance.
+typedef struct p_uvec_uring {
+    int fd;
+    unsigned entries;
+    unsigned queued;
+    unsigned sq_mask;
+    unsigned cq_mask;
+    P_UVEC_ATOMIC(unsigned) *sq_head;
+    P_UVEC_ATOMIC(unsigned) *sq_tail;
+    P_UVEC_ATOMIC(unsigned) *cq_head;
+    P_UVEC_ATOMIC(unsigned) *cq_tail;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map;
+    void *cq_map;
+    size_t sq_map_size;
+    size_t cq_map_size;
+} p_uvec_uring;
+
+#endif
+
+/**
+ * Context submitting asynchronous loads and stores of vectors.
+ * Contexts must only be used by one thread at a time.
+ */
+typedef struct UVecAsync {
+    /** @cond */
+    p_uvec_async_op *head;
+    p_uvec_async_op *tail;
+    p_uvec_async_op *done;
+    unsigned outstanding;
+    unsigned inflight;
+    uvec_ret status;
+    bool uring;
+    bool stop;
+    unsigned nthreads;
+    pthread_t *threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+#ifdef P_UVEC_HAS_URING
+    p_uvec_uring ring;
+#endif
+    /** @endcond */
+} UVecAsync;
+
+// #############
+// # Constants #
+// #############
+
+/// Alignment of staging buffers, offsets and lengths for direct I/O.
+#define P_UVEC_ASYNC_ALIGN ((size_t)4096)
+
+/// Default queue depth.
+#define P_UVEC_ASYNC_DEPTH 64u
+
+/// Maximum number of threads of the fallback thread pool.
+#define P_UVEC_ASYNC_THREADS 8u
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Rounds a size up to the alignment required for direct I/O.
+ *
+ * @param size [size_t] Size.
+ * @return [size_t] Aligned size.
+ */
+#define p_uvec_async_align(size) \
+    (((size) + P_UVEC_ASYNC_ALIGN - 1) & ~(P_UVEC_ASYNC_ALIGN - 1))
+
+/**
+ * Returns the number of bytes occupied by a serialized vector, rounded up
+ * to the alignment required for direct I/O.
+ *
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ * @return [size_t] Number of bytes.
+ */
+p_uvec_static_inline size_t p_uvec_async_span(size_t size, uvec_uint count) {
+    return p_uvec_async_align(P_UVEC_IO_HEADER_SIZE + size * count);
+}
+
+/**
+ * Checks whether a file descriptor has been opened for direct I/O.
+ *
+ * @param fd [int] File descriptor.
+ * @return [bool] True if the file descriptor bypasses the page cache.
+ */
+p_uvec_static_inline bool p_uvec_async_is_direct(int fd) {
+#ifdef O_DIRECT
+    int const flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && (flags & O_DIRECT);
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+/**
+ * Resizes the staging buffer of an operation, preserving the transferred bytes.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ * @param len [size_t] New length.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_async_buf_resize(p_uvec_async_op *op, size_t len) {
+    if (len > SIZE_MAX - P_UVEC_ASYNC_ALIGN) return UVEC_ERR;
+    unsigned char *mem = UVEC_MALLOC(len + P_UVEC_ASYNC_ALIGN - 1);
+    if (!mem) return UVEC_ERR;
+
+    unsigned char *buf = (unsigned char *)p_uvec_async_align((uintptr_t)mem);
+    if (op->done) memcpy(buf, op->buf, op->done);
+    UVEC_FREE(op->mem);
+
+    op->mem = mem;
+    op->buf = buf;
+    op->len = len;
+    return UVEC_OK;
+}
+
+/**
+ * Allocates an operation.
+ *
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Offset of the serialized vector.
+ * @param stage [p_uvec_async_stage] Initial stage.
+ * @param need [size_t] Number of bytes to transfer.
+ * @param func [uvec_async_func] Completion callback, may be NULL.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [p_uvec_async_op*] Operation, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_async_op* p_uvec_async_op_alloc(int fd, off_t offset,
+                                                            p_uvec_async_stage stage, size_t need,
+                                                            uvec_async_func func, void *ctx) {
+    p_uvec_async_op *op = UVEC_MALLOC(sizeof(*op));
+    if (!op) return NULL;
+
+    *op = (p_uvec_async_op){
+        .offset = offset,
+        .fd = fd,
+        .stage = stage,
+        .direct = p_uvec_async_is_direct(fd),
+        .need = need,
+        .func = func,
+        .ctx = ctx
+    };
+
+    size_t len = op->direct || stage == P_UVEC_ASYNC_HEADER ? p_uvec_async_align(need) : need;
+    if (len < need || p_uvec_async_buf_resize(op, len)) {
+        UVEC_FREE(op);
+        return NULL;
+    }
+
+    return op;
+}
+
+/**
+ * Releases an operation.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ */
+p_uvec_static_inline void p_uvec_async_op_free(p_uvec_async_op *op) {
+    UVEC_FREE(op->mem);
+    UVEC_FREE(op);
+}
+
+/**
+ * Parses the header read by a load, preparing to read the rest of the storage.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ * @return [bool] True if more data must be read.
+ */
+p_uvec_static_inline bool p_uvec_async_header(p_uvec_async_op *op) {
+    uint64_t count;
+
+    if (p_uvec_io_header_parse(op->buf, op->size, &count, &op->checksum, &op->swap)) {
+        op->ret = UVEC_NO;
+        return false;
+    }
+
+    if (count > UVEC_UINT_MAX || count > (SIZE_MAX - 2 * P_UVEC_ASYNC_ALIGN) / op->size) {
+        op->ret = UVEC_ERR;
+        return false;
+    }
+
+    op->count = (uvec_uint)count;
+    op->stage = P_UVEC_ASYNC_DATA;
+    op->need = P_UVEC_IO_HEADER_SIZE + op->count * op->size;
+    if (op->done >= op->need) return false;
+
+    size_t const len = op->direct ? p_uvec_async_align(op->need) : op->need;
+    if (len > op->len && p_uvec_async_buf_resize(op, len)) op->ret = UVEC_ERR;
+    op->len = len;
+    return !op->ret;
+}
+
+/**
+ * Verifies the checksum of a loaded vector, converting its byte order if needed.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the data is corrupted.
+ */
+p_uvec_static_inline uvec_ret p_uvec_async_verify(p_uvec_async_op *op) {
+    unsigned char *data = op->buf + P_UVEC_IO_HEADER_SIZE;
+    size_t const bytes = op->count * op->size;
+    p_uvec_fletcher f = { 0, 0 };
+
+    if (bytes) p_uvec_fletcher_update(&f, data, bytes);
+    if (p_uvec_fletcher_value(f) != op->checksum) return UVEC_NO;
+    if (op->swap) p_uvec_io_swap(data, op->size, op->count);
+    return UVEC_OK;
+}
+
+/**
+ * Advances an operation after a transfer.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ * @param res [ssize_t] Number of transferred bytes, or a negated error code.
+ * @return [bool] True if more data must be transferred, false if the operation is complete.
+ */
+p_uvec_static_inline bool p_uvec_async_advance(p_uvec_async_op *op, ssize_t res) {
+    if (res < 0) {
+        if (res == -EINTR || res == -EAGAIN) return true;
+        op->ret = UVEC_ERR;
+        return false;
+    }
+
+    op->done += (size_t)res;
+
+    if (op->done < op->need) {
+        if (res) return true;
+        op->ret = op->stage == P_UVEC_ASYNC_STORE ? UVEC_ERR : UVEC_NO;
+        return false;
+    }
+
+    if (op->stage == P_UVEC_ASYNC_HEADER && p_uvec_async_header(op)) return true;
+    if (op->stage == P_UVEC_ASYNC_DATA && !op->ret) op->ret = p_uvec_async_verify(op);
+    return false;
+}
+
+/**
+ * Performs an operation on the calling thread.
+ *
+ * @param op [p_uvec_async_op*] Operation.
+ */
+p_uvec_static_inline void p_uvec_async_execute(p_uvec_async_op *op) {
+    ssize_t res;
+
+    do {
+        size_t len = op->len - op->done;
+        if (len > P_UVEC_IO_CHUNK) len = P_UVEC_IO_CHUNK;
+        off_t const offset = op->offset + (off_t)op->done;
+
+        if (op->stage == P_UVEC_ASYNC_STORE) {
+            res = pwrite(op->fd, op->buf + op->done, len, offset);
+        } else {
+            res = pread(op->fd, op->buf + op->done, len, offset);
+        }
+
+        if (res < 0) res = -errno;
+    } while (p_uvec_async_advance(op, res));
+}
+
+/**
+ * Main function of the threads of the fallback thread pool.
+ *
+ * @param arg [UVecAsync*] Context.
+ * @return [void*] NULL.
+ */
+p_uvec_static_inline void* p_uvec_async_thread_main(void *arg) {
+    UVecAsync *a = arg;
+    pthread_mutex_lock(&a->lock);
+
+    while (true) {
+        while (!a->stop && !a->head) pthread_cond_wait(&a->work, &a->lock);
+        if (!a->head) break;
+
+        p_uvec_async_op *op = a->head;
+        a->head = op->next;
+        if (!a->head) a->tail = NULL;
+
+        pthread_mutex_unlock(&a->lock);
+        p_uvec_async_execute(op);
+        pthread_mutex_lock(&a->lock);
+
+        op->next = a->done;
+        a->done = op;
+        pthread_cond_signal(&a->idle);
+    }
+
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+/**
+ * Queues an operation.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param op [p_uvec_async_op*] Operation.
+ */
+p_uvec_static_inline void p_uvec_async_queue(UVecAsync *a, p_uvec_async_op *op) {
+    op->next = NULL;
+    a->outstanding++;
+    if (!a->uring) pthread_mutex_lock(&a->lock);
+
+    if (a->tail) {
+        a->tail->next = op;
+    } else {
+        a->head = op;
+    }
+
+    a->tail = op;
+
+    if (!a->uring) {
+        pthread_cond_signal(&a->work);
+        pthread_mutex_unlock(&a->lock);
+    }
+}
+
+#ifdef P_UVEC_HAS_URING
+
+/**
+ * Sets up an io_uring instance.
+ *
+ * @param r [p_uvec_uring*] Ring.
+ * @param entries [unsigned] Number of submission queue entries.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_uring_init(p_uvec_uring *r, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) return UVEC_ERR;
+
+    r->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool const single = p.features & IORING_FEAT_SINGLE_MMAP;
+
+    if (single) {
+        if (r->cq_map_size > r->sq_map_size) r->sq_map_size = r->cq_map_size;
+        r->cq_map_size = 0;
+    }
+
+    int const prot = PROT_READ | PROT_WRITE;
+    r->sq_map = mmap(NULL, r->sq_map_size, prot, MAP_SHARED, r->fd, IORING_OFF_SQ_RING);
+    r->cq_map = r->sq_map;
+    r->sqes = MAP_FAILED;
+
+    if (r->sq_map != MAP_FAILED && !single) {
+        r->cq_map = mmap(NULL, r->cq_map_size, prot, MAP_SHARED, r->fd, IORING_OFF_CQ_RING);
+    }
+
+    if (r->cq_map != MAP_FAILED) {
+        r->sqes = mmap(NULL, p.sq_entries * sizeof(*r->sqes), prot, MAP_SHARED, r->fd,
+                       IORING_OFF_SQES);
+    }
+
+    if (r->sqes == MAP_FAILED) {
+        if (r->cq_map != MAP_FAILED && !single) munmap(r->cq_map, r->cq_map_size);
+        if (r->sq_map != MAP_FAILED) munmap(r->sq_map, r->sq_map_size);
+        close(r->fd);
+        return UVEC_ERR;
+    }
+
+    unsigned char *sq = r->sq_map, *cq = r->cq_map;
+    r->entries = p.sq_entries;
+    r->sq_head = (void *)(sq + p.sq_off.head);
+    r->sq_tail = (void *)(sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned *)(void *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (void *)(sq + p.sq_off.array);
+    r->cq_head = (void *)(cq + p.cq_off.head);
+    r->cq_tail = (void *)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned *)(void *)(cq + p.cq_off.ring_mask);
+    r->cqes = (void *)(cq + p.cq_off.cqes);
+    return UVEC_OK;
+}
+
+/**
+ * Tears down an io_uring instance.
+ *
+ * @param r [p_uvec_uring*] Ring.
+ */
+p_uvec_static_inline void p_uvec_uring_deinit(p_uvec_uring *r) {
+    munmap(r->sqes, r->entries * sizeof(*r->sqes));
+    if (r->cq_map_size) munmap(r->cq_map, r->cq_map_size);
+    munmap(r->sq_map, r->sq_map_size);
+    close(r->fd);
+}
+
+/**
+ * Adds the next transfer of an operation to the submission queue.
+ *
+ * @param r [p_uvec_uring*] Ring.
+ * @param op [p_uvec_async_op*] Operation.
+ */
+p_uvec_static_inline void p_uvec_uring_push(p_uvec_uring *r, p_uvec_async_op *op) {
+    unsigned const tail = p_uvec_atomic_load(r->sq_tail, P_UVEC_MO_RELAXED);
+    unsigned const idx = tail & r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+
+    op->iov.iov_base = op->buf + op->done;
+    op->iov.iov_len = op->len - op->done;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op->stage == P_UVEC_ASYNC_STORE ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = op->fd;
+    sqe->off = (uint64_t)(op->offset + (off_t)op->done);
+    sqe->addr = (uint64_t)(uintptr_t)&op->iov;
+    sqe->len = 1;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+
+    r->sq_array[idx] = idx;
+    p_uvec_atomic_store(r->sq_tail, tail + 1, P_UVEC_MO_RELEASE);
+    r->queued++;
+}
+
+/**
+ * Moves queued operations to the submission queue, and submits them.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param wait [bool] If true, waits for at least one completion.
+ * @param[out] failed [p_uvec_async_op**] List of operations that could not be submitted.
+ */
+p_uvec_static_inline void p_uvec_uring_submit(UVecAsync *a, bool wait, p_uvec_async_op **failed) {
+    p_uvec_uring *r = &a->ring;
+
+    while (a->head && a->inflight < r->entries) {
+        p_uvec_async_op *op = a->head;
+        a->head = op->next;
+        if (!a->head) a->tail = NULL;
+        p_uvec_uring_push(r, op);
+        a->inflight++;
+    }
+
+    if (!r->queued && !(wait && a->inflight)) return;
+    unsigned const flags = wait ? IORING_ENTER_GETEVENTS : 0;
+    long const ret = syscall(__NR_io_uring_enter, r->fd, r->queued, wait ? 1 : 0, flags, NULL, 0);
+
+    if (ret >= 0) {
+        r->queued -= (unsigned)ret;
+        return;
+    }
+
+    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) return;
+
+    // Fail the entries the kernel has not consumed.
+    unsigned const head = p_uvec_atomic_load(r->sq_head, P_UVEC_MO_ACQUIRE);
+    unsigned tail = p_uvec_atomic_load(r->sq_tail, P_UVEC_MO_RELAXED);
+
+    for (; tail != head; --tail, --a->inflight) {
+        struct io_uring_sqe *sqe = &r->sqes[r->sq_array[(tail - 1) & r->sq_mask]];
+        p_uvec_async_op *op = (p_uvec_async_op *)(uintptr_t)sqe->user_data;
+        op->ret = UVEC_ERR;
+        op->next = *failed;
+        *failed = op;
+    }
+
+    p_uvec_atomic_store(r->sq_tail, head, P_UVEC_MO_RELEASE);
+    r->queued = 0;
+}
+
+/**
+ * Reaps completion queue entries, requeuing the operations that need more transfers.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param[out] done [p_uvec_async_op**] List of completed operations.
+ */
+p_uvec_static_inline void p_uvec_uring_reap(UVecAsync *a, p_uvec_async_op **done) {
+    p_uvec_uring *r = &a->ring;
+    unsigned head = p_uvec_atomic_load(r->cq_head, P_UVEC_MO_RELAXED);
+    unsigned const tail = p_uvec_atomic_load(r->cq_tail, P_UVEC_MO_ACQUIRE);
+
+    for (; head != tail; ++head, --a->inflight) {
+        struct io_uring_cqe *cqe = &r->cqes[head & r->cq_mask];
+        p_uvec_async_op *op = (p_uvec_async_op *)(uintptr_t)cqe->user_data;
+
+        if (p_uvec_async_advance(op, cqe->res)) {
+            op->next = a->head;
+            a->head = op;
+            if (!a->tail) a->tail = op;
+        } else {
+            op->next = *done;
+            *done = op;
+        }
+    }
+
+    p_uvec_atomic_store(r->cq_head, head, P_UVEC_MO_RELEASE);
+}
+
+#endif
+
+/**
+ * Submits queued operations and collects the completed ones.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param wait [bool] If true, waits for at least one completion.
+ * @return [p_uvec_async_op*] List of completed operations.
+ */
+p_uvec_static_inline p_uvec_async_op* p_uvec_async_collect(UVecAsync *a, bool wait) {
+    p_uvec_async_op *done = NULL;
+
+#ifdef P_UVEC_HAS_URING
+    if (a->uring) {
+        do {
+            p_uvec_uring_submit(a, wait, &done);
+            p_uvec_uring_reap(a, &done);
+        } while (wait && !done && a->outstanding);
+        return done;
+    }
+#endif
+
+    pthread_mutex_lock(&a->lock);
+    if (wait) while (!a->done && a->outstanding) pthread_cond_wait(&a->idle, &a->lock);
+    done = a->done;
+    a->done = NULL;
+    pthread_mutex_unlock(&a->lock);
+    return done;
+}
+
+/**
+ * Finalizes completed operations, invoking their callbacks.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param done [p_uvec_async_op*] List of completed operations.
+ * @return [unsigned] Number of completed operations.
+ */
+p_uvec_static_inline unsigned p_uvec_async_complete(UVecAsync *a, p_uvec_async_op *done) {
+    unsigned n = 0;
+
+    for (p_uvec_async_op *next; done; done = next, ++n) {
+        next = done->next;
+
+        if (!done->ret && done->stage == P_UVEC_ASYNC_DATA) {
+            done->ret = done->append(done->vec, done->buf + P_UVEC_IO_HEADER_SIZE, done->count);
+        }
+
+        if (done->ret && !a->status) a->status = done->ret;
+        a->outstanding--;
+
+        uvec_async_func const func = done->func;
+        void *ctx = done->ctx;
+        uvec_ret const ret = done->ret;
+        p_uvec_async_op_free(done);
+        if (func) func(ctx, ret);
+    }
+
+    return n;
+}
+
+/**
+ * Queues the store of a vector's storage.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param storage [void const*] Storage.
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Offset.
+ * @param func [uvec_async_func] Completion callback, may be NULL.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_async_store(UVecAsync *a, void const *storage, size_t size,
+                                                 uvec_uint count, int fd, off_t offset,
+                                                 uvec_async_func func, void *ctx) {
+    size_t const bytes = size * count;
+    p_uvec_async_op *op = p_uvec_async_op_alloc(fd, offset, P_UVEC_ASYNC_STORE,
+                                                P_UVEC_IO_HEADER_SIZE + bytes, func, ctx);
+    if (!op) return UVEC_ERR;
+
+    p_uvec_fletcher f = { 0, 0 };
+    unsigned char *data = op->buf + P_UVEC_IO_HEADER_SIZE;
+
+    if (bytes) {
+        memcpy(data, storage, bytes);
+        p_uvec_fletcher_update(&f, data, bytes);
+    }
+
+    p_uvec_io_header_init(op->buf, size, count, p_uvec_fletcher_value(f));
+    memset(data + bytes, 0, op->len - op->need);
+    op->need = op->len;
+    p_uvec_async_queue(a, op);
+    return UVEC_OK;
+}
+
+/**
+ * Queues the load of a vector.
+ *
+ * @param a [UVecAsync*] Context.
+ * @param vec [void*] Vector.
+ * @param append [uvec_ret (*)(void*, void const*, uvec_uint)] Appends elements to the vector.
+ * @param size [size_t] Element size.
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Offset.
+ * @param func [uvec_async_func] Completion callback, may be NULL.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_async_load(UVecAsync *a, void *vec,
+                                                uvec_ret (*append)(void *, void const *, uvec_uint),
+                                                size_t size, int fd, off_t offset,
+                                                uvec_async_func func, void *ctx) {
+    p_uvec_async_op *op = p_uvec_async_op_alloc(fd, offset, P_UVEC_ASYNC_HEADER,
+                                                P_UVEC_IO_HEADER_SIZE, func, ctx);
+    if (!op) return UVEC_ERR;
+
+    op->vec = vec;
+    op->append = append;
+    op->size = size;
+    p_uvec_async_queue(a, op);
+    return UVEC_OK;
+}
+
+/**
+ * Generates function declarations for the asynchronous persistence functions
+ * of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_ASYNC(T, SCOPE)                                                                 \
+    /** @cond */                                                                                    \
+    SCOPE uvec_ret uvec_async_store_##T(UVecAsync *a, UVec_##T const *vec, int fd, off_t offset,    \
+                                        uvec_async_func func, void *ctx);                           \
+    SCOPE uvec_ret uvec_async_load_##T(UVecAsync *a, UVec_##T *vec, int fd, off_t offset,           \
+                                       uvec_async_func func, void *ctx);                            \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the asynchronous persistence functions
+ * of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_ASYNC(T, SCOPE)                                                                 \
+                                                                                                    \
+    static inline uvec_ret p_uvec_async_append_##T(void *vec, void const *data, uvec_uint n) {      \
+        return uvec_append_array_##T(vec, data, n);                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_async_store_##T(UVecAsync *a, UVec_##T const *vec, int fd, off_t offset,    \
+                                        uvec_async_func func, void *ctx) {                          \
+        return p_uvec_async_store(a, vec->storage, sizeof(T), vec->count, fd, offset, func, ctx);   \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_async_load_##T(UVecAsync *a, UVec_##T *vec, int fd, off_t offset,           \
+                                       uvec_async_func func, void *ctx) {                           \
+        return p_uvec_async_load(a, vec, p_uvec_async_append_##T, sizeof(T), fd, offset,           \
+                                 func, ctx);                                                        \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares the asynchronous persistence functions of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_ASYNC(T) \
+    P_UVEC_DECL_ASYNC(T, p_uvec_unused)
+
+/**
+ * Declares the asynchronous persistence functions of the specified vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_ASYNC_SPEC(T, SPEC) \
+    P_UVEC_DECL_ASYNC(T, SPEC p_uvec_unused)
+
+/**
+ * Implements the previously declared asynchronous persistence functions
+ * of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVec
+ */
+#define UVEC_IMPL_ASYNC(T) \
+    P_UVEC_IMPL_ASYNC(T, p_uvec_unused)
+
+/**
+ * Defines the static asynchronous persistence functions of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVec
+ */
+#define UVEC_INIT_ASYNC(T) \
+    P_UVEC_IMPL_ASYNC(T, p_uvec_static_inline)
+
+/// @name Contexts
+
+/**
+ * Creates an asynchronous I/O context.
+ *
+ * @param depth [unsigned] Maximum number of transfers in flight, or zero for the default (64).
+ *                         The thread pool uses at most 8 threads, regardless of the depth.
+ * @param flags [uvec_async_flags] Flags.
+ * @return [UVecAsync*] Context, or NULL on error.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline UVecAsync* uvec_async_create(unsigned depth, uvec_async_flags flags) {
+    UVecAsync *a = UVEC_MALLOC(sizeof(*a));
+    if (!a) return NULL;
+
+    memset(a, 0, sizeof(*a));
+    if (!depth) depth = P_UVEC_ASYNC_DEPTH;
+
+#ifdef P_UVEC_HAS_URING
+    if (!(flags & UVEC_ASYNC_THREADS) && !p_uvec_uring_init(&a->ring, depth)) {
+        a->uring = true;
+        return a;
+    }
+#else
+    (void)flags;
+#endif
+
+    unsigned const nthreads = depth < P_UVEC_ASYNC_THREADS ? depth : P_UVEC_ASYNC_THREADS;
+    a->threads = UVEC_MALLOC(nthreads * sizeof(*a->threads));
+
+    if (!a->threads) {
+        UVEC_FREE(a);
+        return NULL;
+    }
+
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->work, NULL);
+    pthread_cond_init(&a->idle, NULL);
+
+    while (a->nthreads < nthreads &&
+           !pthread_create(&a->threads[a->nthreads], NULL, p_uvec_async_thread_main, a)) {
+        a->nthreads++;
+    }
+
+    if (!a->nthreads) {
+        pthread_cond_destroy(&a->idle);
+        pthread_cond_destroy(&a->work);
+        pthread_mutex_destroy(&a->lock);
+        UVEC_FREE(a->threads);
+        UVEC_FREE(a);
+        return NULL;
+    }
+
+    return a;
+}
+
+/**
+ * Checks whether the specified context submits requests through io_uring.
+ *
+ * @param a [UVecAsync const*] Context.
+ * @return [bool] True if io_uring is used, false if requests are served by a thread pool.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline bool uvec_async_uses_uring(UVecAsync const *a) {
+    return a->uring;
+}
+
+/**
+ * Returns the number of operations that have not completed yet.
+ *
+ * @param a [UVecAsync const*] Context.
+ * @return [unsigned] Number of operations.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline unsigned uvec_async_pending(UVecAsync const *a) {
+    return a->outstanding;
+}
+
+/**
+ * Submits the queued operations without waiting for their completion.
+ *
+ * @param a [UVecAsync*] Context.
+ *
+ * @note With io_uring, operations are submitted in batches by this function,
+ *       uvec_async_poll and uvec_async_wait. The thread pool starts serving
+ *       operations as soon as they are queued.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline void uvec_async_submit(UVecAsync *a) {
+#ifdef P_UVEC_HAS_URING
+    if (a->uring) {
+        p_uvec_async_op *failed = NULL;
+        p_uvec_uring_submit(a, false, &failed);
+        p_uvec_async_complete(a, failed);
+    }
+#else
+    (void)a;
+#endif
+}
+
+/**
+ * Submits the queued operations and processes those that have completed,
+ * invoking their callbacks, without blocking.
+ *
+ * @param a [UVecAsync*] Context.
+ * @return [unsigned] Number of completed operations.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline unsigned uvec_async_poll(UVecAsync *a) {
+    return p_uvec_async_complete(a, p_uvec_async_collect(a, false));
+}
+
+/**
+ * Waits for all operations to complete, invoking their callbacks.
+ *
+ * @param a [UVecAsync*] Context.
+ * @return [uvec_ret] UVEC_OK if all the operations that completed since the last call
+ *                    succeeded, otherwise the result of the first failed operation.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline uvec_ret uvec_async_wait(UVecAsync *a) {
+    while (a->outstanding) p_uvec_async_complete(a, p_uvec_async_collect(a, true));
+    uvec_ret const ret = a->status;
+    a->status = UVEC_OK;
+    return ret;
+}
+
+/**
+ * Waits for all operations to complete, and destroys the specified context.
+ *
+ * @param a [UVecAsync*] Context.
+ * @return [uvec_ret] Result of uvec_async_wait.
+ *
+ * @public @memberof UVecAsync
+ */
+p_uvec_static_inline uvec_ret uvec_async_destroy(UVecAsync *a) {
+    if (!a) return UVEC_OK;
+    uvec_ret const ret = uvec_async_wait(a);
+
+#ifdef P_UVEC_HAS_URING
+    if (a->uring) {
+        p_uvec_uring_deinit(&a->ring);
+        UVEC_FREE(a);
+        return ret;
+    }
+#endif
+
+    pthread_mutex_lock(&a->lock);
+    a->stop = true;
+    pthread_cond_broadcast(&a->work);
+    pthread_mutex_unlock(&a->lock);
+
+    for (unsigned i = 0; i < a->nthreads; ++i) pthread_join(a->threads[i], NULL);
+    pthread_cond_destroy(&a->idle);
+    pthread_cond_destroy(&a->work);
+    pthread_mutex_destroy(&a->lock);
+    UVEC_FREE(a->threads);
+    UVEC_FREE(a);
+    return ret;
+}
+
+/// @name Persistence
+
+/**
+ * Returns the number of bytes occupied by the specified vector once stored,
+ * rounded up to the alignment required for direct I/O. Vectors stored at offsets
+ * that are multiples of this alignment can be accessed via O_DIRECT file descriptors.
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector instance.
+ * @return [size_t] Number of bytes.
+ *
+ * @public @related UVec
+ */
+#define uvec_async_span(T, vec) p_uvec_async_span(sizeof(T), (vec)->count)
+
+/**
+ * Queues the store of the specified vector at an offset of a file descriptor.
+ * The vector is serialized in the format of uvec_write_fd, and is copied to a staging
+ * buffer before this function returns, so it can be modified right away.
+ *
+ * @param T [symbol] Vector type.
+ * @param a [UVecAsync*] Context.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Offset.
+ * @param func [uvec_async_func] Completion callback, may be NULL.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [uvec_ret] UVEC_OK if the operation was queued, otherwise UVEC_ERR.
+ *
+ * @note If the file descriptor was opened with O_DIRECT, the offset must be aligned
+ *       to 4096 bytes, and the serialized vector is padded with zeros to the same alignment.
+ *       O_DIRECT is only detected if it is defined, e.g. via _GNU_SOURCE.
+ *
+ * @public @related UVec
+ */
+#define uvec_async_store(T, a, vec, fd, offset, func, ctx) \
+    P_UVEC_CONCAT(uvec_async_store_, T)(a, vec, fd, offset, func, ctx)
+
+/**
+ * Queues the load of a vector stored at an offset of a file descriptor,
+ * appending its elements to the specified vector once the operation completes.
+ *
+ * @param T [symbol] Vector type.
+ * @param a [UVecAsync*] Context.
+ * @param vec [UVec(T)*] Vector instance, which must not be accessed until the
+ *                       operation completes.
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Offset.
+ * @param func [uvec_async_func] Completion callback, may be NULL.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [uvec_ret] UVEC_OK if the operation was queued, otherwise UVEC_ERR.
+ *
+ * @note The operation completes with UVEC_NO if the data is invalid, truncated,
+ *       corrupted or has a different element size.
+ * @note Elements are appended on the thread calling uvec_async_poll or uvec_async_wait.
+ *
+ * @public @related UVec
+ */
+#define uvec_async_load(T, a, vec, fd, offset, func, ctx) \
+    P_UVEC_CONCAT(uvec_async_load_, T)(a, vec, fd, offset, func, ctx)
+
+#endif // UVEC_ASYNC_H
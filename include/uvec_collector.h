@@ -0,0 +1,579 @@
+/**
+ * uVec - thread-local collectors.
+ *
+ * Collectors give each producer thread a private vector, so that elements can be
+ * pushed without any synchronization. Once producers are done, the per-thread vectors
+ * are combined into a single vector, copying or merging them in parallel.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_COLLECTOR_H
+#define UVEC_COLLECTOR_H
+
+#include "uvec.h"
+#include <pthread.h>
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A set of per-thread vectors that can be combined into a single vector.
+ * @struct UVecCollector
+ */
+
+/// Task executed by p_uvec_run_parallel.
+typedef void (*p_uvec_task_func)(void *ctx, unsigned idx);
+
+/// Argument of the threads spawned by p_uvec_run_parallel.
+typedef struct p_uvec_task {
+    p_uvec_task_func func;
+    void *ctx;
+    unsigned idx;
+} p_uvec_task;
+
+// #############
+// # Constants #
+// #############
+
+/// Minimum number of bytes processed by each parallel task.
+#define P_UVEC_TASK_MIN_BYTES ((uvec_uint)1 << 18)
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Returns the number of tasks a job should be split into.
+ *
+ * @param max [unsigned] Maximum number of tasks.
+ * @param bytes [size_t] Number of bytes processed by the job.
+ * @return [unsigned] Number of tasks.
+ */
+p_uvec_static_inline unsigned p_uvec_task_count(unsigned max, size_t bytes) {
+    size_t tasks = bytes / P_UVEC_TASK_MIN_BYTES;
+    return tasks < 1 ? 1 : (tasks > max ? max : (unsigned)tasks);
+}
+
+/**
+ * Returns the start of the specified task's share of 'count' elements.
+ *
+ * @param count [uvec_uint] Number of elements.
+ * @param tasks [unsigned] Number of tasks.
+ * @param idx [unsigned] Task index.
+ * @return [uvec_uint] Index of the first element processed by the task.
+ */
+p_uvec_static_inline uvec_uint p_uvec_task_start(uvec_uint count, unsigned tasks, unsigned idx) {
+    uvec_uint rem = count % tasks;
+    return count / tasks * idx + (idx < rem ? idx : rem);
+}
+
+p_uvec_static_inline void* p_uvec_task_run(void *arg) {
+    p_uvec_task *task = arg;
+    task->func(task->ctx, task->idx);
+    return NULL;
+}
+
+/**
+ * Runs 'count' instances of the specified task in parallel, each on its own thread,
+ * and waits for their completion. Tasks whose threads cannot be spawned are run
+ * on the calling thread.
+ *
+ * @param count [unsigned] Number of tasks.
+ * @param func [p_uvec_task_func] Task function.
+ * @param ctx [void*] Task context.
+ */
+p_uvec_static_inline void p_uvec_run_parallel(unsigned count, p_uvec_task_func func, void *ctx) {
+    if (count < 2) {
+        if (count) func(ctx, 0);
+        return;
+    }
+
+    pthread_t *threads = UVEC_MALLOC((count - 1) * (sizeof(*threads) + sizeof(p_uvec_task)));
+    p_uvec_task *tasks = (p_uvec_task *)(threads + count - 1);
+    unsigned spawned = 0;
+
+    if (threads) {
+        for (; spawned < count - 1; ++spawned) {
+            tasks[spawned] = (p_uvec_task){ .func = func, .ctx = ctx, .idx = spawned + 1 };
+            if (pthread_create(&threads[spawned], NULL, p_uvec_task_run, &tasks[spawned])) break;
+        }
+    }
+
+    func(ctx, 0);
+    for (unsigned i = spawned + 1; i < count; ++i) func(ctx, i);
+    for (unsigned i = 0; i < spawned; ++i) pthread_join(threads[i], NULL);
+    UVEC_FREE(threads);
+}
+
+/**
+ * Defines a new collector struct.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                \
+    typedef union p_uvec_collector_slot_##T {                                                       \
+        UVec_##T vec;                                                                               \
+        char pad[p_uvec_cache_align(sizeof(UVec_##T))];                                             \
+    } p_uvec_collector_slot_##T;                                                                    \
+                                                                                                    \
+    typedef struct UVecCollector_##T {                                                              \
+        /** @cond */                                                                                \
+        unsigned count;                                                                             \
+        p_uvec_collector_slot_##T *slots;                                                           \
+        void *mem;                                                                                  \
+        /** @endcond */                                                                             \
+    } UVecCollector_##T;
+
+/**
+ * Generates function declarations for the specified collector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_COLLECTOR(T, SCOPE)                                                             \
+    /** @cond */                                                                                    \
+    SCOPE UVecCollector_##T* uvec_collector_alloc_##T(unsigned count);                              \
+    SCOPE void uvec_collector_free_##T(UVecCollector_##T *col);                                     \
+    SCOPE uvec_uint uvec_collector_count_##T(UVecCollector_##T const *col);                         \
+    SCOPE uvec_ret uvec_collector_combine_##T(UVecCollector_##T *col, UVec_##T *vec);               \
+    /** @endcond */                                                                                 \
+
+/**
+ * Generates function declarations for the specified comparable collector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_COLLECTOR_COMPARABLE(T, SCOPE)                                                  \
+    /** @cond */                                                                                    \
+    SCOPE uvec_ret uvec_collector_combine_sorted_##T(UVecCollector_##T *col, UVec_##T *vec);        \
+    /** @endcond */                                                                                 \
+
+/**
+ * Generates function definitions for the specified collector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_COLLECTOR(T, SCOPE)                                                             \
+                                                                                                    \
+    typedef struct p_uvec_collector_copy_ctx_##T {                                                  \
+        UVecCollector_##T *col;                                                                     \
+        uvec_uint const *offsets;                                                                   \
+        T *dest;                                                                                    \
+        unsigned tasks;                                                                             \
+    } p_uvec_collector_copy_ctx_##T;                                                                \
+                                                                                                    \
+    static inline void p_uvec_collector_copy_task_##T(void *data, unsigned idx) {                   \
+        p_uvec_collector_copy_ctx_##T *ctx = data;                                                  \
+        uvec_uint const *offsets = ctx->offsets;                                                    \
+        uvec_uint const total = offsets[ctx->col->count];                                           \
+        uvec_uint start = p_uvec_task_start(total, ctx->tasks, idx);                                \
+        uvec_uint const end = p_uvec_task_start(total, ctx->tasks, idx + 1);                        \
+        unsigned l = 0, r = ctx->col->count;                                                        \
+                                                                                                    \
+        while (r - l > 1) {                                                                         \
+            unsigned m = l + (r - l) / 2;                                                           \
+            if (offsets[m] <= start) l = m; else r = m;                                             \
+        }                                                                                           \
+                                                                                                    \
+        for (; start < end; ++l) {                                                                  \
+            uvec_uint from = start - offsets[l];                                                    \
+            uvec_uint n = (offsets[l + 1] < end ? offsets[l + 1] : end) - start;                    \
+            if (!n) continue;                                                                       \
+            memcpy(ctx->dest + start, ctx->col->slots[l].vec.storage + from, n * sizeof(T));        \
+            start += n;                                                                             \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_uint* p_uvec_collector_prepare_##T(UVecCollector_##T *col,                  \
+                                                          UVec_##T *vec) {                          \
+        uvec_uint *offsets = UVEC_MALLOC((col->count + 1) * sizeof(*offsets));                      \
+        if (!offsets) return NULL;                                                                  \
+                                                                                                    \
+        offsets[0] = 0;                                                                             \
+        for (unsigned i = 0; i < col->count; ++i) {                                                 \
+            offsets[i + 1] = offsets[i] + col->slots[i].vec.count;                                  \
+        }                                                                                           \
+                                                                                                    \
+        if (p_uvec_cow_unshare(vec) ||                                                              \
+            uvec_reserve_capacity_##T(vec, vec->count + offsets[col->count])) {                     \
+            UVEC_FREE(offsets);                                                                     \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return offsets;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_collector_copy_##T(UVecCollector_##T *col,                           \
+                                                 uvec_uint const *offsets, T *dest) {               \
+        uvec_uint const total = offsets[col->count];                                                \
+        p_uvec_collector_copy_ctx_##T ctx = {                                                       \
+            .col = col, .offsets = offsets, .dest = dest,                                           \
+            .tasks = p_uvec_task_count(col->count, (size_t)total * sizeof(T))                       \
+        };                                                                                          \
+        p_uvec_run_parallel(ctx.tasks, p_uvec_collector_copy_task_##T, &ctx);                       \
+        for (unsigned i = 0; i < col->count; ++i) col->slots[i].vec.count = 0;                      \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecCollector_##T* uvec_collector_alloc_##T(unsigned count) {                             \
+        UVecCollector_##T *col = UVEC_MALLOC(sizeof(*col));                                         \
+        if (!col) return NULL;                                                                      \
+                                                                                                    \
+        col->count = count;                                                                         \
+        col->mem = UVEC_MALLOC(count * sizeof(*col->slots) + UVEC_CACHE_LINE_SIZE);                 \
+                                                                                                    \
+        if (!col->mem) {                                                                            \
+            UVEC_FREE(col);                                                                         \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        col->slots = (void *)p_uvec_cache_align((uintptr_t)col->mem);                               \
+        uvec_ret ret = UVEC_OK;                                                                     \
+                                                                                                    \
+        for (unsigned i = 0; i < count; ++i) {                                                      \
+            col->slots[i].vec = uvec_init(T);                                                       \
+            if (!ret) ret = p_uvec_registry_own(&col->slots[i].vec);                                \
+        }                                                                                           \
+                                                                                                    \
+        if (ret) {                                                                                  \
+            for (unsigned i = 0; i < count; ++i) uvec_deinit(col->slots[i].vec);                    \
+            UVEC_FREE(col->mem);                                                                    \
+            UVEC_FREE(col);                                                                         \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return col;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_collector_free_##T(UVecCollector_##T *col) {                                    \
+        if (!col) return;                                                                           \
+        for (unsigned i = 0; i < col->count; ++i) uvec_deinit(col->slots[i].vec);                   \
+        UVEC_FREE(col->mem);                                                                        \
+        UVEC_FREE(col);                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_collector_count_##T(UVecCollector_##T const *col) {                        \
+        uvec_uint count = 0;                                                                        \
+        for (unsigned i = 0; i < col->count; ++i) count += col->slots[i].vec.count;                 \
+        return count;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_collector_combine_##T(UVecCollector_##T *col, UVec_##T *vec) {              \
+        uvec_uint *offsets = p_uvec_collector_prepare_##T(col, vec);                                \
+        if (!offsets) return UVEC_ERR;                                                              \
+                                                                                                    \
+        p_uvec_collector_copy_##T(col, offsets, vec->storage + vec->count);                         \
+        vec->count += offsets[col->count];                                                          \
+        UVEC_FREE(offsets);                                                                         \
+        return UVEC_OK;                                                                             \
+    }
+
+/**
+ * Generates function definitions for the specified comparable collector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ *
+ * @note Runs are sorted and merged via the comparison function of the UVec(T) type.
+ */
+#define P_UVEC_IMPL_COLLECTOR_COMPARABLE(T, SCOPE)                                                  \
+                                                                                                    \
+    typedef struct p_uvec_collector_merge_ctx_##T {                                                 \
+        UVecCollector_##T *col;                                                                     \
+        uvec_uint const *bounds;                                                                    \
+        T const *src;                                                                               \
+        T *dst;                                                                                     \
+        unsigned runs;                                                                              \
+    } p_uvec_collector_merge_ctx_##T;                                                               \
+                                                                                                    \
+    static inline void p_uvec_collector_sort_task_##T(void *data, unsigned idx) {                   \
+        p_uvec_collector_merge_ctx_##T *ctx = data;                                                 \
+        UVec_##T *vec = &ctx->col->slots[idx].vec;                                                  \
+        uvec_sort_range_##T(vec, 0, vec->count);                                                    \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_collector_merge_task_##T(void *data, unsigned idx) {                  \
+        p_uvec_collector_merge_ctx_##T *ctx = data;                                                 \
+        unsigned const run = 2 * idx;                                                               \
+        uvec_uint const start = ctx->bounds[run];                                                   \
+        uvec_uint const end = ctx->bounds[run + 2 <= ctx->runs ? run + 2 : run + 1];                \
+        uvec_uint l = start, r = ctx->bounds[run + 1], out = start;                                 \
+        uvec_uint const mid = r;                                                                    \
+        T const *src = ctx->src;                                                                    \
+        T *dst = ctx->dst;                                                                          \
+                                                                                                    \
+        while (l < mid && r < end) {                                                                \
+            dst[out++] = p_uvec_compare_##T(src[r], src[l]) ? src[r++] : src[l++];                  \
+        }                                                                                           \
+                                                                                                    \
+        memcpy(dst + out, src + l, (mid - l) * sizeof(T));                                          \
+        out += mid - l;                                                                             \
+        memcpy(dst + out, src + r, (end - r) * sizeof(T));                                          \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_collector_combine_sorted_##T(UVecCollector_##T *col, UVec_##T *vec) {       \
+        uvec_uint *bounds = p_uvec_collector_prepare_##T(col, vec);                                 \
+        if (!bounds) return UVEC_ERR;                                                               \
+                                                                                                    \
+        uvec_uint const total = bounds[col->count];                                                 \
+        T *storage = vec->storage + vec->count;                                                     \
+        T *scratch = NULL;                                                                          \
+                                                                                                    \
+        if (col->count > 1 && total && !(scratch = UVEC_MALLOC(total * sizeof(T)))) {               \
+            UVEC_FREE(bounds);                                                                      \
+            return UVEC_ERR;                                                                        \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_collector_merge_ctx_##T ctx = {                                                      \
+            .col = col, .bounds = bounds, .src = storage, .dst = scratch, .runs = col->count        \
+        };                                                                                          \
+        bool parallel = p_uvec_task_count(col->count, (size_t)total * sizeof(T)) > 1;               \
+                                                                                                    \
+        if (parallel) {                                                                             \
+            p_uvec_run_parallel(col->count, p_uvec_collector_sort_task_##T, &ctx);                  \
+        } else {                                                                                    \
+            for (unsigned i = 0; i < col->count; ++i) p_uvec_collector_sort_task_##T(&ctx, i);      \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_collector_copy_##T(col, bounds, storage);                                            \
+                                                                                                    \
+        while (scratch && ctx.runs > 1) {                                                           \
+            unsigned pairs = (ctx.runs + 1) / 2;                                                    \
+                                                                                                    \
+            if (p_uvec_task_count(pairs, (size_t)total * sizeof(T)) > 1) {                          \
+                p_uvec_run_parallel(pairs, p_uvec_collector_merge_task_##T, &ctx);                  \
+            } else {                                                                                \
+                for (unsigned i = 0; i < pairs; ++i) p_uvec_collector_merge_task_##T(&ctx, i);      \
+            }                                                                                       \
+                                                                                                    \
+            for (unsigned i = 1; i <= pairs; ++i) {                                                 \
+                bounds[i] = bounds[2 * i <= ctx.runs ? 2 * i : ctx.runs];                           \
+            }                                                                                       \
+                                                                                                    \
+            ctx.runs = pairs;                                                                       \
+            T *temp = (T *)ctx.src;                                                                 \
+            ctx.src = ctx.dst;                                                                      \
+            ctx.dst = temp;                                                                         \
+        }                                                                                           \
+                                                                                                    \
+        if (ctx.src != storage) memcpy(storage, ctx.src, total * sizeof(T));                        \
+        vec->count += total;                                                                        \
+        UVEC_FREE(scratch);                                                                         \
+        UVEC_FREE(bounds);                                                                          \
+        return UVEC_OK;                                                                             \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new collector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_DECL_COLLECTOR(T)                                                                     \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_DECL_COLLECTOR(T, p_uvec_unused)
+
+/**
+ * Declares a new collector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_DECL_COLLECTOR_SPEC(T, SPEC)                                                          \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_DECL_COLLECTOR(T, SPEC p_uvec_unused)
+
+/**
+ * Declares a new comparable collector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared as comparable.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_DECL_COLLECTOR_COMPARABLE(T)                                                          \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_DECL_COLLECTOR(T, p_uvec_unused)                                                        \
+    P_UVEC_DECL_COLLECTOR_COMPARABLE(T, p_uvec_unused)
+
+/**
+ * Declares a new comparable collector type, prepending a specifier
+ * to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_DECL_COLLECTOR_COMPARABLE_SPEC(T, SPEC)                                               \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_DECL_COLLECTOR(T, SPEC p_uvec_unused)                                                   \
+    P_UVEC_DECL_COLLECTOR_COMPARABLE(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared collector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_IMPL_COLLECTOR(T) \
+    P_UVEC_IMPL_COLLECTOR(T, p_uvec_unused)
+
+/**
+ * Implements a previously declared comparable collector type.
+ * Elements are compared via the comparison function of the UVec(T) type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_IMPL_COLLECTOR_COMPARABLE(T)                                                          \
+    P_UVEC_IMPL_COLLECTOR(T, p_uvec_unused)                                                        \
+    P_UVEC_IMPL_COLLECTOR_COMPARABLE(T, p_uvec_unused)
+
+/**
+ * Defines a new static collector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_INIT_COLLECTOR(T)                                                                     \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_IMPL_COLLECTOR(T, p_uvec_static_inline)
+
+/**
+ * Defines a new static comparable collector type.
+ * Elements are compared via the comparison function of the UVec(T) type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined as comparable.
+ *
+ * @public @related UVecCollector
+ */
+#define UVEC_INIT_COLLECTOR_COMPARABLE(T)                                                          \
+    P_UVEC_DEF_TYPE_COLLECTOR(T)                                                                   \
+    P_UVEC_IMPL_COLLECTOR(T, p_uvec_static_inline)                                                 \
+    P_UVEC_IMPL_COLLECTOR_COMPARABLE(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new collector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecCollector
+ */
+#define UVecCollector(T) P_UVEC_CONCAT(UVecCollector_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new collector.
+ *
+ * @param T [symbol] Vector type.
+ * @param count [unsigned] Number of per-thread vectors.
+ * @return [UVecCollector(T)*] Collector instance, or NULL on error.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_alloc(T, count) P_UVEC_CONCAT(uvec_collector_alloc_, T)(count)
+
+/**
+ * Deallocates the specified collector, along with its per-thread vectors.
+ *
+ * @param T [symbol] Vector type.
+ * @param col [UVecCollector(T)*] Collector to free.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_free(T, col) P_UVEC_CONCAT(uvec_collector_free_, T)(col)
+
+/// @name Primitives
+
+/**
+ * Returns the per-thread vector at the specified index. Each vector is cache line aligned,
+ * so that threads pushing to different vectors do not contend.
+ *
+ * @param col [UVecCollector(T)*] Collector instance.
+ * @param idx [unsigned] Index of the vector.
+ * @return [UVec(T)*] Per-thread vector.
+ *
+ * @note Each per-thread vector must only be accessed by one thread at a time.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_vec(col, idx) (&(col)->slots[(idx)].vec)
+
+/**
+ * Returns the total number of elements in the per-thread vectors.
+ *
+ * @param T [symbol] Vector type.
+ * @param col [UVecCollector(T)*] Collector instance.
+ * @return [uvec_uint] Number of elements.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_count(T, col) P_UVEC_CONCAT(uvec_collector_count_, T)(col)
+
+/**
+ * Appends the contents of the per-thread vectors to the specified vector, in order,
+ * then empties them. The destination vector is grown once, and large collections
+ * are copied in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param col [UVecCollector(T)*] Collector instance.
+ * @param vec [UVec(T)*] Destination vector.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Must only be called once all producers are done, and the caller has synchronized
+ *       with them (e.g. by joining their threads). Per-thread vectors retain their
+ *       capacity, so the collector can be reused without reallocating.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_combine(T, col, vec) P_UVEC_CONCAT(uvec_collector_combine_, T)(col, vec)
+
+/**
+ * Sorts the per-thread vectors, merges them and appends the result to the specified vector,
+ * then empties them. Sorting and merging are performed in parallel for large collections.
+ *
+ * @param T [symbol] Vector type.
+ * @param col [UVecCollector(T)*] Collector instance.
+ * @param vec [UVec(T)*] Destination vector.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The merge is stable with respect to the order of the per-thread vectors.
+ *       Existing elements in the destination vector are not merged with the new ones.
+ *
+ * @public @related UVecCollector
+ */
+#define uvec_collector_combine_sorted(T, col, vec) \
+    P_UVEC_CONCAT(uvec_collector_combine_sorted_, T)(col, vec)
+
+#endif // UVEC_COLLECTOR_H
@@ -0,0 +1,487 @@
+/**
+ * uVec - concurrent append vectors.
+ *
+ * Concurrent vectors allow multiple threads to append elements without locking.
+ * Storage is split into segments of exponentially increasing size, so that elements
+ * never move once they have been stored. Once all producers are done, the vector
+ * can be sealed into a regular UVec for single-threaded consumption.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_CONCURRENT_H
+#define UVEC_CONCURRENT_H
+
+#include "uvec.h"
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "Concurrent vectors require atomic operations, not available on this compiler."
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector supporting lock-free concurrent appends.
+ * @struct UVecConcurrent
+ */
+
+// #############
+// # Constants #
+// #############
+
+/// Base 2 logarithm of the size of the first segment.
+#define P_UVEC_CVEC_FIRST_BITS 6
+
+/// Number of elements in the first segment.
+#define P_UVEC_CVEC_FIRST_SIZE ((uvec_uint)1 << P_UVEC_CVEC_FIRST_BITS)
+
+/// Number of segments required to address UVEC_UINT_MAX elements.
+#define P_UVEC_CVEC_SEGMENTS (sizeof(uvec_uint) * 8 - P_UVEC_CVEC_FIRST_BITS + 1)
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Returns the index of the segment containing the element at the specified index.
+ * Segment 0 holds P_UVEC_CVEC_FIRST_SIZE elements, and segment k > 0 holds
+ * P_UVEC_CVEC_FIRST_SIZE * 2^(k - 1) elements.
+ *
+ * @param idx [uvec_uint] Index of the element.
+ * @return [unsigned] Index of the segment.
+ */
+p_uvec_static_inline unsigned p_uvec_cvec_segment(uvec_uint idx) {
+    return idx < P_UVEC_CVEC_FIRST_SIZE ? 0 : p_uvec_uint_log2(idx) - P_UVEC_CVEC_FIRST_BITS + 1;
+}
+
+/**
+ * Returns the index of the first element of the specified segment.
+ *
+ * @param seg [unsigned] Index of the segment.
+ * @return [uvec_uint] Index of the first element.
+ */
+p_uvec_static_inline uvec_uint p_uvec_cvec_segment_start(unsigned seg) {
+    return seg ? P_UVEC_CVEC_FIRST_SIZE << (seg - 1) : 0;
+}
+
+/**
+ * Returns the number of elements in the specified segment.
+ *
+ * @param seg [unsigned] Index of the segment.
+ * @return [uvec_uint] Number of elements.
+ */
+p_uvec_static_inline uvec_uint p_uvec_cvec_segment_size(unsigned seg) {
+    return seg ? P_UVEC_CVEC_FIRST_SIZE << (seg - 1) : P_UVEC_CVEC_FIRST_SIZE;
+}
+
+/**
+ * Claims 'n' contiguous slots, unless the vector would end up with more than
+ * UVEC_UINT_MAX elements.
+ *
+ * @param count [P_UVEC_ATOMIC(uvec_uint)*] Number of claimed slots.
+ * @param n [uvec_uint] Number of slots to claim.
+ * @return [uvec_uint] Index of the first claimed slot, or UVEC_INDEX_NOT_FOUND on overflow.
+ */
+p_uvec_static_inline uvec_uint p_uvec_cvec_claim(P_UVEC_ATOMIC(uvec_uint) *count, uvec_uint n) {
+    uvec_uint start = p_uvec_atomic_load(count, P_UVEC_MO_RELAXED);
+
+    do {
+        if (n > UVEC_UINT_MAX - start) return UVEC_INDEX_NOT_FOUND;
+    } while (!p_uvec_atomic_cas(count, &start, (uvec_uint)(start + n),
+                                P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED));
+
+    return start;
+}
+
+/**
+ * Defines a new concurrent vector struct.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_CONCURRENT(T)                                                               \
+    typedef struct UVecConcurrent_##T {                                                             \
+        /** @cond */                                                                                \
+        P_UVEC_ATOMIC(uvec_uint) count;                                                             \
+        P_UVEC_ATOMIC(bool) failed;                                                                 \
+        char pad[UVEC_CACHE_LINE_SIZE];                                                             \
+        P_UVEC_ATOMIC(T *) segments[P_UVEC_CVEC_SEGMENTS];                                          \
+        /** @endcond */                                                                             \
+    } UVecConcurrent_##T;
+
+/**
+ * Generates function declarations for the specified concurrent vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_CONCURRENT(T, SCOPE)                                                            \
+    /** @cond */                                                                                    \
+    SCOPE UVecConcurrent_##T* uvec_concurrent_alloc_##T(void);                                      \
+    SCOPE void uvec_concurrent_free_##T(UVecConcurrent_##T *cvec);                                  \
+    SCOPE T* uvec_concurrent_at_##T(UVecConcurrent_##T *cvec, uvec_uint idx);                       \
+    SCOPE uvec_ret uvec_concurrent_push_##T(UVecConcurrent_##T *cvec, T item);                      \
+    SCOPE uvec_uint uvec_concurrent_reserve_##T(UVecConcurrent_##T *cvec, uvec_uint n);             \
+    SCOPE uvec_ret uvec_concurrent_append_array_##T(UVecConcurrent_##T *cvec,                       \
+                                                    T const *array, uvec_uint n);                   \
+    SCOPE void uvec_concurrent_remove_all_##T(UVecConcurrent_##T *cvec);                            \
+    SCOPE UVec_##T* uvec_concurrent_seal_##T(UVecConcurrent_##T *cvec);                             \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified concurrent vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_CONCURRENT(T, SCOPE)                                                            \
+                                                                                                    \
+    static inline T* uvec_concurrent_segment_##T(UVecConcurrent_##T *cvec, unsigned seg) {          \
+        T *storage = p_uvec_atomic_load(&cvec->segments[seg], P_UVEC_MO_ACQUIRE);                   \
+        if (storage) return storage;                                                                \
+                                                                                                    \
+        T *new_storage = UVEC_MALLOC(p_uvec_cvec_segment_size(seg) * sizeof(T));                    \
+        if (!new_storage) return NULL;                                                              \
+                                                                                                    \
+        if (p_uvec_atomic_cas(&cvec->segments[seg], &storage, new_storage,                          \
+                              P_UVEC_MO_ACQ_REL, P_UVEC_MO_ACQUIRE)) {                              \
+            return new_storage;                                                                     \
+        }                                                                                           \
+                                                                                                    \
+        UVEC_FREE(new_storage);                                                                     \
+        return storage;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecConcurrent_##T* uvec_concurrent_alloc_##T(void) {                                     \
+        UVecConcurrent_##T *cvec = UVEC_MALLOC(sizeof(*cvec));                                      \
+        if (!cvec) return NULL;                                                                     \
+                                                                                                    \
+        p_uvec_atomic_init(&cvec->count, 0);                                                        \
+        p_uvec_atomic_init(&cvec->failed, false);                                                   \
+        for (unsigned i = 0; i < P_UVEC_CVEC_SEGMENTS; ++i) {                                       \
+            p_uvec_atomic_init(&cvec->segments[i], NULL);                                           \
+        }                                                                                           \
+                                                                                                    \
+        return cvec;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_concurrent_remove_all_##T(UVecConcurrent_##T *cvec) {                           \
+        for (unsigned i = 0; i < P_UVEC_CVEC_SEGMENTS; ++i) {                                       \
+            UVEC_FREE(p_uvec_atomic_exchange(&cvec->segments[i], NULL, P_UVEC_MO_ACQ_REL));         \
+        }                                                                                           \
+        p_uvec_atomic_store(&cvec->count, 0, P_UVEC_MO_RELAXED);                                    \
+        p_uvec_atomic_store(&cvec->failed, false, P_UVEC_MO_RELAXED);                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_concurrent_free_##T(UVecConcurrent_##T *cvec) {                                 \
+        if (!cvec) return;                                                                          \
+        uvec_concurrent_remove_all_##T(cvec);                                                       \
+        UVEC_FREE(cvec);                                                                            \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T* uvec_concurrent_at_##T(UVecConcurrent_##T *cvec, uvec_uint idx) {                      \
+        unsigned seg = p_uvec_cvec_segment(idx);                                                    \
+        T *storage = p_uvec_atomic_load(&cvec->segments[seg], P_UVEC_MO_ACQUIRE);                   \
+        return storage + (idx - p_uvec_cvec_segment_start(seg));                                    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_concurrent_push_##T(UVecConcurrent_##T *cvec, T item) {                     \
+        uvec_uint idx = p_uvec_cvec_claim(&cvec->count, 1);                                         \
+        if (idx == UVEC_INDEX_NOT_FOUND) return UVEC_ERR;                                           \
+                                                                                                    \
+        unsigned seg = p_uvec_cvec_segment(idx);                                                    \
+        T *storage = uvec_concurrent_segment_##T(cvec, seg);                                        \
+                                                                                                    \
+        if (!storage) {                                                                             \
+            p_uvec_atomic_store(&cvec->failed, true, P_UVEC_MO_RELAXED);                            \
+            return UVEC_ERR;                                                                        \
+        }                                                                                           \
+                                                                                                    \
+        storage[idx - p_uvec_cvec_segment_start(seg)] = item;                                       \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_concurrent_reserve_##T(UVecConcurrent_##T *cvec, uvec_uint n) {            \
+        uvec_uint start = p_uvec_cvec_claim(&cvec->count, n);                                       \
+        if (!n || start == UVEC_INDEX_NOT_FOUND) return start;                                      \
+                                                                                                    \
+        unsigned last = p_uvec_cvec_segment(start + n - 1);                                         \
+                                                                                                    \
+        for (unsigned seg = p_uvec_cvec_segment(start); seg <= last; ++seg) {                       \
+            if (!uvec_concurrent_segment_##T(cvec, seg)) {                                          \
+                p_uvec_atomic_store(&cvec->failed, true, P_UVEC_MO_RELAXED);                        \
+                return UVEC_INDEX_NOT_FOUND;                                                        \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        return start;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_concurrent_append_array_##T(UVecConcurrent_##T *cvec,                       \
+                                                    T const *array, uvec_uint n) {                  \
+        if (!(n && array)) return UVEC_OK;                                                          \
+                                                                                                    \
+        uvec_uint idx = uvec_concurrent_reserve_##T(cvec, n);                                       \
+        if (idx == UVEC_INDEX_NOT_FOUND) return UVEC_ERR;                                           \
+                                                                                                    \
+        for (unsigned seg = p_uvec_cvec_segment(idx); n; ++seg) {                                   \
+            uvec_uint offset = idx - p_uvec_cvec_segment_start(seg);                                \
+            uvec_uint span = p_uvec_cvec_segment_size(seg) - offset;                                \
+            if (span > n) span = n;                                                                 \
+                                                                                                    \
+            T *storage = p_uvec_atomic_load(&cvec->segments[seg], P_UVEC_MO_RELAXED);               \
+            memcpy(storage + offset, array, span * sizeof(T));                                      \
+                                                                                                    \
+            array += span;                                                                          \
+            idx += span;                                                                            \
+            n -= span;                                                                              \
+        }                                                                                           \
+                                                                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T* uvec_concurrent_seal_##T(UVecConcurrent_##T *cvec) {                            \
+        if (p_uvec_atomic_load(&cvec->failed, P_UVEC_MO_ACQUIRE)) return NULL;                      \
+                                                                                                    \
+        uvec_uint count = p_uvec_atomic_load(&cvec->count, P_UVEC_MO_ACQUIRE);                      \
+        UVec_##T *vec = uvec_alloc_##T();                                                           \
+                                                                                                    \
+        if (!vec || uvec_reserve_capacity_##T(vec, count)) {                                        \
+            uvec_free_##T(vec);                                                                     \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        for (unsigned seg = 0; vec->count < count; ++seg) {                                         \
+            uvec_uint span = p_uvec_cvec_segment_size(seg);                                         \
+            if (span > count - vec->count) span = count - vec->count;                               \
+            T *storage = p_uvec_atomic_load(&cvec->segments[seg], P_UVEC_MO_ACQUIRE);               \
+            uvec_append_array_##T(vec, storage, span);                                              \
+        }                                                                                           \
+                                                                                                    \
+        uvec_concurrent_remove_all_##T(cvec);                                                       \
+        return vec;                                                                                 \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new concurrent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecConcurrent
+ */
+#define UVEC_DECL_CONCURRENT(T)                                                                     \
+    P_UVEC_DEF_TYPE_CONCURRENT(T)                                                                   \
+    P_UVEC_DECL_CONCURRENT(T, p_uvec_unused)
+
+/**
+ * Declares a new concurrent vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecConcurrent
+ */
+#define UVEC_DECL_CONCURRENT_SPEC(T, SPEC)                                                          \
+    P_UVEC_DEF_TYPE_CONCURRENT(T)                                                                   \
+    P_UVEC_DECL_CONCURRENT(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared concurrent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecConcurrent
+ */
+#define UVEC_IMPL_CONCURRENT(T) \
+    P_UVEC_IMPL_CONCURRENT(T, p_uvec_unused)
+
+/**
+ * Defines a new static concurrent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecConcurrent
+ */
+#define UVEC_INIT_CONCURRENT(T)                                                                     \
+    P_UVEC_DEF_TYPE_CONCURRENT(T)                                                                   \
+    P_UVEC_IMPL_CONCURRENT(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new concurrent vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecConcurrent
+ */
+#define UVecConcurrent(T) P_UVEC_CONCAT(UVecConcurrent_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new concurrent vector.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecConcurrent(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_alloc(T) P_UVEC_CONCAT(uvec_concurrent_alloc_, T)()
+
+/**
+ * Deallocates the specified concurrent vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector to free.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_free(T, cvec) P_UVEC_CONCAT(uvec_concurrent_free_, T)(cvec)
+
+/// @name Primitives
+
+/**
+ * Returns the number of elements in the concurrent vector, including those
+ * whose slots have been reserved but that may not have been stored yet.
+ *
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @return [uvec_uint] Number of elements.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_count(cvec) p_uvec_atomic_load(&(cvec)->count, P_UVEC_MO_ACQUIRE)
+
+/**
+ * Returns a pointer to the element at the specified index.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param idx [uvec_uint] Index of a reserved slot.
+ * @return [T*] Pointer to the element.
+ *
+ * @note Elements never move, so the returned pointer is valid until the vector is sealed,
+ *       cleared or deallocated.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_at(T, cvec, idx) P_UVEC_CONCAT(uvec_concurrent_at_, T)(cvec, idx)
+
+/**
+ * Retrieves the element at the specified index.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @return [T] Element at the specified index.
+ *
+ * @note The element must have been stored by a push that happens-before this call.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_get(T, cvec, idx) (*P_UVEC_CONCAT(uvec_concurrent_at_, T)(cvec, idx))
+
+/**
+ * Pushes the specified element to the top of the vector. Safe to call from multiple threads.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Pushes fail without affecting the vector if it already holds UVEC_UINT_MAX elements.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_push(T, cvec, item) P_UVEC_CONCAT(uvec_concurrent_push_, T)(cvec, item)
+
+/**
+ * Reserves 'n' contiguous slots, which the caller can then fill via uvec_concurrent_at.
+ * Safe to call from multiple threads.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param n [uvec_uint] Number of slots to reserve.
+ * @return [uvec_uint] Index of the first reserved slot, or UVEC_INDEX_NOT_FOUND on error.
+ *
+ * @note Reserved slots may span multiple segments, so they must be accessed
+ *       via uvec_concurrent_at rather than through pointer arithmetic.
+ *       Reservations fail without affecting the vector if it would end up with more than
+ *       UVEC_UINT_MAX elements.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_reserve(T, cvec, n) P_UVEC_CONCAT(uvec_concurrent_reserve_, T)(cvec, n)
+
+/**
+ * Appends an array to the vector, as a contiguous block. Safe to call from multiple threads.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param array [T*] Array to append.
+ * @param n [uvec_uint] Number of elements to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_append_array(T, cvec, array, n) \
+    P_UVEC_CONCAT(uvec_concurrent_append_array_, T)(cvec, array, n)
+
+/**
+ * Appends a vector to the concurrent vector, as a contiguous block.
+ * Safe to call from multiple threads.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @param vec [UVec(T)*] Vector to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_append(T, cvec, vec) \
+    P_UVEC_CONCAT(uvec_concurrent_append_array_, T)(cvec, (vec)->storage, (vec)->count)
+
+/**
+ * Removes all the elements in the vector, releasing its storage.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ *
+ * @note Must not be called concurrently with other operations.
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_remove_all(T, cvec) P_UVEC_CONCAT(uvec_concurrent_remove_all_, T)(cvec)
+
+/**
+ * Moves the elements of the concurrent vector into a new vector, leaving it empty.
+ *
+ * @param T [symbol] Vector type.
+ * @param cvec [UVecConcurrent(T)*] Vector instance.
+ * @return [UVec(T)*] Vector containing the elements, or NULL if memory could not be allocated,
+ *                    either now or during any previous push or reservation.
+ *
+ * @note Must only be called once all producers are done, and the caller has synchronized
+ *       with them (e.g. by joining their threads).
+ *
+ * @public @related UVecConcurrent
+ */
+#define uvec_concurrent_seal(T, cvec) P_UVEC_CONCAT(uvec_concurrent_seal_, T)(cvec)
+
+#endif // UVEC_CONCURRENT_H
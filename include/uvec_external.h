@@ -0,0 +1,536 @@
+/**
+ * uVec - external memory sorting.
+ *
+ * Sorts serialized vectors that do not fit in memory. The input is read in runs
+ * that fit in the memory budget, each run is sorted via the vector's sort function
+ * and spilled to a temporary file, and runs are then merged in a single pass via
+ * a loser tree. During the merge, a reader thread prefetches the next block of each
+ * run while the calling thread merges the current ones.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_EXTERNAL_H
+#define UVEC_EXTERNAL_H
+
+#include "uvec_io.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+// #########
+// # Types #
+// #########
+
+/**
+ * Sorted run in the temporary file, double-buffered during the merge.
+ * The back buffer and 'next' belong to the reader thread until 'ready' is set,
+ * while 'left' only belongs to the merging thread.
+ */
+typedef struct p_uvec_ext_run {
+    uint64_t next;
+    uint64_t end;
+    uint64_t left;
+    unsigned char *buf[2];
+    uvec_uint len[2];
+    unsigned front;
+    bool ready;
+} p_uvec_ext_run;
+
+/// Prefetches blocks of sorted runs.
+typedef struct p_uvec_ext_reader {
+    int fd;
+    size_t size;
+    uvec_uint block;
+    unsigned k;
+    unsigned cursor;
+    p_uvec_ext_run *runs;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool threaded;
+    bool stop;
+    bool failed;
+} p_uvec_ext_reader;
+
+// #############
+// # Constants #
+// #############
+
+/// Default memory budget of external sorts, in bytes.
+#define P_UVEC_EXTERNAL_MEMORY ((size_t)1 << 26u)
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Reads from a file descriptor at the specified offset, retrying on partial reads
+ * and interruptions.
+ *
+ * @param fd [int] File descriptor.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @param offset [off_t] Offset.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO on end of file, UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_fd_pread(int fd, void *buf, size_t len, off_t offset) {
+    for (char *ptr = buf; len;) {
+        ssize_t ret = pread(fd, ptr, len < P_UVEC_IO_CHUNK ? len : P_UVEC_IO_CHUNK, offset);
+
+        if (ret > 0) {
+            ptr += ret;
+            len -= (size_t)ret;
+            offset += ret;
+        } else if (!ret) {
+            return UVEC_NO;
+        } else if (errno != EINTR) {
+            return UVEC_ERR;
+        }
+    }
+
+    return UVEC_OK;
+}
+
+/**
+ * Creates an anonymous temporary file.
+ *
+ * @param dir [char const*] Directory, or NULL for the default temporary directory.
+ * @param[out] file [FILE**] Stream, if the file was created via tmpfile.
+ * @return [int] File descriptor, or -1 on error.
+ */
+p_uvec_static_inline int p_uvec_ext_tmp(char const *dir, FILE **file) {
+    *file = NULL;
+
+    if (!dir) {
+        *file = tmpfile();
+        return *file ? fileno(*file) : -1;
+    }
+
+    static char const name[] = "/uvec-sort-XXXXXX";
+    size_t const len = strlen(dir);
+    char *path = UVEC_MALLOC(len + sizeof(name));
+    if (!path) return -1;
+
+    memcpy(path, dir, len);
+    memcpy(path + len, name, sizeof(name));
+
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    UVEC_FREE(path);
+    return fd;
+}
+
+/**
+ * Loads the next block of a run into its back buffer.
+ *
+ * @param r [p_uvec_ext_reader*] Reader.
+ * @param run [p_uvec_ext_run*] Run.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_ext_load(p_uvec_ext_reader *r, p_uvec_ext_run *run) {
+    unsigned const back = run->front ^ 1u;
+    uint64_t const left = run->end - run->next;
+    uvec_uint const n = left < r->block ? (uvec_uint)left : r->block;
+
+    if (p_uvec_io_fd_pread(r->fd, run->buf[back], n * r->size, (off_t)(run->next * r->size))) {
+        return UVEC_ERR;
+    }
+
+    run->len[back] = n;
+    run->next += n;
+    return UVEC_OK;
+}
+
+/**
+ * Main function of the reader thread.
+ *
+ * @param arg [p_uvec_ext_reader*] Reader.
+ * @return [void*] NULL.
+ */
+p_uvec_static_inline void* p_uvec_ext_reader_main(void *arg) {
+    p_uvec_ext_reader *r = arg;
+    pthread_mutex_lock(&r->lock);
+
+    while (!r->stop) {
+        p_uvec_ext_run *run = NULL;
+
+        for (unsigned i = 0; i < r->k; ++i) {
+            unsigned const idx = (r->cursor + i) % r->k;
+
+            if (!r->runs[idx].ready && r->runs[idx].next < r->runs[idx].end) {
+                run = &r->runs[idx];
+                r->cursor = idx + 1;
+                break;
+            }
+        }
+
+        if (!run) {
+            pthread_cond_wait(&r->cond, &r->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&r->lock);
+        uvec_ret ret = p_uvec_ext_load(r, run);
+        pthread_mutex_lock(&r->lock);
+
+        if (ret) r->failed = true;
+        run->ready = true;
+        pthread_cond_broadcast(&r->cond);
+        if (ret) break;
+    }
+
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+/**
+ * Swaps the buffers of a run, waiting for the reader thread to fill its back buffer.
+ *
+ * @param r [p_uvec_ext_reader*] Reader.
+ * @param run [p_uvec_ext_run*] Run.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_ext_swap(p_uvec_ext_reader *r, p_uvec_ext_run *run) {
+    if (!r->threaded) {
+        if (p_uvec_ext_load(r, run)) return UVEC_ERR;
+        run->front ^= 1u;
+        return UVEC_OK;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    while (!run->ready && !r->failed) pthread_cond_wait(&r->cond, &r->lock);
+    bool const failed = r->failed;
+
+    if (!failed) {
+        run->front ^= 1u;
+        run->ready = false;
+        pthread_cond_broadcast(&r->cond);
+    }
+
+    pthread_mutex_unlock(&r->lock);
+    return failed ? UVEC_ERR : UVEC_OK;
+}
+
+/**
+ * Initializes a reader and starts its thread. If the thread cannot be started,
+ * blocks are loaded on the calling thread.
+ *
+ * @param r [p_uvec_ext_reader*] Reader.
+ * @param fd [int] File descriptor of the temporary file.
+ * @param size [size_t] Element size.
+ * @param count [uint64_t] Number of elements.
+ * @param run_size [uvec_uint] Number of elements of each run, except the last one.
+ * @param k [unsigned] Number of runs.
+ * @param block [uvec_uint] Number of elements of each buffer.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_ext_reader_init(p_uvec_ext_reader *r, int fd, size_t size,
+                                                     uint64_t count, uvec_uint run_size,
+                                                     unsigned k, uvec_uint block) {
+    r->fd = fd;
+    r->size = size;
+    r->block = block;
+    r->k = k;
+    r->cursor = 0;
+    r->stop = false;
+    r->failed = false;
+    r->runs = UVEC_MALLOC(k * sizeof(*r->runs));
+    unsigned char *buf = UVEC_MALLOC(2 * (size_t)k * block * size);
+
+    if (!(r->runs && buf)) {
+        UVEC_FREE(r->runs);
+        UVEC_FREE(buf);
+        return UVEC_ERR;
+    }
+
+    for (unsigned i = 0; i < k; ++i) {
+        p_uvec_ext_run *run = &r->runs[i];
+        run->next = (uint64_t)i * run_size;
+        run->end = count - run->next < run_size ? count : run->next + run_size;
+        run->left = run->end - run->next;
+        run->buf[0] = buf + 2 * (size_t)i * block * size;
+        run->buf[1] = run->buf[0] + (size_t)block * size;
+        run->len[0] = run->len[1] = 0;
+        run->front = 0;
+        run->ready = false;
+    }
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    r->threaded = !pthread_create(&r->thread, NULL, p_uvec_ext_reader_main, r);
+    return UVEC_OK;
+}
+
+/**
+ * Stops the reader thread and releases the reader's resources.
+ *
+ * @param r [p_uvec_ext_reader*] Reader.
+ */
+p_uvec_static_inline void p_uvec_ext_reader_deinit(p_uvec_ext_reader *r) {
+    if (r->threaded) {
+        pthread_mutex_lock(&r->lock);
+        r->stop = true;
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+        pthread_join(r->thread, NULL);
+    }
+
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    UVEC_FREE(r->runs[0].buf[0]);
+    UVEC_FREE(r->runs);
+}
+
+/**
+ * Generates function declarations for the external sort of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_EXTERNAL(T, SCOPE)                                                              \
+    /** @cond */                                                                                    \
+    SCOPE uvec_ret uvec_external_sort_##T(int in_fd, int out_fd, size_t memory,                     \
+                                          char const *tmp_dir);                                     \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the external sort of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_EXTERNAL(T, SCOPE)                                                              \
+                                                                                                    \
+    typedef struct p_uvec_ext_ctx_##T {                                                             \
+        UVecWriter *w;                                                                              \
+        int fd;                                                                                     \
+    } p_uvec_ext_ctx_##T;                                                                           \
+                                                                                                    \
+    static inline uvec_uint p_uvec_ext_lower_bound_##T(T const *array, uvec_uint n, T item) {       \
+        UVec_##T view = uvec_init(T);                                                               \
+        view.storage = (T *)array;                                                                  \
+        view.count = view.allocated = n;                                                            \
+        return uvec_insertion_index_sorted_##T(&view, item);                                        \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_ret p_uvec_ext_spill_##T(UVec_##T *chunk, uint64_t offset, void *data) {     \
+        p_uvec_ext_ctx_##T *ctx = data;                                                             \
+        uvec_sort_range_##T(chunk, 0, chunk->count);                                                \
+        (void)offset;                                                                               \
+        if (ctx->w) return uvec_writer_append_##T(ctx->w, chunk);                                   \
+        return p_uvec_io_fd_write(&ctx->fd, chunk->storage, chunk->count * sizeof(T));              \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_ret p_uvec_ext_merge_##T(p_uvec_ext_reader *r, UVecWriter *w) {              \
+        unsigned const k = r->k;                                                                    \
+        T const **heads = UVEC_MALLOC(k * (4 * sizeof(*heads) + 3 * sizeof(unsigned)));             \
+        T *out = UVEC_MALLOC((size_t)k * r->block * sizeof(T));                                     \
+        uvec_ret ret = heads && out ? UVEC_OK : UVEC_ERR;                                           \
+        if (ret) goto end;                                                                          \
+                                                                                                    \
+        T const **ends = heads + k, **pos = ends + k, **lim = pos + k;                              \
+        unsigned *tree = (unsigned *)(lim + k);                                                     \
+        for (unsigned i = 0; i < k; ++i) pos[i] = lim[i] = NULL;                                    \
+                                                                                                    \
+        while (true) {                                                                              \
+            unsigned bound = k;                                                                     \
+                                                                                                    \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                p_uvec_ext_run *run = &r->runs[i];                                                  \
+                                                                                                    \
+                if (pos[i] == lim[i] && run->left) {                                                \
+                    if ((ret = p_uvec_ext_swap(r, run))) goto end;                                  \
+                    pos[i] = (T const *)(void *)run->buf[run->front];                               \
+                    lim[i] = pos[i] + run->len[run->front];                                         \
+                    run->left -= run->len[run->front];                                              \
+                }                                                                                   \
+                                                                                                    \
+                if (run->left) {                                                                    \
+                    if (bound == k || p_uvec_ext_lower_bound_##T(lim[i] - 1, 1, lim[bound][-1])) {  \
+                        bound = i;                                                                  \
+                    }                                                                               \
+                }                                                                                   \
+            }                                                                                       \
+                                                                                                    \
+            uvec_uint total = 0;                                                                    \
+                                                                                                    \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                heads[i] = ends[i] = pos[i];                                                        \
+                if (!pos[i]) continue;                                                              \
+                if (bound == k || bound == i) {                                                     \
+                    ends[i] = lim[i];                                                               \
+                } else {                                                                            \
+                    ends[i] += p_uvec_ext_lower_bound_##T(pos[i], (uvec_uint)(lim[i] - pos[i]),     \
+                                                          lim[bound][-1]);                          \
+                }                                                                                   \
+                total += (uvec_uint)(ends[i] - heads[i]);                                           \
+                pos[i] = ends[i];                                                                   \
+            }                                                                                       \
+                                                                                                    \
+            if (total) {                                                                            \
+                p_uvec_merge_k_##T(out, heads, ends, k, tree);                                      \
+                if ((ret = p_uvec_writer_append(w, out, sizeof(T), total))) goto end;               \
+            }                                                                                       \
+                                                                                                    \
+            if (bound == k) break;                                                                  \
+        }                                                                                           \
+                                                                                                    \
+    end:                                                                                            \
+        UVEC_FREE(out);                                                                             \
+        UVEC_FREE(heads);                                                                           \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_external_sort_##T(int in_fd, int out_fd, size_t memory,                     \
+                                          char const *tmp_dir) {                                    \
+        uint64_t count, checksum;                                                                   \
+        bool swap;                                                                                  \
+                                                                                                    \
+        uvec_ret ret = p_uvec_io_read_header(p_uvec_io_fd_read, &in_fd, sizeof(T), &count,          \
+                                             &checksum, &swap);                                     \
+        if (ret) return ret;                                                                        \
+                                                                                                    \
+        if (!memory) memory = P_UVEC_EXTERNAL_MEMORY;                                               \
+        size_t const elems = memory / sizeof(T);                                                    \
+        uvec_uint run_size = elems > UVEC_UINT_MAX / 2 ? UVEC_UINT_MAX / 2 : (uvec_uint)elems;      \
+        run_size = p_uvec_io_window(run_size ? run_size : 1, sizeof(T));                            \
+                                                                                                    \
+        uint64_t const runs = count / run_size + (count % run_size != 0);                           \
+        if (runs > UINT_MAX / 4) return UVEC_ERR;                                                   \
+        unsigned const k = (unsigned)runs;                                                          \
+                                                                                                    \
+        UVecWriter *w = p_uvec_writer_open(out_fd, sizeof(T), 0);                                   \
+        if (!w) return UVEC_ERR;                                                                    \
+        p_uvec_ext_ctx_##T ctx = { .w = w, .fd = -1 };                                              \
+                                                                                                    \
+        if (k <= 1) {                                                                               \
+            ret = p_uvec_io_read_chunks_##T(in_fd, count, checksum, swap, run_size,                 \
+                                            p_uvec_ext_spill_##T, &ctx);                            \
+            uvec_ret const close_ret = uvec_writer_close(w);                                        \
+            return ret ? ret : close_ret;                                                           \
+        }                                                                                           \
+                                                                                                    \
+        FILE *file;                                                                                 \
+        ctx.w = NULL;                                                                               \
+        ctx.fd = p_uvec_ext_tmp(tmp_dir, &file);                                                    \
+        if (ctx.fd < 0) ret = UVEC_ERR;                                                             \
+                                                                                                    \
+        if (!ret) {                                                                                 \
+            ret = p_uvec_io_read_chunks_##T(in_fd, count, checksum, swap, run_size,                 \
+                                            p_uvec_ext_spill_##T, &ctx);                            \
+        }                                                                                           \
+                                                                                                    \
+        if (!ret) {                                                                                 \
+            p_uvec_ext_reader r;                                                                    \
+            uvec_uint block = (uvec_uint)(memory / (3 * (size_t)k * sizeof(T)));                    \
+            if (block < 4) block = 4;                                                               \
+            if (block > run_size) block = run_size;                                                 \
+                                                                                                    \
+            ret = p_uvec_ext_reader_init(&r, ctx.fd, sizeof(T), count, run_size, k, block);         \
+                                                                                                    \
+            if (!ret) {                                                                             \
+                ret = p_uvec_ext_merge_##T(&r, w);                                                  \
+                p_uvec_ext_reader_deinit(&r);                                                       \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        if (file) {                                                                                 \
+            fclose(file);                                                                           \
+        } else if (ctx.fd >= 0) {                                                                   \
+            close(ctx.fd);                                                                          \
+        }                                                                                           \
+                                                                                                    \
+        uvec_ret const close_ret = uvec_writer_close(w);                                            \
+        return ret ? ret : close_ret;                                                               \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares the external sort of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_EXTERNAL(T) \
+    P_UVEC_DECL_EXTERNAL(T, p_uvec_unused)
+
+/**
+ * Declares the external sort of the specified vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_EXTERNAL_SPEC(T, SPEC) \
+    P_UVEC_DECL_EXTERNAL(T, SPEC p_uvec_unused)
+
+/**
+ * Implements the previously declared external sort of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have been implemented as a comparable type,
+ *       and its serialization functions must have been implemented.
+ *
+ * @public @related UVec
+ */
+#define UVEC_IMPL_EXTERNAL(T) \
+    P_UVEC_IMPL_EXTERNAL(T, p_uvec_unused)
+
+/**
+ * Defines the static external sort of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have been defined as a comparable type,
+ *       and its serialization functions must have been defined.
+ *
+ * @public @related UVec
+ */
+#define UVEC_INIT_EXTERNAL(T) \
+    P_UVEC_IMPL_EXTERNAL(T, p_uvec_static_inline)
+
+/// @name Sorting
+
+/**
+ * Sorts a serialized vector that may not fit in memory. The sort uses
+ * the comparison function of the vector type, and is not stable.
+ *
+ * @param T [symbol] Vector type.
+ * @param in_fd [int] File descriptor from which the vector is read.
+ * @param out_fd [int] Seekable file descriptor to which the sorted vector is written.
+ * @param memory [size_t] Memory budget in bytes, used for sorted runs and merge buffers.
+ *                        If zero, a budget of 64 MiB is used.
+ * @param tmp_dir [char const*] Directory where sorted runs are spilled,
+ *                              or NULL for the default temporary directory.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the input is invalid, truncated,
+ *                    corrupted or has a different element size, otherwise UVEC_ERR.
+ *
+ * @note Runs are merged in a single pass, so the budget should be large enough
+ *       to hold a few blocks of each run: with a budget of M bytes, inputs up to
+ *       about M * M / (3 * 4 * sizeof(T)) bytes are merged with at least 4 elements
+ *       per block, and larger inputs exceed the budget.
+ * @note If the operation fails, the contents of 'out_fd' are unspecified.
+ *
+ * @public @related UVec
+ */
+#define uvec_external_sort(T, in_fd, out_fd, memory, tmp_dir) \
+    P_UVEC_CONCAT(uvec_external_sort_, T)(in_fd, out_fd, memory, tmp_dir)
+
+#endif // UVEC_EXTERNAL_H
@@ -0,0 +1,464 @@
+/**
+ * uVec - incrementally resized vectors.
+ *
+ * Incremental vectors de-amortize growth: when full, they allocate a new buffer but do not
+ * copy their elements right away. Instead, each subsequent push migrates a few elements
+ * from the old buffer, and indexing checks both buffers until migration completes.
+ * Pushes therefore never copy the whole vector, and their worst case latency is constant,
+ * excluding the cost of the allocation itself. Once migration completes, the elements
+ * can be accessed as a regular UVec.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_INCREMENTAL_H
+#define UVEC_INCREMENTAL_H
+
+#include "uvec.h"
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector whose elements migrate incrementally to a new buffer on growth.
+ * @struct UVecIncremental
+ */
+
+// #############
+// # Constants #
+// #############
+
+/**
+ * Number of elements migrated to the new buffer by each insertion. Any value greater than
+ * zero completes migration before the new buffer fills up, as it is twice as large as the old
+ * one; larger values release the old buffer sooner, at the expense of slower insertions.
+ */
+#define P_UVEC_INCREMENTAL_STEP 2
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Defines a new incremental vector struct.
+ * Elements whose index is lower than 'pending' are stored in the old buffer,
+ * the others in the storage of the underlying vector.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_INCREMENTAL(T)                                                              \
+    typedef struct UVecIncremental_##T {                                                            \
+        /** @cond */                                                                                \
+        UVec_##T vec;                                                                               \
+        T *old;                                                                                     \
+        uvec_uint pending;                                                                          \
+        /** @endcond */                                                                             \
+    } UVecIncremental_##T;
+
+/**
+ * Generates function declarations for the specified incremental vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_INCREMENTAL(T, SCOPE)                                                           \
+    /** @cond */                                                                                    \
+    SCOPE UVecIncremental_##T* uvec_incremental_alloc_##T(void);                                    \
+    SCOPE void uvec_incremental_free_##T(UVecIncremental_##T *iv);                                  \
+    SCOPE T* uvec_incremental_at_##T(UVecIncremental_##T *iv, uvec_uint idx);                       \
+    SCOPE T uvec_incremental_get_##T(UVecIncremental_##T const *iv, uvec_uint idx);                 \
+    SCOPE void uvec_incremental_set_##T(UVecIncremental_##T *iv, uvec_uint idx, T item);            \
+    SCOPE uvec_ret uvec_incremental_push_##T(UVecIncremental_##T *iv, T item);                      \
+    SCOPE uvec_ret uvec_incremental_append_array_##T(UVecIncremental_##T *iv,                       \
+                                                     T const *array, uvec_uint n);                  \
+    SCOPE T uvec_incremental_pop_##T(UVecIncremental_##T *iv);                                      \
+    SCOPE void uvec_incremental_remove_all_##T(UVecIncremental_##T *iv);                            \
+    SCOPE void uvec_incremental_flush_##T(UVecIncremental_##T *iv);                                 \
+    SCOPE UVec_##T* uvec_incremental_vec_##T(UVecIncremental_##T *iv);                              \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified incremental vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_INCREMENTAL(T, SCOPE)                                                           \
+                                                                                                    \
+    static inline void p_uvec_incremental_migrate_##T(UVecIncremental_##T *iv, uvec_uint n) {       \
+        if (!iv->old) return;                                                                       \
+        if (n > iv->pending) n = iv->pending;                                                       \
+                                                                                                    \
+        iv->pending -= n;                                                                           \
+        memcpy(iv->vec.storage + iv->pending, iv->old + iv->pending, n * sizeof(T));                \
+        p_uvec_stats(T, UVEC_STATS_MOVE, n * sizeof(T));                                            \
+                                                                                                    \
+        if (!iv->pending) {                                                                         \
+            UVEC_FREE(iv->old);                                                                     \
+            iv->old = NULL;                                                                         \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_ret p_uvec_incremental_expand_##T(UVecIncremental_##T *iv) {                 \
+        if (iv->vec.count < iv->vec.allocated) return UVEC_OK;                                      \
+        p_uvec_incremental_migrate_##T(iv, iv->pending);                                            \
+                                                                                                    \
+        uvec_uint allocated = iv->vec.allocated ? iv->vec.allocated * 2 : 2;                        \
+        T *storage = UVEC_MALLOC(sizeof(T) * allocated);                                            \
+        if (!storage) return UVEC_ERR;                                                              \
+        p_uvec_stats(T, UVEC_STATS_REALLOC, sizeof(T) * allocated);                                 \
+                                                                                                    \
+        iv->old = iv->vec.storage;                                                                  \
+        iv->pending = iv->vec.count;                                                                \
+        iv->vec.storage = storage;                                                                  \
+        iv->vec.allocated = allocated;                                                              \
+        p_uvec_incremental_migrate_##T(iv, 0);                                                      \
+                                                                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecIncremental_##T* uvec_incremental_alloc_##T(void) {                                   \
+        UVecIncremental_##T *iv = UVEC_MALLOC(sizeof(*iv));                                         \
+        if (!iv) return NULL;                                                                       \
+                                                                                                    \
+        iv->vec = uvec_init(T);                                                                     \
+        iv->old = NULL;                                                                             \
+        iv->pending = 0;                                                                            \
+                                                                                                    \
+        return iv;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_incremental_remove_all_##T(UVecIncremental_##T *iv) {                           \
+        UVEC_FREE(iv->old);                                                                         \
+        iv->old = NULL;                                                                             \
+        iv->pending = 0;                                                                            \
+        iv->vec.count = 0;                                                                          \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_incremental_free_##T(UVecIncremental_##T *iv) {                                 \
+        if (!iv) return;                                                                            \
+        UVEC_FREE(iv->old);                                                                         \
+        uvec_deinit(iv->vec);                                                                       \
+        UVEC_FREE(iv);                                                                              \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T* uvec_incremental_at_##T(UVecIncremental_##T *iv, uvec_uint idx) {                      \
+        if (idx < iv->pending) return iv->old + idx;                                                \
+        return p_uvec_cow_unshare(&iv->vec) ? NULL : iv->vec.storage + idx;                         \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T uvec_incremental_get_##T(UVecIncremental_##T const *iv, uvec_uint idx) {                \
+        return idx < iv->pending ? iv->old[idx] : iv->vec.storage[idx];                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_incremental_set_##T(UVecIncremental_##T *iv, uvec_uint idx, T item) {           \
+        T *p = uvec_incremental_at_##T(iv, idx);                                                    \
+        if (p) *p = item;                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_incremental_push_##T(UVecIncremental_##T *iv, T item) {                     \
+        if (p_uvec_cow_unshare(&iv->vec) || p_uvec_incremental_expand_##T(iv)) return UVEC_ERR;     \
+        p_uvec_incremental_migrate_##T(iv, P_UVEC_INCREMENTAL_STEP);                                \
+        iv->vec.storage[iv->vec.count++] = item;                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_incremental_append_array_##T(UVecIncremental_##T *iv,                       \
+                                                     T const *array, uvec_uint n) {                 \
+        if (!(n && array)) return UVEC_OK;                                                          \
+        if (p_uvec_cow_unshare(&iv->vec)) return UVEC_ERR;                                          \
+                                                                                                    \
+        while (n) {                                                                                 \
+            if (p_uvec_incremental_expand_##T(iv)) return UVEC_ERR;                                 \
+                                                                                                    \
+            uvec_uint span = iv->vec.allocated - iv->vec.count;                                     \
+            if (span > n) span = n;                                                                 \
+                                                                                                    \
+            p_uvec_incremental_migrate_##T(iv, span < iv->pending / P_UVEC_INCREMENTAL_STEP ?       \
+                                               span * P_UVEC_INCREMENTAL_STEP : iv->pending);       \
+            memcpy(iv->vec.storage + iv->vec.count, array, span * sizeof(T));                       \
+                                                                                                    \
+            iv->vec.count += span;                                                                  \
+            array += span;                                                                          \
+            n -= span;                                                                              \
+        }                                                                                           \
+                                                                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T uvec_incremental_pop_##T(UVecIncremental_##T *iv) {                                     \
+        T item = uvec_incremental_get_##T(iv, --iv->vec.count);                                     \
+        if (iv->pending > iv->vec.count) iv->pending = iv->vec.count;                               \
+        p_uvec_incremental_migrate_##T(iv, P_UVEC_INCREMENTAL_STEP);                                \
+        return item;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_incremental_flush_##T(UVecIncremental_##T *iv) {                                \
+        p_uvec_incremental_migrate_##T(iv, iv->pending);                                            \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T* uvec_incremental_vec_##T(UVecIncremental_##T *iv) {                             \
+        uvec_incremental_flush_##T(iv);                                                             \
+        return &iv->vec;                                                                            \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new incremental vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecIncremental
+ */
+#define UVEC_DECL_INCREMENTAL(T)                                                                    \
+    P_UVEC_DEF_TYPE_INCREMENTAL(T)                                                                  \
+    P_UVEC_DECL_INCREMENTAL(T, p_uvec_unused)
+
+/**
+ * Declares a new incremental vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecIncremental
+ */
+#define UVEC_DECL_INCREMENTAL_SPEC(T, SPEC)                                                         \
+    P_UVEC_DEF_TYPE_INCREMENTAL(T)                                                                  \
+    P_UVEC_DECL_INCREMENTAL(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared incremental vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecIncremental
+ */
+#define UVEC_IMPL_INCREMENTAL(T) \
+    P_UVEC_IMPL_INCREMENTAL(T, p_uvec_unused)
+
+/**
+ * Defines a new static incremental vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecIncremental
+ */
+#define UVEC_INIT_INCREMENTAL(T)                                                                    \
+    P_UVEC_DEF_TYPE_INCREMENTAL(T)                                                                  \
+    P_UVEC_IMPL_INCREMENTAL(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new incremental vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecIncremental
+ */
+#define UVecIncremental(T) P_UVEC_CONCAT(UVecIncremental_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new, empty incremental vector.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecIncremental(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_alloc(T) P_UVEC_CONCAT(uvec_incremental_alloc_, T)()
+
+/**
+ * Deallocates the specified incremental vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector to free.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_free(T, iv) P_UVEC_CONCAT(uvec_incremental_free_, T)(iv)
+
+/// @name Primitives
+
+/**
+ * Returns the number of elements in the incremental vector.
+ *
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @return [uvec_uint] Number of elements.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_count(iv) ((iv)->vec.count)
+
+/**
+ * Returns the maximum number of elements that can be held by the incremental vector
+ * before it needs to grow.
+ *
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @return [uvec_uint] Capacity.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_capacity(iv) ((iv)->vec.allocated)
+
+/**
+ * Checks whether the incremental vector is migrating elements to a new buffer.
+ *
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @return [bool] True if some elements are still stored in the old buffer, false otherwise.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_migrating(iv) ((iv)->old != NULL)
+
+/**
+ * Returns a pointer to the element at the specified index, which can be used to modify it.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @return [T*] Pointer to the element, or NULL if shared storage could not be copied.
+ *
+ * @note Elements move during migration, so the returned pointer is only valid
+ *       until the next insertion or removal.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_at(T, iv, idx) P_UVEC_CONCAT(uvec_incremental_at_, T)(iv, idx)
+
+/**
+ * Retrieves the element at the specified index.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @return [T] Element at the specified index.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_get(T, iv, idx) P_UVEC_CONCAT(uvec_incremental_get_, T)(iv, idx)
+
+/**
+ * Replaces the element at the specified index.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @param item [T] Replacement element.
+ *
+ * @note In copy-on-write mode (UVEC_COW), the element is not replaced
+ *       if the shared storage cannot be copied.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_set(T, iv, idx, item) \
+    P_UVEC_CONCAT(uvec_incremental_set_, T)(iv, idx, item)
+
+/// @name Insertion and removal
+
+/**
+ * Pushes the specified element to the top of the vector, in constant time.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_push(T, iv, item) P_UVEC_CONCAT(uvec_incremental_push_, T)(iv, item)
+
+/**
+ * Appends an array to the vector. Elements are migrated proportionally to the number
+ * of appended elements, so that the time taken is linear in 'n'.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param array [T const*] Array to append.
+ * @param n [uvec_uint] Number of elements to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_append_array(T, iv, array, n) \
+    P_UVEC_CONCAT(uvec_incremental_append_array_, T)(iv, array, n)
+
+/**
+ * Appends a vector to the incremental vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @param vec [UVec(T)*] Vector to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_append(T, iv, vec) \
+    P_UVEC_CONCAT(uvec_incremental_append_array_, T)(iv, (vec)->storage, (vec)->count)
+
+/**
+ * Removes and returns the element at the top of the vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance, must not be empty.
+ * @return [T] Removed element.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_pop(T, iv) P_UVEC_CONCAT(uvec_incremental_pop_, T)(iv)
+
+/**
+ * Removes all the elements in the vector, keeping the capacity of the new buffer.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_remove_all(T, iv) P_UVEC_CONCAT(uvec_incremental_remove_all_, T)(iv)
+
+/// @name Conversion
+
+/**
+ * Migrates all the remaining elements to the new buffer, releasing the old one.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_flush(T, iv) P_UVEC_CONCAT(uvec_incremental_flush_, T)(iv)
+
+/**
+ * Completes migration and returns the underlying vector, so that it can be used
+ * with the regular vector API.
+ *
+ * @param T [symbol] Vector type.
+ * @param iv [UVecIncremental(T)*] Vector instance.
+ * @return [UVec(T)*] Underlying vector, owned by the incremental vector.
+ *
+ * @note The returned vector may be modified freely, but it is only guaranteed to hold
+ *       all the elements until the next insertion into the incremental vector.
+ *
+ * @public @related UVecIncremental
+ */
+#define uvec_incremental_vec(T, iv) P_UVEC_CONCAT(uvec_incremental_vec_, T)(iv)
+
+#endif // UVEC_INCREMENTAL_H
@@ -0,0 +1,1003 @@
+/**
+ * uVec - binary serialization.
+ *
+ * Vectors are serialized as a fixed-size header followed by their raw storage.
+ * The header records the element size, the number of elements, the byte order of the
+ * writer and a Fletcher-64 checksum of the storage, so that files can be validated
+ * on load and read on hosts with a different byte order. Vectors larger than memory
+ * can be streamed chunk by chunk via uvec_read_fd_chunked and UVecWriter, and the raw storage
+ * of many vectors can be transferred with a single system call via uvec_writev and uvec_readv.
+ *
+ * Header layout (64 bytes, fields in the byte order of the writer):
+ *
+ * | Offset | Size | Field                               |
+ * |--------|------|-------------------------------------|
+ * | 0      | 8    | Magic ("UVECBIN\0")                 |
+ * | 8      | 4    | Byte order mark (0x01020304)        |
+ * | 12     | 4    | Format version                      |
+ * | 16     | 8    | Element size                        |
+ * | 24     | 8    | Number of elements                  |
+ * | 32     | 8    | Checksum of the storage             |
+ * | 40     | 24   | Reserved (zero)                     |
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_IO_H
+#define UVEC_IO_H
+
+#include "uvec.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// #########
+// # Types #
+// #########
+
+/**
+ * Function transferring exactly 'len' bytes between a buffer and an I/O handle.
+ *
+ * @param handle [void*] I/O handle.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO on end of file, UVEC_ERR on error.
+ */
+typedef uvec_ret (*p_uvec_io_func)(void *handle, void *buf, size_t len);
+
+/// Running Fletcher-64 checksum.
+typedef struct p_uvec_fletcher {
+    uint64_t lo;
+    uint64_t hi;
+} p_uvec_fletcher;
+
+/**
+ * Writer serializing a stream of elements to a file descriptor.
+ * Elements are buffered, and written in large sequential writes.
+ */
+typedef struct UVecWriter {
+    /** @cond */
+    int fd;
+    off_t start;
+    size_t size;
+    uint64_t count;
+    p_uvec_fletcher f;
+    unsigned char *buf;
+    size_t buf_size;
+    size_t buf_len;
+    /** @endcond */
+} UVecWriter;
+
+// #############
+// # Constants #
+// #############
+
+/// Size of the serialization header.
+#define P_UVEC_IO_HEADER_SIZE 64
+
+/// Current version of the serialization format.
+#define P_UVEC_IO_VERSION 1
+
+/// Byte order mark, as written by the host.
+#define P_UVEC_IO_BOM 0x01020304u
+
+/// Byte order mark, as written by a host with the opposite byte order.
+#define P_UVEC_IO_BOM_SWAPPED 0x04030201u
+
+/// Maximum number of bytes transferred by a single system call.
+#define P_UVEC_IO_CHUNK ((size_t)1 << 30u)
+
+/// Number of 32 bit words that can be summed before reducing the Fletcher-64 sums.
+#define P_UVEC_FLETCHER_BLOCK ((size_t)1 << 16u)
+
+/// Magic bytes at the start of the serialization header (including the terminator).
+#define P_UVEC_IO_MAGIC "UVECBIN"
+
+/// Default size in bytes of the window used by chunked reads and writers.
+#define P_UVEC_IO_WINDOW ((size_t)1 << 20u)
+
+/// Maximum number of buffers transferred by a single scatter/gather system call.
+#if defined IOV_MAX && IOV_MAX < 1024
+    #define P_UVEC_IO_IOV_MAX IOV_MAX
+#elif defined IOV_MAX || defined __linux__
+    #define P_UVEC_IO_IOV_MAX 1024
+#else
+    #define P_UVEC_IO_IOV_MAX 16
+#endif
+
+// ###############
+// # Private API #
+// ###############
+
+/// Reverse the byte order of 16, 32 and 64 bit integers.
+#if defined __GNUC__ || defined __clang__
+    #define p_uvec_bswap16(x) __builtin_bswap16(x)
+    #define p_uvec_bswap32(x) __builtin_bswap32(x)
+    #define p_uvec_bswap64(x) __builtin_bswap64(x)
+#else
+    #define p_uvec_bswap16(x) ((uint16_t)(((uint16_t)(x) >> 8u) | ((uint16_t)(x) << 8u)))
+    #define p_uvec_bswap32(x) (                                                                     \
+        ((uint32_t)p_uvec_bswap16((uint16_t)(x)) << 16u) |                                          \
+        (uint32_t)p_uvec_bswap16((uint16_t)((uint32_t)(x) >> 16u))                                  \
+    )
+    #define p_uvec_bswap64(x) (                                                                     \
+        ((uint64_t)p_uvec_bswap32((uint32_t)(x)) << 32u) |                                          \
+        (uint64_t)p_uvec_bswap32((uint32_t)((uint64_t)(x) >> 32u))                                  \
+    )
+#endif
+
+/**
+ * Reverses the byte order of each element of an array.
+ *
+ * @param data [void*] Array.
+ * @param size [size_t] Element size, must be 1, 2, 4 or 8.
+ * @param count [size_t] Number of elements.
+ */
+p_uvec_static_inline void p_uvec_io_swap(void *data, size_t size, size_t count) {
+    unsigned char *bytes = data;
+
+    if (size == 2) {
+        for (size_t i = 0; i < count; ++i, bytes += 2) {
+            uint16_t x;
+            memcpy(&x, bytes, 2);
+            x = p_uvec_bswap16(x);
+            memcpy(bytes, &x, 2);
+        }
+    } else if (size == 4) {
+        for (size_t i = 0; i < count; ++i, bytes += 4) {
+            uint32_t x;
+            memcpy(&x, bytes, 4);
+            x = p_uvec_bswap32(x);
+            memcpy(bytes, &x, 4);
+        }
+    } else if (size == 8) {
+        for (size_t i = 0; i < count; ++i, bytes += 8) {
+            uint64_t x;
+            memcpy(&x, bytes, 8);
+            x = p_uvec_bswap64(x);
+            memcpy(bytes, &x, 8);
+        }
+    }
+}
+
+/**
+ * Updates a Fletcher-64 checksum. The data is processed as a sequence of little-endian
+ * 32 bit words, so that the checksum does not depend on the byte order of the host.
+ *
+ * @param f [p_uvec_fletcher*] Checksum.
+ * @param data [void const*] Data.
+ * @param len [size_t] Number of bytes, must be a multiple of 4 unless this is the last update.
+ */
+p_uvec_static_inline void p_uvec_fletcher_update(p_uvec_fletcher *f, void const *data, size_t len) {
+    unsigned char const *bytes = data;
+    uint64_t lo = f->lo, hi = f->hi;
+
+    while (len) {
+        size_t block = len < P_UVEC_FLETCHER_BLOCK * 4 ? len : P_UVEC_FLETCHER_BLOCK * 4;
+        len -= block;
+
+        for (; block >= 4; block -= 4, bytes += 4) {
+            lo += (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8u |
+                  (uint32_t)bytes[2] << 16u | (uint32_t)bytes[3] << 24u;
+            hi += lo;
+        }
+
+        if (block) {
+            uint32_t tail = 0;
+            for (size_t i = 0; i < block; ++i) tail |= (uint32_t)bytes[i] << (8u * i);
+            bytes += block;
+            lo += tail;
+            hi += lo;
+        }
+
+        lo %= UINT32_MAX;
+        hi %= UINT32_MAX;
+    }
+
+    f->lo = lo;
+    f->hi = hi;
+}
+
+/**
+ * Returns the value of a Fletcher-64 checksum.
+ *
+ * @param f [p_uvec_fletcher] Checksum.
+ * @return [uint64_t] Checksum value.
+ */
+#define p_uvec_fletcher_value(f) (((f).hi << 32u) | (f).lo)
+
+/**
+ * Reads from a file descriptor, retrying on partial reads and interruptions.
+ *
+ * @param handle [int*] File descriptor.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO on end of file, UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_fd_read(void *handle, void *buf, size_t len) {
+    int const fd = *(int *)handle;
+
+    for (char *ptr = buf; len;) {
+        ssize_t ret = read(fd, ptr, len < P_UVEC_IO_CHUNK ? len : P_UVEC_IO_CHUNK);
+
+        if (ret > 0) {
+            ptr += ret;
+            len -= (size_t)ret;
+        } else if (!ret) {
+            return UVEC_NO;
+        } else if (errno != EINTR) {
+            return UVEC_ERR;
+        }
+    }
+
+    return UVEC_OK;
+}
+
+/**
+ * Writes to a file descriptor, retrying on partial writes and interruptions.
+ *
+ * @param handle [int*] File descriptor.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_fd_write(void *handle, void *buf, size_t len) {
+    int const fd = *(int *)handle;
+
+    for (char const *ptr = buf; len;) {
+        ssize_t ret = write(fd, ptr, len < P_UVEC_IO_CHUNK ? len : P_UVEC_IO_CHUNK);
+
+        if (ret > 0) {
+            ptr += ret;
+            len -= (size_t)ret;
+        } else if (ret == 0 || errno != EINTR) {
+            return UVEC_ERR;
+        }
+    }
+
+    return UVEC_OK;
+}
+
+/**
+ * Transfers a sequence of buffers to or from a file descriptor, retrying on partial
+ * transfers and interruptions. The buffers are consumed as they are transferred.
+ *
+ * @param fd [int] File descriptor.
+ * @param iov [struct iovec*] Buffers.
+ * @param n [size_t] Number of buffers, at most P_UVEC_IO_IOV_MAX.
+ * @param writing [bool] True to write the buffers, false to read them.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO on end of file, UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_fd_transferv(int fd, struct iovec *iov, size_t n,
+                                                     bool writing) {
+    while (true) {
+        while (n && !iov->iov_len) {
+            ++iov;
+            --n;
+        }
+
+        if (!n) return UVEC_OK;
+        ssize_t ret = writing ? writev(fd, iov, (int)n) : readv(fd, iov, (int)n);
+
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return UVEC_ERR;
+        }
+
+        if (!ret) return writing ? UVEC_ERR : UVEC_NO;
+
+        for (size_t len = (size_t)ret; len;) {
+            if (len < iov->iov_len) {
+                iov->iov_base = (char *)iov->iov_base + len;
+                iov->iov_len -= len;
+                break;
+            }
+
+            len -= iov->iov_len;
+            ++iov;
+            --n;
+        }
+    }
+}
+
+/**
+ * Reads from a stream.
+ *
+ * @param handle [FILE*] Stream.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO on end of file, UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_file_read(void *handle, void *buf, size_t len) {
+    if (fread(buf, 1, len, handle) == len) return UVEC_OK;
+    return ferror((FILE *)handle) ? UVEC_ERR : UVEC_NO;
+}
+
+/**
+ * Writes to a stream.
+ *
+ * @param handle [FILE*] Stream.
+ * @param buf [void*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_file_write(void *handle, void *buf, size_t len) {
+    return fwrite(buf, 1, len, handle) == len ? UVEC_OK : UVEC_ERR;
+}
+
+/**
+ * Fills a serialization header.
+ *
+ * @param header [unsigned char*] Header buffer.
+ * @param size [size_t] Element size.
+ * @param count [uint64_t] Number of elements.
+ * @param checksum [uint64_t] Checksum of the storage.
+ */
+p_uvec_static_inline void p_uvec_io_header_init(unsigned char *header, size_t size,
+                                                uint64_t count, uint64_t checksum) {
+    uint32_t const bom = P_UVEC_IO_BOM, version = P_UVEC_IO_VERSION;
+    uint64_t const elem_size = size;
+
+    memset(header, 0, P_UVEC_IO_HEADER_SIZE);
+    memcpy(header, P_UVEC_IO_MAGIC, sizeof(P_UVEC_IO_MAGIC));
+    memcpy(header + 8, &bom, sizeof(bom));
+    memcpy(header + 12, &version, sizeof(version));
+    memcpy(header + 16, &elem_size, sizeof(elem_size));
+    memcpy(header + 24, &count, sizeof(count));
+    memcpy(header + 32, &checksum, sizeof(checksum));
+}
+
+/**
+ * Parses and validates a serialization header.
+ *
+ * @param header [unsigned char const*] Header buffer.
+ * @param size [size_t] Expected element size.
+ * @param[out] count [uint64_t*] Number of elements.
+ * @param[out] checksum [uint64_t*] Checksum of the storage.
+ * @param[out] swap [bool*] True if the storage has the opposite byte order.
+ * @return [uvec_ret] UVEC_OK if the header is valid and compatible, otherwise UVEC_NO.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_header_parse(unsigned char const *header, size_t size,
+                                                     uint64_t *count, uint64_t *checksum,
+                                                     bool *swap) {
+    uint32_t bom, version;
+    uint64_t elem_size;
+
+    if (memcmp(header, P_UVEC_IO_MAGIC, sizeof(P_UVEC_IO_MAGIC))) return UVEC_NO;
+    memcpy(&bom, header + 8, sizeof(bom));
+    memcpy(&version, header + 12, sizeof(version));
+    memcpy(&elem_size, header + 16, sizeof(elem_size));
+    memcpy(count, header + 24, sizeof(*count));
+    memcpy(checksum, header + 32, sizeof(*checksum));
+
+    if (bom == P_UVEC_IO_BOM_SWAPPED) {
+        *swap = true;
+        version = p_uvec_bswap32(version);
+        elem_size = p_uvec_bswap64(elem_size);
+        *count = p_uvec_bswap64(*count);
+        *checksum = p_uvec_bswap64(*checksum);
+    } else if (bom == P_UVEC_IO_BOM) {
+        *swap = false;
+    } else {
+        return UVEC_NO;
+    }
+
+    if (version != P_UVEC_IO_VERSION || elem_size != size) return UVEC_NO;
+    if (*swap && size != 1 && size != 2 && size != 4 && size != 8) return UVEC_NO;
+    return UVEC_OK;
+}
+
+/**
+ * Serializes the specified storage.
+ *
+ * @param write_func [p_uvec_io_func] Write function.
+ * @param handle [void*] I/O handle.
+ * @param storage [void const*] Storage.
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_write(p_uvec_io_func write_func, void *handle,
+                                              void const *storage, size_t size, uvec_uint count) {
+    size_t const bytes = size * count;
+    p_uvec_fletcher f = { 0, 0 };
+    if (bytes) p_uvec_fletcher_update(&f, storage, bytes);
+
+    unsigned char header[P_UVEC_IO_HEADER_SIZE];
+    p_uvec_io_header_init(header, size, count, p_uvec_fletcher_value(f));
+
+    if (write_func(handle, header, sizeof(header))) return UVEC_ERR;
+    return bytes ? write_func(handle, (void *)storage, bytes) : UVEC_OK;
+}
+
+/**
+ * Reads a serialization header.
+ *
+ * @param read_func [p_uvec_io_func] Read function.
+ * @param handle [void*] I/O handle.
+ * @param size [size_t] Expected element size.
+ * @param[out] count [uint64_t*] Number of elements.
+ * @param[out] checksum [uint64_t*] Checksum of the storage.
+ * @param[out] swap [bool*] True if the storage has the opposite byte order.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the header is invalid or incompatible,
+ *                    UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_read_header(p_uvec_io_func read_func, void *handle,
+                                                    size_t size, uint64_t *count,
+                                                    uint64_t *checksum, bool *swap) {
+    unsigned char header[P_UVEC_IO_HEADER_SIZE];
+    uvec_ret ret = read_func(handle, header, sizeof(header));
+    return ret ? ret : p_uvec_io_header_parse(header, size, count, checksum, swap);
+}
+
+/**
+ * Reads serialized storage, verifying its checksum and converting its byte order if needed.
+ *
+ * @param read_func [p_uvec_io_func] Read function.
+ * @param handle [void*] I/O handle.
+ * @param dst [void*] Destination buffer.
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ * @param checksum [uint64_t] Expected checksum.
+ * @param swap [bool] True if the storage has the opposite byte order.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the data is truncated or corrupted,
+ *                    UVEC_ERR on error.
+ */
+p_uvec_static_inline uvec_ret p_uvec_io_read_storage(p_uvec_io_func read_func, void *handle,
+                                                     void *dst, size_t size, uvec_uint count,
+                                                     uint64_t checksum, bool swap) {
+    unsigned char *bytes = dst;
+    size_t len = size * count;
+    p_uvec_fletcher f = { 0, 0 };
+
+    while (len) {
+        size_t chunk = len < P_UVEC_IO_CHUNK ? len : P_UVEC_IO_CHUNK;
+        uvec_ret ret = read_func(handle, bytes, chunk);
+        if (ret) return ret;
+        p_uvec_fletcher_update(&f, bytes, chunk);
+        bytes += chunk;
+        len -= chunk;
+    }
+
+    if (p_uvec_fletcher_value(f) != checksum) return UVEC_NO;
+    if (swap) p_uvec_io_swap(dst, size, count);
+    return UVEC_OK;
+}
+
+/**
+ * Advises the kernel about the access pattern of a file region, if supported.
+ *
+ * @param fd [int] File descriptor.
+ * @param offset [off_t] Start of the region.
+ * @param len [size_t] Length of the region, or zero for the rest of the file.
+ * @param advice [symbol] SEQUENTIAL or WILLNEED.
+ */
+#ifdef POSIX_FADV_SEQUENTIAL
+    #define p_uvec_io_fadvise(fd, offset, len, advice) \
+        ((void)posix_fadvise(fd, offset, (off_t)(len), P_UVEC_CONCAT(POSIX_FADV_, advice)))
+#else
+    #define p_uvec_io_fadvise(fd, offset, len, advice) ((void)0)
+#endif
+
+/**
+ * Returns the number of elements in a streaming window. The window is rounded up
+ * to a multiple of four elements, so that the checksum can be updated one window at a time.
+ *
+ * @param window [uvec_uint] Requested number of elements, or zero for the default.
+ * @param size [size_t] Element size.
+ * @return [uvec_uint] Number of elements.
+ */
+p_uvec_static_inline uvec_uint p_uvec_io_window(uvec_uint window, size_t size) {
+    if (!window) {
+        size_t const n = P_UVEC_IO_WINDOW / size;
+        window = n > UVEC_UINT_MAX ? UVEC_UINT_MAX : n ? (uvec_uint)n : 1;
+    }
+
+    if (window > UVEC_UINT_MAX - 3) return UVEC_UINT_MAX - 3;
+    return (uvec_uint)(window + 3) / 4 * 4;
+}
+
+/**
+ * Writes the buffered elements of a writer.
+ *
+ * @param w [UVecWriter*] Writer.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_writer_flush(UVecWriter *w) {
+    if (!w->buf_len) return UVEC_OK;
+    p_uvec_fletcher_update(&w->f, w->buf, w->buf_len);
+    uvec_ret ret = p_uvec_io_fd_write(&w->fd, w->buf, w->buf_len);
+    w->buf_len = 0;
+    return ret;
+}
+
+/**
+ * Creates a writer, writing a placeholder header at the current position.
+ *
+ * @param fd [int] File descriptor, which must be seekable.
+ * @param size [size_t] Element size.
+ * @param window [uvec_uint] Number of buffered elements, or zero for the default.
+ * @return [UVecWriter*] Writer, or NULL on error.
+ */
+p_uvec_static_inline UVecWriter* p_uvec_writer_open(int fd, size_t size, uvec_uint window) {
+    UVecWriter *w = UVEC_MALLOC(sizeof(*w));
+    if (!w) return NULL;
+
+    w->fd = fd;
+    w->size = size;
+    w->count = 0;
+    w->f = (p_uvec_fletcher){ 0, 0 };
+    w->buf_len = 0;
+    w->buf_size = p_uvec_io_window(window, size) * size;
+    w->buf = UVEC_MALLOC(w->buf_size);
+    w->start = lseek(fd, 0, SEEK_CUR);
+
+    unsigned char header[P_UVEC_IO_HEADER_SIZE];
+    p_uvec_io_header_init(header, size, 0, 0);
+
+    if (!w->buf || w->start < 0 || p_uvec_io_fd_write(&fd, header, sizeof(header))) {
+        UVEC_FREE(w->buf);
+        UVEC_FREE(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+/**
+ * Appends elements to a writer.
+ *
+ * @param w [UVecWriter*] Writer.
+ * @param data [void const*] Elements.
+ * @param size [size_t] Element size.
+ * @param n [uvec_uint] Number of elements.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_writer_append(UVecWriter *w, void const *data, size_t size,
+                                                   uvec_uint n) {
+    if (size != w->size) return UVEC_ERR;
+    unsigned char const *bytes = data;
+    size_t len = size * n;
+
+    if (w->buf_len) {
+        size_t fill = w->buf_size - w->buf_len;
+        if (fill > len) fill = len;
+        memcpy(w->buf + w->buf_len, bytes, fill);
+        w->buf_len += fill;
+        bytes += fill;
+        len -= fill;
+        if (w->buf_len == w->buf_size && p_uvec_writer_flush(w)) return UVEC_ERR;
+    }
+
+    if (len >= w->buf_size) {
+        size_t const direct = len / w->buf_size * w->buf_size;
+        p_uvec_fletcher_update(&w->f, bytes, direct);
+        if (p_uvec_io_fd_write(&w->fd, (void *)bytes, direct)) return UVEC_ERR;
+        bytes += direct;
+        len -= direct;
+    }
+
+    if (len) {
+        memcpy(w->buf, bytes, len);
+        w->buf_len = len;
+    }
+
+    w->count += n;
+    return UVEC_OK;
+}
+
+/**
+ * Generates function declarations for the serialization functions of the specified
+ * vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_IO(T, SCOPE)                                                                    \
+    /** @cond */                                                                                    \
+    SCOPE uvec_ret uvec_write_fd_##T(UVec_##T const *vec, int fd);                                  \
+    SCOPE uvec_ret uvec_read_fd_##T(UVec_##T *vec, int fd);                                         \
+    SCOPE uvec_ret uvec_write_file_##T(UVec_##T const *vec, FILE *file);                            \
+    SCOPE uvec_ret uvec_read_file_##T(UVec_##T *vec, FILE *file);                                   \
+    SCOPE uvec_ret uvec_read_fd_chunked_##T(int fd, uvec_uint window,                               \
+                                            uvec_ret (*func)(UVec_##T *, uint64_t, void *),         \
+                                            void *ctx);                                             \
+    SCOPE uvec_ret uvec_writer_append_##T(UVecWriter *w, UVec_##T const *vec);                      \
+    SCOPE uvec_ret uvec_writev_##T(int fd, UVec_##T const *const *vecs, size_t n);                  \
+    SCOPE uvec_ret uvec_readv_##T(int fd, UVec_##T *const *vecs, uvec_uint const *counts,           \
+                                  size_t n);                                                        \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the serialization functions of the specified
+ * vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_IO(T, SCOPE)                                                                    \
+                                                                                                    \
+    static inline uvec_ret p_uvec_io_read_##T(UVec_##T *vec, p_uvec_io_func read_func,              \
+                                              void *handle) {                                       \
+        uint64_t count, checksum;                                                                   \
+        bool swap;                                                                                  \
+                                                                                                    \
+        uvec_ret ret = p_uvec_io_read_header(read_func, handle, sizeof(T), &count, &checksum,       \
+                                             &swap);                                                \
+        if (ret || !count) return ret;                                                              \
+        if (count > UVEC_UINT_MAX - vec->count) return UVEC_ERR;                                    \
+                                                                                                    \
+        uvec_uint const n = (uvec_uint)count;                                                       \
+                                                                                                    \
+        if (p_uvec_cow_unshare(vec) || uvec_reserve_capacity_##T(vec, vec->count + n)) {            \
+            return UVEC_ERR;                                                                        \
+        }                                                                                           \
+                                                                                                    \
+        ret = p_uvec_io_read_storage(read_func, handle, vec->storage + vec->count, sizeof(T), n,    \
+                                     checksum, swap);                                               \
+        if (!ret) vec->count += n;                                                                  \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_write_fd_##T(UVec_##T const *vec, int fd) {                                 \
+        return p_uvec_io_write(p_uvec_io_fd_write, &fd, vec->storage, sizeof(T), vec->count);       \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_read_fd_##T(UVec_##T *vec, int fd) {                                        \
+        return p_uvec_io_read_##T(vec, p_uvec_io_fd_read, &fd);                                     \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_write_file_##T(UVec_##T const *vec, FILE *file) {                           \
+        return p_uvec_io_write(p_uvec_io_file_write, file, vec->storage, sizeof(T), vec->count);    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_read_file_##T(UVec_##T *vec, FILE *file) {                                  \
+        return p_uvec_io_read_##T(vec, p_uvec_io_file_read, file);                                  \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_ret p_uvec_io_read_chunks_##T(int fd, uint64_t count, uint64_t checksum,     \
+                                                     bool swap, uvec_uint window,                   \
+                                                     uvec_ret (*func)(UVec_##T *, uint64_t, void *),\
+                                                     void *ctx) {                                   \
+        window = p_uvec_io_window(window, sizeof(T));                                               \
+        off_t pos = lseek(fd, 0, SEEK_CUR);                                                         \
+        if (pos >= 0) p_uvec_io_fadvise(fd, pos, 0, SEQUENTIAL);                                    \
+                                                                                                    \
+        UVec_##T chunk = uvec_init(T);                                                              \
+        p_uvec_fletcher f = { 0, 0 };                                                               \
+        uvec_ret ret = UVEC_OK;                                                                     \
+                                                                                                    \
+        for (uint64_t offset = 0; offset < count;) {                                                \
+            uvec_uint const n = count - offset < window ? (uvec_uint)(count - offset) : window;     \
+            size_t const bytes = n * sizeof(T);                                                     \
+                                                                                                    \
+            if (pos >= 0) {                                                                         \
+                pos += (off_t)bytes;                                                                \
+                p_uvec_io_fadvise(fd, pos, bytes, WILLNEED);                                        \
+            }                                                                                       \
+                                                                                                    \
+            if ((ret = uvec_reserve_capacity_##T(&chunk, n))) break;                                \
+            if ((ret = p_uvec_io_fd_read(&fd, chunk.storage, bytes))) break;                        \
+                                                                                                    \
+            p_uvec_fletcher_update(&f, chunk.storage, bytes);                                       \
+            if (swap) p_uvec_io_swap(chunk.storage, sizeof(T), n);                                  \
+            chunk.count = n;                                                                        \
+                                                                                                    \
+            if ((ret = func(&chunk, offset, ctx))) break;                                           \
+            offset += n;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        if (!ret && p_uvec_fletcher_value(f) != checksum) ret = UVEC_NO;                            \
+        uvec_deinit(chunk);                                                                         \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_read_fd_chunked_##T(int fd, uvec_uint window,                               \
+                                            uvec_ret (*func)(UVec_##T *, uint64_t, void *),         \
+                                            void *ctx) {                                            \
+        uint64_t count, checksum;                                                                   \
+        bool swap;                                                                                  \
+                                                                                                    \
+        uvec_ret ret = p_uvec_io_read_header(p_uvec_io_fd_read, &fd, sizeof(T), &count, &checksum,  \
+                                             &swap);                                                \
+        return ret ? ret : p_uvec_io_read_chunks_##T(fd, count, checksum, swap, window, func, ctx); \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_writer_append_##T(UVecWriter *w, UVec_##T const *vec) {                     \
+        return p_uvec_writer_append(w, vec->storage, sizeof(T), vec->count);                        \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_writev_##T(int fd, UVec_##T const *const *vecs, size_t n) {                 \
+        struct iovec iov[P_UVEC_IO_IOV_MAX];                                                        \
+                                                                                                    \
+        for (size_t i = 0; i < n;) {                                                                \
+            size_t batch = 0;                                                                       \
+                                                                                                    \
+            for (; i < n && batch < P_UVEC_IO_IOV_MAX; ++i) {                                       \
+                if (!vecs[i]->count) continue;                                                      \
+                iov[batch].iov_base = vecs[i]->storage;                                             \
+                iov[batch++].iov_len = vecs[i]->count * sizeof(T);                                  \
+            }                                                                                       \
+                                                                                                    \
+            if (p_uvec_io_fd_transferv(fd, iov, batch, true)) return UVEC_ERR;                      \
+        }                                                                                           \
+                                                                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_readv_##T(int fd, UVec_##T *const *vecs, uvec_uint const *counts,           \
+                                  size_t n) {                                                       \
+        for (size_t i = 0; i < n; ++i) {                                                            \
+            UVec_##T *vec = vecs[i];                                                                \
+            if (!counts[i]) continue;                                                               \
+            if (counts[i] > UVEC_UINT_MAX - vec->count) return UVEC_ERR;                            \
+                                                                                                    \
+            if (p_uvec_cow_unshare(vec) ||                                                          \
+                uvec_reserve_capacity_##T(vec, vec->count + counts[i])) return UVEC_ERR;            \
+        }                                                                                           \
+                                                                                                    \
+        struct iovec iov[P_UVEC_IO_IOV_MAX];                                                        \
+                                                                                                    \
+        for (size_t i = 0; i < n;) {                                                                \
+            size_t batch = 0;                                                                       \
+                                                                                                    \
+            for (; i < n && batch < P_UVEC_IO_IOV_MAX; ++i) {                                       \
+                if (!counts[i]) continue;                                                           \
+                iov[batch].iov_base = vecs[i]->storage + vecs[i]->count;                            \
+                iov[batch++].iov_len = counts[i] * sizeof(T);                                       \
+            }                                                                                       \
+                                                                                                    \
+            uvec_ret const ret = p_uvec_io_fd_transferv(fd, iov, batch, false);                     \
+            if (ret) return ret;                                                                    \
+        }                                                                                           \
+                                                                                                    \
+        for (size_t i = 0; i < n; ++i) vecs[i]->count += counts[i];                                 \
+        return UVEC_OK;                                                                             \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares the serialization functions of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_IO(T) \
+    P_UVEC_DECL_IO(T, p_uvec_unused)
+
+/**
+ * Declares the serialization functions of the specified vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVec
+ */
+#define UVEC_DECL_IO_SPEC(T, SPEC) \
+    P_UVEC_DECL_IO(T, SPEC p_uvec_unused)
+
+/**
+ * Implements the previously declared serialization functions of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVec
+ */
+#define UVEC_IMPL_IO(T) \
+    P_UVEC_IMPL_IO(T, p_uvec_unused)
+
+/**
+ * Defines the static serialization functions of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVec
+ */
+#define UVEC_INIT_IO(T) \
+    P_UVEC_IMPL_IO(T, p_uvec_static_inline)
+
+/// @name Serialization
+
+/**
+ * Writes the specified vector to a file descriptor.
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param fd [int] File descriptor.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVec
+ */
+#define uvec_write_fd(T, vec, fd) P_UVEC_CONCAT(uvec_write_fd_, T)(vec, fd)
+
+/**
+ * Reads a vector from a file descriptor, appending its elements to the specified vector.
+ * Capacity is reserved once, and elements are read directly into the vector's storage.
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param fd [int] File descriptor.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the data is invalid, truncated,
+ *                    corrupted or has a different element size, otherwise UVEC_ERR.
+ *
+ * @note Data written on a host with a different byte order is converted, provided
+ *       that elements are scalars of 1, 2, 4 or 8 bytes.
+ * @note The vector is left unchanged if the operation fails, though its capacity may grow.
+ *
+ * @public @related UVec
+ */
+#define uvec_read_fd(T, vec, fd) P_UVEC_CONCAT(uvec_read_fd_, T)(vec, fd)
+
+/**
+ * Writes the specified vector to a stream.
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param file [FILE*] Stream.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVec
+ */
+#define uvec_write_file(T, vec, file) P_UVEC_CONCAT(uvec_write_file_, T)(vec, file)
+
+/**
+ * Reads a vector from a stream, appending its elements to the specified vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param file [FILE*] Stream.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the data is invalid, truncated,
+ *                    corrupted or has a different element size, otherwise UVEC_ERR.
+ *
+ * @see uvec_read_fd
+ *
+ * @public @related UVec
+ */
+#define uvec_read_file(T, vec, file) P_UVEC_CONCAT(uvec_read_file_, T)(vec, file)
+
+/// @name Streaming
+
+/**
+ * Reads a serialized vector from a file descriptor one chunk at a time, so that
+ * vectors larger than memory can be processed with bounded memory use. Chunks are
+ * read into a fixed-size window, which is passed to the specified callback.
+ *
+ * @param T [symbol] Vector type.
+ * @param fd [int] File descriptor.
+ * @param window [uvec_uint] Maximum number of elements per chunk, rounded up to a multiple
+ *                           of four. If zero, a window of about 1 MiB is used.
+ * @param func [uvec_ret (*)(UVec(T) *chunk, uint64_t offset, void *ctx)] Callback, receiving
+ *             the chunk and the index of its first element.
+ * @param ctx [void*] Context passed to the callback.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the data is invalid, truncated,
+ *                    corrupted or has a different element size, UVEC_ERR on error,
+ *                    or the value returned by the callback if other than UVEC_OK.
+ *
+ * @note The checksum of the data is only verified after the last chunk has been processed.
+ * @note If the callback returns a value other than UVEC_OK, reading stops and
+ *       the file offset is left after the last chunk that was read.
+ * @note The callback may modify the chunk, which is refilled on the next iteration.
+ *
+ * @public @related UVec
+ */
+#define uvec_read_fd_chunked(T, fd, window, func, ctx) \
+    P_UVEC_CONCAT(uvec_read_fd_chunked_, T)(fd, window, func, ctx)
+
+/**
+ * Creates a writer that serializes a stream of elements to a file descriptor,
+ * starting from its current offset. The number of elements is not limited by
+ * the available memory, as elements are written in large sequential writes
+ * as soon as the writer's buffer is full.
+ *
+ * @param T [symbol] Vector type.
+ * @param fd [int] File descriptor, which must be seekable.
+ * @param window [uvec_uint] Number of buffered elements, rounded up to a multiple of four.
+ *                           If zero, a buffer of about 1 MiB is used.
+ * @return [UVecWriter*] Writer, or NULL on error.
+ *
+ * @public @memberof UVecWriter
+ */
+#define uvec_writer_open(T, fd, window) p_uvec_writer_open(fd, sizeof(T), window)
+
+/**
+ * Appends the elements of the specified vector to a writer.
+ *
+ * @param T [symbol] Vector type.
+ * @param w [UVecWriter*] Writer.
+ * @param vec [UVec(T)*] Vector instance.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @memberof UVecWriter
+ */
+#define uvec_writer_append(T, w, vec) P_UVEC_CONCAT(uvec_writer_append_, T)(w, vec)
+
+/**
+ * Flushes the specified writer, finalizes the serialization header and
+ * deallocates the writer. On success, the file offset is left after the last element.
+ *
+ * @param w [UVecWriter*] Writer.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The writer is deallocated even if the operation fails.
+ *
+ * @public @memberof UVecWriter
+ */
+p_uvec_static_inline uvec_ret uvec_writer_close(UVecWriter *w) {
+    if (!w) return UVEC_OK;
+    uvec_ret ret = p_uvec_writer_flush(w);
+
+    if (!ret) {
+        unsigned char header[P_UVEC_IO_HEADER_SIZE];
+        p_uvec_io_header_init(header, w->size, w->count, p_uvec_fletcher_value(w->f));
+        off_t const end = lseek(w->fd, 0, SEEK_CUR);
+
+        if (end < 0 || lseek(w->fd, w->start, SEEK_SET) < 0 ||
+            p_uvec_io_fd_write(&w->fd, header, sizeof(header)) ||
+            lseek(w->fd, end, SEEK_SET) < 0) {
+            ret = UVEC_ERR;
+        }
+    }
+
+    UVEC_FREE(w->buf);
+    UVEC_FREE(w);
+    return ret;
+}
+
+/// @name Scatter/gather I/O
+
+/**
+ * Writes the raw storage of multiple vectors to a file descriptor, one after the other,
+ * gathering up to IOV_MAX vectors in each system call.
+ *
+ * @param T [symbol] Vector type.
+ * @param fd [int] File descriptor.
+ * @param vecs [UVec(T) const* const*] Vectors.
+ * @param n [size_t] Number of vectors.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Unlike uvec_write_fd, no header is written: the data is not self-describing,
+ *       and is meant to be read back via uvec_readv with the same element counts.
+ *
+ * @public @related UVec
+ */
+#define uvec_writev(T, fd, vecs, n) P_UVEC_CONCAT(uvec_writev_, T)(fd, vecs, n)
+
+/**
+ * Reads raw storage from a file descriptor into multiple vectors, scattering
+ * up to IOV_MAX vectors in each system call. Capacity is reserved upfront,
+ * and elements are read directly into each vector's storage.
+ *
+ * @param T [symbol] Vector type.
+ * @param fd [int] File descriptor.
+ * @param vecs [UVec(T)* const*] Vectors.
+ * @param counts [uvec_uint const*] Number of elements to append to each vector.
+ * @param n [size_t] Number of vectors.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the end of file is reached first,
+ *                    otherwise UVEC_ERR.
+ *
+ * @note If the operation fails, the vectors are left unchanged, though their capacity may grow.
+ *
+ * @public @related UVec
+ */
+#define uvec_readv(T, fd, vecs, counts, n) P_UVEC_CONCAT(uvec_readv_, T)(fd, vecs, counts, n)
+
+#endif // UVEC_IO_H
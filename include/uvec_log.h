@@ -0,0 +1,838 @@
+/**
+ * uVec - crash-safe append-only logs.
+ *
+ * Log vectors durably append fixed-size records to a file. Records are pushed
+ * to an in-memory tail, and a background thread commits them in batches, writing
+ * each batch as a checksummed block and waiting for it to reach stable storage
+ * before acknowledging it. Grouping concurrent appends into a single commit amortizes
+ * the cost of synchronizing the file; a configurable delay trades commit latency
+ * for larger batches. Committed records are read in place via a read-only mapping.
+ *
+ * When a log is opened, its blocks are verified and a torn or corrupted tail,
+ * left behind by a crash during a commit, is truncated.
+ *
+ * File layout (fields in the byte order of the writer):
+ *
+ * | Offset | Size | Field                               |
+ * |--------|------|-------------------------------------|
+ * | 0      | 8    | Magic ("UVECLOG\0")                 |
+ * | 8      | 4    | Byte order mark (0x01020304)        |
+ * | 12     | 4    | Format version                      |
+ * | 16     | 8    | Element size                        |
+ * | 24     | 40   | Reserved (zero)                     |
+ * | 64     | ...  | Blocks                              |
+ *
+ * Block layout, padded to a multiple of 32 bytes:
+ *
+ * | Offset | Size | Field                               |
+ * |--------|------|-------------------------------------|
+ * | 0      | 4    | Magic (0x4B4C4255)                  |
+ * | 4      | 4    | Reserved (zero)                     |
+ * | 8      | 8    | Number of records                   |
+ * | 16     | 8    | Checksum of the count and records   |
+ * | 24     | 8    | Reserved (zero)                     |
+ * | 32     | ...  | Records                             |
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_LOG_H
+#define UVEC_LOG_H
+
+#include "uvec_mapped.h"
+#include <pthread.h>
+#include <time.h>
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector of records durably appended to a file.
+ * @struct UVecLog
+ */
+
+/// Block of a log, as indexed by the thread reading the log.
+typedef struct p_uvec_log_block {
+    uint64_t first;
+    uint64_t offset;
+} p_uvec_log_block;
+
+/**
+ * State of a log that does not depend on the record type.
+ * The mapping and the block index belong to the thread owning the log, the write offset
+ * and the block buffer to the commit thread, and the remaining fields are protected
+ * by the lock.
+ */
+typedef struct p_uvec_log {
+    size_t size;
+    int fd;
+    unsigned delay;
+    struct timespec deadline;
+    uint64_t pushed;
+    uint64_t durable;
+    uint64_t durable_size;
+    bool flush;
+    bool stop;
+    uvec_ret status;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    uint64_t end;
+    unsigned char *buf;
+    size_t buf_size;
+    unsigned char *map;
+    size_t map_size;
+    uint64_t scanned;
+    uint64_t count;
+    p_uvec_log_block *blocks;
+    size_t nblocks;
+    size_t blocks_size;
+} p_uvec_log;
+
+// #############
+// # Constants #
+// #############
+
+/// Magic bytes at the start of log files (including the terminator).
+#define P_UVEC_LOG_MAGIC "UVECLOG"
+
+/// Current version of the log format.
+#define P_UVEC_LOG_VERSION 1
+
+/// Size of the log file header.
+#define P_UVEC_LOG_HEADER_SIZE 64
+
+/// Magic number at the start of each block.
+#define P_UVEC_LOG_BLOCK_MAGIC 0x4B4C4255u
+
+/// Size of the block header, and alignment of blocks.
+#define P_UVEC_LOG_BLOCK_HEADER_SIZE 32
+
+/// Number of pending bytes that starts a commit regardless of the commit delay.
+#define P_UVEC_LOG_BATCH ((size_t)1 << 20u)
+
+// ###############
+// # Private API #
+// ###############
+
+/// Synchronizes the data of a file with stable storage.
+#if defined _POSIX_SYNCHRONIZED_IO && _POSIX_SYNCHRONIZED_IO > 0
+    #define p_uvec_log_datasync(fd) fdatasync(fd)
+#else
+    #define p_uvec_log_datasync(fd) fsync(fd)
+#endif
+
+/**
+ * Returns the size of a block.
+ *
+ * @param size [size_t] Record size.
+ * @param count [uint64_t] Number of records.
+ * @return [uint64_t] Size of the block, including its header and padding.
+ */
+#define p_uvec_log_block_size(size, count)                                                          \
+    (((uint64_t)P_UVEC_LOG_BLOCK_HEADER_SIZE + (size) * (count) +                                   \
+      P_UVEC_LOG_BLOCK_HEADER_SIZE - 1) & ~(uint64_t)(P_UVEC_LOG_BLOCK_HEADER_SIZE - 1))
+
+/**
+ * Writes to a file descriptor at the specified offset, retrying on partial writes
+ * and interruptions.
+ *
+ * @param fd [int] File descriptor.
+ * @param buf [void const*] Buffer.
+ * @param len [size_t] Number of bytes.
+ * @param offset [off_t] Offset.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_pwrite(int fd, void const *buf, size_t len,
+                                                off_t offset) {
+    for (char const *ptr = buf; len;) {
+        ssize_t ret = pwrite(fd, ptr, len < P_UVEC_IO_CHUNK ? len : P_UVEC_IO_CHUNK, offset);
+
+        if (ret > 0) {
+            ptr += ret;
+            len -= (size_t)ret;
+            offset += ret;
+        } else if (ret == 0 || errno != EINTR) {
+            return UVEC_ERR;
+        }
+    }
+
+    return UVEC_OK;
+}
+
+/**
+ * Computes the checksum of a block.
+ *
+ * @param count [uint64_t] Number of records.
+ * @param records [void const*] Records.
+ * @param size [size_t] Record size.
+ * @return [uint64_t] Checksum.
+ */
+p_uvec_static_inline uint64_t p_uvec_log_checksum(uint64_t count, void const *records,
+                                                  size_t size) {
+    p_uvec_fletcher f = { 0, 0 };
+    p_uvec_fletcher_update(&f, &count, sizeof(count));
+    if (count) p_uvec_fletcher_update(&f, records, size * count);
+    return p_uvec_fletcher_value(f);
+}
+
+/**
+ * Indexes the blocks of the mapping up to the specified offset.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @param limit [uint64_t] Offset at which indexing stops.
+ * @param verify [bool] If true, indexing stops at the first invalid block.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_scan(p_uvec_log *g, uint64_t limit, bool verify) {
+    uint64_t pos = g->scanned;
+
+    while (limit - pos >= P_UVEC_LOG_BLOCK_HEADER_SIZE) {
+        unsigned char const *block = g->map + pos;
+        unsigned char const *records = block + P_UVEC_LOG_BLOCK_HEADER_SIZE;
+        uint64_t const avail = limit - pos - P_UVEC_LOG_BLOCK_HEADER_SIZE;
+        uint64_t count, checksum;
+        uint32_t magic;
+
+        memcpy(&magic, block, sizeof(magic));
+        memcpy(&count, block + 8, sizeof(count));
+        memcpy(&checksum, block + 16, sizeof(checksum));
+
+        if (magic != P_UVEC_LOG_BLOCK_MAGIC || !count || count > avail / g->size) break;
+        uint64_t const len = p_uvec_log_block_size(g->size, count);
+        if (len > limit - pos) break;
+        if (verify && p_uvec_log_checksum(count, records, g->size) != checksum) break;
+
+        if (g->nblocks == g->blocks_size) {
+            size_t const new_size = g->blocks_size ? 2 * g->blocks_size : 16;
+            void *blocks = UVEC_REALLOC(g->blocks, new_size * sizeof(*g->blocks));
+            if (!blocks) return UVEC_ERR;
+            g->blocks = blocks;
+            g->blocks_size = new_size;
+        }
+
+        g->blocks[g->nblocks++] = (p_uvec_log_block){
+            .first = g->count,
+            .offset = pos + P_UVEC_LOG_BLOCK_HEADER_SIZE
+        };
+        g->count += count;
+        pos += len;
+    }
+
+    g->scanned = pos;
+    return UVEC_OK;
+}
+
+/**
+ * Maps the committed blocks of a log that have not been indexed yet.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_refresh(p_uvec_log *g) {
+    pthread_mutex_lock(&g->lock);
+    uint64_t const size = g->durable_size;
+    pthread_mutex_unlock(&g->lock);
+
+    if (size > g->map_size) {
+        if (size > SIZE_MAX) return UVEC_ERR;
+        void *map = p_uvec_mapped_remap(g->map, g->map_size, (size_t)size, g->fd, PROT_READ);
+        if (map == MAP_FAILED) return UVEC_ERR;
+        g->map = map;
+        g->map_size = (size_t)size;
+    }
+
+    return p_uvec_log_scan(g, size, false);
+}
+
+/**
+ * Writes a block and waits for it to reach stable storage.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @param records [void const*] Records.
+ * @param count [uvec_uint] Number of records.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_commit(p_uvec_log *g, void const *records,
+                                                uvec_uint count) {
+    uint64_t const len = p_uvec_log_block_size(g->size, count);
+    if (len > SIZE_MAX) return UVEC_ERR;
+
+    if (len > g->buf_size) {
+        unsigned char *buf = UVEC_REALLOC(g->buf, (size_t)len);
+        if (!buf) return UVEC_ERR;
+        g->buf = buf;
+        g->buf_size = (size_t)len;
+    }
+
+    uint32_t const magic = P_UVEC_LOG_BLOCK_MAGIC;
+    uint64_t const n = count, checksum = p_uvec_log_checksum(n, records, g->size);
+    size_t const bytes = g->size * count;
+
+    memset(g->buf, 0, P_UVEC_LOG_BLOCK_HEADER_SIZE);
+    memcpy(g->buf, &magic, sizeof(magic));
+    memcpy(g->buf + 8, &n, sizeof(n));
+    memcpy(g->buf + 16, &checksum, sizeof(checksum));
+    memcpy(g->buf + P_UVEC_LOG_BLOCK_HEADER_SIZE, records, bytes);
+    memset(g->buf + P_UVEC_LOG_BLOCK_HEADER_SIZE + bytes, 0,
+           (size_t)len - P_UVEC_LOG_BLOCK_HEADER_SIZE - bytes);
+
+    if (p_uvec_log_pwrite(g->fd, g->buf, (size_t)len, (off_t)g->end) ||
+        p_uvec_log_datasync(g->fd)) {
+        return UVEC_ERR;
+    }
+
+    g->end += len;
+    return UVEC_OK;
+}
+
+/**
+ * Waits until the pending records of a log should be committed.
+ *
+ * @param g [p_uvec_log*] Log, whose lock must be held.
+ * @param pending [uvec_uint] Number of pending records.
+ * @return [bool] True if a commit should start, false if the state of the log must be
+ *                checked again.
+ */
+p_uvec_static_inline bool p_uvec_log_wait(p_uvec_log *g, uvec_uint pending) {
+    if (!pending || g->status) {
+        pthread_cond_wait(&g->work, &g->lock);
+        return false;
+    }
+
+    if (g->flush || g->stop || !g->delay || g->size * pending >= P_UVEC_LOG_BATCH) return true;
+    return pthread_cond_timedwait(&g->work, &g->lock, &g->deadline) == ETIMEDOUT;
+}
+
+/**
+ * Called when records are pushed to the tail of a log.
+ *
+ * @param g [p_uvec_log*] Log, whose lock must be held.
+ * @param n [uvec_uint] Number of records.
+ * @param pending [uvec_uint] Number of pending records, including the pushed ones.
+ */
+p_uvec_static_inline void p_uvec_log_pushed(p_uvec_log *g, uvec_uint n, uvec_uint pending) {
+    g->pushed += n;
+
+    if (pending == n) {
+        clock_gettime(CLOCK_REALTIME, &g->deadline);
+        long const ns = g->deadline.tv_nsec + (long)(g->delay % 1000000u) * 1000;
+        g->deadline.tv_sec += (time_t)(g->delay / 1000000u + ns / 1000000000);
+        g->deadline.tv_nsec = ns % 1000000000;
+        pthread_cond_signal(&g->work);
+    } else if (g->size * pending >= P_UVEC_LOG_BATCH) {
+        pthread_cond_signal(&g->work);
+    }
+}
+
+/**
+ * Called when a commit completes.
+ *
+ * @param g [p_uvec_log*] Log, whose lock must be held.
+ * @param n [uvec_uint] Number of committed records.
+ * @param ret [uvec_ret] Result of the commit.
+ */
+p_uvec_static_inline void p_uvec_log_committed(p_uvec_log *g, uvec_uint n, uvec_ret ret) {
+    if (ret) {
+        g->status = ret;
+    } else {
+        g->durable += n;
+        g->durable_size = g->end;
+    }
+
+    pthread_cond_broadcast(&g->done);
+}
+
+/**
+ * Waits until the records pushed so far have been committed, and maps them.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_sync(p_uvec_log *g) {
+    pthread_mutex_lock(&g->lock);
+    uint64_t const target = g->pushed;
+
+    if (g->durable < target) {
+        g->flush = true;
+        pthread_cond_signal(&g->work);
+    }
+
+    while (!g->status && g->durable < target) pthread_cond_wait(&g->done, &g->lock);
+    uvec_ret const ret = g->status;
+    pthread_mutex_unlock(&g->lock);
+    return ret ? ret : p_uvec_log_refresh(g);
+}
+
+/**
+ * Releases the resources of a log, except its commit thread.
+ *
+ * @param g [p_uvec_log*] Log.
+ */
+p_uvec_static_inline void p_uvec_log_deinit(p_uvec_log *g) {
+    munmap(g->map, g->map_size);
+    close(g->fd);
+    pthread_cond_destroy(&g->done);
+    pthread_cond_destroy(&g->work);
+    pthread_mutex_destroy(&g->lock);
+    UVEC_FREE(g->blocks);
+    UVEC_FREE(g->buf);
+}
+
+/**
+ * Opens or creates a log file, truncating its torn or corrupted tail.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @param path [char const*] Path to the file.
+ * @param size [size_t] Record size.
+ * @param delay [unsigned] Commit delay in microseconds.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR with errno set.
+ */
+p_uvec_static_inline uvec_ret p_uvec_log_open(p_uvec_log *g, char const *path, size_t size,
+                                              unsigned delay) {
+    memset(g, 0, sizeof(*g));
+    g->size = size;
+    g->delay = delay;
+    g->map = MAP_FAILED;
+    g->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (g->fd < 0) return UVEC_ERR;
+
+    struct stat st;
+    if (fstat(g->fd, &st)) goto err;
+
+    if ((uint64_t)st.st_size < P_UVEC_LOG_HEADER_SIZE) {
+        // New file, or crash while creating it.
+        unsigned char header[P_UVEC_LOG_HEADER_SIZE] = { 0 };
+        uint32_t const bom = P_UVEC_IO_BOM, version = P_UVEC_LOG_VERSION;
+        uint64_t const elem_size = size;
+
+        memcpy(header, P_UVEC_LOG_MAGIC, sizeof(P_UVEC_LOG_MAGIC));
+        memcpy(header + 8, &bom, sizeof(bom));
+        memcpy(header + 12, &version, sizeof(version));
+        memcpy(header + 16, &elem_size, sizeof(elem_size));
+
+        if (ftruncate(g->fd, 0) || p_uvec_log_pwrite(g->fd, header, sizeof(header), 0) ||
+            p_uvec_log_datasync(g->fd)) goto err;
+
+        st.st_size = P_UVEC_LOG_HEADER_SIZE;
+    }
+
+    if ((uint64_t)st.st_size > SIZE_MAX) {
+        errno = EFBIG;
+        goto err;
+    }
+
+    g->map_size = (size_t)st.st_size;
+    g->map = mmap(NULL, g->map_size, PROT_READ, MAP_SHARED, g->fd, 0);
+    if (g->map == MAP_FAILED) goto err;
+
+    uint32_t bom, version;
+    uint64_t elem_size;
+    memcpy(&bom, g->map + 8, sizeof(bom));
+    memcpy(&version, g->map + 12, sizeof(version));
+    memcpy(&elem_size, g->map + 16, sizeof(elem_size));
+
+    if (memcmp(g->map, P_UVEC_LOG_MAGIC, sizeof(P_UVEC_LOG_MAGIC)) || bom != P_UVEC_IO_BOM ||
+        version != P_UVEC_LOG_VERSION || elem_size != size) {
+        errno = EINVAL;
+        goto err;
+    }
+
+    g->scanned = P_UVEC_LOG_HEADER_SIZE;
+    if (p_uvec_log_scan(g, g->map_size, true)) goto err;
+
+    if (g->scanned < g->map_size &&
+        (ftruncate(g->fd, (off_t)g->scanned) || p_uvec_log_datasync(g->fd))) goto err;
+
+    g->end = g->durable_size = g->scanned;
+    g->pushed = g->durable = g->count;
+    pthread_mutex_init(&g->lock, NULL);
+    pthread_cond_init(&g->work, NULL);
+    pthread_cond_init(&g->done, NULL);
+    return UVEC_OK;
+
+err:
+    {
+        int const error = errno;
+        if (g->map != MAP_FAILED) munmap(g->map, g->map_size);
+        close(g->fd);
+        UVEC_FREE(g->blocks);
+        errno = error;
+    }
+    return UVEC_ERR;
+}
+
+/**
+ * Returns the address of a committed record.
+ *
+ * @param g [p_uvec_log*] Log.
+ * @param idx [uint64_t] Record index.
+ * @param[out] n [uint64_t*] Number of records stored contiguously from the returned address,
+ *                           may be NULL.
+ * @return [void const*] Address of the record, or NULL if the index is out of bounds.
+ */
+p_uvec_static_inline void const* p_uvec_log_span(p_uvec_log const *g, uint64_t idx,
+                                                 uint64_t *n) {
+    if (idx >= g->count) return NULL;
+    size_t lo = 0, hi = g->nblocks;
+
+    while (hi - lo > 1) {
+        size_t const mid = lo + (hi - lo) / 2;
+        if (g->blocks[mid].first <= idx) lo = mid; else hi = mid;
+    }
+
+    p_uvec_log_block const *block = &g->blocks[lo];
+    if (n) *n = (lo + 1 < g->nblocks ? block[1].first : g->count) - idx;
+    return g->map + block->offset + (idx - block->first) * g->size;
+}
+
+/**
+ * Defines a new log vector type.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_LOG(T)                                                                      \
+    typedef struct UVecLog_##T {                                                                    \
+        /** @cond */                                                                                \
+        p_uvec_log log;                                                                             \
+        UVec_##T tail;                                                                              \
+        UVec_##T batch;                                                                             \
+        /** @endcond */                                                                             \
+    } UVecLog_##T;
+
+/**
+ * Generates function declarations for the specified log vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_LOG(T, SCOPE)                                                                   \
+    /** @cond */                                                                                    \
+    SCOPE UVecLog_##T* uvec_log_open_##T(char const *path, unsigned delay);                         \
+    SCOPE uvec_ret uvec_log_close_##T(UVecLog_##T *log);                                            \
+    SCOPE uvec_ret uvec_log_sync_##T(UVecLog_##T *log);                                             \
+    SCOPE uvec_ret uvec_log_refresh_##T(UVecLog_##T *log);                                          \
+    SCOPE uvec_ret uvec_log_push_##T(UVecLog_##T *log, T item);                                     \
+    SCOPE uvec_ret uvec_log_append_array_##T(UVecLog_##T *log, T const *array, uvec_uint n);        \
+    SCOPE T const* uvec_log_span_##T(UVecLog_##T const *log, uint64_t idx, uint64_t *n);            \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified log vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_LOG(T, SCOPE)                                                                   \
+                                                                                                    \
+    static inline void* p_uvec_log_main_##T(void *arg) {                                            \
+        UVecLog_##T *log = arg;                                                                     \
+        p_uvec_log *g = &log->log;                                                                  \
+        pthread_mutex_lock(&g->lock);                                                               \
+                                                                                                    \
+        while (!g->stop || (log->tail.count && !g->status)) {                                       \
+            if (!p_uvec_log_wait(g, log->tail.count)) continue;                                     \
+                                                                                                    \
+            UVec_##T const tail = log->tail;                                                        \
+            log->tail = log->batch;                                                                 \
+            log->batch = tail;                                                                      \
+            g->flush = false;                                                                       \
+                                                                                                    \
+            pthread_mutex_unlock(&g->lock);                                                         \
+            uvec_ret const ret = p_uvec_log_commit(g, tail.storage, tail.count);                    \
+            pthread_mutex_lock(&g->lock);                                                           \
+                                                                                                    \
+            p_uvec_log_committed(g, tail.count, ret);                                               \
+            log->batch.count = 0;                                                                   \
+        }                                                                                           \
+                                                                                                    \
+        pthread_mutex_unlock(&g->lock);                                                             \
+        return NULL;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecLog_##T* uvec_log_open_##T(char const *path, unsigned delay) {                        \
+        UVecLog_##T *log = UVEC_MALLOC(sizeof(*log));                                               \
+        if (!log) return NULL;                                                                      \
+                                                                                                    \
+        if (p_uvec_log_open(&log->log, path, sizeof(T), delay)) {                                   \
+            UVEC_FREE(log);                                                                         \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        log->tail = uvec_init(T);                                                                   \
+        log->batch = uvec_init(T);                                                                  \
+        int error = ENOMEM;                                                                         \
+                                                                                                    \
+        if (!(p_uvec_registry_own(&log->tail) || p_uvec_registry_own(&log->batch))) {               \
+            error = pthread_create(&log->log.thread, NULL, p_uvec_log_main_##T, log);               \
+        }                                                                                           \
+                                                                                                    \
+        if (error) {                                                                                \
+            uvec_deinit(log->tail);                                                                 \
+            uvec_deinit(log->batch);                                                                \
+            p_uvec_log_deinit(&log->log);                                                           \
+            UVEC_FREE(log);                                                                         \
+            errno = error;                                                                          \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return log;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_log_close_##T(UVecLog_##T *log) {                                           \
+        if (!log) return UVEC_OK;                                                                   \
+        p_uvec_log *g = &log->log;                                                                  \
+                                                                                                    \
+        pthread_mutex_lock(&g->lock);                                                               \
+        g->stop = true;                                                                             \
+        pthread_cond_signal(&g->work);                                                              \
+        pthread_mutex_unlock(&g->lock);                                                             \
+        pthread_join(g->thread, NULL);                                                              \
+                                                                                                    \
+        uvec_ret const ret = g->status;                                                             \
+        p_uvec_log_deinit(g);                                                                       \
+        uvec_deinit(log->tail);                                                                     \
+        uvec_deinit(log->batch);                                                                    \
+        UVEC_FREE(log);                                                                             \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_log_sync_##T(UVecLog_##T *log) {                                            \
+        return p_uvec_log_sync(&log->log);                                                          \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_log_refresh_##T(UVecLog_##T *log) {                                         \
+        return p_uvec_log_refresh(&log->log);                                                       \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_log_append_array_##T(UVecLog_##T *log, T const *array, uvec_uint n) {       \
+        if (!n) return UVEC_OK;                                                                     \
+        p_uvec_log *g = &log->log;                                                                  \
+        pthread_mutex_lock(&g->lock);                                                               \
+                                                                                                    \
+        while (!g->status && n > UVEC_UINT_MAX - log->tail.count) {                                 \
+            g->flush = true;                                                                        \
+            pthread_cond_signal(&g->work);                                                          \
+            pthread_cond_wait(&g->done, &g->lock);                                                  \
+        }                                                                                           \
+                                                                                                    \
+        uvec_ret ret = g->status;                                                                   \
+        if (!ret) ret = uvec_append_array_##T(&log->tail, array, n);                                \
+        if (!ret) p_uvec_log_pushed(g, n, log->tail.count);                                         \
+                                                                                                    \
+        pthread_mutex_unlock(&g->lock);                                                             \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_log_push_##T(UVecLog_##T *log, T item) {                                    \
+        return uvec_log_append_array_##T(log, &item, 1);                                            \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T const* uvec_log_span_##T(UVecLog_##T const *log, uint64_t idx, uint64_t *n) {           \
+        return p_uvec_log_span(&log->log, idx, n);                                                  \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new log vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecLog
+ */
+#define UVEC_DECL_LOG(T)                                                                            \
+    P_UVEC_DEF_TYPE_LOG(T)                                                                          \
+    P_UVEC_DECL_LOG(T, p_uvec_unused)
+
+/**
+ * Declares a new log vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecLog
+ */
+#define UVEC_DECL_LOG_SPEC(T, SPEC)                                                                 \
+    P_UVEC_DEF_TYPE_LOG(T)                                                                          \
+    P_UVEC_DECL_LOG(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared log vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecLog
+ */
+#define UVEC_IMPL_LOG(T) \
+    P_UVEC_IMPL_LOG(T, p_uvec_unused)
+
+/**
+ * Defines a new static log vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecLog
+ */
+#define UVEC_INIT_LOG(T)                                                                            \
+    P_UVEC_DEF_TYPE_LOG(T)                                                                          \
+    P_UVEC_IMPL_LOG(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new log vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecLog
+ */
+#define UVecLog(T) P_UVEC_CONCAT(UVecLog_, T)
+
+/// @name Memory management
+
+/**
+ * Opens a log file, creating it if it does not exist. Blocks are verified,
+ * and a torn or corrupted tail is truncated.
+ *
+ * @param T [symbol] Vector type.
+ * @param path [char const*] Path to the file.
+ * @param delay [unsigned] Maximum time in microseconds pushed records wait before their commit
+ *                         starts. Zero commits as soon as possible, still grouping the records
+ *                         pushed while the previous commit is in progress; larger values
+ *                         yield fewer, larger commits. Commits also start as soon as
+ *                         about 1 MiB of records is pending.
+ * @return [UVecLog(T)*] Log, or NULL on error, in which case errno is set.
+ *
+ * @note Files written on a host with a different byte order or with a different record size
+ *       are rejected with EINVAL.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_open(T, path, delay) P_UVEC_CONCAT(uvec_log_open_, T)(path, delay)
+
+/**
+ * Commits the pending records and closes the specified log.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR if any commit failed.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_close(T, lg) P_UVEC_CONCAT(uvec_log_close_, T)(lg)
+
+/// @name Primitives
+
+/**
+ * Appends a record to the tail of the log. The record is committed asynchronously.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @param item [T] Record.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note This function can be called concurrently by multiple threads.
+ * @note Once a commit fails, the log rejects further records, and must be reopened.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_push(T, lg, item) P_UVEC_CONCAT(uvec_log_push_, T)(lg, item)
+
+/**
+ * Appends the elements of an array to the tail of the log. The records
+ * are committed asynchronously, in the same block.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @param array [T const*] Array.
+ * @param n [uvec_uint] Number of elements of the array.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note This function can be called concurrently by multiple threads.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_append_array(T, lg, array, n) \
+    P_UVEC_CONCAT(uvec_log_append_array_, T)(lg, array, n)
+
+/**
+ * Waits until the records pushed before this call are durable, and makes them readable.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Invalidates the pointers returned by uvec_log_get and uvec_log_span.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_sync(T, lg) P_UVEC_CONCAT(uvec_log_sync_, T)(lg)
+
+/**
+ * Makes the records committed so far readable, without waiting for pending ones.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note Invalidates the pointers returned by uvec_log_get and uvec_log_span.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_refresh(T, lg) P_UVEC_CONCAT(uvec_log_refresh_, T)(lg)
+
+/**
+ * Returns the number of readable records, as of the last call to uvec_log_open,
+ * uvec_log_sync or uvec_log_refresh.
+ *
+ * @param lg [UVecLog(T)*] Log.
+ * @return [uint64_t] Number of records.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_count(lg) ((lg)->log.count)
+
+/**
+ * Returns the contiguous records of the log starting at the specified index.
+ * Records are read in place from the mapped file, and are laid out contiguously
+ * within the blocks they were committed in.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @param idx [uint64_t] Index of the first record.
+ * @param[out] n [uint64_t*] Number of contiguous records starting at 'idx', may be NULL.
+ * @return [T const*] First record, or NULL if the index is out of bounds.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_span(T, lg, idx, n) P_UVEC_CONCAT(uvec_log_span_, T)(lg, idx, n)
+
+/**
+ * Returns the address of the record at the specified index.
+ *
+ * @param T [symbol] Vector type.
+ * @param lg [UVecLog(T)*] Log.
+ * @param idx [uint64_t] Record index.
+ * @return [T const*] Record, or NULL if the index is out of bounds.
+ *
+ * @public @memberof UVecLog
+ */
+#define uvec_log_get(T, lg, idx) uvec_log_span(T, lg, idx, NULL)
+
+#endif // UVEC_LOG_H
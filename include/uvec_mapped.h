@@ -0,0 +1,469 @@
+/**
+ * uVec - memory-mapped vectors.
+ *
+ * Mapped vectors are backed by a file in the serialization format of uvec_io.h,
+ * whose storage is mapped directly into memory. Opening a read-only mapped vector
+ * takes constant time and does not copy its elements, and the page cache is shared
+ * among all processes mapping the same file. Read-write mapped vectors grow
+ * by extending and remapping the underlying file.
+ *
+ * The elements of a mapped vector are accessed through a regular UVec(T) view
+ * (see uvec_mapped_vec), so that functions that do not change the size or capacity
+ * of a vector, such as uvec_get, uvec_foreach or uvec_index_of_sorted, work unchanged.
+ *
+ * @note Mapping a file is only possible if it was written on a host
+ *       with the same byte order.
+ * @note On Linux, define _GNU_SOURCE before including any header to grow
+ *       mappings in place via mremap.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_MAPPED_H
+#define UVEC_MAPPED_H
+
+#include "uvec_io.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector whose storage is a memory-mapped file.
+ * @struct UVecMapped
+ */
+
+/// Flags for opening mapped vectors.
+typedef enum uvec_mapped_flags {
+
+    /// Map the file read-only.
+    UVEC_MAPPED_READ = 0,
+
+    /// Map the file read-write, so that the vector can be modified and grown.
+    UVEC_MAPPED_WRITE = 1 << 0,
+
+    /// Create the file if needed, discarding its contents (implies UVEC_MAPPED_WRITE).
+    UVEC_MAPPED_CREATE = 1 << 1,
+
+    /// Verify the checksum of the storage on open (requires reading the whole file).
+    UVEC_MAPPED_VERIFY = 1 << 2
+
+} uvec_mapped_flags;
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Resizes a shared file mapping.
+ *
+ * @param map [void*] Current mapping.
+ * @param old_size [size_t] Current size of the mapping.
+ * @param new_size [size_t] New size of the mapping.
+ * @param fd [int] File descriptor.
+ * @param prot [int] Memory protection of the mapping.
+ * @return [void*] New mapping, or MAP_FAILED on error.
+ */
+p_uvec_static_inline void* p_uvec_mapped_remap(void *map, size_t old_size, size_t new_size,
+                                               int fd, int prot) {
+#if defined __linux__ && defined MREMAP_MAYMOVE
+    (void)fd;
+    (void)prot;
+    return mremap(map, old_size, new_size, MREMAP_MAYMOVE);
+#else
+    void *new_map = mmap(NULL, new_size, prot, MAP_SHARED, fd, 0);
+    if (new_map != MAP_FAILED) munmap(map, old_size);
+    return new_map;
+#endif
+}
+
+/**
+ * Updates the serialization header of a mapped file.
+ *
+ * @param map [unsigned char*] Mapping.
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ */
+p_uvec_static_inline void p_uvec_mapped_update_header(unsigned char *map, size_t size,
+                                                      uvec_uint count) {
+    p_uvec_fletcher f = { 0, 0 };
+    if (count) p_uvec_fletcher_update(&f, map + P_UVEC_IO_HEADER_SIZE, size * count);
+    p_uvec_io_header_init(map, size, count, p_uvec_fletcher_value(f));
+}
+
+/**
+ * Opens and maps a file in the serialization format.
+ *
+ * @param path [char const*] Path to the file.
+ * @param flags [unsigned] Flags.
+ * @param elem_size [size_t] Element size.
+ * @param[out] fd [int*] File descriptor.
+ * @param[out] map_size [size_t*] Size of the mapping.
+ * @param[out] count [uint64_t*] Number of elements.
+ * @return [unsigned char*] Mapping, or NULL on error.
+ */
+p_uvec_static_inline unsigned char* p_uvec_mapped_open(char const *path, unsigned flags,
+                                                       size_t elem_size, int *fd,
+                                                       size_t *map_size, uint64_t *count) {
+    if (flags & UVEC_MAPPED_CREATE) flags |= UVEC_MAPPED_WRITE;
+    bool const writable = flags & UVEC_MAPPED_WRITE;
+    int oflags = writable ? O_RDWR : O_RDONLY;
+    if (flags & UVEC_MAPPED_CREATE) oflags |= O_CREAT | O_TRUNC;
+
+    *fd = open(path, oflags, 0644);
+    if (*fd < 0) return NULL;
+
+    unsigned char *map = MAP_FAILED;
+    uint64_t checksum;
+    bool swap;
+    struct stat st;
+
+    if (flags & UVEC_MAPPED_CREATE && ftruncate(*fd, P_UVEC_IO_HEADER_SIZE)) goto err;
+    if (fstat(*fd, &st)) goto err;
+
+    if ((uint64_t)st.st_size < P_UVEC_IO_HEADER_SIZE || (uint64_t)st.st_size > SIZE_MAX) {
+        errno = EINVAL;
+        goto err;
+    }
+
+    *map_size = (size_t)st.st_size;
+    map = mmap(NULL, *map_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+               *fd, 0);
+    if (map == MAP_FAILED) goto err;
+
+    if (flags & UVEC_MAPPED_CREATE) {
+        p_uvec_io_header_init(map, elem_size, 0, 0);
+        *count = 0;
+        return map;
+    }
+
+    if (p_uvec_io_header_parse(map, elem_size, count, &checksum, &swap) || swap ||
+        *count > UVEC_UINT_MAX ||
+        *count > (*map_size - P_UVEC_IO_HEADER_SIZE) / elem_size) {
+        errno = EINVAL;
+        goto err;
+    }
+
+    if (flags & UVEC_MAPPED_VERIFY) {
+        p_uvec_fletcher f = { 0, 0 };
+        p_uvec_fletcher_update(&f, map + P_UVEC_IO_HEADER_SIZE, elem_size * (size_t)*count);
+
+        if (p_uvec_fletcher_value(f) != checksum) {
+            errno = EINVAL;
+            goto err;
+        }
+    }
+
+    return map;
+
+err:
+    {
+        int const error = errno;
+        if (map != MAP_FAILED) munmap(map, *map_size);
+        close(*fd);
+        errno = error;
+    }
+    return NULL;
+}
+
+/**
+ * Defines a new mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_MAPPED(T)                                                                   \
+    typedef struct UVecMapped_##T {                                                                 \
+        /** @cond */                                                                                \
+        UVec_##T vec;                                                                               \
+        unsigned char *map;                                                                         \
+        size_t size;                                                                                \
+        int fd;                                                                                     \
+        bool writable;                                                                              \
+        /** @endcond */                                                                             \
+    } UVecMapped_##T;
+
+/**
+ * Generates function declarations for the specified mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_MAPPED(T, SCOPE)                                                                \
+    /** @cond */                                                                                    \
+    SCOPE UVecMapped_##T* uvec_mapped_open_##T(char const *path, unsigned flags);                   \
+    SCOPE uvec_ret uvec_mapped_close_##T(UVecMapped_##T *mv);                                       \
+    SCOPE uvec_ret uvec_mapped_sync_##T(UVecMapped_##T *mv);                                        \
+    SCOPE uvec_ret uvec_mapped_reserve_##T(UVecMapped_##T *mv, uvec_uint capacity);                 \
+    SCOPE uvec_ret uvec_mapped_push_##T(UVecMapped_##T *mv, T item);                                \
+    SCOPE uvec_ret uvec_mapped_append_array_##T(UVecMapped_##T *mv, T const *array, uvec_uint n);   \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_MAPPED(T, SCOPE)                                                                \
+                                                                                                    \
+    static inline void p_uvec_mapped_bind_##T(UVecMapped_##T *mv) {                                 \
+        size_t capacity = (mv->size - P_UVEC_IO_HEADER_SIZE) / sizeof(T);                           \
+        if (capacity > UVEC_UINT_MAX) capacity = UVEC_UINT_MAX;                                     \
+        mv->vec.allocated = (uvec_uint)capacity;                                                    \
+        mv->vec.storage = capacity ? (T *)(void *)(mv->map + P_UVEC_IO_HEADER_SIZE) : NULL;         \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecMapped_##T* uvec_mapped_open_##T(char const *path, unsigned flags) {                  \
+        UVecMapped_##T *mv = UVEC_MALLOC(sizeof(*mv));                                              \
+        if (!mv) return NULL;                                                                       \
+                                                                                                    \
+        uint64_t count;                                                                             \
+        mv->map = p_uvec_mapped_open(path, flags, sizeof(T), &mv->fd, &mv->size, &count);           \
+                                                                                                    \
+        if (!mv->map) {                                                                             \
+            UVEC_FREE(mv);                                                                          \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        mv->writable = flags & (UVEC_MAPPED_WRITE | UVEC_MAPPED_CREATE);                            \
+        mv->vec = uvec_init(T);                                                                     \
+        mv->vec.count = (uvec_uint)count;                                                           \
+        p_uvec_mapped_bind_##T(mv);                                                                 \
+        return mv;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mapped_sync_##T(UVecMapped_##T *mv) {                                       \
+        if (!mv->writable) return UVEC_OK;                                                          \
+        p_uvec_mapped_update_header(mv->map, sizeof(T), mv->vec.count);                             \
+        return msync(mv->map, mv->size, MS_SYNC) ? UVEC_ERR : UVEC_OK;                              \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mapped_close_##T(UVecMapped_##T *mv) {                                      \
+        if (!mv) return UVEC_OK;                                                                    \
+        uvec_ret ret = UVEC_OK;                                                                     \
+                                                                                                    \
+        if (mv->writable) {                                                                         \
+            p_uvec_mapped_update_header(mv->map, sizeof(T), mv->vec.count);                         \
+            size_t const size = P_UVEC_IO_HEADER_SIZE + sizeof(T) * mv->vec.count;                  \
+            if (munmap(mv->map, mv->size) || ftruncate(mv->fd, (off_t)size)) ret = UVEC_ERR;        \
+        } else {                                                                                    \
+            munmap(mv->map, mv->size);                                                              \
+        }                                                                                           \
+                                                                                                    \
+        if (close(mv->fd)) ret = UVEC_ERR;                                                          \
+        UVEC_FREE(mv);                                                                              \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mapped_reserve_##T(UVecMapped_##T *mv, uvec_uint capacity) {                \
+        if (mv->vec.allocated >= capacity) return UVEC_OK;                                          \
+        if (!mv->writable) return UVEC_ERR;                                                         \
+                                                                                                    \
+        uvec_uint new_capacity = capacity;                                                          \
+        p_uvec_uint_next_power_2(new_capacity);                                                     \
+        if (new_capacity < capacity) new_capacity = capacity;                                       \
+                                                                                                    \
+        size_t const size = P_UVEC_IO_HEADER_SIZE + sizeof(T) * new_capacity;                       \
+        if ((size - P_UVEC_IO_HEADER_SIZE) / sizeof(T) != new_capacity) return UVEC_ERR;            \
+        if (ftruncate(mv->fd, (off_t)size)) return UVEC_ERR;                                        \
+                                                                                                    \
+        unsigned char *map = p_uvec_mapped_remap(mv->map, mv->size, size, mv->fd,                   \
+                                                 PROT_READ | PROT_WRITE);                           \
+        if (map == MAP_FAILED) return UVEC_ERR;                                                     \
+                                                                                                    \
+        mv->map = map;                                                                              \
+        mv->size = size;                                                                            \
+        p_uvec_mapped_bind_##T(mv);                                                                 \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mapped_push_##T(UVecMapped_##T *mv, T item) {                               \
+        if (mv->vec.count == UVEC_UINT_MAX ||                                                       \
+            uvec_mapped_reserve_##T(mv, mv->vec.count + 1)) return UVEC_ERR;                        \
+        mv->vec.storage[mv->vec.count++] = item;                                                    \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mapped_append_array_##T(UVecMapped_##T *mv, T const *array, uvec_uint n) {  \
+        if (!n) return UVEC_OK;                                                                     \
+        if (n > UVEC_UINT_MAX - mv->vec.count ||                                                    \
+            uvec_mapped_reserve_##T(mv, mv->vec.count + n)) return UVEC_ERR;                        \
+        memcpy(mv->vec.storage + mv->vec.count, array, n * sizeof(T));                              \
+        mv->vec.count += n;                                                                         \
+        return UVEC_OK;                                                                             \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecMapped
+ */
+#define UVEC_DECL_MAPPED(T)                                                                         \
+    P_UVEC_DEF_TYPE_MAPPED(T)                                                                       \
+    P_UVEC_DECL_MAPPED(T, p_uvec_unused)
+
+/**
+ * Declares a new mapped vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecMapped
+ */
+#define UVEC_DECL_MAPPED_SPEC(T, SPEC)                                                              \
+    P_UVEC_DEF_TYPE_MAPPED(T)                                                                       \
+    P_UVEC_DECL_MAPPED(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecMapped
+ */
+#define UVEC_IMPL_MAPPED(T) \
+    P_UVEC_IMPL_MAPPED(T, p_uvec_unused)
+
+/**
+ * Defines a new static mapped vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecMapped
+ */
+#define UVEC_INIT_MAPPED(T)                                                                         \
+    P_UVEC_DEF_TYPE_MAPPED(T)                                                                       \
+    P_UVEC_IMPL_MAPPED(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new mapped vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecMapped
+ */
+#define UVecMapped(T) P_UVEC_CONCAT(UVecMapped_, T)
+
+/// @name Memory management
+
+/**
+ * Maps a file written via the serialization functions of uvec_io.h.
+ *
+ * @param T [symbol] Vector type.
+ * @param path [char const*] Path to the file.
+ * @param flags [unsigned] Combination of uvec_mapped_flags.
+ * @return [UVecMapped(T)*] Vector instance, or NULL on error.
+ *
+ * @note If the file is not a valid serialized vector of type T, was written on a host
+ *       with a different byte order or fails checksum verification, errno is set to EINVAL.
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_open(T, path, flags) P_UVEC_CONCAT(uvec_mapped_open_, T)(path, flags)
+
+/**
+ * Unmaps and closes the specified vector. If the vector is writable, its header is
+ * updated and the file is truncated to its serialized size.
+ *
+ * @param T [symbol] Vector type.
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The vector is deallocated even if the operation fails.
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_close(T, mv) P_UVEC_CONCAT(uvec_mapped_close_, T)(mv)
+
+/**
+ * Updates the header of a writable vector and flushes its contents to the file.
+ * Until this function or uvec_mapped_close is called, other processes mapping the file
+ * see its previous number of elements.
+ *
+ * @param T [symbol] Vector type.
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_sync(T, mv) P_UVEC_CONCAT(uvec_mapped_sync_, T)(mv)
+
+/// @name Primitives
+
+/**
+ * Returns a vector view of the mapped storage.
+ *
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @return [UVec(T)*] Vector view.
+ *
+ * @warning The view must not be passed to functions that change its size or capacity,
+ *          nor copied in copy-on-write mode. Elements of read-only vectors must not be
+ *          modified, and growing a writable vector invalidates pointers to its elements.
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_vec(mv) (&(mv)->vec)
+
+/**
+ * Ensures that the specified vector can hold at least as many elements as 'capacity',
+ * extending and remapping the file if needed.
+ *
+ * @param T [symbol] Vector type.
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @param capacity [uvec_uint] Capacity.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if the vector is read-only).
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_reserve(T, mv, capacity) \
+    P_UVEC_CONCAT(uvec_mapped_reserve_, T)(mv, capacity)
+
+/**
+ * Pushes the specified element to the top of the vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if the vector is read-only).
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_push(T, mv, item) P_UVEC_CONCAT(uvec_mapped_push_, T)(mv, item)
+
+/**
+ * Appends the specified array to the vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param mv [UVecMapped(T)*] Vector instance.
+ * @param array [T const*] Array to append.
+ * @param n [uvec_uint] Number of elements to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if the vector is read-only).
+ *
+ * @public @related UVecMapped
+ */
+#define uvec_mapped_append_array(T, mv, array, n) \
+    P_UVEC_CONCAT(uvec_mapped_append_array_, T)(mv, array, n)
+
+#endif // UVEC_MAPPED_H
@@ -0,0 +1,1128 @@
+/**
+ * uVec - parallel algorithms.
+ *
+ * A small work-stealing thread pool, and parallel versions of common vector
+ * operations built on top of it. Vectors are split into cache line aligned chunks,
+ * which are initially distributed evenly across workers. Workers that run out of
+ * chunks steal half of the remaining chunks of another worker.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_PARALLEL_H
+#define UVEC_PARALLEL_H
+
+#include "uvec.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "Parallel algorithms require atomic operations, not available on this compiler."
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * Function processing a range of elements.
+ *
+ * @param ctx [void*] Context.
+ * @param chunk [uvec_uint] Index of the chunk.
+ * @param start [uvec_uint] Index of the first element.
+ * @param end [uvec_uint] Index past the last element.
+ */
+typedef void (*uvec_range_func)(void *ctx, uvec_uint chunk, uvec_uint start, uvec_uint end);
+
+/// Per-worker state.
+typedef struct p_uvec_pool_worker {
+    P_UVEC_ATOMIC(uint64_t) range;
+    struct UVecPool *pool;
+    unsigned idx;
+    char pad[UVEC_CACHE_LINE_SIZE];
+} p_uvec_pool_worker;
+
+/// Parallel job.
+typedef struct p_uvec_pool_job {
+    uvec_range_func func;
+    void *ctx;
+    uvec_uint count;
+    uvec_uint chunk;
+    uvec_uint skew;
+    uvec_uint chunks;
+} p_uvec_pool_job;
+
+/// Work-stealing thread pool.
+typedef struct UVecPool {
+    /** @cond */
+    unsigned count;
+    p_uvec_pool_worker *workers;
+    pthread_t *threads;
+    pthread_mutex_t run_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    unsigned pending;
+    bool stop;
+    p_uvec_pool_job job;
+    /** @endcond */
+} UVecPool;
+
+// #############
+// # Constants #
+// #############
+
+/// Number of chunks each worker is initially assigned, if the vector is large enough.
+#define P_UVEC_POOL_CHUNKS_PER_WORKER 8
+
+/// Minimum size of a chunk, in bytes.
+#define P_UVEC_POOL_MIN_CHUNK_BYTES 4096
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Packs a range of chunks into a 64 bit integer.
+ *
+ * @param lo [uint64_t] First chunk.
+ * @param hi [uint64_t] Chunk past the last one.
+ * @return [uint64_t] Packed range.
+ */
+#define p_uvec_pool_range(lo, hi) (((uint64_t)(lo) << 32u) | (uint64_t)(hi))
+
+/**
+ * Returns the index of the first element of the specified chunk.
+ *
+ * @param job [p_uvec_pool_job const*] Job.
+ * @param i [uvec_uint] Chunk index.
+ * @return [uvec_uint] Index of the first element.
+ */
+p_uvec_static_inline uvec_uint p_uvec_pool_bound(p_uvec_pool_job const *job, uvec_uint i) {
+    if (!i) return 0;
+    uvec_uint bound = i * job->chunk - job->skew;
+    return bound > job->count ? job->count : bound;
+}
+
+/**
+ * Initializes a job over the specified storage, splitting it into cache line aligned chunks.
+ *
+ * @param pool [UVecPool const*] Thread pool, can be NULL.
+ * @param storage [void const*] Storage.
+ * @param size [size_t] Element size.
+ * @param count [uvec_uint] Number of elements.
+ * @return [p_uvec_pool_job] Job.
+ */
+p_uvec_static_inline p_uvec_pool_job p_uvec_pool_job_init(UVecPool const *pool, void const *storage,
+                                                          size_t size, uvec_uint count) {
+    p_uvec_pool_job job = { .count = count, .chunk = count ? count : 1, .chunks = 1 };
+    unsigned workers = pool ? pool->count : 1;
+    if (workers < 2 || !count) return job;
+
+    uvec_uint line = 1, first = 0;
+
+    if (size < UVEC_CACHE_LINE_SIZE && UVEC_CACHE_LINE_SIZE % size == 0) {
+        line = UVEC_CACHE_LINE_SIZE / size;
+        size_t offset = (UVEC_CACHE_LINE_SIZE - (uintptr_t)storage % UVEC_CACHE_LINE_SIZE);
+        if (offset % size == 0) first = (uvec_uint)(offset / size) % line;
+    }
+
+    uvec_uint chunk = count / (workers * P_UVEC_POOL_CHUNKS_PER_WORKER);
+    uvec_uint min = P_UVEC_POOL_MIN_CHUNK_BYTES / size;
+    if (chunk < min) chunk = min;
+    if (chunk < 1) chunk = 1;
+    chunk = (chunk + line - 1) / line * line;
+
+    job.chunk = chunk;
+    job.skew = first ? chunk - first : 0;
+    job.chunks = (count + job.skew + chunk - 1) / chunk;
+    return job;
+}
+
+/**
+ * Steals half of the remaining chunks of another worker.
+ *
+ * @param pool [UVecPool*] Thread pool.
+ * @param self [unsigned] Index of the stealing worker.
+ * @return [bool] True if chunks were stolen, false if there are no chunks left.
+ */
+p_uvec_static_inline bool p_uvec_pool_steal(UVecPool *pool, unsigned self) {
+    for (unsigned i = 1; i < pool->count; ++i) {
+        P_UVEC_ATOMIC(uint64_t) *victim = &pool->workers[(self + i) % pool->count].range;
+        uint64_t range = p_uvec_atomic_load(victim, P_UVEC_MO_ACQUIRE);
+
+        while ((uint32_t)(range >> 32u) < (uint32_t)range) {
+            uint32_t lo = (uint32_t)(range >> 32u), hi = (uint32_t)range;
+            uint32_t mid = hi - (hi - lo + 1) / 2;
+
+            if (p_uvec_atomic_cas(victim, &range, p_uvec_pool_range(lo, mid),
+                                  P_UVEC_MO_ACQ_REL, P_UVEC_MO_ACQUIRE)) {
+                p_uvec_atomic_store(&pool->workers[self].range, p_uvec_pool_range(mid, hi),
+                                    P_UVEC_MO_RELEASE);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Processes chunks of the current job until there are none left.
+ *
+ * @param pool [UVecPool*] Thread pool.
+ * @param self [unsigned] Index of the worker.
+ */
+p_uvec_static_inline void p_uvec_pool_work(UVecPool *pool, unsigned self) {
+    p_uvec_pool_job const *job = &pool->job;
+    P_UVEC_ATOMIC(uint64_t) *own = &pool->workers[self].range;
+
+    while (true) {
+        uint64_t range = p_uvec_atomic_load(own, P_UVEC_MO_ACQUIRE);
+        uint32_t lo = (uint32_t)(range >> 32u), hi = (uint32_t)range;
+
+        if (lo < hi) {
+            if (p_uvec_atomic_cas(own, &range, p_uvec_pool_range(lo + 1, hi),
+                                  P_UVEC_MO_ACQ_REL, P_UVEC_MO_RELAXED)) {
+                job->func(job->ctx, lo, p_uvec_pool_bound(job, lo), p_uvec_pool_bound(job, lo + 1));
+            }
+        } else if (!p_uvec_pool_steal(pool, self)) {
+            break;
+        }
+    }
+}
+
+/**
+ * Worker thread body: waits for jobs and processes them until the pool is stopped.
+ *
+ * @param arg [p_uvec_pool_worker*] Worker.
+ * @return [void*] NULL.
+ */
+p_uvec_static_inline void* p_uvec_pool_main(void *arg) {
+    p_uvec_pool_worker *worker = arg;
+    UVecPool *pool = worker->pool;
+    unsigned long generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while (!pool->stop && pool->generation == generation) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->stop) break;
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        p_uvec_pool_work(pool, worker->idx);
+
+        pthread_mutex_lock(&pool->lock);
+        if (!--pool->pending) pthread_cond_signal(&pool->done);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Runs the specified job, distributing its chunks across the pool workers.
+ * The calling thread participates as worker 0.
+ *
+ * @param pool [UVecPool*] Thread pool, can be NULL.
+ * @param job [p_uvec_pool_job const*] Job.
+ */
+p_uvec_static_inline void p_uvec_pool_run(UVecPool *pool, p_uvec_pool_job const *job) {
+    if (!job->count) return;
+
+    if (!pool || pool->count < 2 || job->chunks < 2) {
+        for (uvec_uint i = 0; i < job->chunks; ++i) {
+            job->func(job->ctx, i, p_uvec_pool_bound(job, i), p_uvec_pool_bound(job, i + 1));
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+
+    pool->job = *job;
+    uint64_t chunks = job->chunks;
+
+    for (unsigned i = 0; i < pool->count; ++i) {
+        uint64_t lo = chunks * i / pool->count, hi = chunks * (i + 1) / pool->count;
+        p_uvec_atomic_store(&pool->workers[i].range, p_uvec_pool_range(lo, hi), P_UVEC_MO_RELAXED);
+    }
+
+    pool->pending = pool->count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    p_uvec_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+/**
+ * Generates function declarations for the parallel algorithms of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_PARALLEL(T, SCOPE)                                                              \
+    /** @cond */                                                                                    \
+    SCOPE void uvec_parallel_foreach_##T(UVecPool *pool, UVec_##T *vec,                             \
+                                         void (*func)(T *, void *), void *ctx);                     \
+    SCOPE uvec_ret uvec_parallel_map_##T(UVecPool *pool, UVec_##T const *vec, UVec_##T *dest,       \
+                                         T (*func)(T, void *), void *ctx);                          \
+    SCOPE T uvec_parallel_reduce_##T(UVecPool *pool, UVec_##T const *vec,                           \
+                                     T (*func)(T, T, void *), T init, void *ctx);                   \
+    SCOPE UVec_##T* uvec_parallel_deep_copy_##T(UVecPool *pool, UVec_##T const *vec,                \
+                                                T (*copy_func)(T));                                 \
+    /** @endcond */
+
+/**
+ * Generates function declarations for the parallel algorithms of the specified
+ * equatable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_PARALLEL_EQUATABLE(T, SCOPE)                                                    \
+    /** @cond */                                                                                    \
+    SCOPE uvec_uint uvec_parallel_index_of_##T(UVecPool *pool, UVec_##T const *vec, T item);        \
+    /** @endcond */
+
+/**
+ * Generates function declarations for the parallel algorithms of the specified
+ * comparable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_PARALLEL_COMPARABLE(T, SCOPE)                                                   \
+    /** @cond */                                                                                    \
+    SCOPE uvec_uint uvec_parallel_index_of_min_##T(UVecPool *pool, UVec_##T const *vec);            \
+    SCOPE uvec_uint uvec_parallel_index_of_max_##T(UVecPool *pool, UVec_##T const *vec);            \
+    SCOPE uvec_ret uvec_parallel_merge_sorted_k_##T(UVecPool *pool, UVec_##T *dst,                  \
+                                                    UVec_##T * const *runs, unsigned k);            \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the parallel algorithms of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_PARALLEL(T, SCOPE)                                                              \
+                                                                                                    \
+    typedef struct p_uvec_parallel_ctx_##T {                                                        \
+        T const *src;                                                                               \
+        T *dst;                                                                                     \
+        union {                                                                                     \
+            void (*foreach)(T *, void *);                                                           \
+            T (*map)(T, void *);                                                                    \
+            T (*reduce)(T, T, void *);                                                              \
+            T (*copy)(T);                                                                           \
+        } func;                                                                                     \
+        void *ctx;                                                                                  \
+        T *partials;                                                                                \
+    } p_uvec_parallel_ctx_##T;                                                                      \
+                                                                                                    \
+    static inline void p_uvec_parallel_foreach_task_##T(void *data, uvec_uint chunk,                \
+                                                        uvec_uint start, uvec_uint end) {           \
+        p_uvec_parallel_ctx_##T *ctx = data;                                                        \
+        for (uvec_uint i = start; i < end; ++i) ctx->func.foreach(ctx->dst + i, ctx->ctx);          \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_map_task_##T(void *data, uvec_uint chunk,                    \
+                                                    uvec_uint start, uvec_uint end) {               \
+        p_uvec_parallel_ctx_##T *ctx = data;                                                        \
+        for (uvec_uint i = start; i < end; ++i) ctx->dst[i] = ctx->func.map(ctx->src[i], ctx->ctx); \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_reduce_task_##T(void *data, uvec_uint chunk,                 \
+                                                       uvec_uint start, uvec_uint end) {            \
+        p_uvec_parallel_ctx_##T *ctx = data;                                                        \
+        T acc = ctx->src[start];                                                                    \
+        for (uvec_uint i = start + 1; i < end; ++i) {                                               \
+            acc = ctx->func.reduce(acc, ctx->src[i], ctx->ctx);                                     \
+        }                                                                                           \
+        ctx->partials[chunk] = acc;                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_copy_task_##T(void *data, uvec_uint chunk,                   \
+                                                     uvec_uint start, uvec_uint end) {              \
+        p_uvec_parallel_ctx_##T *ctx = data;                                                        \
+        for (uvec_uint i = start; i < end; ++i) ctx->dst[i] = ctx->func.copy(ctx->src[i]);          \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_parallel_foreach_##T(UVecPool *pool, UVec_##T *vec,                             \
+                                         void (*func)(T *, void *), void *ctx) {                    \
+        if (!vec->count || p_uvec_cow_unshare(vec)) return;                                         \
+        p_uvec_parallel_ctx_##T data = { .dst = vec->storage, .func.foreach = func, .ctx = ctx };   \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, vec->storage, sizeof(T), vec->count);      \
+        job.func = p_uvec_parallel_foreach_task_##T;                                                \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_parallel_map_##T(UVecPool *pool, UVec_##T const *vec, UVec_##T *dest,       \
+                                         T (*func)(T, void *), void *ctx) {                         \
+        uvec_uint const count = vec->count;                                                         \
+                                                                                                    \
+        if (dest != vec) {                                                                          \
+            dest->count = 0;                                                                        \
+            if (uvec_reserve_capacity_##T(dest, count)) return UVEC_ERR;                            \
+        }                                                                                           \
+                                                                                                    \
+        if (!count) return UVEC_OK;                                                                 \
+        if (p_uvec_cow_unshare(dest)) return UVEC_ERR;                                              \
+                                                                                                    \
+        p_uvec_parallel_ctx_##T data = {                                                            \
+            .src = vec->storage, .dst = dest->storage, .func.map = func, .ctx = ctx                 \
+        };                                                                                          \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, dest->storage, sizeof(T), count);          \
+        job.func = p_uvec_parallel_map_task_##T;                                                    \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+        dest->count = count;                                                                        \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T uvec_parallel_reduce_##T(UVecPool *pool, UVec_##T const *vec,                           \
+                                     T (*func)(T, T, void *), T init, void *ctx) {                  \
+        if (!vec->count) return init;                                                               \
+                                                                                                    \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, vec->storage, sizeof(T), vec->count);      \
+        p_uvec_parallel_ctx_##T data = { .src = vec->storage, .func.reduce = func, .ctx = ctx };    \
+                                                                                                    \
+        if (!(data.partials = UVEC_MALLOC(job.chunks * sizeof(T)))) {                               \
+            for (uvec_uint i = 0; i < vec->count; ++i) init = func(init, vec->storage[i], ctx);     \
+            return init;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        job.func = p_uvec_parallel_reduce_task_##T;                                                 \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+                                                                                                    \
+        for (uvec_uint i = 0; i < job.chunks; ++i) init = func(init, data.partials[i], ctx);        \
+        UVEC_FREE(data.partials);                                                                   \
+        return init;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T* uvec_parallel_deep_copy_##T(UVecPool *pool, UVec_##T const *vec,                \
+                                                T (*copy_func)(T)) {                                \
+        UVec_##T *copy = uvec_alloc_##T();                                                          \
+        if (!copy) return NULL;                                                                     \
+                                                                                                    \
+        if (uvec_reserve_capacity_##T(copy, vec->count)) {                                          \
+            uvec_free_##T(copy);                                                                    \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_parallel_ctx_##T data = {                                                            \
+            .src = vec->storage, .dst = copy->storage, .func.copy = copy_func                       \
+        };                                                                                          \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, copy->storage, sizeof(T), vec->count);     \
+        job.func = p_uvec_parallel_copy_task_##T;                                                   \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+        copy->count = vec->count;                                                                   \
+        return copy;                                                                                \
+    }
+
+/**
+ * Generates function definitions for the parallel algorithms of the specified
+ * equatable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ * @param equal_func Equality function: (T, T) -> bool
+ */
+#define P_UVEC_IMPL_PARALLEL_EQUATABLE(T, SCOPE, equal_func)                                        \
+                                                                                                    \
+    typedef struct p_uvec_parallel_find_ctx_##T {                                                   \
+        T const *storage;                                                                           \
+        T item;                                                                                     \
+        P_UVEC_ATOMIC(uvec_uint) found;                                                             \
+    } p_uvec_parallel_find_ctx_##T;                                                                 \
+                                                                                                    \
+    static inline void p_uvec_parallel_index_of_task_##T(void *data, uvec_uint chunk,               \
+                                                         uvec_uint start, uvec_uint end) {          \
+        p_uvec_parallel_find_ctx_##T *ctx = data;                                                   \
+        uvec_uint found = p_uvec_atomic_load(&ctx->found, P_UVEC_MO_RELAXED);                       \
+        if (found < end) end = found;                                                               \
+                                                                                                    \
+        for (uvec_uint i = start; i < end; ++i) {                                                   \
+            if (!equal_func(ctx->storage[i], ctx->item)) continue;                                  \
+                                                                                                    \
+            while (i < found && !p_uvec_atomic_cas(&ctx->found, &found, i,                          \
+                                                   P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED));          \
+            break;                                                                                  \
+        }                                                                                           \
+                                                                                                    \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_parallel_index_of_##T(UVecPool *pool, UVec_##T const *vec, T item) {       \
+        p_uvec_parallel_find_ctx_##T data = { .storage = vec->storage, .item = item };              \
+        p_uvec_atomic_init(&data.found, UVEC_INDEX_NOT_FOUND);                                      \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, vec->storage, sizeof(T), vec->count);      \
+        job.func = p_uvec_parallel_index_of_task_##T;                                               \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+        return p_uvec_atomic_load(&data.found, P_UVEC_MO_RELAXED);                                  \
+    }
+
+/**
+ * Generates function definitions for the parallel algorithms of the specified
+ * comparable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ * @param compare_func Comparison function: (T, T) -> bool
+ *
+ * @note Sorted runs are split and merged via the comparison function of the UVec(T) type,
+ *       as in uvec_merge_sorted_k.
+ */
+#define P_UVEC_IMPL_PARALLEL_COMPARABLE(T, SCOPE, compare_func)                                     \
+                                                                                                    \
+    typedef struct p_uvec_parallel_minmax_ctx_##T {                                                 \
+        T const *storage;                                                                           \
+        uvec_uint *partials;                                                                        \
+        bool max;                                                                                   \
+    } p_uvec_parallel_minmax_ctx_##T;                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_minmax_task_##T(void *data, uvec_uint chunk,                 \
+                                                       uvec_uint start, uvec_uint end) {            \
+        p_uvec_parallel_minmax_ctx_##T *ctx = data;                                                 \
+        T const *storage = ctx->storage;                                                            \
+        uvec_uint idx = start;                                                                      \
+                                                                                                    \
+        if (ctx->max) {                                                                             \
+            for (uvec_uint i = start + 1; i < end; ++i) {                                           \
+                if (compare_func(storage[idx], storage[i])) idx = i;                                \
+            }                                                                                       \
+        } else {                                                                                    \
+            for (uvec_uint i = start + 1; i < end; ++i) {                                           \
+                if (compare_func(storage[i], storage[idx])) idx = i;                                \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        ctx->partials[chunk] = idx;                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_uint p_uvec_parallel_minmax_##T(UVecPool *pool, UVec_##T const *vec,         \
+                                                       bool max) {                                  \
+        if (!vec->count) return UVEC_INDEX_NOT_FOUND;                                               \
+                                                                                                    \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, vec->storage, sizeof(T), vec->count);      \
+        p_uvec_parallel_minmax_ctx_##T data = { .storage = vec->storage, .max = max };              \
+        uvec_uint idx = 0;                                                                          \
+                                                                                                    \
+        if (!(data.partials = UVEC_MALLOC(job.chunks * sizeof(*data.partials)))) {                  \
+            data.partials = &idx;                                                                   \
+            p_uvec_parallel_minmax_task_##T(&data, 0, 0, vec->count);                               \
+            return idx;                                                                             \
+        }                                                                                           \
+                                                                                                    \
+        job.func = p_uvec_parallel_minmax_task_##T;                                                 \
+        job.ctx = &data;                                                                            \
+        p_uvec_pool_run(pool, &job);                                                                \
+                                                                                                    \
+        T const *storage = vec->storage;                                                            \
+        idx = data.partials[0];                                                                     \
+                                                                                                    \
+        for (uvec_uint i = 1; i < job.chunks; ++i) {                                                \
+            uvec_uint cur = data.partials[i];                                                       \
+            if (max ? compare_func(storage[idx], storage[cur])                                      \
+                    : compare_func(storage[cur], storage[idx])) idx = cur;                          \
+        }                                                                                           \
+                                                                                                    \
+        UVEC_FREE(data.partials);                                                                   \
+        return idx;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_parallel_index_of_min_##T(UVecPool *pool, UVec_##T const *vec) {           \
+        return p_uvec_parallel_minmax_##T(pool, vec, false);                                        \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_parallel_index_of_max_##T(UVecPool *pool, UVec_##T const *vec) {           \
+        return p_uvec_parallel_minmax_##T(pool, vec, true);                                         \
+    }                                                                                               \
+                                                                                                    \
+    typedef struct p_uvec_parallel_merge_ctx_##T {                                                  \
+        UVec_##T * const *runs;                                                                     \
+        unsigned k;                                                                                 \
+        T *out;                                                                                     \
+        uvec_uint total;                                                                            \
+        uvec_uint parts;                                                                            \
+        char *scratch;                                                                              \
+        size_t scratch_size;                                                                        \
+    } p_uvec_parallel_merge_ctx_##T;                                                                \
+                                                                                                    \
+    static inline uvec_uint p_uvec_parallel_lower_bound_##T(UVec_##T const *vec, T item) {          \
+        uvec_uint l = 0, r = vec->count;                                                            \
+                                                                                                    \
+        while (l < r) {                                                                             \
+            uvec_uint m = l + (r - l) / 2;                                                          \
+            if (p_uvec_compare_##T(vec->storage[m], item)) l = m + 1; else r = m;                   \
+        }                                                                                           \
+                                                                                                    \
+        return l;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_uint p_uvec_parallel_upper_bound_##T(UVec_##T const *vec, T item) {          \
+        uvec_uint l = 0, r = vec->count;                                                            \
+                                                                                                    \
+        while (l < r) {                                                                             \
+            uvec_uint m = l + (r - l) / 2;                                                          \
+            if (p_uvec_compare_##T(item, vec->storage[m])) r = m; else l = m + 1;                   \
+        }                                                                                           \
+                                                                                                    \
+        return l;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_co_rank_##T(UVec_##T * const *runs, unsigned k,              \
+                                                   uvec_uint rank, uvec_uint *lo, uvec_uint *hi,    \
+                                                   uvec_uint *cut) {                                \
+        for (unsigned i = 0; i < k; ++i) {                                                          \
+            lo[i] = 0;                                                                              \
+            hi[i] = runs[i]->count;                                                                 \
+        }                                                                                           \
+                                                                                                    \
+        while (true) {                                                                              \
+            unsigned j = 0;                                                                         \
+            uvec_uint width = 0;                                                                    \
+                                                                                                    \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                if (hi[i] - lo[i] > width) {                                                        \
+                    width = hi[i] - lo[i];                                                          \
+                    j = i;                                                                          \
+                }                                                                                   \
+            }                                                                                       \
+                                                                                                    \
+            if (!width) return;                                                                     \
+                                                                                                    \
+            uvec_uint const mid = lo[j] + width / 2;                                                \
+            T const pivot = runs[j]->storage[mid];                                                  \
+            uvec_uint before = 0;                                                                   \
+                                                                                                    \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                if (i == j) {                                                                       \
+                    cut[i] = mid;                                                                   \
+                } else if (i < j) {                                                                 \
+                    cut[i] = p_uvec_parallel_upper_bound_##T(runs[i], pivot);                       \
+                } else {                                                                            \
+                    cut[i] = p_uvec_parallel_lower_bound_##T(runs[i], pivot);                       \
+                }                                                                                   \
+                before += cut[i];                                                                   \
+            }                                                                                       \
+                                                                                                    \
+            if (before < rank) {                                                                    \
+                for (unsigned i = 0; i < k; ++i) if (cut[i] > lo[i]) lo[i] = cut[i];                \
+                lo[j] = mid + 1;                                                                    \
+            } else {                                                                                \
+                for (unsigned i = 0; i < k; ++i) if (cut[i] < hi[i]) hi[i] = cut[i];                \
+                hi[j] = mid;                                                                        \
+            }                                                                                       \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline uvec_uint p_uvec_parallel_part_start_##T(p_uvec_parallel_merge_ctx_##T const *ctx,\
+                                                           uvec_uint part) {                        \
+        uvec_uint rem = ctx->total % ctx->parts;                                                    \
+        return ctx->total / ctx->parts * part + (part < rem ? part : rem);                          \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_parallel_merge_task_##T(void *data, uvec_uint chunk,                  \
+                                                      uvec_uint start, uvec_uint end) {             \
+        p_uvec_parallel_merge_ctx_##T *ctx = data;                                                  \
+        unsigned const k = ctx->k;                                                                  \
+                                                                                                    \
+        for (uvec_uint part = start; part < end; ++part) {                                          \
+            T const **heads = (T const **)(void *)(ctx->scratch + part * ctx->scratch_size);        \
+            T const **ends = heads + k;                                                             \
+            uvec_uint *lo = (uvec_uint *)(ends + k), *hi = lo + k, *cut = hi + k;                   \
+            uvec_uint const first = p_uvec_parallel_part_start_##T(ctx, part);                      \
+            uvec_uint const last = p_uvec_parallel_part_start_##T(ctx, part + 1);                   \
+                                                                                                    \
+            p_uvec_parallel_co_rank_##T(ctx->runs, k, first, lo, hi, cut);                          \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                heads[i] = ctx->runs[i]->storage;                                                   \
+                if (lo[i]) heads[i] += lo[i];                                                       \
+            }                                                                                       \
+                                                                                                    \
+            p_uvec_parallel_co_rank_##T(ctx->runs, k, last, lo, hi, cut);                           \
+            for (unsigned i = 0; i < k; ++i) {                                                      \
+                ends[i] = ctx->runs[i]->storage;                                                    \
+                if (lo[i]) ends[i] += lo[i];                                                        \
+            }                                                                                       \
+                                                                                                    \
+            p_uvec_merge_k_##T(ctx->out + first, heads, ends, k, (unsigned *)(cut + k));            \
+        }                                                                                           \
+                                                                                                    \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_parallel_merge_sorted_k_##T(UVecPool *pool, UVec_##T *dst,                  \
+                                                    UVec_##T * const *runs, unsigned k) {           \
+        uvec_uint total = 0;                                                                        \
+        for (unsigned i = 0; i < k; ++i) total += runs[i]->count;                                   \
+                                                                                                    \
+        p_uvec_pool_job job = p_uvec_pool_job_init(pool, NULL, sizeof(T), total);                   \
+        if (k < 2 || job.chunks < 2) return uvec_merge_sorted_k_##T(dst, runs, k);                  \
+                                                                                                    \
+        p_uvec_parallel_merge_ctx_##T data = {                                                      \
+            .runs = runs, .k = k, .total = total, .parts = job.chunks,                              \
+            .scratch_size = p_uvec_cache_align(k * (2 * sizeof(T *) + 3 * sizeof(uvec_uint) +       \
+                                                    3 * sizeof(unsigned)))                          \
+        };                                                                                          \
+                                                                                                    \
+        if (p_uvec_cow_unshare(dst) || uvec_reserve_capacity_##T(dst, dst->count + total)) {        \
+            return UVEC_ERR;                                                                        \
+        }                                                                                           \
+                                                                                                    \
+        if (!(data.scratch = UVEC_MALLOC(data.parts * data.scratch_size))) return UVEC_ERR;         \
+                                                                                                    \
+        data.out = dst->storage + dst->count;                                                       \
+        job = (p_uvec_pool_job){                                                                    \
+            .func = p_uvec_parallel_merge_task_##T, .ctx = &data,                                   \
+            .count = data.parts, .chunk = 1, .chunks = data.parts                                   \
+        };                                                                                          \
+        p_uvec_pool_run(pool, &job);                                                                \
+                                                                                                    \
+        dst->count += total;                                                                        \
+        UVEC_FREE(data.scratch);                                                                    \
+        return UVEC_OK;                                                                             \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares the parallel algorithms of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL(T) \
+    P_UVEC_DECL_PARALLEL(T, p_uvec_unused)
+
+/**
+ * Declares the parallel algorithms of the specified vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL_SPEC(T, SPEC) \
+    P_UVEC_DECL_PARALLEL(T, SPEC p_uvec_unused)
+
+/**
+ * Declares the parallel algorithms of the specified equatable vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL_EQUATABLE(T)                                                             \
+    P_UVEC_DECL_PARALLEL(T, p_uvec_unused)                                                          \
+    P_UVEC_DECL_PARALLEL_EQUATABLE(T, p_uvec_unused)
+
+/**
+ * Declares the parallel algorithms of the specified equatable vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL_EQUATABLE_SPEC(T, SPEC)                                                  \
+    P_UVEC_DECL_PARALLEL(T, SPEC p_uvec_unused)                                                     \
+    P_UVEC_DECL_PARALLEL_EQUATABLE(T, SPEC p_uvec_unused)
+
+/**
+ * Declares the parallel algorithms of the specified comparable vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL_COMPARABLE(T)                                                            \
+    P_UVEC_DECL_PARALLEL(T, p_uvec_unused)                                                          \
+    P_UVEC_DECL_PARALLEL_EQUATABLE(T, p_uvec_unused)                                                \
+    P_UVEC_DECL_PARALLEL_COMPARABLE(T, p_uvec_unused)
+
+/**
+ * Declares the parallel algorithms of the specified comparable vector type,
+ * prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_DECL_PARALLEL_COMPARABLE_SPEC(T, SPEC)                                                 \
+    P_UVEC_DECL_PARALLEL(T, SPEC p_uvec_unused)                                                     \
+    P_UVEC_DECL_PARALLEL_EQUATABLE(T, SPEC p_uvec_unused)                                           \
+    P_UVEC_DECL_PARALLEL_COMPARABLE(T, SPEC p_uvec_unused)
+
+/**
+ * Implements the previously declared parallel algorithms of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_IMPL_PARALLEL(T) \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_unused)
+
+/**
+ * Implements the previously declared parallel algorithms of the specified equatable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param equal_func [(T, T) -> bool] Equality function.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_IMPL_PARALLEL_EQUATABLE(T, equal_func)                                                 \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_unused)                                                          \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_unused, equal_func)
+
+/**
+ * Implements the previously declared parallel algorithms of the specified comparable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param equal_func [(T, T) -> bool] Equality function.
+ * @param compare_func [(T, T) -> bool] Comparison function (True if LHS is smaller than RHS).
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_IMPL_PARALLEL_COMPARABLE(T, equal_func, compare_func)                                  \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_unused)                                                          \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_unused, equal_func)                                    \
+    P_UVEC_IMPL_PARALLEL_COMPARABLE(T, p_uvec_unused, compare_func)
+
+/**
+ * Implements the previously declared parallel algorithms of the specified comparable vector type
+ * whose elements can be checked for equality via == and compared via <.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_IMPL_PARALLEL_IDENTIFIABLE(T)                                                          \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_unused)                                                          \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_unused, p_uvec_identical)                              \
+    P_UVEC_IMPL_PARALLEL_COMPARABLE(T, p_uvec_unused, p_uvec_less_than)
+
+/**
+ * Defines the static parallel algorithms of the specified vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_INIT_PARALLEL(T) \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_static_inline)
+
+/**
+ * Defines the static parallel algorithms of the specified equatable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param equal_func [(T, T) -> bool] Equality function.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_INIT_PARALLEL_EQUATABLE(T, equal_func)                                                 \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_static_inline)                                                   \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_static_inline, equal_func)
+
+/**
+ * Defines the static parallel algorithms of the specified comparable vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param equal_func [(T, T) -> bool] Equality function.
+ * @param compare_func [(T, T) -> bool] Comparison function (True if LHS is smaller than RHS).
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_INIT_PARALLEL_COMPARABLE(T, equal_func, compare_func)                                  \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_static_inline)                                                   \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_static_inline, equal_func)                             \
+    P_UVEC_IMPL_PARALLEL_COMPARABLE(T, p_uvec_static_inline, compare_func)
+
+/**
+ * Defines the static parallel algorithms of the specified comparable vector type
+ * whose elements can be checked for equality via == and compared via <.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPool
+ */
+#define UVEC_INIT_PARALLEL_IDENTIFIABLE(T)                                                          \
+    P_UVEC_IMPL_PARALLEL(T, p_uvec_static_inline)                                                   \
+    P_UVEC_IMPL_PARALLEL_EQUATABLE(T, p_uvec_static_inline, p_uvec_identical)                       \
+    P_UVEC_IMPL_PARALLEL_COMPARABLE(T, p_uvec_static_inline, p_uvec_less_than)
+
+/// @name Thread pools
+
+/**
+ * Allocates a new thread pool.
+ *
+ * @param threads [unsigned] Number of threads, including the calling one.
+ *                           If zero, the number of online processors is used.
+ * @return [UVecPool*] Thread pool, or NULL on error.
+ *
+ * @public @memberof UVecPool
+ */
+p_uvec_static_inline UVecPool* uvec_pool_alloc(unsigned threads) {
+    if (!threads) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned)cpus : 1;
+    }
+
+    UVecPool *pool = UVEC_MALLOC(sizeof(*pool));
+    if (!pool) return NULL;
+
+    pool->workers = UVEC_MALLOC(threads * sizeof(*pool->workers));
+    pool->threads = UVEC_MALLOC(threads * sizeof(*pool->threads));
+
+    if (!(pool->workers && pool->threads)) {
+        UVEC_FREE(pool->workers);
+        UVEC_FREE(pool->threads);
+        UVEC_FREE(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->stop = false;
+    pool->count = 1;
+
+    for (unsigned i = 0; i < threads; ++i) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].idx = i;
+        p_uvec_atomic_init(&pool->workers[i].range, 0);
+    }
+
+    for (; pool->count < threads; ++pool->count) {
+        if (pthread_create(&pool->threads[pool->count], NULL,
+                           p_uvec_pool_main, &pool->workers[pool->count])) break;
+    }
+
+    return pool;
+}
+
+/**
+ * Stops the threads of the specified pool and deallocates it.
+ *
+ * @param pool [UVecPool*] Thread pool.
+ *
+ * @public @memberof UVecPool
+ */
+p_uvec_static_inline void uvec_pool_free(UVecPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 1; i < pool->count; ++i) pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    UVEC_FREE(pool->threads);
+    UVEC_FREE(pool->workers);
+    UVEC_FREE(pool);
+}
+
+/**
+ * Returns the number of threads of the specified pool, including the calling one.
+ *
+ * @param pool [UVecPool*] Thread pool.
+ * @return [unsigned] Number of threads.
+ *
+ * @public @memberof UVecPool
+ */
+#define uvec_pool_threads(pool) ((pool) ? (pool)->count : 1)
+
+/**
+ * Calls the specified function on chunks of the range [0, count), in parallel.
+ * Returns once all chunks have been processed.
+ *
+ * @param pool [UVecPool*] Thread pool. If NULL, chunks are processed on the calling thread.
+ * @param count [uvec_uint] Number of elements.
+ * @param size [size_t] Size of each element, used to determine the chunk size.
+ * @param func [uvec_range_func] Function processing a chunk.
+ * @param ctx [void*] Context passed to the function.
+ *
+ * @note Parallel operations must not be started from within a chunk function.
+ *
+ * @public @memberof UVecPool
+ */
+p_uvec_static_inline void uvec_parallel_for(UVecPool *pool, uvec_uint count, size_t size,
+                                            uvec_range_func func, void *ctx) {
+    p_uvec_pool_job job = p_uvec_pool_job_init(pool, NULL, size, count);
+    job.func = func;
+    job.ctx = ctx;
+    p_uvec_pool_run(pool, &job);
+}
+
+/// @name Parallel algorithms
+
+/**
+ * Calls the specified function on each element of the vector, in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param func [void (*)(T *, void *)] Function called on a pointer to each element.
+ * @param ctx [void*] Context passed to the function.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_foreach(T, pool, vec, func, ctx) \
+    P_UVEC_CONCAT(uvec_parallel_foreach_, T)(pool, vec, func, ctx)
+
+/**
+ * Replaces the contents of 'dest' with the result of applying the specified function
+ * to each element of 'vec', in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Source vector.
+ * @param dest [UVec(T)*] Destination vector, can be the same as the source vector.
+ * @param func [T (*)(T, void *)] Mapping function.
+ * @param ctx [void*] Context passed to the function.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_map(T, pool, vec, dest, func, ctx) \
+    P_UVEC_CONCAT(uvec_parallel_map_, T)(pool, vec, dest, func, ctx)
+
+/**
+ * Reduces the elements of the vector via the specified function, in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param func [T (*)(T, T, void *)] Reduction function, must be associative.
+ * @param init [T] Initial value.
+ * @param ctx [void*] Context passed to the function.
+ * @return [T] Result of the reduction.
+ *
+ * @note Elements are combined in order, so the function need not be commutative.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_reduce(T, pool, vec, func, init, ctx) \
+    P_UVEC_CONCAT(uvec_parallel_reduce_, T)(pool, vec, func, init, ctx)
+
+/**
+ * Returns a new vector containing deep copies of the elements of the specified vector,
+ * obtained by calling the copy function in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector to copy.
+ * @param copy_func [T (*)(T)] Copy function.
+ * @return [UVec(T)*] Copied vector, or NULL on error.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_deep_copy(T, pool, vec, copy_func) \
+    P_UVEC_CONCAT(uvec_parallel_deep_copy_, T)(pool, vec, copy_func)
+
+/**
+ * Returns the index of the first occurrence of the specified element, searching in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector instance.
+ * @param item [T] Element to search.
+ * @return [uvec_uint] Index of the found element, or UVEC_INDEX_NOT_FOUND.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_index_of(T, pool, vec, item) \
+    P_UVEC_CONCAT(uvec_parallel_index_of_, T)(pool, vec, item)
+
+/**
+ * Returns the index of the minimum element in the vector, searching in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector instance.
+ * @return [uvec_uint] Index of the minimum element, or UVEC_INDEX_NOT_FOUND if empty.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_index_of_min(T, pool, vec) \
+    P_UVEC_CONCAT(uvec_parallel_index_of_min_, T)(pool, vec)
+
+/**
+ * Returns the index of the maximum element in the vector, searching in parallel.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param vec [UVec(T)*] Vector instance.
+ * @return [uvec_uint] Index of the maximum element, or UVEC_INDEX_NOT_FOUND if empty.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_index_of_max(T, pool, vec) \
+    P_UVEC_CONCAT(uvec_parallel_index_of_max_, T)(pool, vec)
+
+/**
+ * Merges the specified sorted vectors in parallel, appending the result to the destination
+ * vector. The output is split into ranges by co-ranking, so that each task merges
+ * disjoint slices of the input vectors into a disjoint range of the output.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool.
+ * @param dst [UVec(T)*] Destination vector, must not be one of the merged vectors.
+ * @param runs [UVec(T)**] Sorted vectors.
+ * @param k [unsigned] Number of sorted vectors.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The result is the same as that of uvec_merge_sorted_k.
+ *
+ * @public @related UVecPool
+ */
+#define uvec_parallel_merge_sorted_k(T, pool, dst, runs, k) \
+    P_UVEC_CONCAT(uvec_parallel_merge_sorted_k_, T)(pool, dst, runs, k)
+
+#endif // UVEC_PARALLEL_H
@@ -0,0 +1,1408 @@
+/**
+ * uVec - persistent vectors.
+ *
+ * Persistent vectors are immutable: every update returns a new version, which shares
+ * most of its structure with the original one. They are implemented as relaxed radix
+ * balanced trees (RRB-trees), and support efficient concatenation and slicing.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_PERSISTENT_H
+#define UVEC_PERSISTENT_H
+
+#include "uvec.h"
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "Persistent vectors require atomic operations, not available on this compiler."
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A persistent vector, implemented as a relaxed radix balanced tree.
+ * @struct UVecPersistent
+ */
+
+// #############
+// # Constants #
+// #############
+
+/// Number of bits of the index consumed by each level of the tree.
+#define P_UVEC_PNODE_BITS 5
+
+/// Number of slots in a tree node.
+#define P_UVEC_PNODE_SLOTS (1u << P_UVEC_PNODE_BITS)
+
+/// Number of nodes exceeding the optimum that are tolerated when concatenating trees.
+#define P_UVEC_PNODE_EXTRA 2
+
+// ###############
+// # Private API #
+// ###############
+
+/// Type with the strictest alignment requirement.
+typedef union p_uvec_max_align {
+    void *p;
+    long long ll;
+    long double ld;
+} p_uvec_max_align;
+
+/// Tree node.
+typedef struct p_uvec_pnode {
+
+    /// Reference count.
+    P_UVEC_ATOMIC(size_t) refs;
+
+    /// Size table, or NULL if all children but the last one are full.
+    uvec_uint *sizes;
+
+    /// Number of used slots.
+    unsigned count;
+
+    /// True if the node is owned by a transient vector, and can be updated in place.
+    bool owned;
+
+    /// Slots: elements (leaf nodes) or children, followed by the size table (internal nodes).
+    p_uvec_max_align data[];
+
+} p_uvec_pnode;
+
+/// Type-erased persistent vector.
+typedef struct p_uvec_pvec {
+
+    /// Number of elements.
+    uvec_uint count;
+
+    /// Height of the tree (0 if the root is a leaf).
+    unsigned height;
+
+    /// Root of the tree, or NULL if the vector is empty.
+    p_uvec_pnode *root;
+
+    /// True if the vector is transient.
+    bool transient;
+
+} p_uvec_pvec;
+
+/// Returns the children of an internal node.
+#define p_uvec_pnode_children(node) ((p_uvec_pnode **)(node)->data)
+
+/// Returns the memory reserved for the size table of an internal node.
+#define p_uvec_pnode_size_table(node) \
+    ((uvec_uint *)(p_uvec_pnode_children(node) + P_UVEC_PNODE_SLOTS))
+
+/// Returns the address of the element at the specified index in a leaf node.
+#define p_uvec_pnode_elem(node, idx, size) \
+    ((unsigned char *)(node)->data + (size_t)(idx) * (size))
+
+/// Returns the maximum number of elements held by each child of a node at the specified height.
+#define p_uvec_pnode_child_capacity(height) ((uint64_t)1 << (P_UVEC_PNODE_BITS * (height)))
+
+/**
+ * Allocates a new tree node.
+ *
+ * @param height [unsigned] Height of the node.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the node is owned by a transient vector.
+ * @return [p_uvec_pnode *] Node, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_alloc(unsigned height, size_t size, bool owned) {
+    size_t slot_size = height ? sizeof(p_uvec_pnode *) + sizeof(uvec_uint) : size;
+    p_uvec_pnode *node = UVEC_MALLOC(sizeof(*node) + P_UVEC_PNODE_SLOTS * slot_size);
+    if (!node) return NULL;
+
+    p_uvec_atomic_init(&node->refs, 1);
+    node->sizes = NULL;
+    node->count = 0;
+    node->owned = owned;
+    return node;
+}
+
+/**
+ * Retains a tree node.
+ *
+ * @param node [p_uvec_pnode *] Node.
+ */
+p_uvec_static_inline void p_uvec_pnode_retain(p_uvec_pnode *node) {
+    p_uvec_atomic_fetch_add(&node->refs, 1, P_UVEC_MO_RELAXED);
+}
+
+/**
+ * Releases a tree node, deallocating it if it is not referenced anymore.
+ *
+ * @param node [p_uvec_pnode *] Node.
+ * @param height [unsigned] Height of the node.
+ */
+p_uvec_static_inline void p_uvec_pnode_release(p_uvec_pnode *node, unsigned height) {
+    if (!node || p_uvec_atomic_fetch_sub(&node->refs, 1, P_UVEC_MO_ACQ_REL) != 1) return;
+
+    if (height) {
+        p_uvec_pnode **children = p_uvec_pnode_children(node);
+        for (unsigned i = 0; i < node->count; ++i) p_uvec_pnode_release(children[i], height - 1);
+    }
+
+    UVEC_FREE(node);
+}
+
+/**
+ * Copies slots from a node to another.
+ *
+ * @param dst [p_uvec_pnode *] Destination node, whose slots are appended to.
+ * @param src [p_uvec_pnode const *] Source node.
+ * @param start [unsigned] Index of the first slot to copy.
+ * @param n [unsigned] Number of slots to copy.
+ * @param height [unsigned] Height of the nodes.
+ * @param size [size_t] Element size.
+ */
+p_uvec_static_inline void p_uvec_pnode_copy_slots(p_uvec_pnode *dst, p_uvec_pnode const *src,
+                                                  unsigned start, unsigned n,
+                                                  unsigned height, size_t size) {
+    if (height) {
+        p_uvec_pnode **dst_children = p_uvec_pnode_children(dst) + dst->count;
+        p_uvec_pnode **src_children = p_uvec_pnode_children(src) + start;
+
+        for (unsigned i = 0; i < n; ++i) {
+            dst_children[i] = src_children[i];
+            p_uvec_pnode_retain(dst_children[i]);
+        }
+    } else {
+        memcpy(p_uvec_pnode_elem(dst, dst->count, size), p_uvec_pnode_elem(src, start, size),
+               n * size);
+    }
+
+    dst->count += n;
+}
+
+/**
+ * Returns the number of elements in a subtree.
+ *
+ * @param node [p_uvec_pnode const *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ * @return [uvec_uint] Number of elements.
+ */
+p_uvec_static_inline uvec_uint p_uvec_pnode_tree_size(p_uvec_pnode const *node, unsigned height) {
+    uvec_uint size = 0;
+
+    for (; height; --height) {
+        if (node->sizes) return size + node->sizes[node->count - 1];
+        size += (uvec_uint)((node->count - 1) * p_uvec_pnode_child_capacity(height));
+        node = p_uvec_pnode_children(node)[node->count - 1];
+    }
+
+    return size + node->count;
+}
+
+/**
+ * Computes the size table of an internal node, or discards it if all children
+ * but the last one are full.
+ *
+ * @param node [p_uvec_pnode *] Node.
+ * @param height [unsigned] Height of the node.
+ */
+p_uvec_static_inline void p_uvec_pnode_update_sizes(p_uvec_pnode *node, unsigned height) {
+    p_uvec_pnode **children = p_uvec_pnode_children(node);
+    uvec_uint *sizes = p_uvec_pnode_size_table(node);
+    uint64_t const full = p_uvec_pnode_child_capacity(height);
+    uvec_uint total = 0;
+    bool strict = true;
+
+    for (unsigned i = 0; i < node->count; ++i) {
+        uvec_uint size = p_uvec_pnode_tree_size(children[i], height - 1);
+        if (i < node->count - 1 && size != full) strict = false;
+        sizes[i] = total += size;
+    }
+
+    node->sizes = strict ? NULL : sizes;
+}
+
+/**
+ * Copies a tree node.
+ *
+ * @param node [p_uvec_pnode const *] Node.
+ * @param height [unsigned] Height of the node.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the copy is owned by a transient vector.
+ * @return [p_uvec_pnode *] Copy, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_copy(p_uvec_pnode const *node, unsigned height,
+                                                     size_t size, bool owned) {
+    p_uvec_pnode *copy = p_uvec_pnode_alloc(height, size, owned);
+    if (!copy) return NULL;
+
+    p_uvec_pnode_copy_slots(copy, node, 0, node->count, height, size);
+
+    if (node->sizes) {
+        copy->sizes = p_uvec_pnode_size_table(copy);
+        memcpy(copy->sizes, node->sizes, node->count * sizeof(*copy->sizes));
+    }
+
+    return copy;
+}
+
+/**
+ * Returns a node that can be updated in place: either the node itself, if it is owned
+ * by the transient vector performing the update, or a copy.
+ *
+ * @param node [p_uvec_pnode *] Node.
+ * @param height [unsigned] Height of the node.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the update is performed by a transient vector.
+ * @return [p_uvec_pnode *] Updatable node, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_editable(p_uvec_pnode *node, unsigned height,
+                                                         size_t size, bool owned) {
+    return owned && node->owned ? node : p_uvec_pnode_copy(node, height, size, owned);
+}
+
+/**
+ * Replaces a child of a node, releasing the replaced child.
+ *
+ * @param node [p_uvec_pnode *] Node.
+ * @param idx [unsigned] Index of the child.
+ * @param child [p_uvec_pnode *] New child.
+ * @param height [unsigned] Height of the node.
+ */
+p_uvec_static_inline void p_uvec_pnode_replace_child(p_uvec_pnode *node, unsigned idx,
+                                                     p_uvec_pnode *child, unsigned height) {
+    p_uvec_pnode **children = p_uvec_pnode_children(node);
+    if (children[idx] == child) return;
+    p_uvec_pnode_release(children[idx], height - 1);
+    children[idx] = child;
+}
+
+/**
+ * Finds the child of an internal node that contains the element at the specified index.
+ *
+ * @param node [p_uvec_pnode const *] Node.
+ * @param height [unsigned] Height of the node.
+ * @param[in,out] idx [uvec_uint *] Index of the element, updated to be relative to the child.
+ * @return [unsigned] Index of the child.
+ */
+p_uvec_static_inline unsigned p_uvec_pnode_child_index(p_uvec_pnode const *node, unsigned height,
+                                                       uvec_uint *idx) {
+    unsigned const shift = P_UVEC_PNODE_BITS * height;
+    unsigned child = (unsigned)((uint64_t)*idx >> shift);
+
+    if (node->sizes) {
+        // Children hold at most 2^shift elements, so the radix index is a lower bound.
+        while (node->sizes[child] <= *idx) ++child;
+        if (child) *idx -= node->sizes[child - 1];
+    } else {
+        *idx -= (uvec_uint)((uint64_t)child << shift);
+    }
+
+    return child;
+}
+
+/**
+ * Returns a path of single-child nodes leading to a leaf containing the specified element.
+ *
+ * @param height [unsigned] Height of the path.
+ * @param item [void const *] Element.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the nodes are owned by a transient vector.
+ * @return [p_uvec_pnode *] Root of the path, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_new_path(unsigned height, void const *item,
+                                                         size_t size, bool owned) {
+    p_uvec_pnode *node = p_uvec_pnode_alloc(0, size, owned);
+    if (!node) return NULL;
+
+    memcpy(p_uvec_pnode_elem(node, 0, size), item, size);
+    node->count = 1;
+
+    for (unsigned h = 1; h <= height; ++h) {
+        p_uvec_pnode *parent = p_uvec_pnode_alloc(h, size, owned);
+
+        if (!parent) {
+            p_uvec_pnode_release(node, h - 1);
+            return NULL;
+        }
+
+        p_uvec_pnode_children(parent)[0] = node;
+        parent->count = 1;
+        node = parent;
+    }
+
+    return node;
+}
+
+/**
+ * Replaces the element at the specified index in a subtree.
+ *
+ * @param node [p_uvec_pnode *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ * @param idx [uvec_uint] Index of the element.
+ * @param item [void const *] Replacement element.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the update is performed by a transient vector.
+ * @return [p_uvec_pnode *] Updated root, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_set(p_uvec_pnode *node, unsigned height,
+                                                    uvec_uint idx, void const *item,
+                                                    size_t size, bool owned) {
+    p_uvec_pnode *edit = p_uvec_pnode_editable(node, height, size, owned);
+    if (!edit) return NULL;
+
+    if (!height) {
+        memcpy(p_uvec_pnode_elem(edit, idx, size), item, size);
+        return edit;
+    }
+
+    unsigned i = p_uvec_pnode_child_index(edit, height, &idx);
+    p_uvec_pnode *child = p_uvec_pnode_set(p_uvec_pnode_children(edit)[i], height - 1,
+                                           idx, item, size, owned);
+    if (!child) {
+        if (edit != node) p_uvec_pnode_release(edit, height);
+        return NULL;
+    }
+
+    p_uvec_pnode_replace_child(edit, i, child, height);
+    return edit;
+}
+
+/**
+ * Appends an element to the rightmost leaf of a subtree.
+ *
+ * @param node [p_uvec_pnode *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ * @param item [void const *] Element.
+ * @param size [size_t] Element size.
+ * @param owned [bool] True if the update is performed by a transient vector.
+ * @param[out] out [p_uvec_pnode **] Updated root.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the subtree has no room
+ *                    for the element, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pnode_push(p_uvec_pnode *node, unsigned height,
+                                                void const *item, size_t size,
+                                                bool owned, p_uvec_pnode **out) {
+    p_uvec_pnode *edit;
+
+    if (!height) {
+        if (node->count == P_UVEC_PNODE_SLOTS) return UVEC_NO;
+        if (!(edit = p_uvec_pnode_editable(node, height, size, owned))) return UVEC_ERR;
+        memcpy(p_uvec_pnode_elem(edit, edit->count++, size), item, size);
+        *out = edit;
+        return UVEC_OK;
+    }
+
+    unsigned last = node->count - 1;
+    p_uvec_pnode *old_child = p_uvec_pnode_children(node)[last], *child;
+    uvec_ret ret = p_uvec_pnode_push(old_child, height - 1, item, size, owned, &child);
+
+    if (ret == UVEC_ERR) return ret;
+
+    if (ret == UVEC_NO) {
+        if (node->count == P_UVEC_PNODE_SLOTS) return UVEC_NO;
+        if (!(child = p_uvec_pnode_new_path(height - 1, item, size, owned))) return UVEC_ERR;
+    }
+
+    if (!(edit = p_uvec_pnode_editable(node, height, size, owned))) {
+        if (child != old_child) p_uvec_pnode_release(child, height - 1);
+        return UVEC_ERR;
+    }
+
+    if (ret == UVEC_OK) {
+        p_uvec_pnode_replace_child(edit, last, child, height);
+        if (edit->sizes) edit->sizes[last]++;
+    } else {
+        p_uvec_pnode_children(edit)[edit->count++] = child;
+
+        if (edit->sizes) {
+            edit->sizes[last + 1] = edit->sizes[last] + 1;
+        } else if (p_uvec_pnode_tree_size(old_child, height - 1) !=
+                   p_uvec_pnode_child_capacity(height)) {
+            p_uvec_pnode_update_sizes(edit, height);
+        }
+    }
+
+    *out = edit;
+    return UVEC_OK;
+}
+
+/**
+ * Returns a subtree containing the first 'n' elements of the specified subtree.
+ *
+ * @param node [p_uvec_pnode *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ * @param n [uvec_uint] Number of elements to keep (must be greater than zero).
+ * @param size [size_t] Element size.
+ * @return [p_uvec_pnode *] Root of the new subtree, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_take(p_uvec_pnode *node, unsigned height,
+                                                     uvec_uint n, size_t size) {
+    uvec_uint last = n - 1;
+    unsigned idx = height ? p_uvec_pnode_child_index(node, height, &last) : (unsigned)last;
+    p_uvec_pnode *child = NULL, *res;
+
+    if (idx == node->count - 1) {
+        if (!height || p_uvec_pnode_tree_size(node, height) == n) {
+            p_uvec_pnode_retain(node);
+            return node;
+        }
+    }
+
+    if (height) {
+        child = p_uvec_pnode_take(p_uvec_pnode_children(node)[idx], height - 1, last + 1, size);
+        if (!child) return NULL;
+    }
+
+    if (!(res = p_uvec_pnode_alloc(height, size, false))) {
+        p_uvec_pnode_release(child, height - 1);
+        return NULL;
+    }
+
+    if (height) {
+        p_uvec_pnode_copy_slots(res, node, 0, idx, height, size);
+        p_uvec_pnode_children(res)[res->count++] = child;
+        p_uvec_pnode_update_sizes(res, height);
+    } else {
+        p_uvec_pnode_copy_slots(res, node, 0, idx + 1, height, size);
+    }
+
+    return res;
+}
+
+/**
+ * Returns a subtree containing all but the first 'n' elements of the specified subtree.
+ *
+ * @param node [p_uvec_pnode *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ * @param n [uvec_uint] Number of elements to drop (must be less than the size of the subtree).
+ * @param size [size_t] Element size.
+ * @return [p_uvec_pnode *] Root of the new subtree, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_drop(p_uvec_pnode *node, unsigned height,
+                                                     uvec_uint n, size_t size) {
+    if (!n) {
+        p_uvec_pnode_retain(node);
+        return node;
+    }
+
+    unsigned idx = height ? p_uvec_pnode_child_index(node, height, &n) : (unsigned)n;
+    p_uvec_pnode *child = NULL, *res;
+
+    if (height) {
+        child = p_uvec_pnode_drop(p_uvec_pnode_children(node)[idx], height - 1, n, size);
+        if (!child) return NULL;
+    }
+
+    if (!(res = p_uvec_pnode_alloc(height, size, false))) {
+        p_uvec_pnode_release(child, height - 1);
+        return NULL;
+    }
+
+    if (height) {
+        p_uvec_pnode_children(res)[res->count++] = child;
+        p_uvec_pnode_copy_slots(res, node, idx + 1, node->count - idx - 1, height, size);
+        p_uvec_pnode_update_sizes(res, height);
+    } else {
+        p_uvec_pnode_copy_slots(res, node, idx, node->count - idx, height, size);
+    }
+
+    return res;
+}
+
+/**
+ * Allocates an internal node with the specified children, which are not retained.
+ *
+ * @param children [p_uvec_pnode **] Children.
+ * @param n [unsigned] Number of children.
+ * @param height [unsigned] Height of the node.
+ * @param size [size_t] Element size.
+ * @return [p_uvec_pnode *] Node, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_with_children(p_uvec_pnode **children, unsigned n,
+                                                              unsigned height, size_t size) {
+    p_uvec_pnode *node = p_uvec_pnode_alloc(height, size, false);
+    if (!node) return NULL;
+
+    memcpy(p_uvec_pnode_children(node), children, n * sizeof(*children));
+    node->count = n;
+    p_uvec_pnode_update_sizes(node, height);
+    return node;
+}
+
+/**
+ * Merges the children of three adjacent nodes, redistributing their slots so that
+ * the number of resulting nodes is close to the optimum.
+ *
+ * @param left [p_uvec_pnode *] Left node, whose last child is replaced by 'center', or NULL.
+ * @param center [p_uvec_pnode *] Center node.
+ * @param right [p_uvec_pnode *] Right node, whose first child is replaced by 'center', or NULL.
+ * @param height [unsigned] Height of the nodes.
+ * @param size [size_t] Element size.
+ * @return [p_uvec_pnode *] Node of height 'height + 1', containing one or two children,
+ *                          or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_rebalance(p_uvec_pnode *left, p_uvec_pnode *center,
+                                                          p_uvec_pnode *right, unsigned height,
+                                                          size_t size) {
+    p_uvec_pnode *all[2 * P_UVEC_PNODE_SLOTS], *nodes[2 * P_UVEC_PNODE_SLOTS], *top[2];
+    unsigned plan[2 * P_UVEC_PNODE_SLOTS], n = 0, slots = 0;
+
+    if (left) {
+        for (unsigned i = 0; i < left->count - 1; ++i) all[n++] = p_uvec_pnode_children(left)[i];
+    }
+
+    for (unsigned i = 0; i < center->count; ++i) all[n++] = p_uvec_pnode_children(center)[i];
+
+    if (right) {
+        for (unsigned i = 1; i < right->count; ++i) all[n++] = p_uvec_pnode_children(right)[i];
+    }
+
+    for (unsigned i = 0; i < n; ++i) slots += plan[i] = all[i]->count;
+
+    // Shift slots to the right until the number of nodes is within the tolerated range.
+    unsigned const optimal = (slots + P_UVEC_PNODE_SLOTS - 1) / P_UVEC_PNODE_SLOTS;
+    unsigned new_n = n;
+
+    for (unsigned i = 0; new_n > optimal + P_UVEC_PNODE_EXTRA; --i, --new_n) {
+        while (plan[i] == P_UVEC_PNODE_SLOTS) ++i;
+
+        for (unsigned remaining = plan[i]; remaining; ++i) {
+            unsigned merged = remaining + plan[i + 1];
+            plan[i] = merged < P_UVEC_PNODE_SLOTS ? merged : P_UVEC_PNODE_SLOTS;
+            remaining = merged - plan[i];
+        }
+
+        for (unsigned j = i; j < new_n - 1; ++j) plan[j] = plan[j + 1];
+    }
+
+    // Execute the plan, reusing nodes whose slots are unchanged.
+    unsigned const child_height = height - 1;
+    unsigned k = 0;
+
+    for (unsigned ai = 0, si = 0; k < new_n; ++k) {
+        if (!si && all[ai]->count == plan[k]) {
+            p_uvec_pnode_retain(all[ai]);
+            nodes[k] = all[ai++];
+            continue;
+        }
+
+        p_uvec_pnode *node = p_uvec_pnode_alloc(child_height, size, false);
+        if (!node) goto err;
+
+        while (node->count < plan[k]) {
+            unsigned n_copy = all[ai]->count - si;
+            if (n_copy > plan[k] - node->count) n_copy = plan[k] - node->count;
+
+            p_uvec_pnode_copy_slots(node, all[ai], si, n_copy, child_height, size);
+            si += n_copy;
+
+            if (si == all[ai]->count) {
+                ++ai;
+                si = 0;
+            }
+        }
+
+        if (child_height) p_uvec_pnode_update_sizes(node, child_height);
+        nodes[k] = node;
+    }
+
+    // Pack the resulting nodes into one or two parents.
+    unsigned n_top = new_n > P_UVEC_PNODE_SLOTS ? 2 : 1;
+    unsigned first = n_top == 2 ? P_UVEC_PNODE_SLOTS : new_n;
+
+    if (!(top[0] = p_uvec_pnode_with_children(nodes, first, height, size))) goto err;
+
+    if (n_top == 2 && !(top[1] = p_uvec_pnode_with_children(nodes + first, new_n - first,
+                                                              height, size))) {
+        UVEC_FREE(top[0]);
+        goto err;
+    }
+
+    p_uvec_pnode *res = p_uvec_pnode_with_children(top, n_top, height + 1, size);
+
+    if (!res) {
+        for (unsigned i = 0; i < n_top; ++i) UVEC_FREE(top[i]);
+        goto err;
+    }
+
+    return res;
+
+err:
+    for (unsigned i = 0; i < k; ++i) p_uvec_pnode_release(nodes[i], child_height);
+    return NULL;
+}
+
+/**
+ * Concatenates two subtrees.
+ *
+ * @param left [p_uvec_pnode *] Root of the left subtree.
+ * @param lh [unsigned] Height of the left subtree.
+ * @param right [p_uvec_pnode *] Root of the right subtree.
+ * @param rh [unsigned] Height of the right subtree.
+ * @param size [size_t] Element size.
+ * @return [p_uvec_pnode *] Node of height 'max(lh, rh) + 1', containing one or two children,
+ *                          or NULL on error.
+ */
+p_uvec_static_inline p_uvec_pnode* p_uvec_pnode_concat(p_uvec_pnode *left, unsigned lh,
+                                                       p_uvec_pnode *right, unsigned rh,
+                                                       size_t size) {
+    p_uvec_pnode *center, *res;
+    unsigned height;
+
+    if (lh > rh) {
+        height = lh;
+        center = p_uvec_pnode_concat(p_uvec_pnode_children(left)[left->count - 1], lh - 1,
+                                     right, rh, size);
+        right = NULL;
+    } else if (lh < rh) {
+        height = rh;
+        center = p_uvec_pnode_concat(left, lh, p_uvec_pnode_children(right)[0], rh - 1, size);
+        left = NULL;
+    } else if (lh) {
+        height = lh;
+        center = p_uvec_pnode_concat(p_uvec_pnode_children(left)[left->count - 1], lh - 1,
+                                     p_uvec_pnode_children(right)[0], rh - 1, size);
+    } else if (left->count + right->count <= P_UVEC_PNODE_SLOTS) {
+        if (!(center = p_uvec_pnode_alloc(0, size, false))) return NULL;
+        p_uvec_pnode_copy_slots(center, left, 0, left->count, 0, size);
+        p_uvec_pnode_copy_slots(center, right, 0, right->count, 0, size);
+        if (!(res = p_uvec_pnode_with_children(&center, 1, 1, size))) UVEC_FREE(center);
+        return res;
+    } else {
+        p_uvec_pnode_retain(left);
+        p_uvec_pnode_retain(right);
+        if (!(res = p_uvec_pnode_with_children((p_uvec_pnode *[]){ left, right }, 2, 1, size))) {
+            p_uvec_pnode_release(left, 0);
+            p_uvec_pnode_release(right, 0);
+        }
+        return res;
+    }
+
+    if (!center) return NULL;
+    res = p_uvec_pnode_rebalance(left, center, right, height, size);
+    p_uvec_pnode_release(center, height);
+    return res;
+}
+
+/**
+ * Persists all nodes owned by a transient vector.
+ *
+ * @param node [p_uvec_pnode *] Root of the subtree.
+ * @param height [unsigned] Height of the subtree.
+ */
+p_uvec_static_inline void p_uvec_pnode_persist(p_uvec_pnode *node, unsigned height) {
+    if (!node->owned) return;
+    node->owned = false;
+
+    if (height) {
+        p_uvec_pnode **children = p_uvec_pnode_children(node);
+        for (unsigned i = 0; i < node->count; ++i) p_uvec_pnode_persist(children[i], height - 1);
+    }
+}
+
+/**
+ * Removes single-child nodes from the top of the tree.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ */
+p_uvec_static_inline void p_uvec_pvec_collapse(p_uvec_pvec *vec) {
+    while (vec->height && vec->root->count == 1) {
+        p_uvec_pnode *child = p_uvec_pnode_children(vec->root)[0];
+        p_uvec_pnode_retain(child);
+        p_uvec_pnode_release(vec->root, vec->height--);
+        vec->root = child;
+    }
+}
+
+/**
+ * Returns the address of the element at the specified index.
+ *
+ * @param vec [p_uvec_pvec const *] Vector.
+ * @param idx [uvec_uint] Index.
+ * @param size [size_t] Element size.
+ * @param[out] n [uvec_uint *] Number of elements stored contiguously from 'idx', or NULL.
+ * @return [void *] Address of the element.
+ */
+p_uvec_static_inline void* p_uvec_pvec_at(p_uvec_pvec const *vec, uvec_uint idx, size_t size,
+                                          uvec_uint *n) {
+    p_uvec_pnode *node = vec->root;
+
+    for (unsigned h = vec->height; h; --h) {
+        node = p_uvec_pnode_children(node)[p_uvec_pnode_child_index(node, h, &idx)];
+    }
+
+    if (n) *n = node->count - idx;
+    return p_uvec_pnode_elem(node, idx, size);
+}
+
+/**
+ * Initializes a vector with the specified elements.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ * @param array [void const *] Elements.
+ * @param n [uvec_uint] Number of elements.
+ * @param size [size_t] Element size.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pvec_init_array(p_uvec_pvec *vec, void const *array,
+                                                     uvec_uint n, size_t size) {
+    *vec = (p_uvec_pvec){ .count = n, .height = 0, .root = NULL, .transient = false };
+    if (!n) return UVEC_OK;
+
+    // Build the tree bottom-up, compacting each level in place.
+    uvec_uint level_n = (n + P_UVEC_PNODE_SLOTS - 1) / P_UVEC_PNODE_SLOTS;
+    p_uvec_pnode **level = UVEC_MALLOC(level_n * sizeof(*level));
+    if (!level) return UVEC_ERR;
+
+    unsigned char const *bytes = array;
+    uvec_uint built = 0;
+
+    for (; built < level_n; ++built) {
+        if (!(level[built] = p_uvec_pnode_alloc(0, size, false))) goto err;
+        uvec_uint start = built * P_UVEC_PNODE_SLOTS;
+        level[built]->count = n - start < P_UVEC_PNODE_SLOTS ? n - start : P_UVEC_PNODE_SLOTS;
+        memcpy(level[built]->data, bytes + start * size, level[built]->count * size);
+    }
+
+    while (level_n > 1) {
+        uvec_uint parent_n = (level_n + P_UVEC_PNODE_SLOTS - 1) / P_UVEC_PNODE_SLOTS;
+        ++vec->height;
+
+        for (uvec_uint i = 0; i < parent_n; ++i) {
+            uvec_uint start = i * P_UVEC_PNODE_SLOTS;
+            unsigned count = level_n - start < P_UVEC_PNODE_SLOTS ? level_n - start
+                                                                  : P_UVEC_PNODE_SLOTS;
+            p_uvec_pnode *parent = p_uvec_pnode_alloc(vec->height, size, false);
+
+            if (!parent) {
+                // Release the parents built so far, and the children not yet adopted.
+                for (uvec_uint j = 0; j < i; ++j) p_uvec_pnode_release(level[j], vec->height);
+                for (uvec_uint j = start; j < level_n; ++j) {
+                    p_uvec_pnode_release(level[j], vec->height - 1);
+                }
+                UVEC_FREE(level);
+                return UVEC_ERR;
+            }
+
+            memcpy(p_uvec_pnode_children(parent), level + start, count * sizeof(*level));
+            parent->count = count;
+            level[i] = parent;
+        }
+
+        level_n = parent_n;
+    }
+
+    vec->root = level[0];
+    UVEC_FREE(level);
+    return UVEC_OK;
+
+err:
+    for (uvec_uint i = 0; i < built; ++i) p_uvec_pnode_release(level[i], 0);
+    UVEC_FREE(level);
+    return UVEC_ERR;
+}
+
+/**
+ * Replaces the element at the specified index.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ * @param idx [uvec_uint] Index.
+ * @param item [void const *] Replacement element.
+ * @param size [size_t] Element size.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pvec_set(p_uvec_pvec *vec, uvec_uint idx,
+                                              void const *item, size_t size) {
+    p_uvec_pnode *root = p_uvec_pnode_set(vec->root, vec->height, idx, item, size, vec->transient);
+    if (!root) return UVEC_ERR;
+    if (root != vec->root) p_uvec_pnode_release(vec->root, vec->height);
+    vec->root = root;
+    return UVEC_OK;
+}
+
+/**
+ * Appends an element to the vector.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ * @param item [void const *] Element.
+ * @param size [size_t] Element size.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pvec_push(p_uvec_pvec *vec, void const *item, size_t size) {
+    if (vec->count == UVEC_UINT_MAX) return UVEC_ERR;
+
+    bool const owned = vec->transient;
+    p_uvec_pnode *root;
+
+    if (!vec->root) {
+        if (!(root = p_uvec_pnode_new_path(0, item, size, owned))) return UVEC_ERR;
+        vec->root = root;
+        vec->count = 1;
+        return UVEC_OK;
+    }
+
+    uvec_ret ret = p_uvec_pnode_push(vec->root, vec->height, item, size, owned, &root);
+    if (ret == UVEC_ERR) return ret;
+
+    if (ret == UVEC_OK) {
+        if (root != vec->root) p_uvec_pnode_release(vec->root, vec->height);
+    } else {
+        // The tree is full: grow it by one level.
+        p_uvec_pnode *path = p_uvec_pnode_new_path(vec->height, item, size, owned);
+        if (!path) return UVEC_ERR;
+
+        if (!(root = p_uvec_pnode_alloc(vec->height + 1, size, owned))) {
+            p_uvec_pnode_release(path, vec->height);
+            return UVEC_ERR;
+        }
+
+        p_uvec_pnode_children(root)[0] = vec->root;
+        p_uvec_pnode_children(root)[1] = path;
+        root->count = 2;
+        p_uvec_pnode_update_sizes(root, ++vec->height);
+    }
+
+    vec->root = root;
+    vec->count++;
+    return UVEC_OK;
+}
+
+/**
+ * Restricts the vector to the elements in the specified range.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ * @param start [uvec_uint] Range start index.
+ * @param len [uvec_uint] Range length.
+ * @param size [size_t] Element size.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pvec_slice(p_uvec_pvec *vec, uvec_uint start, uvec_uint len,
+                                                size_t size) {
+    p_uvec_pnode *root = NULL;
+
+    if (len) {
+        p_uvec_pnode *dropped = p_uvec_pnode_drop(vec->root, vec->height, start, size);
+        if (!dropped) return UVEC_ERR;
+        root = p_uvec_pnode_take(dropped, vec->height, len, size);
+        p_uvec_pnode_release(dropped, vec->height);
+        if (!root) return UVEC_ERR;
+    }
+
+    p_uvec_pnode_release(vec->root, vec->height);
+    vec->root = root;
+    vec->count = len;
+
+    if (root) {
+        p_uvec_pvec_collapse(vec);
+    } else {
+        vec->height = 0;
+    }
+
+    return UVEC_OK;
+}
+
+/**
+ * Appends the elements of another vector to the vector.
+ *
+ * @param vec [p_uvec_pvec *] Vector.
+ * @param other [p_uvec_pvec const *] Vector to append.
+ * @param size [size_t] Element size.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_pvec_concat(p_uvec_pvec *vec, p_uvec_pvec const *other,
+                                                 size_t size) {
+    if (!other->count) return UVEC_OK;
+    if (other->count > UVEC_UINT_MAX - vec->count) return UVEC_ERR;
+
+    if (!vec->count) {
+        p_uvec_pnode_retain(other->root);
+        p_uvec_pnode_release(vec->root, vec->height);
+        vec->root = other->root;
+        vec->height = other->height;
+        vec->count = other->count;
+        return UVEC_OK;
+    }
+
+    p_uvec_pnode *root = p_uvec_pnode_concat(vec->root, vec->height, other->root, other->height,
+                                             size);
+    if (!root) return UVEC_ERR;
+
+    p_uvec_pnode_release(vec->root, vec->height);
+    vec->root = root;
+    vec->height = (vec->height > other->height ? vec->height : other->height) + 1;
+    vec->count += other->count;
+    p_uvec_pvec_collapse(vec);
+    return UVEC_OK;
+}
+
+/**
+ * Defines a new persistent vector struct.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_PERSISTENT(T)                                                               \
+    typedef struct UVecPersistent_##T {                                                             \
+        /** @cond */                                                                                \
+        p_uvec_pvec p;                                                                              \
+        /** @endcond */                                                                             \
+    } UVecPersistent_##T;
+
+/**
+ * Generates function declarations for the specified persistent vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_PERSISTENT(T, SCOPE)                                                            \
+    /** @cond */                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_alloc_##T(void);                                      \
+    SCOPE UVecPersistent_##T* uvec_persistent_from_array_##T(T const *array, uvec_uint n);          \
+    SCOPE UVec_##T* uvec_persistent_to_vec_##T(UVecPersistent_##T const *pvec);                     \
+    SCOPE void uvec_persistent_free_##T(UVecPersistent_##T *pvec);                                  \
+    SCOPE UVecPersistent_##T* uvec_persistent_set_##T(UVecPersistent_##T const *pvec,               \
+                                                      uvec_uint idx, T item);                       \
+    SCOPE UVecPersistent_##T* uvec_persistent_push_##T(UVecPersistent_##T const *pvec, T item);     \
+    SCOPE UVecPersistent_##T* uvec_persistent_concat_##T(UVecPersistent_##T const *pvec,            \
+                                                         UVecPersistent_##T const *other);          \
+    SCOPE UVecPersistent_##T* uvec_persistent_slice_##T(UVecPersistent_##T const *pvec,             \
+                                                        uvec_uint start, uvec_uint len);            \
+    SCOPE UVecPersistent_##T* uvec_persistent_transient_##T(UVecPersistent_##T const *pvec);        \
+    SCOPE uvec_ret uvec_transient_set_##T(UVecPersistent_##T *tvec, uvec_uint idx, T item);         \
+    SCOPE uvec_ret uvec_transient_push_##T(UVecPersistent_##T *tvec, T item);                       \
+    SCOPE void uvec_transient_persist_##T(UVecPersistent_##T *tvec);                                \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified persistent vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_PERSISTENT(T, SCOPE)                                                            \
+                                                                                                    \
+    static inline UVecPersistent_##T* uvec_persistent_derive_##T(UVecPersistent_##T const *pvec) {  \
+        if (pvec->p.transient) return NULL;                                                         \
+                                                                                                    \
+        UVecPersistent_##T *derived = UVEC_MALLOC(sizeof(*derived));                                \
+        if (!derived) return NULL;                                                                  \
+                                                                                                    \
+        derived->p = pvec->p;                                                                       \
+        if (derived->p.root) p_uvec_pnode_retain(derived->p.root);                                  \
+        return derived;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_from_array_##T(T const *array, uvec_uint n) {         \
+        UVecPersistent_##T *pvec = UVEC_MALLOC(sizeof(*pvec));                                      \
+        if (!pvec) return NULL;                                                                     \
+                                                                                                    \
+        if (p_uvec_pvec_init_array(&pvec->p, array, n, sizeof(T))) {                                \
+            UVEC_FREE(pvec);                                                                        \
+            pvec = NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return pvec;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_alloc_##T(void) {                                     \
+        return uvec_persistent_from_array_##T(NULL, 0);                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T* uvec_persistent_to_vec_##T(UVecPersistent_##T const *pvec) {                    \
+        UVec_##T *vec = uvec_alloc_##T();                                                           \
+        if (!vec) return NULL;                                                                      \
+                                                                                                    \
+        if (uvec_reserve_capacity_##T(vec, pvec->p.count)) {                                        \
+            uvec_free_##T(vec);                                                                     \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        for (uvec_uint i = 0, n; i < pvec->p.count; i += n) {                                       \
+            T const *leaf = p_uvec_pvec_at(&pvec->p, i, sizeof(T), &n);                             \
+            uvec_append_array_##T(vec, leaf, n);                                                    \
+        }                                                                                           \
+                                                                                                    \
+        return vec;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_persistent_free_##T(UVecPersistent_##T *pvec) {                                 \
+        if (!pvec) return;                                                                          \
+        p_uvec_pnode_release(pvec->p.root, pvec->p.height);                                         \
+        UVEC_FREE(pvec);                                                                            \
+    }                                                                                               \
+                                                                                                    \
+    static inline UVecPersistent_##T* uvec_persistent_check_##T(UVecPersistent_##T *pvec,           \
+                                                                uvec_ret ret) {                     \
+        if (ret && pvec) {                                                                          \
+            uvec_persistent_free_##T(pvec);                                                         \
+            pvec = NULL;                                                                            \
+        }                                                                                           \
+        return pvec;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_set_##T(UVecPersistent_##T const *pvec,               \
+                                                      uvec_uint idx, T item) {                      \
+        UVecPersistent_##T *derived = uvec_persistent_derive_##T(pvec);                             \
+        if (!derived) return NULL;                                                                  \
+        uvec_ret ret = p_uvec_pvec_set(&derived->p, idx, &item, sizeof(T));                         \
+        return uvec_persistent_check_##T(derived, ret);                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_push_##T(UVecPersistent_##T const *pvec, T item) {    \
+        UVecPersistent_##T *derived = uvec_persistent_derive_##T(pvec);                             \
+        if (!derived) return NULL;                                                                  \
+        uvec_ret ret = p_uvec_pvec_push(&derived->p, &item, sizeof(T));                             \
+        return uvec_persistent_check_##T(derived, ret);                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_concat_##T(UVecPersistent_##T const *pvec,            \
+                                                         UVecPersistent_##T const *other) {         \
+        if (other->p.transient) return NULL;                                                        \
+        UVecPersistent_##T *derived = uvec_persistent_derive_##T(pvec);                             \
+        if (!derived) return NULL;                                                                  \
+        uvec_ret ret = p_uvec_pvec_concat(&derived->p, &other->p, sizeof(T));                       \
+        return uvec_persistent_check_##T(derived, ret);                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_slice_##T(UVecPersistent_##T const *pvec,             \
+                                                        uvec_uint start, uvec_uint len) {           \
+        UVecPersistent_##T *derived = uvec_persistent_derive_##T(pvec);                             \
+        if (!derived) return NULL;                                                                  \
+        uvec_ret ret = p_uvec_pvec_slice(&derived->p, start, len, sizeof(T));                       \
+        return uvec_persistent_check_##T(derived, ret);                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecPersistent_##T* uvec_persistent_transient_##T(UVecPersistent_##T const *pvec) {       \
+        UVecPersistent_##T *tvec = uvec_persistent_derive_##T(pvec);                                \
+        if (tvec) tvec->p.transient = true;                                                         \
+        return tvec;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_transient_set_##T(UVecPersistent_##T *tvec, uvec_uint idx, T item) {        \
+        return p_uvec_pvec_set(&tvec->p, idx, &item, sizeof(T));                                    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_transient_push_##T(UVecPersistent_##T *tvec, T item) {                      \
+        return p_uvec_pvec_push(&tvec->p, &item, sizeof(T));                                        \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_transient_persist_##T(UVecPersistent_##T *tvec) {                               \
+        if (tvec->p.root) p_uvec_pnode_persist(tvec->p.root, tvec->p.height);                       \
+        tvec->p.transient = false;                                                                  \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new persistent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecPersistent
+ */
+#define UVEC_DECL_PERSISTENT(T)                                                                     \
+    P_UVEC_DEF_TYPE_PERSISTENT(T)                                                                   \
+    P_UVEC_DECL_PERSISTENT(T, p_uvec_unused)
+
+/**
+ * Declares a new persistent vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecPersistent
+ */
+#define UVEC_DECL_PERSISTENT_SPEC(T, SPEC)                                                          \
+    P_UVEC_DEF_TYPE_PERSISTENT(T)                                                                   \
+    P_UVEC_DECL_PERSISTENT(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared persistent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPersistent
+ */
+#define UVEC_IMPL_PERSISTENT(T) \
+    P_UVEC_IMPL_PERSISTENT(T, p_uvec_unused)
+
+/**
+ * Defines a new static persistent vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecPersistent
+ */
+#define UVEC_INIT_PERSISTENT(T)                                                                     \
+    P_UVEC_DEF_TYPE_PERSISTENT(T)                                                                   \
+    P_UVEC_IMPL_PERSISTENT(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new persistent vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecPersistent
+ */
+#define UVecPersistent(T) P_UVEC_CONCAT(UVecPersistent_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new, empty persistent vector.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecPersistent(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_alloc(T) P_UVEC_CONCAT(uvec_persistent_alloc_, T)()
+
+/**
+ * Deallocates the specified version of a persistent vector.
+ * Other versions are not affected.
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector to free.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_free(T, pvec) P_UVEC_CONCAT(uvec_persistent_free_, T)(pvec)
+
+/**
+ * Creates a persistent vector containing the elements of the specified array.
+ * Performance: O(n)
+ *
+ * @param T [symbol] Vector type.
+ * @param array [T const*] Array.
+ * @param n [uvec_uint] Number of elements in the array.
+ * @return [UVecPersistent(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_from_array(T, array, n) \
+    P_UVEC_CONCAT(uvec_persistent_from_array_, T)(array, n)
+
+/**
+ * Creates a persistent vector containing the elements of the specified vector.
+ * Performance: O(n)
+ *
+ * @param T [symbol] Vector type.
+ * @param vec [UVec(T)*] Vector.
+ * @return [UVecPersistent(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_from_vec(T, vec) \
+    P_UVEC_CONCAT(uvec_persistent_from_array_, T)((vec)->storage, (vec)->count)
+
+/**
+ * Copies the elements of a persistent vector into a new vector.
+ * Performance: O(n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Persistent vector.
+ * @return [UVec(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_to_vec(T, pvec) P_UVEC_CONCAT(uvec_persistent_to_vec_, T)(pvec)
+
+/// @name Primitives
+
+/**
+ * Returns the number of elements in the persistent vector.
+ *
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @return [uvec_uint] Number of elements.
+ *
+ * @note For convenience, this macro returns '0' for NULL vectors.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_count(pvec) ((pvec) ? (pvec)->p.count : 0)
+
+/**
+ * Retrieves the element at the specified index.
+ * Performance: O(log32 n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @return [T] Element at the specified index.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_get(T, pvec, idx) \
+    (*(T const *)p_uvec_pvec_at(&(pvec)->p, idx, sizeof(T), NULL))
+
+/**
+ * Returns a new version of the persistent vector, in which the element
+ * at the specified index has been replaced.
+ * Performance: O(log32 n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param idx [uvec_uint] Index.
+ * @param item [T] Replacement element.
+ * @return [UVecPersistent(T)*] New version, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_set(T, pvec, idx, item) \
+    P_UVEC_CONCAT(uvec_persistent_set_, T)(pvec, idx, item)
+
+/**
+ * Returns a new version of the persistent vector, with the specified element appended.
+ * Performance: O(log32 n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param item [T] Element to append.
+ * @return [UVecPersistent(T)*] New version, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_push(T, pvec, item) P_UVEC_CONCAT(uvec_persistent_push_, T)(pvec, item)
+
+/**
+ * Returns a new persistent vector containing the elements of 'pvec'
+ * followed by those of 'other'.
+ * Performance: O(log32 n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] First vector.
+ * @param other [UVecPersistent(T)*] Second vector.
+ * @return [UVecPersistent(T)*] Concatenated vector, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_concat(T, pvec, other) \
+    P_UVEC_CONCAT(uvec_persistent_concat_, T)(pvec, other)
+
+/**
+ * Returns a new persistent vector containing the elements in the specified range.
+ * Performance: O(log32 n)
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param start [uvec_uint] Range start index.
+ * @param len [uvec_uint] Range length.
+ * @return [UVecPersistent(T)*] Sliced vector, or NULL on error.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_slice(T, pvec, start, len) \
+    P_UVEC_CONCAT(uvec_persistent_slice_, T)(pvec, start, len)
+
+/// @name Iteration
+
+/**
+ * Iterates over the persistent vector, executing the specified code block for each element.
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param item_name [symbol] Name of the element variable.
+ * @param idx_name [symbol] Name of the index variable.
+ * @param code [code] Code block to execute.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_iterate(T, pvec, item_name, idx_name, code) do {                            \
+    UVecPersistent(T) const *p_v_##idx_name = (pvec);                                               \
+    if (p_v_##idx_name) {                                                                           \
+        T const *p_leaf_##idx_name = NULL;                                                          \
+        uvec_uint p_n_##idx_name = 0;                                                               \
+        for (uvec_uint idx_name = 0; idx_name != p_v_##idx_name->p.count; ++idx_name) {             \
+            if (!p_n_##idx_name--) {                                                                \
+                p_leaf_##idx_name = p_uvec_pvec_at(&p_v_##idx_name->p, idx_name, sizeof(T),         \
+                                                   &p_n_##idx_name);                                \
+                p_n_##idx_name--;                                                                   \
+            }                                                                                       \
+            T item_name = *(p_leaf_##idx_name++);                                                   \
+            code;                                                                                   \
+        }                                                                                           \
+    }                                                                                               \
+} while(0)
+
+/**
+ * Iterates over the persistent vector, executing the specified code block for each element.
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @param item_name [symbol] Name of the element variable.
+ * @param code [code] Code block to execute.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_foreach(T, pvec, item_name, code) \
+    uvec_persistent_iterate(T, pvec, item_name, p_i_##item_name, code)
+
+/// @name Transient vectors
+
+/**
+ * Returns a transient copy of the persistent vector. Transient vectors can be efficiently
+ * updated in place, and are useful to build or batch-update persistent vectors.
+ * Nodes are only copied the first time they are updated.
+ *
+ * @param T [symbol] Vector type.
+ * @param pvec [UVecPersistent(T)*] Vector instance.
+ * @return [UVecPersistent(T)*] Transient vector, or NULL on error.
+ *
+ * @note The returned vector must only be updated via uvec_transient_* operations,
+ *       until it is made persistent via uvec_transient_persist.
+ *       Operations returning new versions fail if invoked on transient vectors.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_persistent_transient(T, pvec) P_UVEC_CONCAT(uvec_persistent_transient_, T)(pvec)
+
+/**
+ * Replaces the element at the specified index of a transient vector, in place.
+ *
+ * @param T [symbol] Vector type.
+ * @param tvec [UVecPersistent(T)*] Transient vector.
+ * @param idx [uvec_uint] Index.
+ * @param item [T] Replacement element.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_transient_set(T, tvec, idx, item) \
+    P_UVEC_CONCAT(uvec_transient_set_, T)(tvec, idx, item)
+
+/**
+ * Appends an element to a transient vector, in place.
+ *
+ * @param T [symbol] Vector type.
+ * @param tvec [UVecPersistent(T)*] Transient vector.
+ * @param item [T] Element to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_transient_push(T, tvec, item) P_UVEC_CONCAT(uvec_transient_push_, T)(tvec, item)
+
+/**
+ * Makes a transient vector persistent.
+ * Performance: O(number of nodes updated while transient)
+ *
+ * @param T [symbol] Vector type.
+ * @param tvec [UVecPersistent(T)*] Transient vector.
+ *
+ * @public @related UVecPersistent
+ */
+#define uvec_transient_persist(T, tvec) P_UVEC_CONCAT(uvec_transient_persist_, T)(tvec)
+
+#endif // UVEC_PERSISTENT_H
@@ -0,0 +1,910 @@
+/**
+ * uVec - bounded lock-free queues.
+ *
+ * Single-producer single-consumer (SPSC) and multi-producer multi-consumer (MPMC)
+ * ring queues, with support for batch operations. Define UVEC_QUEUE_BLOCKING
+ * to make the *_wait functions sleep on a futex rather than yielding (Linux only).
+ *
+ * @note Futexes also require defining _GNU_SOURCE before including any header,
+ *       otherwise the *_wait functions keep yielding.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_QUEUE_H
+#define UVEC_QUEUE_H
+
+#include "uvec.h"
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "Queues require atomic operations, not available on this compiler."
+#endif
+
+#if defined UVEC_QUEUE_BLOCKING && defined __linux__ && defined _GNU_SOURCE
+    #define P_UVEC_QUEUE_FUTEX
+    #include <limits.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#else
+    #include <sched.h>
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A bounded, wait-free single-producer single-consumer queue.
+ * @struct UVecSpscQueue
+ */
+
+/**
+ * A bounded, lock-free multi-producer multi-consumer queue.
+ * @struct UVecMpmcQueue
+ */
+
+/// Event used to wake up threads waiting on a queue.
+typedef struct p_uvec_queue_event {
+    P_UVEC_ATOMIC(uint32_t) seq;
+    P_UVEC_ATOMIC(uint32_t) waiters;
+} p_uvec_queue_event;
+
+// ###############
+// # Private API #
+// ###############
+
+#ifdef P_UVEC_QUEUE_FUTEX
+
+/**
+ * Signals the specified event, waking up all its waiters.
+ * Only issues a system call if there are waiting threads.
+ *
+ * @param ev [p_uvec_queue_event*] Event.
+ */
+p_uvec_static_inline void p_uvec_queue_notify(p_uvec_queue_event *ev) {
+    p_uvec_atomic_fence(P_UVEC_MO_SEQ_CST);
+    if (!p_uvec_atomic_load(&ev->waiters, P_UVEC_MO_RELAXED)) return;
+    p_uvec_atomic_fetch_add(&ev->seq, 1, P_UVEC_MO_RELEASE);
+    syscall(SYS_futex, &ev->seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * Registers the calling thread as a waiter of the specified event.
+ * The caller must then retry the operation it is waiting for, and either
+ * call p_uvec_queue_wait_end if it fails again, or p_uvec_queue_wait_cancel.
+ *
+ * @param ev [p_uvec_queue_event*] Event.
+ * @return [uint32_t] Current event sequence number.
+ */
+p_uvec_static_inline uint32_t p_uvec_queue_wait_begin(p_uvec_queue_event *ev) {
+    p_uvec_atomic_fetch_add(&ev->waiters, 1, P_UVEC_MO_SEQ_CST);
+    return p_uvec_atomic_load(&ev->seq, P_UVEC_MO_ACQUIRE);
+}
+
+/**
+ * Sleeps until the specified event is signaled, unless it already was.
+ *
+ * @param ev [p_uvec_queue_event*] Event.
+ * @param seq [uint32_t] Sequence number returned by p_uvec_queue_wait_begin.
+ */
+p_uvec_static_inline void p_uvec_queue_wait_end(p_uvec_queue_event *ev, uint32_t seq) {
+    syscall(SYS_futex, &ev->seq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+    p_uvec_atomic_fetch_sub(&ev->waiters, 1, P_UVEC_MO_RELAXED);
+}
+
+/**
+ * Unregisters the calling thread as a waiter of the specified event.
+ *
+ * @param ev [p_uvec_queue_event*] Event.
+ */
+#define p_uvec_queue_wait_cancel(ev) \
+    ((void)p_uvec_atomic_fetch_sub(&(ev)->waiters, 1, P_UVEC_MO_RELAXED))
+
+#else
+
+#define p_uvec_queue_notify(ev) ((void)(ev))
+#define p_uvec_queue_wait_begin(ev) ((void)(ev), 0u)
+#define p_uvec_queue_wait_end(ev, seq) ((void)(ev), (void)(seq), (void)sched_yield())
+#define p_uvec_queue_wait_cancel(ev) ((void)(ev))
+
+#endif
+
+/**
+ * Initializes the specified event.
+ *
+ * @param ev [p_uvec_queue_event*] Event.
+ */
+p_uvec_static_inline void p_uvec_queue_event_init(p_uvec_queue_event *ev) {
+    p_uvec_atomic_init(&ev->seq, 0);
+    p_uvec_atomic_init(&ev->waiters, 0);
+}
+
+/**
+ * Returns the ring capacity required to hold the specified number of elements.
+ *
+ * @param capacity [uvec_uint] Requested capacity.
+ * @return [uvec_uint] Power of two capacity, or 0 if the requested capacity is invalid.
+ */
+p_uvec_static_inline uvec_uint p_uvec_queue_capacity(uvec_uint capacity) {
+    if (!capacity || capacity > UVEC_UINT_MAX / 2 + 1) return 0;
+    p_uvec_uint_next_power_2(capacity);
+    return capacity;
+}
+
+/**
+ * Copies elements from an array into a ring buffer, handling wraparound.
+ *
+ * @param ring [void*] Ring buffer.
+ * @param mask [uvec_uint] Ring capacity minus one.
+ * @param pos [uvec_uint] Position of the first element in the ring.
+ * @param array [void const*] Source array.
+ * @param n [uvec_uint] Number of elements.
+ * @param size [size_t] Element size.
+ */
+p_uvec_static_inline void p_uvec_ring_copy_in(void *ring, uvec_uint mask, uvec_uint pos,
+                                              void const *array, uvec_uint n, size_t size) {
+    uvec_uint idx = pos & mask, first = mask - idx + 1;
+    if (first > n) first = n;
+    memcpy((char *)ring + idx * size, array, first * size);
+    memcpy(ring, (char const *)array + first * size, (n - first) * size);
+}
+
+/**
+ * Copies elements from a ring buffer into an array, handling wraparound.
+ *
+ * @param ring [void const*] Ring buffer.
+ * @param mask [uvec_uint] Ring capacity minus one.
+ * @param pos [uvec_uint] Position of the first element in the ring.
+ * @param array [void*] Destination array.
+ * @param n [uvec_uint] Number of elements.
+ * @param size [size_t] Element size.
+ */
+p_uvec_static_inline void p_uvec_ring_copy_out(void const *ring, uvec_uint mask, uvec_uint pos,
+                                               void *array, uvec_uint n, size_t size) {
+    uvec_uint idx = pos & mask, first = mask - idx + 1;
+    if (first > n) first = n;
+    memcpy(array, (char const *)ring + idx * size, first * size);
+    memcpy((char *)array + first * size, ring, (n - first) * size);
+}
+
+/**
+ * Returns true if the unsigned distance between the specified positions is "negative",
+ * meaning that 'lhs' precedes 'rhs'.
+ *
+ * @param lhs [uvec_uint] First position.
+ * @param rhs [uvec_uint] Second position.
+ * @return [bool] True if 'lhs' precedes 'rhs'.
+ */
+#define p_uvec_ring_precedes(lhs, rhs) ((uvec_uint)((lhs) - (rhs)) > UVEC_UINT_MAX / 2)
+
+/**
+ * Defines new queue structs.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_QUEUE(T)                                                                    \
+    typedef struct UVecSpscQueue_##T {                                                              \
+        /** @cond */                                                                                \
+        P_UVEC_ATOMIC(uvec_uint) tail;                                                              \
+        uvec_uint head_cache;                                                                       \
+        char pad_1[UVEC_CACHE_LINE_SIZE];                                                           \
+        P_UVEC_ATOMIC(uvec_uint) head;                                                              \
+        uvec_uint tail_cache;                                                                       \
+        char pad_2[UVEC_CACHE_LINE_SIZE];                                                           \
+        uvec_uint mask;                                                                             \
+        T *storage;                                                                                 \
+        p_uvec_queue_event not_empty;                                                               \
+        p_uvec_queue_event not_full;                                                                \
+        /** @endcond */                                                                             \
+    } UVecSpscQueue_##T;                                                                            \
+                                                                                                    \
+    typedef struct UVecMpmcQueue_##T {                                                              \
+        /** @cond */                                                                                \
+        P_UVEC_ATOMIC(uvec_uint) tail;                                                              \
+        char pad_1[UVEC_CACHE_LINE_SIZE];                                                           \
+        P_UVEC_ATOMIC(uvec_uint) head;                                                              \
+        char pad_2[UVEC_CACHE_LINE_SIZE];                                                           \
+        uvec_uint mask;                                                                             \
+        T *storage;                                                                                 \
+        P_UVEC_ATOMIC(uvec_uint) *seq;                                                              \
+        p_uvec_queue_event not_empty;                                                               \
+        p_uvec_queue_event not_full;                                                                \
+        /** @endcond */                                                                             \
+    } UVecMpmcQueue_##T;
+
+/**
+ * Generates function declarations for the specified queue type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ * @param K [symbol] Queue kind (spsc or mpmc).
+ * @param Q [symbol] Queue struct (UVecSpscQueue or UVecMpmcQueue).
+ */
+#define P_UVEC_DECL_QUEUE_KIND(T, SCOPE, K, Q)                                                      \
+    /** @cond */                                                                                    \
+    SCOPE Q##_##T* uvec_##K##_alloc_##T(uvec_uint capacity);                                        \
+    SCOPE void uvec_##K##_free_##T(Q##_##T *q);                                                     \
+    SCOPE uvec_ret uvec_##K##_push_##T(Q##_##T *q, T item);                                         \
+    SCOPE uvec_ret uvec_##K##_pop_##T(Q##_##T *q, T *item);                                         \
+    SCOPE uvec_uint uvec_##K##_push_array_##T(Q##_##T *q, T const *array, uvec_uint n);             \
+    SCOPE uvec_uint uvec_##K##_pop_array_##T(Q##_##T *q, T *array, uvec_uint n);                   \
+    SCOPE void uvec_##K##_push_wait_##T(Q##_##T *q, T item);                                        \
+    SCOPE T uvec_##K##_pop_wait_##T(Q##_##T *q);                                                    \
+    SCOPE void uvec_##K##_push_array_wait_##T(Q##_##T *q, T const *array, uvec_uint n);             \
+    SCOPE uvec_uint uvec_##K##_pop_array_wait_##T(Q##_##T *q, T *array, uvec_uint n);              \
+    /** @endcond */
+
+/**
+ * Generates function declarations for the specified queue types.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_QUEUE(T, SCOPE)                                                                 \
+    P_UVEC_DECL_QUEUE_KIND(T, SCOPE, spsc, UVecSpscQueue)                                           \
+    P_UVEC_DECL_QUEUE_KIND(T, SCOPE, mpmc, UVecMpmcQueue)
+
+/**
+ * Generates the blocking functions for the specified queue type,
+ * on top of its non-blocking primitives.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ * @param K [symbol] Queue kind (spsc or mpmc).
+ * @param Q [symbol] Queue struct (UVecSpscQueue or UVecMpmcQueue).
+ */
+#define P_UVEC_IMPL_QUEUE_WAIT(T, SCOPE, K, Q)                                                      \
+                                                                                                    \
+    SCOPE void uvec_##K##_push_wait_##T(Q##_##T *q, T item) {                                       \
+        while (uvec_##K##_push_##T(q, item)) {                                                      \
+            uint32_t seq = p_uvec_queue_wait_begin(&q->not_full);                                   \
+                                                                                                    \
+            if (!uvec_##K##_push_##T(q, item)) {                                                    \
+                p_uvec_queue_wait_cancel(&q->not_full);                                             \
+                return;                                                                             \
+            }                                                                                       \
+                                                                                                    \
+            p_uvec_queue_wait_end(&q->not_full, seq);                                               \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE T uvec_##K##_pop_wait_##T(Q##_##T *q) {                                                   \
+        T item;                                                                                     \
+                                                                                                    \
+        while (uvec_##K##_pop_##T(q, &item)) {                                                      \
+            uint32_t seq = p_uvec_queue_wait_begin(&q->not_empty);                                  \
+                                                                                                    \
+            if (!uvec_##K##_pop_##T(q, &item)) {                                                    \
+                p_uvec_queue_wait_cancel(&q->not_empty);                                            \
+                break;                                                                              \
+            }                                                                                       \
+                                                                                                    \
+            p_uvec_queue_wait_end(&q->not_empty, seq);                                              \
+        }                                                                                           \
+                                                                                                    \
+        return item;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_##K##_push_array_wait_##T(Q##_##T *q, T const *array, uvec_uint n) {            \
+        while (n) {                                                                                 \
+            uvec_uint pushed = uvec_##K##_push_array_##T(q, array, n);                              \
+                                                                                                    \
+            if (!pushed) {                                                                          \
+                uint32_t seq = p_uvec_queue_wait_begin(&q->not_full);                               \
+                pushed = uvec_##K##_push_array_##T(q, array, n);                                    \
+                                                                                                    \
+                if (pushed) {                                                                       \
+                    p_uvec_queue_wait_cancel(&q->not_full);                                         \
+                } else {                                                                            \
+                    p_uvec_queue_wait_end(&q->not_full, seq);                                       \
+                }                                                                                   \
+            }                                                                                       \
+                                                                                                    \
+            array += pushed;                                                                        \
+            n -= pushed;                                                                            \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_##K##_pop_array_wait_##T(Q##_##T *q, T *array, uvec_uint n) {              \
+        uvec_uint popped = 0;                                                                       \
+                                                                                                    \
+        while (n && !(popped = uvec_##K##_pop_array_##T(q, array, n))) {                            \
+            uint32_t seq = p_uvec_queue_wait_begin(&q->not_empty);                                  \
+                                                                                                    \
+            if ((popped = uvec_##K##_pop_array_##T(q, array, n))) {                                 \
+                p_uvec_queue_wait_cancel(&q->not_empty);                                            \
+                break;                                                                              \
+            }                                                                                       \
+                                                                                                    \
+            p_uvec_queue_wait_end(&q->not_empty, seq);                                              \
+        }                                                                                           \
+                                                                                                    \
+        return popped;                                                                              \
+    }
+
+/**
+ * Generates function definitions for the specified SPSC queue type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_SPSC(T, SCOPE)                                                                  \
+                                                                                                    \
+    SCOPE UVecSpscQueue_##T* uvec_spsc_alloc_##T(uvec_uint capacity) {                              \
+        capacity = p_uvec_queue_capacity(capacity);                                                 \
+        if (!capacity) return NULL;                                                                 \
+                                                                                                    \
+        UVecSpscQueue_##T *q = UVEC_MALLOC(sizeof(*q));                                             \
+        if (!q) return NULL;                                                                        \
+                                                                                                    \
+        if (!(q->storage = UVEC_MALLOC(capacity * sizeof(T)))) {                                    \
+            UVEC_FREE(q);                                                                           \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        q->mask = capacity - 1;                                                                     \
+        q->head_cache = q->tail_cache = 0;                                                          \
+        p_uvec_atomic_init(&q->head, 0);                                                            \
+        p_uvec_atomic_init(&q->tail, 0);                                                            \
+        p_uvec_queue_event_init(&q->not_empty);                                                     \
+        p_uvec_queue_event_init(&q->not_full);                                                      \
+        return q;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_spsc_free_##T(UVecSpscQueue_##T *q) {                                           \
+        if (!q) return;                                                                             \
+        UVEC_FREE(q->storage);                                                                      \
+        UVEC_FREE(q);                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_spsc_push_##T(UVecSpscQueue_##T *q, T item) {                               \
+        uvec_uint tail = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED);                           \
+                                                                                                    \
+        if ((uvec_uint)(tail - q->head_cache) > q->mask) {                                          \
+            q->head_cache = p_uvec_atomic_load(&q->head, P_UVEC_MO_ACQUIRE);                        \
+            if ((uvec_uint)(tail - q->head_cache) > q->mask) return UVEC_NO;                        \
+        }                                                                                           \
+                                                                                                    \
+        q->storage[tail & q->mask] = item;                                                          \
+        p_uvec_atomic_store(&q->tail, (uvec_uint)(tail + 1), P_UVEC_MO_RELEASE);                    \
+        p_uvec_queue_notify(&q->not_empty);                                                         \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_spsc_pop_##T(UVecSpscQueue_##T *q, T *item) {                               \
+        uvec_uint head = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED);                           \
+                                                                                                    \
+        if (head == q->tail_cache) {                                                                \
+            q->tail_cache = p_uvec_atomic_load(&q->tail, P_UVEC_MO_ACQUIRE);                        \
+            if (head == q->tail_cache) return UVEC_NO;                                              \
+        }                                                                                           \
+                                                                                                    \
+        *item = q->storage[head & q->mask];                                                         \
+        p_uvec_atomic_store(&q->head, (uvec_uint)(head + 1), P_UVEC_MO_RELEASE);                    \
+        p_uvec_queue_notify(&q->not_full);                                                          \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_spsc_push_array_##T(UVecSpscQueue_##T *q, T const *array, uvec_uint n) {   \
+        uvec_uint tail = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED);                           \
+        uvec_uint space = q->mask - (uvec_uint)(tail - q->head_cache) + 1;                          \
+                                                                                                    \
+        if (space < n) {                                                                            \
+            q->head_cache = p_uvec_atomic_load(&q->head, P_UVEC_MO_ACQUIRE);                        \
+            space = q->mask - (uvec_uint)(tail - q->head_cache) + 1;                                \
+        }                                                                                           \
+                                                                                                    \
+        if (n > space) n = space;                                                                   \
+        if (!n) return 0;                                                                           \
+                                                                                                    \
+        p_uvec_ring_copy_in(q->storage, q->mask, tail, array, n, sizeof(T));                        \
+        p_uvec_atomic_store(&q->tail, (uvec_uint)(tail + n), P_UVEC_MO_RELEASE);                    \
+        p_uvec_queue_notify(&q->not_empty);                                                         \
+        return n;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_spsc_pop_array_##T(UVecSpscQueue_##T *q, T *array, uvec_uint n) {          \
+        uvec_uint head = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED);                           \
+        uvec_uint count = (uvec_uint)(q->tail_cache - head);                                        \
+                                                                                                    \
+        if (count < n) {                                                                            \
+            q->tail_cache = p_uvec_atomic_load(&q->tail, P_UVEC_MO_ACQUIRE);                        \
+            count = (uvec_uint)(q->tail_cache - head);                                              \
+        }                                                                                           \
+                                                                                                    \
+        if (n > count) n = count;                                                                   \
+        if (!n) return 0;                                                                           \
+                                                                                                    \
+        p_uvec_ring_copy_out(q->storage, q->mask, head, array, n, sizeof(T));                       \
+        p_uvec_atomic_store(&q->head, (uvec_uint)(head + n), P_UVEC_MO_RELEASE);                    \
+        p_uvec_queue_notify(&q->not_full);                                                          \
+        return n;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    P_UVEC_IMPL_QUEUE_WAIT(T, SCOPE, spsc, UVecSpscQueue)
+
+/**
+ * Generates function definitions for the specified MPMC queue type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_MPMC(T, SCOPE)                                                                  \
+                                                                                                    \
+    SCOPE UVecMpmcQueue_##T* uvec_mpmc_alloc_##T(uvec_uint capacity) {                              \
+        capacity = p_uvec_queue_capacity(capacity);                                                 \
+        if (!capacity) return NULL;                                                                 \
+                                                                                                    \
+        UVecMpmcQueue_##T *q = UVEC_MALLOC(sizeof(*q));                                             \
+        if (!q) return NULL;                                                                        \
+                                                                                                    \
+        q->storage = UVEC_MALLOC(capacity * sizeof(T));                                             \
+        q->seq = UVEC_MALLOC(capacity * sizeof(*q->seq));                                           \
+                                                                                                    \
+        if (!(q->storage && q->seq)) {                                                              \
+            UVEC_FREE(q->storage);                                                                  \
+            UVEC_FREE(q->seq);                                                                      \
+            UVEC_FREE(q);                                                                           \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        for (uvec_uint i = 0; i < capacity; ++i) p_uvec_atomic_init(&q->seq[i], i);                 \
+        q->mask = capacity - 1;                                                                     \
+        p_uvec_atomic_init(&q->head, 0);                                                            \
+        p_uvec_atomic_init(&q->tail, 0);                                                            \
+        p_uvec_queue_event_init(&q->not_empty);                                                     \
+        p_uvec_queue_event_init(&q->not_full);                                                      \
+        return q;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_mpmc_free_##T(UVecMpmcQueue_##T *q) {                                           \
+        if (!q) return;                                                                             \
+        UVEC_FREE(q->storage);                                                                      \
+        UVEC_FREE(q->seq);                                                                          \
+        UVEC_FREE(q);                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mpmc_push_##T(UVecMpmcQueue_##T *q, T item) {                               \
+        uvec_uint pos = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED);                            \
+                                                                                                    \
+        while (true) {                                                                              \
+            uvec_uint seq = p_uvec_atomic_load(&q->seq[pos & q->mask], P_UVEC_MO_ACQUIRE);          \
+                                                                                                    \
+            if (seq == pos) {                                                                       \
+                if (p_uvec_atomic_cas(&q->tail, &pos, (uvec_uint)(pos + 1),                         \
+                                      P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED)) break;                 \
+            } else if (p_uvec_ring_precedes(seq, pos)) {                                            \
+                return UVEC_NO;                                                                     \
+            } else {                                                                                \
+                pos = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED);                              \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        q->storage[pos & q->mask] = item;                                                           \
+        p_uvec_atomic_store(&q->seq[pos & q->mask], (uvec_uint)(pos + 1), P_UVEC_MO_RELEASE);       \
+        p_uvec_queue_notify(&q->not_empty);                                                         \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_mpmc_pop_##T(UVecMpmcQueue_##T *q, T *item) {                               \
+        uvec_uint pos = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED);                            \
+                                                                                                    \
+        while (true) {                                                                              \
+            uvec_uint seq = p_uvec_atomic_load(&q->seq[pos & q->mask], P_UVEC_MO_ACQUIRE);          \
+            uvec_uint const ready = (uvec_uint)(pos + 1);                                           \
+                                                                                                    \
+            if (seq == ready) {                                                                     \
+                if (p_uvec_atomic_cas(&q->head, &pos, ready,                                        \
+                                      P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED)) break;                 \
+            } else if (p_uvec_ring_precedes(seq, ready)) {                                          \
+                return UVEC_NO;                                                                     \
+            } else {                                                                                \
+                pos = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED);                              \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        *item = q->storage[pos & q->mask];                                                          \
+        p_uvec_atomic_store(&q->seq[pos & q->mask], (uvec_uint)(pos + q->mask + 1),                 \
+                            P_UVEC_MO_RELEASE);                                                     \
+        p_uvec_queue_notify(&q->not_full);                                                          \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_mpmc_push_array_##T(UVecMpmcQueue_##T *q, T const *array, uvec_uint n) {   \
+        if (n > q->mask + 1) n = q->mask + 1;                                                       \
+        uvec_uint pos = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED), avail;                     \
+                                                                                                    \
+        while (n) {                                                                                 \
+            for (avail = 0; avail < n; ++avail) {                                                   \
+                uvec_uint i = (uvec_uint)(pos + avail);                                             \
+                if (p_uvec_atomic_load(&q->seq[i & q->mask], P_UVEC_MO_ACQUIRE) != i) break;        \
+            }                                                                                       \
+                                                                                                    \
+            if (avail) {                                                                            \
+                if (p_uvec_atomic_cas(&q->tail, &pos, (uvec_uint)(pos + avail),                     \
+                                      P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED)) break;                 \
+            } else if (p_uvec_ring_precedes(p_uvec_atomic_load(&q->seq[pos & q->mask],             \
+                                                                P_UVEC_MO_RELAXED), pos)) {         \
+                return 0;                                                                           \
+            } else {                                                                                \
+                pos = p_uvec_atomic_load(&q->tail, P_UVEC_MO_RELAXED);                              \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        if (!n) return 0;                                                                           \
+        p_uvec_ring_copy_in(q->storage, q->mask, pos, array, avail, sizeof(T));                     \
+                                                                                                    \
+        for (uvec_uint i = 0; i < avail; ++i) {                                                     \
+            uvec_uint const cur = (uvec_uint)(pos + i);                                             \
+            p_uvec_atomic_store(&q->seq[cur & q->mask], (uvec_uint)(cur + 1), P_UVEC_MO_RELEASE);   \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_queue_notify(&q->not_empty);                                                         \
+        return avail;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_mpmc_pop_array_##T(UVecMpmcQueue_##T *q, T *array, uvec_uint n) {          \
+        if (n > q->mask + 1) n = q->mask + 1;                                                       \
+        uvec_uint pos = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED), ready;                     \
+                                                                                                    \
+        while (n) {                                                                                 \
+            for (ready = 0; ready < n; ++ready) {                                                   \
+                uvec_uint i = (uvec_uint)(pos + ready + 1);                                         \
+                if (p_uvec_atomic_load(&q->seq[(i - 1) & q->mask], P_UVEC_MO_ACQUIRE) != i) break;  \
+            }                                                                                       \
+                                                                                                    \
+            if (ready) {                                                                            \
+                if (p_uvec_atomic_cas(&q->head, &pos, (uvec_uint)(pos + ready),                     \
+                                      P_UVEC_MO_RELAXED, P_UVEC_MO_RELAXED)) break;                 \
+            } else if (p_uvec_ring_precedes(p_uvec_atomic_load(&q->seq[pos & q->mask],             \
+                                                                P_UVEC_MO_RELAXED),                 \
+                                            (uvec_uint)(pos + 1))) {                                \
+                return 0;                                                                           \
+            } else {                                                                                \
+                pos = p_uvec_atomic_load(&q->head, P_UVEC_MO_RELAXED);                              \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        if (!n) return 0;                                                                           \
+        p_uvec_ring_copy_out(q->storage, q->mask, pos, array, ready, sizeof(T));                    \
+                                                                                                    \
+        for (uvec_uint i = 0; i < ready; ++i) {                                                     \
+            uvec_uint const cur = (uvec_uint)(pos + i);                                             \
+            p_uvec_atomic_store(&q->seq[cur & q->mask], (uvec_uint)(cur + q->mask + 1),             \
+                                P_UVEC_MO_RELEASE);                                                 \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_queue_notify(&q->not_full);                                                          \
+        return ready;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    P_UVEC_IMPL_QUEUE_WAIT(T, SCOPE, mpmc, UVecMpmcQueue)
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares new SPSC and MPMC queue types.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define UVEC_DECL_QUEUE(T)                                                                          \
+    P_UVEC_DEF_TYPE_QUEUE(T)                                                                        \
+    P_UVEC_DECL_QUEUE(T, p_uvec_unused)
+
+/**
+ * Declares new SPSC and MPMC queue types, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define UVEC_DECL_QUEUE_SPEC(T, SPEC)                                                               \
+    P_UVEC_DEF_TYPE_QUEUE(T)                                                                        \
+    P_UVEC_DECL_QUEUE(T, SPEC p_uvec_unused)
+
+/**
+ * Implements previously declared SPSC and MPMC queue types.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define UVEC_IMPL_QUEUE(T)                                                                          \
+    P_UVEC_IMPL_SPSC(T, p_uvec_unused)                                                              \
+    P_UVEC_IMPL_MPMC(T, p_uvec_unused)
+
+/**
+ * Defines new static SPSC and MPMC queue types.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define UVEC_INIT_QUEUE(T)                                                                          \
+    P_UVEC_DEF_TYPE_QUEUE(T)                                                                        \
+    P_UVEC_IMPL_SPSC(T, p_uvec_static_inline)                                                       \
+    P_UVEC_IMPL_MPMC(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new SPSC queue variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define UVecSpscQueue(T) P_UVEC_CONCAT(UVecSpscQueue_, T)
+
+/**
+ * Declares a new MPMC queue variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define UVecMpmcQueue(T) P_UVEC_CONCAT(UVecMpmcQueue_, T)
+
+/// @name SPSC queues
+
+/**
+ * Allocates a new SPSC queue.
+ *
+ * @param T [symbol] Vector type.
+ * @param capacity [uvec_uint] Capacity, rounded up to the next power of two.
+ * @return [UVecSpscQueue(T)*] Queue instance, or NULL on error.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_alloc(T, capacity) P_UVEC_CONCAT(uvec_spsc_alloc_, T)(capacity)
+
+/**
+ * Deallocates the specified SPSC queue.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue to free.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_free(T, q) P_UVEC_CONCAT(uvec_spsc_free_, T)(q)
+
+/**
+ * Enqueues the specified element. Must only be called by the producer thread.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param item [T] Element to enqueue.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the queue is full.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_push(T, q, item) P_UVEC_CONCAT(uvec_spsc_push_, T)(q, item)
+
+/**
+ * Dequeues an element. Must only be called by the consumer thread.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param item [T*] Dequeued element.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the queue is empty.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_pop(T, q, item) P_UVEC_CONCAT(uvec_spsc_pop_, T)(q, item)
+
+/**
+ * Enqueues as many elements of the specified array as there is room for.
+ * Must only be called by the producer thread.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param array [T const*] Elements to enqueue.
+ * @param n [uvec_uint] Number of elements.
+ * @return [uvec_uint] Number of enqueued elements.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_push_array(T, q, array, n) P_UVEC_CONCAT(uvec_spsc_push_array_, T)(q, array, n)
+
+/**
+ * Dequeues up to 'n' elements. Must only be called by the consumer thread.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param array [T*] Array receiving the dequeued elements.
+ * @param n [uvec_uint] Maximum number of elements to dequeue.
+ * @return [uvec_uint] Number of dequeued elements.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_pop_array(T, q, array, n) P_UVEC_CONCAT(uvec_spsc_pop_array_, T)(q, array, n)
+
+/**
+ * Enqueues the specified element, waiting for room if the queue is full.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param item [T] Element to enqueue.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_push_wait(T, q, item) P_UVEC_CONCAT(uvec_spsc_push_wait_, T)(q, item)
+
+/**
+ * Dequeues an element, waiting for one if the queue is empty.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @return [T] Dequeued element.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_pop_wait(T, q) P_UVEC_CONCAT(uvec_spsc_pop_wait_, T)(q)
+
+/**
+ * Enqueues all the elements of the specified array, waiting for room as needed.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param array [T const*] Elements to enqueue.
+ * @param n [uvec_uint] Number of elements.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_push_array_wait(T, q, array, n) \
+    P_UVEC_CONCAT(uvec_spsc_push_array_wait_, T)(q, array, n)
+
+/**
+ * Dequeues up to 'n' elements, waiting for at least one if the queue is empty.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecSpscQueue(T)*] Queue instance.
+ * @param array [T*] Array receiving the dequeued elements.
+ * @param n [uvec_uint] Maximum number of elements to dequeue.
+ * @return [uvec_uint] Number of dequeued elements.
+ *
+ * @public @related UVecSpscQueue
+ */
+#define uvec_spsc_pop_array_wait(T, q, array, n) \
+    P_UVEC_CONCAT(uvec_spsc_pop_array_wait_, T)(q, array, n)
+
+/// @name MPMC queues
+
+/**
+ * Allocates a new MPMC queue.
+ *
+ * @param T [symbol] Vector type.
+ * @param capacity [uvec_uint] Capacity, rounded up to the next power of two.
+ * @return [UVecMpmcQueue(T)*] Queue instance, or NULL on error.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_alloc(T, capacity) P_UVEC_CONCAT(uvec_mpmc_alloc_, T)(capacity)
+
+/**
+ * Deallocates the specified MPMC queue.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue to free.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_free(T, q) P_UVEC_CONCAT(uvec_mpmc_free_, T)(q)
+
+/**
+ * Enqueues the specified element.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param item [T] Element to enqueue.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the queue is full.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_push(T, q, item) P_UVEC_CONCAT(uvec_mpmc_push_, T)(q, item)
+
+/**
+ * Dequeues an element.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param item [T*] Dequeued element.
+ * @return [uvec_ret] UVEC_OK on success, UVEC_NO if the queue is empty.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_pop(T, q, item) P_UVEC_CONCAT(uvec_mpmc_pop_, T)(q, item)
+
+/**
+ * Enqueues up to 'n' elements of the specified array as a contiguous block,
+ * claiming as many consecutive free slots as are available.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param array [T const*] Elements to enqueue.
+ * @param n [uvec_uint] Number of elements.
+ * @return [uvec_uint] Number of enqueued elements.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_push_array(T, q, array, n) P_UVEC_CONCAT(uvec_mpmc_push_array_, T)(q, array, n)
+
+/**
+ * Dequeues up to 'n' consecutive elements.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param array [T*] Array receiving the dequeued elements.
+ * @param n [uvec_uint] Maximum number of elements to dequeue.
+ * @return [uvec_uint] Number of dequeued elements.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_pop_array(T, q, array, n) P_UVEC_CONCAT(uvec_mpmc_pop_array_, T)(q, array, n)
+
+/**
+ * Enqueues the specified element, waiting for room if the queue is full.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param item [T] Element to enqueue.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_push_wait(T, q, item) P_UVEC_CONCAT(uvec_mpmc_push_wait_, T)(q, item)
+
+/**
+ * Dequeues an element, waiting for one if the queue is empty.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @return [T] Dequeued element.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_pop_wait(T, q) P_UVEC_CONCAT(uvec_mpmc_pop_wait_, T)(q)
+
+/**
+ * Enqueues all the elements of the specified array, waiting for room as needed.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param array [T const*] Elements to enqueue.
+ * @param n [uvec_uint] Number of elements.
+ *
+ * @note Elements are enqueued in order, but may be interleaved with those
+ *       of other producers if the queue fills up.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_push_array_wait(T, q, array, n) \
+    P_UVEC_CONCAT(uvec_mpmc_push_array_wait_, T)(q, array, n)
+
+/**
+ * Dequeues up to 'n' elements, waiting for at least one if the queue is empty.
+ *
+ * @param T [symbol] Vector type.
+ * @param q [UVecMpmcQueue(T)*] Queue instance.
+ * @param array [T*] Array receiving the dequeued elements.
+ * @param n [uvec_uint] Maximum number of elements to dequeue.
+ * @return [uvec_uint] Number of dequeued elements.
+ *
+ * @public @related UVecMpmcQueue
+ */
+#define uvec_mpmc_pop_array_wait(T, q, array, n) \
+    P_UVEC_CONCAT(uvec_mpmc_pop_array_wait_, T)(q, array, n)
+
+#endif // UVEC_QUEUE_H
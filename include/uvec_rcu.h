@@ -0,0 +1,519 @@
+/**
+ * uVec - read-copy-update vectors.
+ *
+ * RCU vectors are optimized for read-mostly workloads: readers access a consistent
+ * snapshot of the vector without ever blocking or contending with each other, while
+ * writers publish new versions by copying and modifying the current one. Old versions
+ * are reclaimed via epoch-based reclamation, once no reader can be accessing them.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_RCU_H
+#define UVEC_RCU_H
+
+#include "uvec.h"
+#include <pthread.h>
+#include <sched.h>
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "RCU vectors require atomic operations, not available on this compiler."
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector supporting wait-free reads concurrently with copy-on-update writes.
+ * @struct UVecRcu
+ */
+
+/// Handle used by a reader thread to access RCU vectors.
+typedef struct UVecRcuReader {
+    /** @cond */
+    P_UVEC_ATOMIC(size_t) epoch;
+    P_UVEC_ATOMIC(bool) used;
+    struct UVecRcuReader *next;
+    char pad[UVEC_CACHE_LINE_SIZE];
+    /** @endcond */
+} UVecRcuReader;
+
+/// Version that has been replaced, but may still be accessed by readers.
+typedef struct p_uvec_rcu_retired {
+    void *ptr;
+    size_t epoch;
+    struct p_uvec_rcu_retired *next;
+} p_uvec_rcu_retired;
+
+/// Epoch-based reclamation domain.
+typedef struct p_uvec_rcu_domain {
+    P_UVEC_ATOMIC(size_t) epoch;
+    pthread_mutex_t lock;
+    UVecRcuReader *readers;
+    p_uvec_rcu_retired *retired;
+    void (*free_func)(void *);
+} p_uvec_rcu_domain;
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Initializes a reclamation domain.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ * @param free_func [void (*)(void *)] Function used to free retired versions.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ */
+p_uvec_static_inline uvec_ret p_uvec_rcu_init(p_uvec_rcu_domain *d, void (*free_func)(void *)) {
+    if (pthread_mutex_init(&d->lock, NULL)) return UVEC_ERR;
+    p_uvec_atomic_init(&d->epoch, 1);
+    d->readers = NULL;
+    d->retired = NULL;
+    d->free_func = free_func;
+    return UVEC_OK;
+}
+
+/**
+ * Returns the oldest epoch announced by a reader currently accessing the domain.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ * @return [size_t] Oldest epoch, or SIZE_MAX if there are no active readers.
+ */
+p_uvec_static_inline size_t p_uvec_rcu_min_epoch(p_uvec_rcu_domain *d) {
+    size_t min = SIZE_MAX;
+
+    for (UVecRcuReader *r = d->readers; r; r = r->next) {
+        size_t epoch = p_uvec_atomic_load(&r->epoch, P_UVEC_MO_SEQ_CST);
+        if (epoch && epoch < min) min = epoch;
+    }
+
+    return min;
+}
+
+/**
+ * Frees the retired versions that can no longer be accessed by readers.
+ * Must be called with the domain lock held.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ */
+p_uvec_static_inline void p_uvec_rcu_reclaim(p_uvec_rcu_domain *d) {
+    size_t min = p_uvec_rcu_min_epoch(d);
+    p_uvec_rcu_retired **link = &d->retired;
+
+    while (*link) {
+        p_uvec_rcu_retired *cur = *link;
+
+        if (cur->epoch < min) {
+            *link = cur->next;
+            d->free_func(cur->ptr);
+            UVEC_FREE(cur);
+        } else {
+            link = &cur->next;
+        }
+    }
+}
+
+/**
+ * Waits until all retired versions have been reclaimed.
+ * Must be called with the domain lock held.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ */
+p_uvec_static_inline void p_uvec_rcu_synchronize(p_uvec_rcu_domain *d) {
+    for (p_uvec_rcu_reclaim(d); d->retired; p_uvec_rcu_reclaim(d)) sched_yield();
+}
+
+/**
+ * Retires a version that has just been replaced, and advances the epoch.
+ * Must be called with the domain lock held.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ * @param ptr [void*] Replaced version.
+ */
+p_uvec_static_inline void p_uvec_rcu_retire(p_uvec_rcu_domain *d, void *ptr) {
+    size_t epoch = p_uvec_atomic_fetch_add(&d->epoch, 1, P_UVEC_MO_SEQ_CST);
+    p_uvec_rcu_retired *node = UVEC_MALLOC(sizeof(*node));
+
+    if (node) {
+        *node = (p_uvec_rcu_retired){ .ptr = ptr, .epoch = epoch, .next = d->retired };
+        d->retired = node;
+        p_uvec_rcu_reclaim(d);
+    } else {
+        // Cannot defer reclamation: wait for all current readers instead.
+        while (p_uvec_rcu_min_epoch(d) <= epoch) sched_yield();
+        d->free_func(ptr);
+    }
+}
+
+/**
+ * Frees all the resources held by a reclamation domain.
+ * There must be no active readers.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ */
+p_uvec_static_inline void p_uvec_rcu_deinit(p_uvec_rcu_domain *d) {
+    for (p_uvec_rcu_retired *cur = d->retired, *next; cur; cur = next) {
+        next = cur->next;
+        d->free_func(cur->ptr);
+        UVEC_FREE(cur);
+    }
+
+    for (UVecRcuReader *cur = d->readers, *next; cur; cur = next) {
+        next = cur->next;
+        UVEC_FREE(cur);
+    }
+
+    pthread_mutex_destroy(&d->lock);
+}
+
+/**
+ * Registers a new reader with the specified domain.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ * @return [UVecRcuReader*] Reader handle, or NULL on error.
+ */
+p_uvec_static_inline UVecRcuReader* p_uvec_rcu_register(p_uvec_rcu_domain *d) {
+    pthread_mutex_lock(&d->lock);
+    UVecRcuReader *r = d->readers;
+
+    for (; r; r = r->next) {
+        bool used = false;
+        if (p_uvec_atomic_cas(&r->used, &used, true, P_UVEC_MO_ACQUIRE, P_UVEC_MO_RELAXED)) break;
+    }
+
+    if (!r && (r = UVEC_MALLOC(sizeof(*r)))) {
+        p_uvec_atomic_init(&r->epoch, 0);
+        p_uvec_atomic_init(&r->used, true);
+        r->next = d->readers;
+        d->readers = r;
+    }
+
+    pthread_mutex_unlock(&d->lock);
+    return r;
+}
+
+/**
+ * Begins a read-side critical section.
+ *
+ * @param d [p_uvec_rcu_domain*] Domain.
+ * @param r [UVecRcuReader*] Reader handle.
+ */
+p_uvec_static_inline void p_uvec_rcu_read_begin(p_uvec_rcu_domain *d, UVecRcuReader *r) {
+    size_t epoch = p_uvec_atomic_load(&d->epoch, P_UVEC_MO_RELAXED);
+    p_uvec_atomic_store(&r->epoch, epoch, P_UVEC_MO_SEQ_CST);
+}
+
+/**
+ * Defines a new RCU vector struct.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_RCU(T)                                                                      \
+    typedef struct UVecRcu_##T {                                                                    \
+        /** @cond */                                                                                \
+        P_UVEC_ATOMIC(UVec_##T *) vec;                                                              \
+        p_uvec_rcu_domain domain;                                                                   \
+        /** @endcond */                                                                             \
+    } UVecRcu_##T;
+
+/**
+ * Generates function declarations for the specified RCU vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_RCU(T, SCOPE)                                                                   \
+    /** @cond */                                                                                    \
+    SCOPE UVecRcu_##T* uvec_rcu_alloc_##T(void);                                                    \
+    SCOPE void uvec_rcu_free_##T(UVecRcu_##T *rcu);                                                 \
+    SCOPE UVec_##T const* uvec_rcu_read_lock_##T(UVecRcu_##T *rcu, UVecRcuReader *reader);          \
+    SCOPE UVec_##T* uvec_rcu_write_begin_##T(UVecRcu_##T *rcu);                                     \
+    SCOPE void uvec_rcu_write_commit_##T(UVecRcu_##T *rcu, UVec_##T *vec);                          \
+    SCOPE void uvec_rcu_write_abort_##T(UVecRcu_##T *rcu, UVec_##T *vec);                           \
+    SCOPE void uvec_rcu_replace_##T(UVecRcu_##T *rcu, UVec_##T *vec);                               \
+    SCOPE void uvec_rcu_synchronize_##T(UVecRcu_##T *rcu);                                          \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified RCU vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_RCU(T, SCOPE)                                                                   \
+                                                                                                    \
+    static inline void p_uvec_rcu_free_vec_##T(void *vec) {                                         \
+        uvec_free_##T(vec);                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    static inline void p_uvec_rcu_publish_##T(UVecRcu_##T *rcu, UVec_##T *vec) {                    \
+        /* Published vectors come from uvec_alloc, so they are already registered. */            \
+        (void)p_uvec_registry_own(vec);                                                             \
+        UVec_##T *old = p_uvec_atomic_exchange(&rcu->vec, vec, P_UVEC_MO_SEQ_CST);                  \
+        p_uvec_rcu_retire(&rcu->domain, old);                                                       \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecRcu_##T* uvec_rcu_alloc_##T(void) {                                                   \
+        UVecRcu_##T *rcu = UVEC_MALLOC(sizeof(*rcu));                                               \
+        UVec_##T *vec = uvec_alloc_##T();                                                           \
+                                                                                                    \
+        if (!(rcu && vec && p_uvec_registry_own(vec) == UVEC_OK &&                                  \
+              p_uvec_rcu_init(&rcu->domain, p_uvec_rcu_free_vec_##T) == UVEC_OK)) {                 \
+            UVEC_FREE(rcu);                                                                         \
+            uvec_free_##T(vec);                                                                     \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        p_uvec_atomic_init(&rcu->vec, vec);                                                         \
+        return rcu;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_rcu_free_##T(UVecRcu_##T *rcu) {                                                \
+        if (!rcu) return;                                                                           \
+        uvec_free_##T(p_uvec_atomic_load(&rcu->vec, P_UVEC_MO_ACQUIRE));                            \
+        p_uvec_rcu_deinit(&rcu->domain);                                                            \
+        UVEC_FREE(rcu);                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T const* uvec_rcu_read_lock_##T(UVecRcu_##T *rcu, UVecRcuReader *reader) {         \
+        p_uvec_rcu_read_begin(&rcu->domain, reader);                                                \
+        return p_uvec_atomic_load(&rcu->vec, P_UVEC_MO_SEQ_CST);                                    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVec_##T* uvec_rcu_write_begin_##T(UVecRcu_##T *rcu) {                                    \
+        pthread_mutex_lock(&rcu->domain.lock);                                                      \
+        UVec_##T *vec = uvec_copy_##T(p_uvec_atomic_load(&rcu->vec, P_UVEC_MO_RELAXED));            \
+        if (!vec) pthread_mutex_unlock(&rcu->domain.lock);                                          \
+        return vec;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_rcu_write_commit_##T(UVecRcu_##T *rcu, UVec_##T *vec) {                         \
+        p_uvec_rcu_publish_##T(rcu, vec);                                                           \
+        pthread_mutex_unlock(&rcu->domain.lock);                                                    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_rcu_write_abort_##T(UVecRcu_##T *rcu, UVec_##T *vec) {                          \
+        pthread_mutex_unlock(&rcu->domain.lock);                                                    \
+        uvec_free_##T(vec);                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_rcu_replace_##T(UVecRcu_##T *rcu, UVec_##T *vec) {                              \
+        pthread_mutex_lock(&rcu->domain.lock);                                                      \
+        p_uvec_rcu_publish_##T(rcu, vec);                                                           \
+        pthread_mutex_unlock(&rcu->domain.lock);                                                    \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_rcu_synchronize_##T(UVecRcu_##T *rcu) {                                         \
+        pthread_mutex_lock(&rcu->domain.lock);                                                      \
+        p_uvec_rcu_synchronize(&rcu->domain);                                                       \
+        pthread_mutex_unlock(&rcu->domain.lock);                                                    \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new RCU vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecRcu
+ */
+#define UVEC_DECL_RCU(T)                                                                            \
+    P_UVEC_DEF_TYPE_RCU(T)                                                                          \
+    P_UVEC_DECL_RCU(T, p_uvec_unused)
+
+/**
+ * Declares a new RCU vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecRcu
+ */
+#define UVEC_DECL_RCU_SPEC(T, SPEC)                                                                 \
+    P_UVEC_DEF_TYPE_RCU(T)                                                                          \
+    P_UVEC_DECL_RCU(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared RCU vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecRcu
+ */
+#define UVEC_IMPL_RCU(T) \
+    P_UVEC_IMPL_RCU(T, p_uvec_unused)
+
+/**
+ * Defines a new static RCU vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecRcu
+ */
+#define UVEC_INIT_RCU(T)                                                                            \
+    P_UVEC_DEF_TYPE_RCU(T)                                                                          \
+    P_UVEC_IMPL_RCU(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new RCU vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecRcu
+ */
+#define UVecRcu(T) P_UVEC_CONCAT(UVecRcu_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new, empty RCU vector.
+ *
+ * @param T [symbol] Vector type.
+ * @return [UVecRcu(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_alloc(T) P_UVEC_CONCAT(uvec_rcu_alloc_, T)()
+
+/**
+ * Deallocates the specified RCU vector, along with its reader handles.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector to free.
+ *
+ * @note There must be no active readers or writers.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_free(T, rcu) P_UVEC_CONCAT(uvec_rcu_free_, T)(rcu)
+
+/// @name Readers
+
+/**
+ * Registers a new reader. Each reader thread must use its own handle.
+ *
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @return [UVecRcuReader*] Reader handle, or NULL on error.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_register(rcu) p_uvec_rcu_register(&(rcu)->domain)
+
+/**
+ * Unregisters the specified reader, allowing its handle to be reused by other readers.
+ *
+ * @param reader [UVecRcuReader*] Reader handle.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_unregister(reader) \
+    p_uvec_atomic_store(&(reader)->used, false, P_UVEC_MO_RELEASE)
+
+/**
+ * Begins a read-side critical section, returning a snapshot of the vector.
+ * This operation is wait-free.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @param reader [UVecRcuReader*] Reader handle.
+ * @return [UVec(T) const*] Snapshot, valid until uvec_rcu_read_unlock is called.
+ *
+ * @note Critical sections cannot be nested. Long critical sections delay the
+ *       reclamation of replaced versions.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_read_lock(T, rcu, reader) P_UVEC_CONCAT(uvec_rcu_read_lock_, T)(rcu, reader)
+
+/**
+ * Ends a read-side critical section. This operation is wait-free.
+ *
+ * @param reader [UVecRcuReader*] Reader handle.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_read_unlock(reader) \
+    p_uvec_atomic_store(&(reader)->epoch, 0, P_UVEC_MO_RELEASE)
+
+/// @name Writers
+
+/**
+ * Begins an update, returning a private copy of the current version.
+ * Updates are serialized, so other writers block until this one is committed or aborted.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @return [UVec(T)*] Copy of the current version, or NULL on error.
+ *
+ * @note In copy-on-write mode the copy shares storage with the current version
+ *       until it is first mutated.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_write_begin(T, rcu) P_UVEC_CONCAT(uvec_rcu_write_begin_, T)(rcu)
+
+/**
+ * Publishes the copy returned by uvec_rcu_write_begin as the current version.
+ * The replaced version is reclaimed once no reader can be accessing it.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @param vec [UVec(T)*] New version.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_write_commit(T, rcu, vec) P_UVEC_CONCAT(uvec_rcu_write_commit_, T)(rcu, vec)
+
+/**
+ * Discards the copy returned by uvec_rcu_write_begin.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @param vec [UVec(T)*] Discarded copy.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_write_abort(T, rcu, vec) P_UVEC_CONCAT(uvec_rcu_write_abort_, T)(rcu, vec)
+
+/**
+ * Publishes the specified vector as the current version, taking ownership of it.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ * @param vec [UVec(T)*] New version.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_replace(T, rcu, vec) P_UVEC_CONCAT(uvec_rcu_replace_, T)(rcu, vec)
+
+/**
+ * Waits until all replaced versions have been reclaimed.
+ *
+ * @param T [symbol] Vector type.
+ * @param rcu [UVecRcu(T)*] Vector instance.
+ *
+ * @note Must not be called from within a read-side critical section.
+ *
+ * @public @related UVecRcu
+ */
+#define uvec_rcu_synchronize(T, rcu) P_UVEC_CONCAT(uvec_rcu_synchronize_, T)(rcu)
+
+#endif // UVEC_RCU_H
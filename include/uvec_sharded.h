@@ -0,0 +1,445 @@
+/**
+ * uVec - sharded vectors.
+ *
+ * Sharded vectors are made of a fixed number of independent vectors, each guarded
+ * by its own spinlock and padded to a separate cache line. Elements are routed to
+ * a shard based on the calling thread or on a user-provided hash, so that concurrent
+ * writers rarely contend for the same lock. The order of elements across shards
+ * is unspecified.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_SHARDED_H
+#define UVEC_SHARDED_H
+
+#include "uvec_parallel.h"
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector split into independently locked shards.
+ * @struct UVecSharded
+ */
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Returns a number identifying the calling thread. If thread-local storage is available,
+ * threads are numbered sequentially, otherwise the number is derived from the stack address.
+ *
+ * @return [size_t] Thread number.
+ */
+p_uvec_static_inline size_t p_uvec_thread_slot(void) {
+#ifdef P_UVEC_THREAD_LOCAL
+    static P_UVEC_THREAD_LOCAL size_t slot = 0;
+    static P_UVEC_ATOMIC(size_t) next;
+    if (!slot) slot = p_uvec_atomic_fetch_add(&next, 1, P_UVEC_MO_RELAXED) + 1;
+    return slot - 1;
+#else
+    char local;
+    size_t addr = (size_t)((uintptr_t)&local >> 12u);
+    return addr ^ (addr >> 7u) ^ (addr >> 17u);
+#endif
+}
+
+/**
+ * Scrambles the bits of a hash, so that its low bits can be used to select a shard.
+ *
+ * @param hash [size_t] Hash.
+ * @return [size_t] Scrambled hash.
+ */
+#define p_uvec_shard_mix(hash) ((size_t)(((uint64_t)(hash) * 0x9E3779B97F4A7C15ull) >> 32u))
+
+/**
+ * Defines a new sharded vector struct.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_SHARDED(T)                                                                  \
+    typedef struct p_uvec_shard_##T {                                                               \
+        P_UVEC_ATOMIC(bool) lock;                                                                   \
+        UVec_##T vec;                                                                               \
+    } p_uvec_shard_##T;                                                                             \
+                                                                                                    \
+    typedef union p_uvec_shard_slot_##T {                                                           \
+        p_uvec_shard_##T shard;                                                                     \
+        char pad[p_uvec_cache_align(sizeof(p_uvec_shard_##T))];                                     \
+    } p_uvec_shard_slot_##T;                                                                        \
+                                                                                                    \
+    typedef struct UVecSharded_##T {                                                                \
+        /** @cond */                                                                                \
+        unsigned count;                                                                             \
+        p_uvec_shard_slot_##T *slots;                                                               \
+        void *mem;                                                                                  \
+        /** @endcond */                                                                             \
+    } UVecSharded_##T;
+
+/**
+ * Generates function declarations for the specified sharded vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_SHARDED(T, SCOPE)                                                               \
+    /** @cond */                                                                                    \
+    SCOPE UVecSharded_##T* uvec_sharded_alloc_##T(unsigned count);                                  \
+    SCOPE void uvec_sharded_free_##T(UVecSharded_##T *sv);                                          \
+    SCOPE uvec_ret uvec_sharded_push_##T(UVecSharded_##T *sv, T item);                              \
+    SCOPE uvec_ret uvec_sharded_push_hash_##T(UVecSharded_##T *sv, size_t hash, T item);            \
+    SCOPE uvec_ret uvec_sharded_append_array_##T(UVecSharded_##T *sv, T const *array, uvec_uint n); \
+    SCOPE uvec_uint uvec_sharded_count_##T(UVecSharded_##T *sv);                                    \
+    SCOPE void uvec_sharded_foreach_##T(UVecPool *pool, UVecSharded_##T *sv,                        \
+                                        void (*func)(T *, void *), void *ctx);                      \
+    SCOPE uvec_ret uvec_sharded_drain_##T(UVecSharded_##T *sv, UVec_##T *vec);                      \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified sharded vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_SHARDED(T, SCOPE)                                                               \
+                                                                                                    \
+    typedef struct p_uvec_sharded_ctx_##T {                                                         \
+        UVecSharded_##T *sv;                                                                        \
+        void (*func)(T *, void *);                                                                  \
+        void *ctx;                                                                                  \
+    } p_uvec_sharded_ctx_##T;                                                                       \
+                                                                                                    \
+    static inline void p_uvec_sharded_foreach_task_##T(void *data, uvec_uint chunk,                 \
+                                                       uvec_uint start, uvec_uint end) {            \
+        p_uvec_sharded_ctx_##T *ctx = data;                                                         \
+                                                                                                    \
+        for (uvec_uint i = start; i < end; ++i) {                                                   \
+            p_uvec_shard_##T *shard = &ctx->sv->slots[i].shard;                                     \
+            p_uvec_spin_lock(&shard->lock);                                                         \
+            for (uvec_uint j = 0; j < shard->vec.count; ++j) {                                      \
+                ctx->func(shard->vec.storage + j, ctx->ctx);                                        \
+            }                                                                                       \
+            p_uvec_spin_unlock(&shard->lock);                                                       \
+        }                                                                                           \
+                                                                                                    \
+        (void)chunk;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecSharded_##T* uvec_sharded_alloc_##T(unsigned count) {                                 \
+        if (!count) {                                                                               \
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);                                              \
+            count = cpus > 0 ? (unsigned)cpus : 1;                                                  \
+        }                                                                                           \
+                                                                                                    \
+        UVecSharded_##T *sv = UVEC_MALLOC(sizeof(*sv));                                             \
+        if (!sv) return NULL;                                                                       \
+                                                                                                    \
+        uvec_uint shards = count;                                                                   \
+        p_uvec_uint_next_power_2(shards);                                                           \
+        sv->count = (unsigned)shards;                                                               \
+        sv->mem = UVEC_MALLOC(sv->count * sizeof(*sv->slots) + UVEC_CACHE_LINE_SIZE);               \
+                                                                                                    \
+        if (!sv->mem) {                                                                             \
+            UVEC_FREE(sv);                                                                          \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        sv->slots = (void *)p_uvec_cache_align((uintptr_t)sv->mem);                                 \
+        uvec_ret ret = UVEC_OK;                                                                     \
+                                                                                                    \
+        for (unsigned i = 0; i < sv->count; ++i) {                                                  \
+            p_uvec_atomic_init(&sv->slots[i].shard.lock, false);                                    \
+            sv->slots[i].shard.vec = uvec_init(T);                                                  \
+            if (!ret) ret = p_uvec_registry_own(&sv->slots[i].shard.vec);                           \
+        }                                                                                           \
+                                                                                                    \
+        if (ret) {                                                                                  \
+            for (unsigned i = 0; i < sv->count; ++i) uvec_deinit(sv->slots[i].shard.vec);           \
+            UVEC_FREE(sv->mem);                                                                     \
+            UVEC_FREE(sv);                                                                          \
+            return NULL;                                                                            \
+        }                                                                                           \
+                                                                                                    \
+        return sv;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_sharded_free_##T(UVecSharded_##T *sv) {                                        \
+        if (!sv) return;                                                                            \
+        for (unsigned i = 0; i < sv->count; ++i) uvec_deinit(sv->slots[i].shard.vec);               \
+        UVEC_FREE(sv->mem);                                                                         \
+        UVEC_FREE(sv);                                                                              \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_sharded_push_##T(UVecSharded_##T *sv, T item) {                             \
+        p_uvec_shard_##T *shard = &sv->slots[p_uvec_thread_slot() & (sv->count - 1)].shard;         \
+        p_uvec_spin_lock(&shard->lock);                                                             \
+        uvec_ret ret = uvec_push_##T(&shard->vec, item);                                            \
+        p_uvec_spin_unlock(&shard->lock);                                                           \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_sharded_push_hash_##T(UVecSharded_##T *sv, size_t hash, T item) {           \
+        p_uvec_shard_##T *shard = &sv->slots[p_uvec_shard_mix(hash) & (sv->count - 1)].shard;       \
+        p_uvec_spin_lock(&shard->lock);                                                             \
+        uvec_ret ret = uvec_push_##T(&shard->vec, item);                                            \
+        p_uvec_spin_unlock(&shard->lock);                                                           \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_sharded_append_array_##T(UVecSharded_##T *sv, T const *array,               \
+                                                 uvec_uint n) {                                     \
+        p_uvec_shard_##T *shard = &sv->slots[p_uvec_thread_slot() & (sv->count - 1)].shard;         \
+        p_uvec_spin_lock(&shard->lock);                                                             \
+        uvec_ret ret = uvec_append_array_##T(&shard->vec, array, n);                                \
+        p_uvec_spin_unlock(&shard->lock);                                                           \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_uint uvec_sharded_count_##T(UVecSharded_##T *sv) {                                   \
+        uvec_uint count = 0;                                                                        \
+                                                                                                    \
+        for (unsigned i = 0; i < sv->count; ++i) {                                                  \
+            p_uvec_shard_##T *shard = &sv->slots[i].shard;                                          \
+            p_uvec_spin_lock(&shard->lock);                                                         \
+            count += shard->vec.count;                                                              \
+            p_uvec_spin_unlock(&shard->lock);                                                       \
+        }                                                                                           \
+                                                                                                    \
+        return count;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE void uvec_sharded_foreach_##T(UVecPool *pool, UVecSharded_##T *sv,                        \
+                                        void (*func)(T *, void *), void *ctx) {                     \
+        p_uvec_sharded_ctx_##T data = { .sv = sv, .func = func, .ctx = ctx };                       \
+        p_uvec_pool_job job = {                                                                     \
+            .func = p_uvec_sharded_foreach_task_##T, .ctx = &data,                                  \
+            .count = sv->count, .chunk = 1, .chunks = sv->count                                     \
+        };                                                                                          \
+        p_uvec_pool_run(pool, &job);                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_sharded_drain_##T(UVecSharded_##T *sv, UVec_##T *vec) {                     \
+        uvec_uint count = vec->count;                                                               \
+        uvec_ret ret = UVEC_OK;                                                                     \
+                                                                                                    \
+        for (unsigned i = 0; i < sv->count; ++i) {                                                  \
+            p_uvec_spin_lock(&sv->slots[i].shard.lock);                                             \
+            count += sv->slots[i].shard.vec.count;                                                  \
+        }                                                                                           \
+                                                                                                    \
+        if (uvec_reserve_capacity_##T(vec, count)) {                                                \
+            ret = UVEC_ERR;                                                                         \
+        } else {                                                                                    \
+            for (unsigned i = 0; i < sv->count; ++i) {                                              \
+                UVec_##T *shard = &sv->slots[i].shard.vec;                                          \
+                if ((ret = uvec_append_array_##T(vec, shard->storage, shard->count))) break;        \
+                uvec_remove_all_##T(shard);                                                         \
+            }                                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        for (unsigned i = 0; i < sv->count; ++i) p_uvec_spin_unlock(&sv->slots[i].shard.lock);      \
+        return ret;                                                                                 \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new sharded vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecSharded
+ */
+#define UVEC_DECL_SHARDED(T)                                                                        \
+    P_UVEC_DEF_TYPE_SHARDED(T)                                                                      \
+    P_UVEC_DECL_SHARDED(T, p_uvec_unused)
+
+/**
+ * Declares a new sharded vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecSharded
+ */
+#define UVEC_DECL_SHARDED_SPEC(T, SPEC)                                                             \
+    P_UVEC_DEF_TYPE_SHARDED(T)                                                                      \
+    P_UVEC_DECL_SHARDED(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared sharded vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSharded
+ */
+#define UVEC_IMPL_SHARDED(T) \
+    P_UVEC_IMPL_SHARDED(T, p_uvec_unused)
+
+/**
+ * Defines a new static sharded vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecSharded
+ */
+#define UVEC_INIT_SHARDED(T)                                                                        \
+    P_UVEC_DEF_TYPE_SHARDED(T)                                                                      \
+    P_UVEC_IMPL_SHARDED(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new sharded vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecSharded
+ */
+#define UVecSharded(T) P_UVEC_CONCAT(UVecSharded_, T)
+
+/// @name Memory management
+
+/**
+ * Allocates a new, empty sharded vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param count [unsigned] Number of shards, rounded up to a power of two.
+ *                         If zero, the number of online processors is used.
+ * @return [UVecSharded(T)*] Vector instance, or NULL on error.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_alloc(T, count) P_UVEC_CONCAT(uvec_sharded_alloc_, T)(count)
+
+/**
+ * Deallocates the specified sharded vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector to free.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_free(T, sv) P_UVEC_CONCAT(uvec_sharded_free_, T)(sv)
+
+/// @name Primitives
+
+/**
+ * Returns the number of shards.
+ *
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @return [unsigned] Number of shards.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_shards(sv) ((sv)->count)
+
+/**
+ * Returns the total number of elements in the vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @return [uvec_uint] Number of elements.
+ *
+ * @note Shards are visited one at a time, so concurrent insertions may or may not be counted.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_count(T, sv) P_UVEC_CONCAT(uvec_sharded_count_, T)(sv)
+
+/// @name Insertion
+
+/**
+ * Pushes the specified element to the shard assigned to the calling thread.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_push(T, sv, item) P_UVEC_CONCAT(uvec_sharded_push_, T)(sv, item)
+
+/**
+ * Pushes the specified element to the shard selected by the specified hash.
+ * Elements with the same hash are stored in the same shard, in insertion order.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @param hash [size_t] Hash.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_push_hash(T, sv, hash, item) \
+    P_UVEC_CONCAT(uvec_sharded_push_hash_, T)(sv, hash, item)
+
+/**
+ * Appends the specified array to the shard assigned to the calling thread,
+ * acquiring its lock only once.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @param array [T const*] Array to append.
+ * @param n [uvec_uint] Number of elements to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_append_array(T, sv, array, n) \
+    P_UVEC_CONCAT(uvec_sharded_append_array_, T)(sv, array, n)
+
+/// @name Iteration and removal
+
+/**
+ * Calls the specified function on each element of the vector, processing shards in parallel.
+ * Each shard is locked while its elements are being visited.
+ *
+ * @param T [symbol] Vector type.
+ * @param pool [UVecPool*] Thread pool, can be NULL.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @param func [void (*)(T *, void *)] Function called on a pointer to each element.
+ * @param ctx [void*] Context passed to the function.
+ *
+ * @note The function must not insert elements into the sharded vector.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_foreach(T, pool, sv, func, ctx) \
+    P_UVEC_CONCAT(uvec_sharded_foreach_, T)(pool, sv, func, ctx)
+
+/**
+ * Moves all the elements of the sharded vector to the end of the specified vector,
+ * reserving capacity only once. Shards keep their capacity for reuse.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecSharded(T)*] Vector instance.
+ * @param vec [UVec(T)*] Destination vector.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note All shards are locked for the duration of the operation, so the result
+ *       is a consistent snapshot even with concurrent insertions.
+ *
+ * @public @related UVecSharded
+ */
+#define uvec_sharded_drain(T, sv, vec) P_UVEC_CONCAT(uvec_sharded_drain_, T)(sv, vec)
+
+#endif // UVEC_SHARDED_H
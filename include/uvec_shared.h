@@ -0,0 +1,515 @@
+/**
+ * uVec - shared-memory vectors.
+ *
+ * Shared vectors live in a shared memory object (created via memfd_create or shm_open)
+ * that can be mapped by multiple processes at different addresses. The object starts
+ * with a control block, and the storage is located by its offset from the start
+ * of the object rather than by a pointer.
+ *
+ * Shared vectors follow a single-writer, multiple-reader protocol: the writer may only
+ * append elements, and publishes them by atomically updating the number of elements.
+ * When the writer grows the object, it increments a generation number; readers notice
+ * the new generation on their next uvec_shared_refresh call and remap the object.
+ *
+ * @note Define _GNU_SOURCE before including any header to use memfd_create on Linux.
+ *
+ * @see test.c for usage examples.
+ * @author Ivano Bilenchi
+ *
+ * @copyright Copyright (c) 2018-2020 Ivano Bilenchi <https://ivanobilenchi.com>
+ * @copyright SPDX-License-Identifier: MIT
+ *
+ * @file
+ */
+#ifndef UVEC_SHARED_H
+#define UVEC_SHARED_H
+
+#include "uvec_mapped.h"
+
+#ifndef P_UVEC_HAS_ATOMICS
+    #error "Shared vectors require atomic operations, not available on this compiler."
+#endif
+
+// #########
+// # Types #
+// #########
+
+/**
+ * A vector in shared memory, with a single writer and multiple readers.
+ * @struct UVecShared
+ */
+
+/// Control block at the start of a shared memory object.
+typedef struct p_uvec_shared_header {
+    char magic[8];
+    uint64_t elem_size;
+    uint64_t data_offset;
+    P_UVEC_ATOMIC(uint64_t) capacity;
+    P_UVEC_ATOMIC(uint64_t) generation;
+    P_UVEC_ATOMIC(uint64_t) count;
+} p_uvec_shared_header;
+
+// #############
+// # Constants #
+// #############
+
+/// Magic bytes at the start of a shared memory object (including the terminator).
+#define P_UVEC_SHARED_MAGIC "UVECSHM"
+
+/// Offset of the storage from the start of a shared memory object.
+#define P_UVEC_SHARED_DATA_OFFSET p_uvec_cache_align(sizeof(p_uvec_shared_header))
+
+// ###############
+// # Private API #
+// ###############
+
+/**
+ * Creates an anonymous shared memory object.
+ *
+ * @return [int] File descriptor, or -1 on error.
+ */
+p_uvec_static_inline int p_uvec_shared_anon(void) {
+#if defined __linux__ && defined MFD_CLOEXEC
+    return memfd_create("uvec", MFD_CLOEXEC);
+#else
+    static P_UVEC_ATOMIC(unsigned) counter = 0;
+    char name[64];
+
+    for (unsigned i = 0; i < 16; ++i) {
+        unsigned const n = p_uvec_atomic_fetch_add(&counter, 1, P_UVEC_MO_RELAXED);
+        snprintf(name, sizeof(name), "/uvec-%ld-%u", (long)getpid(), n);
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+        if (fd >= 0) {
+            shm_unlink(name);
+            return fd;
+        }
+
+        if (errno != EEXIST) break;
+    }
+
+    return -1;
+#endif
+}
+
+/**
+ * Maps the control block and storage of a shared memory object.
+ *
+ * @param fd [int] File descriptor.
+ * @param writable [bool] True if the object should be mapped read-write.
+ * @param elem_size [size_t] Element size.
+ * @param[out] map_size [size_t*] Size of the mapping.
+ * @return [p_uvec_shared_header*] Mapping, or NULL on error.
+ */
+p_uvec_static_inline p_uvec_shared_header* p_uvec_shared_map(int fd, bool writable,
+                                                             size_t elem_size, size_t *map_size) {
+    int const prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    struct stat st;
+
+    *map_size = P_UVEC_SHARED_DATA_OFFSET;
+    if (writable ? ftruncate(fd, (off_t)*map_size) : fstat(fd, &st)) return NULL;
+
+    if (!writable && (uint64_t)st.st_size < *map_size) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    p_uvec_shared_header *header = mmap(NULL, *map_size, prot, MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED) return NULL;
+
+    if (writable) {
+        memset(header, 0, sizeof(*header));
+        header->elem_size = elem_size;
+        header->data_offset = P_UVEC_SHARED_DATA_OFFSET;
+        p_uvec_atomic_init(&header->capacity, 0);
+        p_uvec_atomic_init(&header->generation, 0);
+        p_uvec_atomic_init(&header->count, 0);
+        memcpy(header->magic, P_UVEC_SHARED_MAGIC, sizeof(P_UVEC_SHARED_MAGIC));
+    } else if (memcmp(header->magic, P_UVEC_SHARED_MAGIC, sizeof(P_UVEC_SHARED_MAGIC)) ||
+               header->elem_size != elem_size || header->data_offset < sizeof(*header) ||
+               header->data_offset > *map_size) {
+        munmap(header, *map_size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return header;
+}
+
+/**
+ * Defines a new shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ */
+#define P_UVEC_DEF_TYPE_SHARED(T)                                                                   \
+    typedef struct UVecShared_##T {                                                                 \
+        /** @cond */                                                                                \
+        UVec_##T vec;                                                                               \
+        p_uvec_shared_header *header;                                                               \
+        size_t size;                                                                                \
+        uint64_t generation;                                                                        \
+        int fd;                                                                                     \
+        bool writer;                                                                                \
+        /** @endcond */                                                                             \
+    } UVecShared_##T;
+
+/**
+ * Generates function declarations for the specified shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the declarations.
+ */
+#define P_UVEC_DECL_SHARED(T, SCOPE)                                                                \
+    /** @cond */                                                                                    \
+    SCOPE UVecShared_##T* uvec_shared_create_##T(char const *name);                                 \
+    SCOPE UVecShared_##T* uvec_shared_open_##T(char const *name);                                   \
+    SCOPE UVecShared_##T* uvec_shared_open_fd_##T(int fd);                                          \
+    SCOPE uvec_ret uvec_shared_close_##T(UVecShared_##T *sv);                                       \
+    SCOPE uvec_ret uvec_shared_refresh_##T(UVecShared_##T *sv);                                     \
+    SCOPE uvec_ret uvec_shared_reserve_##T(UVecShared_##T *sv, uvec_uint capacity);                 \
+    SCOPE uvec_ret uvec_shared_push_##T(UVecShared_##T *sv, T item);                                \
+    SCOPE uvec_ret uvec_shared_append_array_##T(UVecShared_##T *sv, T const *array, uvec_uint n);   \
+    /** @endcond */
+
+/**
+ * Generates function definitions for the specified shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ * @param SCOPE [scope] Scope of the definitions.
+ */
+#define P_UVEC_IMPL_SHARED(T, SCOPE)                                                                \
+                                                                                                    \
+    static inline void p_uvec_shared_bind_##T(UVecShared_##T *sv) {                                 \
+        size_t const offset = (size_t)sv->header->data_offset;                                      \
+        size_t capacity = (sv->size - offset) / sizeof(T);                                          \
+        if (capacity > UVEC_UINT_MAX) capacity = UVEC_UINT_MAX;                                     \
+        sv->vec.allocated = (uvec_uint)capacity;                                                    \
+        sv->vec.storage = capacity ? (T *)(void *)((char *)sv->header + offset) : NULL;             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_shared_refresh_##T(UVecShared_##T *sv) {                                    \
+        if (sv->writer) return UVEC_OK;                                                             \
+        p_uvec_shared_header *header = sv->header;                                                  \
+        uint64_t count = p_uvec_atomic_load(&header->count, P_UVEC_MO_ACQUIRE);                     \
+        uint64_t generation = p_uvec_atomic_load(&header->generation, P_UVEC_MO_ACQUIRE);           \
+                                                                                                    \
+        if (generation != sv->generation) {                                                         \
+            uint64_t capacity = p_uvec_atomic_load(&header->capacity, P_UVEC_MO_ACQUIRE);           \
+            uint64_t size = header->data_offset + capacity * sizeof(T);                             \
+            if (size > SIZE_MAX) return UVEC_ERR;                                                   \
+                                                                                                    \
+            void *map = p_uvec_mapped_remap(header, sv->size, (size_t)size, sv->fd, PROT_READ);     \
+            if (map == MAP_FAILED) return UVEC_ERR;                                                 \
+                                                                                                    \
+            sv->header = map;                                                                       \
+            sv->size = (size_t)size;                                                                \
+            sv->generation = generation;                                                            \
+            p_uvec_shared_bind_##T(sv);                                                             \
+        }                                                                                           \
+                                                                                                    \
+        sv->vec.count = count > sv->vec.allocated ? sv->vec.allocated : (uvec_uint)count;           \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    static inline UVecShared_##T* p_uvec_shared_alloc_##T(int fd, bool writer) {                    \
+        UVecShared_##T *sv = UVEC_MALLOC(sizeof(*sv));                                              \
+        if (!sv) goto err;                                                                          \
+                                                                                                    \
+        sv->header = p_uvec_shared_map(fd, writer, sizeof(T), &sv->size);                           \
+        if (!sv->header) goto err;                                                                  \
+                                                                                                    \
+        sv->fd = fd;                                                                                \
+        sv->writer = writer;                                                                        \
+        sv->generation = 0;                                                                         \
+        sv->vec = uvec_init(T);                                                                     \
+        p_uvec_shared_bind_##T(sv);                                                                 \
+                                                                                                    \
+        if (!writer && uvec_shared_refresh_##T(sv)) {                                               \
+            munmap(sv->header, sv->size);                                                           \
+            goto err;                                                                               \
+        }                                                                                           \
+                                                                                                    \
+        return sv;                                                                                  \
+                                                                                                    \
+    err:                                                                                            \
+        {                                                                                           \
+            int const error = errno;                                                                \
+            UVEC_FREE(sv);                                                                          \
+            close(fd);                                                                              \
+            errno = error;                                                                          \
+        }                                                                                           \
+        return NULL;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecShared_##T* uvec_shared_create_##T(char const *name) {                                \
+        int fd = name ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600) : p_uvec_shared_anon();     \
+        if (fd < 0) return NULL;                                                                    \
+        UVecShared_##T *sv = p_uvec_shared_alloc_##T(fd, true);                                     \
+        if (!sv && name) shm_unlink(name);                                                          \
+        return sv;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecShared_##T* uvec_shared_open_##T(char const *name) {                                  \
+        int fd = shm_open(name, O_RDONLY, 0);                                                       \
+        return fd < 0 ? NULL : p_uvec_shared_alloc_##T(fd, false);                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE UVecShared_##T* uvec_shared_open_fd_##T(int fd) {                                         \
+        fd = dup(fd);                                                                               \
+        return fd < 0 ? NULL : p_uvec_shared_alloc_##T(fd, false);                                  \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_shared_close_##T(UVecShared_##T *sv) {                                      \
+        if (!sv) return UVEC_OK;                                                                    \
+        uvec_ret ret = munmap(sv->header, sv->size) ? UVEC_ERR : UVEC_OK;                           \
+        if (close(sv->fd)) ret = UVEC_ERR;                                                          \
+        UVEC_FREE(sv);                                                                              \
+        return ret;                                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_shared_reserve_##T(UVecShared_##T *sv, uvec_uint capacity) {                \
+        if (!sv->writer) return UVEC_ERR;                                                           \
+        if (sv->vec.allocated >= capacity) return UVEC_OK;                                          \
+                                                                                                    \
+        uvec_uint new_capacity = capacity;                                                          \
+        p_uvec_uint_next_power_2(new_capacity);                                                     \
+        if (new_capacity < capacity) new_capacity = capacity;                                       \
+                                                                                                    \
+        size_t const offset = (size_t)sv->header->data_offset;                                      \
+        size_t const size = offset + sizeof(T) * new_capacity;                                      \
+        if ((size - offset) / sizeof(T) != new_capacity) return UVEC_ERR;                           \
+        if (ftruncate(sv->fd, (off_t)size)) return UVEC_ERR;                                        \
+                                                                                                    \
+        void *map = p_uvec_mapped_remap(sv->header, sv->size, size, sv->fd,                         \
+                                        PROT_READ | PROT_WRITE);                                    \
+        if (map == MAP_FAILED) return UVEC_ERR;                                                     \
+                                                                                                    \
+        sv->header = map;                                                                           \
+        sv->size = size;                                                                            \
+        p_uvec_shared_bind_##T(sv);                                                                 \
+                                                                                                    \
+        p_uvec_atomic_store(&sv->header->capacity, new_capacity, P_UVEC_MO_RELEASE);                \
+        p_uvec_atomic_store(&sv->header->generation, ++sv->generation, P_UVEC_MO_RELEASE);          \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_shared_push_##T(UVecShared_##T *sv, T item) {                               \
+        if (sv->vec.count == UVEC_UINT_MAX ||                                                       \
+            uvec_shared_reserve_##T(sv, sv->vec.count + 1)) return UVEC_ERR;                        \
+        sv->vec.storage[sv->vec.count++] = item;                                                    \
+        p_uvec_atomic_store(&sv->header->count, sv->vec.count, P_UVEC_MO_RELEASE);                  \
+        return UVEC_OK;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    SCOPE uvec_ret uvec_shared_append_array_##T(UVecShared_##T *sv, T const *array, uvec_uint n) {  \
+        if (!n) return UVEC_OK;                                                                     \
+        if (n > UVEC_UINT_MAX - sv->vec.count ||                                                    \
+            uvec_shared_reserve_##T(sv, sv->vec.count + n)) return UVEC_ERR;                        \
+        memcpy(sv->vec.storage + sv->vec.count, array, n * sizeof(T));                              \
+        sv->vec.count += n;                                                                         \
+        p_uvec_atomic_store(&sv->header->count, sv->vec.count, P_UVEC_MO_RELEASE);                  \
+        return UVEC_OK;                                                                             \
+    }
+
+// ##############
+// # Public API #
+// ##############
+
+/// @name Type definitions
+
+/**
+ * Declares a new shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been declared.
+ *
+ * @public @related UVecShared
+ */
+#define UVEC_DECL_SHARED(T)                                                                         \
+    P_UVEC_DEF_TYPE_SHARED(T)                                                                       \
+    P_UVEC_DECL_SHARED(T, p_uvec_unused)
+
+/**
+ * Declares a new shared vector type, prepending a specifier to the generated declarations.
+ *
+ * @param T [symbol] Vector type.
+ * @param SPEC [specifier] Specifier.
+ *
+ * @public @related UVecShared
+ */
+#define UVEC_DECL_SHARED_SPEC(T, SPEC)                                                              \
+    P_UVEC_DEF_TYPE_SHARED(T)                                                                       \
+    P_UVEC_DECL_SHARED(T, SPEC p_uvec_unused)
+
+/**
+ * Implements a previously declared shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecShared
+ */
+#define UVEC_IMPL_SHARED(T) \
+    P_UVEC_IMPL_SHARED(T, p_uvec_unused)
+
+/**
+ * Defines a new static shared vector type.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @note The UVec(T) type must have already been defined.
+ *
+ * @public @related UVecShared
+ */
+#define UVEC_INIT_SHARED(T)                                                                         \
+    P_UVEC_DEF_TYPE_SHARED(T)                                                                       \
+    P_UVEC_IMPL_SHARED(T, p_uvec_static_inline)
+
+/// @name Declaration
+
+/**
+ * Declares a new shared vector variable.
+ *
+ * @param T [symbol] Vector type.
+ *
+ * @public @related UVecShared
+ */
+#define UVecShared(T) P_UVEC_CONCAT(UVecShared_, T)
+
+/// @name Memory management
+
+/**
+ * Creates a new, empty shared vector, returning its writer.
+ *
+ * @param T [symbol] Vector type.
+ * @param name [char const*] Name of the shared memory object (see shm_open), which must not
+ *                           exist. If NULL, an anonymous object is created, which can be
+ *                           shared by passing its file descriptor to other processes.
+ * @return [UVecShared(T)*] Writer instance, or NULL on error.
+ *
+ * @note Named objects persist until they are removed via shm_unlink.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_create(T, name) P_UVEC_CONCAT(uvec_shared_create_, T)(name)
+
+/**
+ * Opens a reader of the specified named shared vector.
+ *
+ * @param T [symbol] Vector type.
+ * @param name [char const*] Name of the shared memory object.
+ * @return [UVecShared(T)*] Reader instance, or NULL on error.
+ *
+ * @note If the object is not a shared vector of type T, errno is set to EINVAL.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_open(T, name) P_UVEC_CONCAT(uvec_shared_open_, T)(name)
+
+/**
+ * Opens a reader of the shared vector referenced by the specified file descriptor,
+ * such as one inherited from the writer's process or received over a Unix socket.
+ *
+ * @param T [symbol] Vector type.
+ * @param fd [int] File descriptor, which is duplicated.
+ * @return [UVecShared(T)*] Reader instance, or NULL on error.
+ *
+ * @note If the object is not a shared vector of type T, errno is set to EINVAL.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_open_fd(T, fd) P_UVEC_CONCAT(uvec_shared_open_fd_, T)(fd)
+
+/**
+ * Unmaps and closes the specified writer or reader.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecShared(T)*] Vector instance.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @note The instance is deallocated even if the operation fails.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_close(T, sv) P_UVEC_CONCAT(uvec_shared_close_, T)(sv)
+
+/// @name Primitives
+
+/**
+ * Returns the file descriptor of the shared memory object.
+ *
+ * @param sv [UVecShared(T)*] Vector instance.
+ * @return [int] File descriptor.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_fd(sv) ((sv)->fd)
+
+/**
+ * Returns a vector view of the shared storage. For readers, the view contains
+ * the elements published as of the last call to uvec_shared_refresh.
+ *
+ * @param sv [UVecShared(T)*] Vector instance.
+ * @return [UVec(T)*] Vector view.
+ *
+ * @warning The view must not be passed to functions that modify the vector,
+ *          nor copied in copy-on-write mode. Refreshing a reader or growing a writer
+ *          invalidates pointers to its elements.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_vec(sv) (&(sv)->vec)
+
+/**
+ * Updates a reader with the elements published by the writer, remapping
+ * the shared memory object if it has grown. Does nothing for writers.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecShared(T)*] Vector instance.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR.
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_refresh(T, sv) P_UVEC_CONCAT(uvec_shared_refresh_, T)(sv)
+
+/**
+ * Ensures that the specified writer can hold at least as many elements as 'capacity',
+ * growing the shared memory object if needed.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecShared(T)*] Writer instance.
+ * @param capacity [uvec_uint] Capacity.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if 'sv' is a reader).
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_reserve(T, sv, capacity) \
+    P_UVEC_CONCAT(uvec_shared_reserve_, T)(sv, capacity)
+
+/**
+ * Pushes the specified element to the top of the vector and publishes it to readers.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecShared(T)*] Writer instance.
+ * @param item [T] Element to push.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if 'sv' is a reader).
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_push(T, sv, item) P_UVEC_CONCAT(uvec_shared_push_, T)(sv, item)
+
+/**
+ * Appends the specified array to the vector and publishes its elements to readers.
+ *
+ * @param T [symbol] Vector type.
+ * @param sv [UVecShared(T)*] Writer instance.
+ * @param array [T const*] Array to append.
+ * @param n [uvec_uint] Number of elements to append.
+ * @return [uvec_ret] UVEC_OK on success, otherwise UVEC_ERR (also if 'sv' is a reader).
+ *
+ * @public @related UVecShared
+ */
+#define uvec_shared_append_array(T, sv, array, n) \
+    P_UVEC_CONCAT(uvec_shared_append_array_, T)(sv, array, n)
+
+#endif // UVEC_SHARED_H
@@ -9,9 +9,32 @@
  * @file
  */
 
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
 #include "uvec.h"
+#include "uvec_concurrent.h"
+#include "uvec_incremental.h"
+#include "uvec_io.h"
+#include "uvec_mapped.h"
+#include "uvec_persistent.h"
+#include "uvec_queue.h"
+#include "uvec_shared.h"
+#include <fcntl.h>
 #include <stdio.h>
 
+#ifdef UVEC_TEST_PTHREADS
+    #include "uvec_async.h"
+    #include "uvec_collector.h"
+    #include "uvec_external.h"
+    #include "uvec_log.h"
+    #include "uvec_parallel.h"
+    #include "uvec_rcu.h"
+    #include "uvec_sharded.h"
+    #include <pthread.h>
+#endif
+
 /// @name Utility macros
 
 #define array_size(array) (sizeof(array) / sizeof(*(array)))
@@ -36,6 +59,23 @@
 /// @name Type definitions
 
 UVEC_INIT_IDENTIFIABLE(int)
+UVEC_INIT_PERSISTENT(int)
+UVEC_INIT_CONCURRENT(int)
+UVEC_INIT_INCREMENTAL(int)
+UVEC_INIT_IO(int)
+UVEC_INIT_MAPPED(int)
+UVEC_INIT_QUEUE(int)
+UVEC_INIT_SHARED(int)
+
+#ifdef UVEC_TEST_PTHREADS
+    UVEC_INIT_ASYNC(int)
+    UVEC_INIT_COLLECTOR_COMPARABLE(int)
+    UVEC_INIT_EXTERNAL(int)
+    UVEC_INIT_LOG(int)
+    UVEC_INIT_PARALLEL_IDENTIFIABLE(int)
+    UVEC_INIT_RCU(int)
+    UVEC_INIT_SHARDED(int)
+#endif
 
 static int int_comparator(const void * a, const void * b) {
     int va = *(const int*)a;
@@ -205,6 +245,1516 @@ static bool test_qsort_reverse(void) {
     return true;
 }
 
+#ifdef UVEC_COW
+
+static bool test_cow(void) {
+    UVec(int) *v1 = uvec_alloc(int);
+    uvec_ret ret = uvec_append_items(int, v1, 3, 2, 4, 1);
+    uvec_assert(ret == UVEC_OK);
+
+    UVec(int) *v2 = uvec_copy(int, v1);
+    UVec(int) *v3 = uvec_copy(int, v2);
+    uvec_assert(v2 && v3);
+    uvec_assert(v1->storage == v2->storage && v2->storage == v3->storage);
+
+    ret = uvec_push(int, v2, 5);
+    uvec_assert(ret == UVEC_OK);
+    uvec_assert(v1->storage != v2->storage && v1->storage == v3->storage);
+    uvec_assert_elements(int, v1, 3, 2, 4, 1);
+    uvec_assert_elements(int, v2, 3, 2, 4, 1, 5);
+
+    uvec_set(v3, 0, 0);
+    uvec_assert(v1->storage != v3->storage);
+    uvec_assert_elements(int, v1, 3, 2, 4, 1);
+    uvec_assert_elements(int, v3, 0, 2, 4, 1);
+
+    uvec_free(int, v2);
+    v2 = uvec_copy(int, v1);
+    uvec_sort(int, v2);
+    uvec_assert_elements(int, v1, 3, 2, 4, 1);
+    uvec_assert_elements(int, v2, 1, 2, 3, 4);
+
+    uvec_free(int, v2);
+    v2 = uvec_copy(int, v1);
+    uvec_free(int, v1);
+    uvec_reverse(int, v2);
+    uvec_assert_elements(int, v2, 1, 4, 2, 3);
+
+    v1 = uvec_copy(int, v2);
+    uvec_remove_at(int, v1, 0);
+    ret = uvec_insert_at(int, v2, 0, 0);
+    uvec_assert(ret == UVEC_OK);
+    uvec_assert_elements(int, v1, 4, 2, 3);
+    uvec_assert_elements(int, v2, 0, 1, 4, 2, 3);
+
+    UVec(int) v4 = uvec_init(int);
+    ret = uvec_append(int, &v4, v3);
+    uvec_assert(ret == UVEC_OK);
+    uvec_free(int, v3);
+    v3 = uvec_copy(int, &v4);
+    uvec_deinit(v4);
+    uvec_assert_elements(int, v3, 0, 2, 4, 1);
+
+    uvec_free(int, v1);
+    uvec_free(int, v2);
+    uvec_free(int, v3);
+    return true;
+}
+
+#endif
+
+static bool persistent_equals_array(UVecPersistent(int) const *pv, int const *array, uvec_uint n) {
+    if (uvec_persistent_count(pv) != n) return false;
+
+    uvec_persistent_iterate(int, pv, item, idx, {
+        if (item != array[idx] || uvec_persistent_get(int, pv, idx) != item) return false;
+    });
+
+    return true;
+}
+
+static bool test_persistent(void) {
+    uvec_uint const n = 40000;
+    int *array = UVEC_MALLOC(n * sizeof(*array));
+    for (uvec_uint i = 0; i < n; ++i) array[i] = (int)i;
+
+    // Push
+    UVecPersistent(int) *pv = uvec_persistent_alloc(int), *empty = pv;
+    uvec_assert(pv && uvec_persistent_count(pv) == 0);
+
+    UVecPersistent(int) *versions[4] = { NULL };
+
+    for (uvec_uint i = 0; i < n; ++i) {
+        UVecPersistent(int) *next = uvec_persistent_push(int, pv, array[i]);
+        uvec_assert(next);
+        if (i % 10000 == 0) versions[i / 10000] = pv;
+        else if (pv != empty) uvec_persistent_free(int, pv);
+        pv = next;
+    }
+
+    uvec_assert(persistent_equals_array(pv, array, n));
+    uvec_assert(persistent_equals_array(empty, array, 0));
+
+    for (uvec_uint i = 1; i < 4; ++i) {
+        uvec_assert(persistent_equals_array(versions[i], array, i * 10000));
+    }
+
+    // Set
+    UVecPersistent(int) *set = uvec_persistent_set(int, pv, 1234, -1);
+    uvec_assert(set);
+    uvec_assert(uvec_persistent_get(int, set, 1234) == -1);
+    uvec_assert(uvec_persistent_get(int, pv, 1234) == 1234);
+    uvec_persistent_free(int, set);
+
+    // Transient
+    UVecPersistent(int) *tv = uvec_persistent_transient(int, empty);
+    uvec_assert(tv);
+    uvec_assert(!uvec_persistent_push(int, tv, 0));
+
+    for (uvec_uint i = 0; i < n; ++i) {
+        uvec_assert(uvec_transient_push(int, tv, array[i]) == UVEC_OK);
+    }
+
+    uvec_assert(uvec_transient_set(int, tv, 7, -7) == UVEC_OK);
+    uvec_transient_persist(int, tv);
+    set = uvec_persistent_set(int, tv, 7, 7);
+    uvec_assert(set && uvec_persistent_get(int, tv, 7) == -7);
+    uvec_assert(persistent_equals_array(set, array, n));
+    uvec_persistent_free(int, tv);
+    uvec_persistent_free(int, set);
+
+    // Slice and concatenation
+    UVecPersistent(int) *pieces = uvec_persistent_from_array(int, array, 0);
+    uint32_t seed = 7;
+
+    for (uvec_uint start = 0; start < n;) {
+        seed = seed * 1103515245 + 12345;
+        uvec_uint len = (seed >> 16) % 3000 + 1;
+        if (len > n - start) len = n - start;
+
+        UVecPersistent(int) *slice = uvec_persistent_slice(int, pv, start, len);
+        uvec_assert(slice);
+        uvec_assert(persistent_equals_array(slice, array + start, len));
+
+        UVecPersistent(int) *concat = uvec_persistent_concat(int, pieces, slice);
+        uvec_assert(concat);
+        uvec_persistent_free(int, pieces);
+        uvec_persistent_free(int, slice);
+        pieces = concat;
+        start += len;
+        uvec_assert(persistent_equals_array(pieces, array, start));
+    }
+
+    UVecPersistent(int) *doubled = uvec_persistent_concat(int, pieces, pieces);
+    uvec_assert(doubled && uvec_persistent_count(doubled) == 2 * n);
+    UVecPersistent(int) *half = uvec_persistent_slice(int, doubled, n / 2, n);
+    uvec_assert(half);
+    uvec_assert(uvec_persistent_count(half) == n);
+
+    uvec_persistent_iterate(int, half, item, idx, {
+        uvec_assert(item == array[(idx + n / 2) % n]);
+    });
+
+    // Conversion
+    UVec(int) *v = uvec_persistent_to_vec(int, pieces);
+    uvec_assert(v && v->count == n && memcmp(v->storage, array, n * sizeof(*array)) == 0);
+    UVecPersistent(int) *from_vec = uvec_persistent_from_vec(int, v);
+    uvec_assert(persistent_equals_array(from_vec, array, n));
+
+    for (uvec_uint i = 1; i < 4; ++i) uvec_persistent_free(int, versions[i]);
+    uvec_persistent_free(int, versions[0]);
+    uvec_persistent_free(int, pv);
+    uvec_persistent_free(int, pieces);
+    uvec_persistent_free(int, doubled);
+    uvec_persistent_free(int, half);
+    uvec_persistent_free(int, from_vec);
+    uvec_free(int, v);
+    UVEC_FREE(array);
+    return true;
+}
+
+#ifdef UVEC_TEST_PTHREADS
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_ITEMS 50000
+
+typedef struct ConcurrentProducer {
+    UVecConcurrent(int) *cvec;
+    int base;
+} ConcurrentProducer;
+
+static void* concurrent_producer(void *data) {
+    UVecConcurrent(int) *cvec = ((ConcurrentProducer *)data)->cvec;
+    int base = ((ConcurrentProducer *)data)->base;
+    int block[100];
+
+    for (int i = 0; i < CONCURRENT_ITEMS / 2; ++i) {
+        if (uvec_concurrent_push(int, cvec, base + i)) return cvec;
+    }
+
+    for (int i = CONCURRENT_ITEMS / 2; i < CONCURRENT_ITEMS; i += 100) {
+        for (int j = 0; j < 100; ++j) block[j] = base + i + j;
+        if (uvec_concurrent_append_array(int, cvec, block, 100)) return cvec;
+    }
+
+    return NULL;
+}
+
+#endif
+
+static bool test_concurrent(void) {
+    UVecConcurrent(int) *cvec = uvec_concurrent_alloc(int);
+    uvec_assert(cvec);
+
+    // Single-threaded
+    uvec_uint const n = 10000;
+    for (uvec_uint i = 0; i < n; ++i) {
+        uvec_assert(uvec_concurrent_push(int, cvec, (int)i) == UVEC_OK);
+    }
+    uvec_assert(uvec_concurrent_count(cvec) == n);
+
+    uvec_uint idx = uvec_concurrent_reserve(int, cvec, 1000);
+    uvec_assert(idx == n);
+    for (uvec_uint i = idx; i < idx + 1000; ++i) *uvec_concurrent_at(int, cvec, i) = (int)i;
+    for (uvec_uint i = 0; i < n + 1000; ++i) {
+        uvec_assert(uvec_concurrent_get(int, cvec, i) == (int)i);
+    }
+
+    UVec(int) *v = uvec_concurrent_seal(int, cvec);
+    uvec_assert(v && v->count == n + 1000 && uvec_concurrent_count(cvec) == 0);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+    uvec_free(int, v);
+
+#ifdef UVEC_TEST_PTHREADS
+    // Multi-threaded
+    pthread_t threads[CONCURRENT_THREADS];
+    ConcurrentProducer producers[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        producers[i] = (ConcurrentProducer){ .cvec = cvec, .base = (int)i * CONCURRENT_ITEMS };
+        uvec_assert(pthread_create(&threads[i], NULL, concurrent_producer, &producers[i]) == 0);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    v = uvec_concurrent_seal(int, cvec);
+    uvec_assert(v && v->count == CONCURRENT_THREADS * CONCURRENT_ITEMS);
+    uvec_sort(int, v);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+    uvec_free(int, v);
+#endif
+
+    uvec_concurrent_free(int, cvec);
+    return true;
+}
+
+static bool test_incremental(void) {
+    UVecIncremental(int) *iv = uvec_incremental_alloc(int);
+    uvec_assert(iv);
+
+    // Migration completes before the new buffer fills up
+    uvec_uint const n = 1024;
+    for (uvec_uint i = 0; i < n; ++i) {
+        uvec_assert(uvec_incremental_push(int, iv, (int)i) == UVEC_OK);
+        if (uvec_incremental_count(iv) == uvec_incremental_capacity(iv)) {
+            uvec_assert(!uvec_incremental_migrating(iv));
+        }
+    }
+    uvec_assert(uvec_incremental_count(iv) == n && !uvec_incremental_migrating(iv));
+
+    // Growth leaves most elements in the old buffer
+    uvec_assert(uvec_incremental_push(int, iv, (int)n) == UVEC_OK);
+    uvec_assert(uvec_incremental_migrating(iv) && uvec_incremental_capacity(iv) == 2 * n);
+    for (uvec_uint i = 0; i <= n; ++i) uvec_assert(uvec_incremental_get(int, iv, i) == (int)i);
+
+    uvec_incremental_set(int, iv, 0, -1);
+    uvec_assert(uvec_incremental_get(int, iv, 0) == -1);
+    uvec_incremental_set(int, iv, 0, 0);
+
+    uvec_assert(uvec_incremental_pop(int, iv) == (int)n);
+    uvec_assert(uvec_incremental_pop(int, iv) == (int)n - 1);
+    uvec_assert(uvec_incremental_count(iv) == n - 1 && uvec_incremental_migrating(iv));
+
+    // Appends migrate elements proportionally
+    int array[600];
+    for (uvec_uint i = 0; i < array_size(array); ++i) array[i] = (int)(n - 1 + i);
+    uvec_assert(uvec_incremental_append_array(int, iv, array, array_size(array)) == UVEC_OK);
+    uvec_assert(!uvec_incremental_migrating(iv));
+
+    UVec(int) *v = uvec_incremental_vec(int, iv);
+    uvec_assert(v->count == n - 1 + array_size(array));
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+
+    // Removals during migration
+    while (!uvec_incremental_migrating(iv)) {
+        uvec_assert(uvec_incremental_push(int, iv, (int)uvec_incremental_count(iv)) == UVEC_OK);
+    }
+
+    for (uvec_uint i = uvec_incremental_count(iv); i-- != 0;) {
+        uvec_assert(uvec_incremental_pop(int, iv) == (int)i);
+    }
+    uvec_assert(uvec_incremental_count(iv) == 0 && !uvec_incremental_migrating(iv));
+
+    // Flush
+    while (!uvec_incremental_migrating(iv)) {
+        uvec_assert(uvec_incremental_push(int, iv, (int)uvec_incremental_count(iv)) == UVEC_OK);
+    }
+    uvec_incremental_flush(int, iv);
+    uvec_assert(!uvec_incremental_migrating(iv));
+    v = uvec_incremental_vec(int, iv);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+
+#ifdef UVEC_COW
+    // Writes do not affect copies sharing storage
+    UVec(int) *copy = uvec_copy(int, v);
+    uvec_assert(copy && copy->storage == v->storage);
+    uvec_incremental_set(int, iv, 0, -1);
+    uvec_assert(uvec_incremental_get(int, iv, 0) == -1 && uvec_get(copy, 0) == 0);
+    uvec_free(int, copy);
+#endif
+
+    uvec_incremental_remove_all(int, iv);
+    uvec_assert(uvec_incremental_count(iv) == 0);
+    uvec_incremental_free(int, iv);
+    return true;
+}
+
+#ifdef UVEC_TEST_PTHREADS
+
+typedef struct CollectorProducer {
+    UVec(int) *vec;
+    int base;
+    bool reverse;
+} CollectorProducer;
+
+static void* collector_producer(void *data) {
+    CollectorProducer *p = data;
+
+    for (int i = 0; i < CONCURRENT_ITEMS; ++i) {
+        int item = p->reverse ? CONCURRENT_THREADS * (CONCURRENT_ITEMS - i) - p->base - 1
+                              : p->base + i;
+        if (uvec_push(int, p->vec, item)) return p;
+    }
+
+    return NULL;
+}
+
+static bool collector_run(UVecCollector(int) *col, bool reverse) {
+    pthread_t threads[CONCURRENT_THREADS];
+    CollectorProducer producers[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        producers[i] = (CollectorProducer) {
+            .vec = uvec_collector_vec(col, i),
+            .base = reverse ? (int)i : (int)i * CONCURRENT_ITEMS,
+            .reverse = reverse
+        };
+        uvec_assert(pthread_create(&threads[i], NULL, collector_producer, &producers[i]) == 0);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    return uvec_collector_count(int, col) == CONCURRENT_THREADS * CONCURRENT_ITEMS;
+}
+
+static bool test_collector(void) {
+    UVecCollector(int) *col = uvec_collector_alloc(int, CONCURRENT_THREADS);
+    uvec_assert(col);
+
+    UVec(int) *v = uvec_alloc(int);
+    uvec_ret ret = uvec_append_items(int, v, -2, -1);
+    uvec_assert(ret == UVEC_OK);
+
+    // Small, sequential combine
+    for (int i = 0; i < 3; ++i) {
+        for (unsigned j = 0; j < CONCURRENT_THREADS; ++j) {
+            ret = uvec_push(int, uvec_collector_vec(col, j), (int)j * 3 + i);
+            uvec_assert(ret == UVEC_OK);
+        }
+    }
+
+    uvec_assert(uvec_collector_combine_sorted(int, col, v) == UVEC_OK);
+    uvec_assert(v->count == CONCURRENT_THREADS * 3 + 2 && uvec_collector_count(int, col) == 0);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i - 2); });
+    uvec_remove_all(int, v);
+
+    // Parallel combine
+    uvec_assert(collector_run(col, false));
+    uvec_assert(uvec_collector_combine(int, col, v) == UVEC_OK);
+    uvec_assert(v->count == CONCURRENT_THREADS * CONCURRENT_ITEMS);
+    uvec_assert(uvec_collector_count(int, col) == 0);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+    uvec_remove_all(int, v);
+
+    // Parallel sorted merge
+    uvec_assert(collector_run(col, true));
+    uvec_assert(uvec_collector_combine_sorted(int, col, v) == UVEC_OK);
+    uvec_assert(v->count == CONCURRENT_THREADS * CONCURRENT_ITEMS);
+    uvec_iterate(int, v, item, i, { uvec_assert(item == (int)i); });
+    uvec_free(int, v);
+
+#ifdef UVEC_COW
+    // Destination sharing storage and spare capacity with a copy
+    v = uvec_alloc(int);
+    uvec_assert(uvec_append_items(int, v, 1, 2, 3) == UVEC_OK);
+    UVec(int) *copy = uvec_copy(int, v);
+    uvec_assert(copy && copy->storage == v->storage && v->allocated > v->count);
+
+    uvec_assert(uvec_push(int, uvec_collector_vec(col, 0), 100) == UVEC_OK);
+    uvec_assert(uvec_collector_combine(int, col, v) == UVEC_OK);
+    uvec_assert(uvec_push(int, uvec_collector_vec(col, 0), 200) == UVEC_OK);
+    uvec_assert(uvec_collector_combine_sorted(int, col, copy) == UVEC_OK);
+    uvec_assert_elements(int, v, 1, 2, 3, 100);
+    uvec_assert_elements(int, copy, 1, 2, 3, 200);
+
+    uvec_free(int, copy);
+    copy = uvec_copy(int, v);
+    uvec_assert(uvec_push(int, uvec_collector_vec(col, 0), 300) == UVEC_OK);
+    uvec_assert(uvec_collector_combine_sorted(int, col, v) == UVEC_OK);
+    uvec_assert_elements(int, v, 1, 2, 3, 100, 300);
+    uvec_assert_elements(int, copy, 1, 2, 3, 100);
+
+    uvec_free(int, copy);
+    uvec_free(int, v);
+#endif
+
+    uvec_collector_free(int, col);
+    return true;
+}
+
+#endif
+
+#ifdef UVEC_TEST_PTHREADS
+
+#define QUEUE_ITEMS 100000
+
+static void* spsc_producer(void *data) {
+    UVecSpscQueue(int) *q = data;
+    int block[37];
+
+    for (int i = 0; i < QUEUE_ITEMS; i += (int)array_size(block)) {
+        uvec_uint n = array_size(block);
+        if (n > (uvec_uint)(QUEUE_ITEMS - i)) n = (uvec_uint)(QUEUE_ITEMS - i);
+        for (uvec_uint j = 0; j < n; ++j) block[j] = i + (int)j;
+        uvec_spsc_push_array_wait(int, q, block, n);
+    }
+
+    return NULL;
+}
+
+typedef struct QueueWorker {
+    UVecMpmcQueue(int) *q;
+    int id;
+    long long sum;
+} QueueWorker;
+
+static void* mpmc_push_worker(void *data) {
+    QueueWorker *w = data;
+    int block[16];
+
+    for (int i = 0; i < QUEUE_ITEMS / 2; ++i) {
+        uvec_mpmc_push_wait(int, w->q, (w->id << 24) | i);
+    }
+
+    for (int i = QUEUE_ITEMS / 2; i < QUEUE_ITEMS; i += (int)array_size(block)) {
+        for (uvec_uint j = 0; j < array_size(block); ++j) block[j] = (w->id << 24) | (i + (int)j);
+        uvec_mpmc_push_array_wait(int, w->q, block, array_size(block));
+    }
+
+    return NULL;
+}
+
+static void* mpmc_pop_worker(void *data) {
+    QueueWorker *w = data;
+    int last[2] = { -1, -1 }, block[16];
+    uvec_uint remaining = QUEUE_ITEMS;
+
+    while (remaining) {
+        uvec_uint n = array_size(block) < remaining ? array_size(block) : remaining;
+        if (w->id) n = uvec_mpmc_pop_array_wait(int, w->q, block, n);
+        else block[0] = uvec_mpmc_pop_wait(int, w->q), n = 1;
+
+        for (uvec_uint i = 0; i < n; ++i) {
+            int producer = block[i] >> 24, seq = block[i] & 0xFFFFFF;
+            if (seq <= last[producer]) return w;
+            last[producer] = seq;
+            w->sum += block[i];
+        }
+
+        remaining -= n;
+    }
+
+    return NULL;
+}
+
+#endif
+
+static bool test_queue(void) {
+    int array[8];
+
+    // SPSC
+    UVecSpscQueue(int) *sq = uvec_spsc_alloc(int, 5);
+    uvec_assert(sq);
+
+    for (int i = 0; i < 8; ++i) uvec_assert(uvec_spsc_push(int, sq, i) == UVEC_OK);
+    uvec_assert(uvec_spsc_push(int, sq, 8) == UVEC_NO);
+
+    for (int i = 0; i < 3; ++i) {
+        int item;
+        uvec_assert(uvec_spsc_pop(int, sq, &item) == UVEC_OK && item == i);
+    }
+
+    int const more[] = { 8, 9, 10, 11, 12 };
+    uvec_assert(uvec_spsc_push_array(int, sq, more, array_size(more)) == 3);
+    uvec_assert(uvec_spsc_pop_array(int, sq, array, array_size(array)) == 8);
+    for (int i = 0; i < 8; ++i) uvec_assert(array[i] == i + 3);
+    uvec_assert(uvec_spsc_pop_array(int, sq, array, array_size(array)) == 0);
+
+    // MPMC
+    UVecMpmcQueue(int) *mq = uvec_mpmc_alloc(int, 8);
+    uvec_assert(mq);
+
+    for (int i = 0; i < 8; ++i) uvec_assert(uvec_mpmc_push(int, mq, i) == UVEC_OK);
+    uvec_assert(uvec_mpmc_push(int, mq, 8) == UVEC_NO);
+    uvec_assert(uvec_mpmc_push_array(int, mq, more, array_size(more)) == 0);
+
+    for (int i = 0; i < 3; ++i) {
+        int item;
+        uvec_assert(uvec_mpmc_pop(int, mq, &item) == UVEC_OK && item == i);
+    }
+
+    uvec_assert(uvec_mpmc_push_array(int, mq, more, array_size(more)) == 3);
+    uvec_assert(uvec_mpmc_pop_array(int, mq, array, array_size(array)) == 8);
+    for (int i = 0; i < 8; ++i) uvec_assert(array[i] == i + 3);
+    uvec_assert(uvec_mpmc_pop_array(int, mq, array, array_size(array)) == 0);
+
+#ifdef UVEC_TEST_PTHREADS
+    // SPSC, threaded
+    pthread_t producer, threads[4];
+    uvec_assert(pthread_create(&producer, NULL, spsc_producer, sq) == 0);
+
+    for (int expected = 0; expected < QUEUE_ITEMS;) {
+        uvec_uint n = uvec_spsc_pop_array_wait(int, sq, array, array_size(array));
+        for (uvec_uint i = 0; i < n; ++i) uvec_assert(array[i] == expected++);
+    }
+
+    uvec_assert(pthread_join(producer, NULL) == 0);
+
+    // MPMC, threaded
+    QueueWorker workers[4];
+    long long sum = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        workers[i] = (QueueWorker){ .q = mq, .id = i % 2, .sum = 0 };
+        void *(*func)(void *) = i < 2 ? mpmc_push_worker : mpmc_pop_worker;
+        uvec_assert(pthread_create(&threads[i], NULL, func, &workers[i]) == 0);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+        sum += workers[i].sum;
+    }
+
+    long long expected_sum = (1LL << 24) * QUEUE_ITEMS;
+    expected_sum += (long long)QUEUE_ITEMS * (QUEUE_ITEMS - 1);
+    uvec_assert(sum == expected_sum);
+    uvec_assert(uvec_mpmc_pop_array(int, mq, array, array_size(array)) == 0);
+#endif
+
+    uvec_spsc_free(int, sq);
+    uvec_mpmc_free(int, mq);
+    return true;
+}
+
+#ifdef UVEC_TEST_PTHREADS
+
+#define RCU_UPDATES 200
+
+typedef struct RcuReader {
+    UVecRcu(int) *rcu;
+    P_UVEC_ATOMIC(bool) *done;
+} RcuReader;
+
+static void* rcu_reader(void *data) {
+    RcuReader *ctx = data;
+    UVecRcuReader *reader = uvec_rcu_register(ctx->rcu);
+    if (!reader) return ctx;
+
+    void *ret = NULL;
+    uvec_uint last = 0;
+
+    while (!p_uvec_atomic_load(ctx->done, P_UVEC_MO_ACQUIRE) && !ret) {
+        UVec(int) const *snapshot = uvec_rcu_read_lock(int, ctx->rcu, reader);
+        uvec_uint count = snapshot->count;
+        if (count < last) ret = ctx;
+
+        uvec_iterate(int, snapshot, item, idx, {
+            if (item != (int)count) ret = ctx;
+        });
+
+        uvec_rcu_read_unlock(reader);
+        last = count;
+        sched_yield();
+    }
+
+    uvec_rcu_unregister(reader);
+    return ret;
+}
+
+static bool test_rcu(void) {
+    UVecRcu(int) *rcu = uvec_rcu_alloc(int);
+    uvec_assert(rcu);
+
+    UVecRcuReader *reader = uvec_rcu_register(rcu);
+    uvec_assert(reader);
+
+    // Readers keep seeing their snapshot across updates
+    UVec(int) const *snapshot = uvec_rcu_read_lock(int, rcu, reader);
+    uvec_assert(snapshot->count == 0);
+
+    UVec(int) *vec = uvec_rcu_write_begin(int, rcu);
+    uvec_assert(vec && uvec_push(int, vec, 1) == UVEC_OK);
+    uvec_rcu_write_commit(int, rcu, vec);
+    uvec_assert(snapshot->count == 0);
+    uvec_rcu_read_unlock(reader);
+
+    snapshot = uvec_rcu_read_lock(int, rcu, reader);
+    uvec_assert_elements(int, snapshot, 1);
+    uvec_rcu_read_unlock(reader);
+
+    vec = uvec_rcu_write_begin(int, rcu);
+    uvec_assert(vec && uvec_push(int, vec, 2) == UVEC_OK);
+    uvec_rcu_write_abort(int, rcu, vec);
+
+    snapshot = uvec_rcu_read_lock(int, rcu, reader);
+    uvec_assert_elements(int, snapshot, 1);
+    uvec_rcu_read_unlock(reader);
+    uvec_rcu_synchronize(int, rcu);
+    uvec_rcu_unregister(reader);
+
+    // Concurrent readers
+    P_UVEC_ATOMIC(bool) done;
+    p_uvec_atomic_init(&done, false);
+    RcuReader ctx = { .rcu = rcu, .done = &done };
+    pthread_t threads[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        uvec_assert(pthread_create(&threads[i], NULL, rcu_reader, &ctx) == 0);
+    }
+
+    for (int i = 2; i <= RCU_UPDATES; ++i) {
+        vec = uvec_rcu_write_begin(int, rcu);
+        uvec_assert(vec && uvec_push(int, vec, i) == UVEC_OK);
+        for (uvec_uint j = 0; j < vec->count; ++j) uvec_set(vec, j, i);
+
+        if (i % 2) {
+            uvec_rcu_write_commit(int, rcu, vec);
+        } else {
+            UVec(int) *copy = uvec_copy(int, vec);
+            uvec_rcu_write_abort(int, rcu, vec);
+            uvec_assert(copy);
+            uvec_rcu_replace(int, rcu, copy);
+        }
+    }
+
+    p_uvec_atomic_store(&done, true, P_UVEC_MO_RELEASE);
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    reader = uvec_rcu_register(rcu);
+    uvec_assert(reader);
+    snapshot = uvec_rcu_read_lock(int, rcu, reader);
+    uvec_assert(snapshot->count == RCU_UPDATES);
+    uvec_rcu_read_unlock(reader);
+
+    uvec_rcu_free(int, rcu);
+    return true;
+}
+
+#endif
+
+#ifdef UVEC_TEST_PTHREADS
+
+#define PARALLEL_ITEMS 1000003
+
+static void parallel_increment(int *item, void *ctx) {
+    *item += *(int *)ctx;
+}
+
+static int parallel_double(int item, void *ctx) {
+    (void)ctx;
+    return item * 2;
+}
+
+static int parallel_sum(int lhs, int rhs, void *ctx) {
+    (void)ctx;
+    return lhs + rhs;
+}
+
+static int parallel_last(int lhs, int rhs, void *ctx) {
+    // Associative but not commutative: checks that chunks are combined in order.
+    (void)ctx;
+    return lhs == -1 ? rhs : (rhs == -1 ? lhs : rhs);
+}
+
+static int parallel_copy(int item) {
+    return item + 1;
+}
+
+#define EXTERNAL_TEST_FILE "uvec_external_test.bin"
+#define EXTERNAL_ITEMS 200003
+
+static bool external_sort_check(UVec(int) const *v, size_t memory, char const *tmp_dir) {
+    int in = open(EXTERNAL_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(in >= 0);
+    unlink(EXTERNAL_TEST_FILE);
+    int out = open(EXTERNAL_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(out >= 0);
+    unlink(EXTERNAL_TEST_FILE);
+
+    uvec_assert(uvec_write_fd(int, v, in) == UVEC_OK);
+    uvec_assert(lseek(in, 0, SEEK_SET) == 0);
+    uvec_assert(uvec_external_sort(int, in, out, memory, tmp_dir) == UVEC_OK);
+    uvec_assert(lseek(out, 0, SEEK_SET) == 0);
+
+    UVec(int) *sorted = uvec_copy(int, v);
+    UVec(int) *r = uvec_alloc(int);
+    uvec_assert(sorted && r);
+    uvec_sort(int, sorted);
+    uvec_assert(uvec_read_fd(int, r, out) == UVEC_OK);
+    uvec_assert(uvec_equals(int, r, sorted));
+
+    uvec_free(int, sorted);
+    uvec_free(int, r);
+    close(in);
+    close(out);
+    return true;
+}
+
+static bool test_external(void) {
+    UVec(int) *v = uvec_alloc(int);
+    uint32_t seed = 42;
+
+    for (unsigned i = 0; i < EXTERNAL_ITEMS; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        uvec_assert(uvec_push(int, v, (int)(seed >> 1u)) == UVEC_OK);
+    }
+
+    // Single run, multiple runs, small merge blocks
+    uvec_assert(external_sort_check(v, 0, NULL));
+    uvec_assert(external_sort_check(v, 1 << 16, NULL));
+    uvec_assert(external_sort_check(v, 1 << 12, "."));
+
+    // Duplicates and presorted runs
+    for (uvec_uint i = 0; i < v->count; ++i) v->storage[i] %= 100;
+    uvec_assert(external_sort_check(v, 1 << 16, NULL));
+    uvec_sort(int, v);
+    uvec_assert(external_sort_check(v, 1 << 16, NULL));
+
+    // Corrupted input
+    int in = open(EXTERNAL_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(in >= 0);
+    unlink(EXTERNAL_TEST_FILE);
+    int out = open(EXTERNAL_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(out >= 0);
+    unlink(EXTERNAL_TEST_FILE);
+
+    uvec_assert(uvec_write_fd(int, v, in) == UVEC_OK);
+    uvec_assert(lseek(in, P_UVEC_IO_HEADER_SIZE + 100, SEEK_SET) >= 0);
+    uvec_assert(write(in, "\xFF", 1) == 1);
+    uvec_assert(lseek(in, 0, SEEK_SET) == 0);
+    uvec_assert(uvec_external_sort(int, in, out, 1 << 16, NULL) == UVEC_NO);
+
+    close(in);
+    close(out);
+    uvec_free(int, v);
+    return true;
+}
+
+#define ASYNC_TEST_FILE "uvec_async_test.bin"
+#define ASYNC_VECTORS 64
+
+static void async_count(void *ctx, uvec_ret ret) {
+    if (!ret) ++*(unsigned *)ctx;
+}
+
+static bool async_check(uvec_async_flags flags, int open_flags) {
+    int fd = open(ASYNC_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC | open_flags, 0600);
+    if (fd < 0 && open_flags) return true;
+    uvec_assert(fd >= 0);
+    unlink(ASYNC_TEST_FILE);
+
+    UVecAsync *a = uvec_async_create(8, flags);
+    uvec_assert(a);
+    uvec_assert(!(flags & UVEC_ASYNC_THREADS) || !uvec_async_uses_uring(a));
+
+    UVec(int) *src[ASYNC_VECTORS], *dst[ASYNC_VECTORS];
+    off_t offsets[ASYNC_VECTORS + 1] = { 0 };
+    unsigned stored = 0, loaded = 0;
+
+    // Batched stores, completed via callbacks
+    for (unsigned i = 0; i < ASYNC_VECTORS; ++i) {
+        src[i] = uvec_alloc(int);
+        dst[i] = uvec_alloc(int);
+        uvec_assert(src[i] && dst[i]);
+        for (unsigned j = 0; j < i * i * 7; ++j) uvec_push(int, src[i], (int)(i * j));
+        offsets[i + 1] = offsets[i] + (off_t)uvec_async_span(int, src[i]);
+        uvec_assert(uvec_async_store(int, a, src[i], fd, offsets[i], async_count, &stored) == 0);
+    }
+
+    uvec_async_submit(a);
+    uvec_assert(uvec_async_wait(a) == UVEC_OK);
+    uvec_assert(stored == ASYNC_VECTORS && !uvec_async_pending(a));
+
+    // Loads, completed via polling
+    for (unsigned i = 0; i < ASYNC_VECTORS; ++i) {
+        uvec_assert(uvec_async_load(int, a, dst[i], fd, offsets[i], async_count, &loaded) == 0);
+    }
+
+    unsigned completed = 0;
+    while (uvec_async_pending(a)) completed += uvec_async_poll(a);
+    uvec_assert(completed == ASYNC_VECTORS && loaded == ASYNC_VECTORS);
+
+    for (unsigned i = 0; i < ASYNC_VECTORS; ++i) {
+        uvec_assert(uvec_equals(int, src[i], dst[i]));
+        uvec_free(int, src[i]);
+        uvec_free(int, dst[i]);
+    }
+
+    UVec(int) *v = uvec_alloc(int);
+    uvec_assert(v);
+
+    // Same format as uvec_write_fd
+    if (!open_flags) {
+        uvec_assert(lseek(fd, offsets[5], SEEK_SET) == offsets[5]);
+        uvec_assert(uvec_read_fd(int, v, fd) == UVEC_OK);
+        uvec_assert(v->count == 5 * 5 * 7 && v->storage[10] == 50);
+        uvec_remove_all(int, v);
+    }
+
+    // Invalid data
+    uvec_assert(uvec_async_load(int, a, v, fd, offsets[ASYNC_VECTORS], NULL, NULL) == 0);
+    uvec_assert(uvec_async_wait(a) == UVEC_NO);
+    uvec_assert(uvec_count(v) == 0);
+
+    uvec_assert(uvec_async_destroy(a) == UVEC_OK);
+    uvec_free(int, v);
+    close(fd);
+    return true;
+}
+
+static bool test_async(void) {
+    uvec_assert(async_check(UVEC_ASYNC_DEFAULT, 0));
+    uvec_assert(async_check(UVEC_ASYNC_THREADS, 0));
+#ifdef O_DIRECT
+    uvec_assert(async_check(UVEC_ASYNC_DEFAULT, O_DIRECT));
+    uvec_assert(async_check(UVEC_ASYNC_THREADS, O_DIRECT));
+#endif
+    return true;
+}
+
+#define LOG_TEST_FILE "uvec_log_test.bin"
+#define LOG_ITEMS 10000
+
+static void* log_producer(void *data) {
+    UVecLog(int) *log = data;
+
+    for (int i = 0; i < LOG_ITEMS; ++i) {
+        if (uvec_log_push(int, log, i)) return log;
+    }
+
+    return NULL;
+}
+
+static bool test_log(void) {
+    unlink(LOG_TEST_FILE);
+    UVecLog(int) *lg = uvec_log_open(int, LOG_TEST_FILE, 1000);
+    uvec_assert(lg);
+    uvec_assert(uvec_log_count(lg) == 0 && !uvec_log_get(int, lg, 0));
+
+    // Group commit
+    for (int i = 0; i < LOG_ITEMS; ++i) uvec_assert(uvec_log_push(int, lg, i) == UVEC_OK);
+    int const array[] = { -1, -2, -3 };
+    uvec_assert(uvec_log_append_array(int, lg, array, 3) == UVEC_OK);
+    uvec_assert(uvec_log_sync(int, lg) == UVEC_OK);
+    uvec_assert(uvec_log_count(lg) == LOG_ITEMS + 3);
+    uvec_assert(*uvec_log_get(int, lg, 1234) == 1234);
+    uvec_assert(*uvec_log_get(int, lg, LOG_ITEMS + 2) == -3);
+    uvec_assert(!uvec_log_get(int, lg, LOG_ITEMS + 3));
+
+    // Concurrent producers
+    pthread_t threads[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        uvec_assert(pthread_create(&threads[i], NULL, log_producer, lg) == 0);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    uvec_assert(uvec_log_sync(int, lg) == UVEC_OK);
+    uint64_t const count = LOG_ITEMS * (CONCURRENT_THREADS + 1) + 3;
+    uvec_assert(uvec_log_count(lg) == count);
+
+    long long sum = 0;
+
+    for (uint64_t i = 0, n; i < count; i += n) {
+        int const *span = uvec_log_span(int, lg, i, &n);
+        uvec_assert(span && n && i + n <= count);
+        for (uint64_t j = 0; j < n; ++j) sum += span[j];
+    }
+
+    long long const expected = (long long)LOG_ITEMS * (LOG_ITEMS - 1) / 2 * (CONCURRENT_THREADS + 1);
+    uvec_assert(sum == expected - 6);
+    uvec_assert(uvec_log_close(int, lg) == UVEC_OK);
+
+    // Recovery
+    lg = uvec_log_open(int, LOG_TEST_FILE, 0);
+    uvec_assert(lg && uvec_log_count(lg) == count);
+    uvec_assert(*uvec_log_get(int, lg, LOG_ITEMS + 1) == -2);
+    uvec_assert(uvec_log_append_array(int, lg, array, 3) == UVEC_OK);
+    uvec_assert(uvec_log_close(int, lg) == UVEC_OK);
+
+    int fd = open(LOG_TEST_FILE, O_RDWR);
+    uvec_assert(fd >= 0);
+    off_t const size = lseek(fd, 0, SEEK_END);
+
+    // Torn block
+    unsigned char torn[P_UVEC_LOG_BLOCK_HEADER_SIZE + 8] = { 0 };
+    uint32_t const magic = P_UVEC_LOG_BLOCK_MAGIC;
+    uint64_t const torn_count = 100;
+    memcpy(torn, &magic, sizeof(magic));
+    memcpy(torn + 8, &torn_count, sizeof(torn_count));
+    uvec_assert(write(fd, torn, sizeof(torn)) == sizeof(torn));
+
+    lg = uvec_log_open(int, LOG_TEST_FILE, 0);
+    uvec_assert(lg && uvec_log_count(lg) == count + 3);
+    uvec_assert(uvec_log_close(int, lg) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_END) == size);
+
+    // Corrupted block
+    uvec_assert(pwrite(fd, "\xFF", 1, size - 24) == 1);
+    lg = uvec_log_open(int, LOG_TEST_FILE, 0);
+    uvec_assert(lg && uvec_log_count(lg) == count);
+    uvec_assert(uvec_log_close(int, lg) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_END) < size);
+
+    // Invalid file
+    uvec_assert(pwrite(fd, "X", 1, 0) == 1);
+    uvec_assert(!uvec_log_open(int, LOG_TEST_FILE, 0) && errno == EINVAL);
+
+    close(fd);
+    unlink(LOG_TEST_FILE);
+    return true;
+}
+
+static bool test_parallel(void) {
+    UVecPool *pool = uvec_pool_alloc(CONCURRENT_THREADS);
+    uvec_assert(pool && uvec_pool_threads(pool) >= 1);
+
+    UVec(int) *v = uvec_alloc(int);
+    uvec_assert(uvec_reserve_capacity(int, v, PARALLEL_ITEMS) == UVEC_OK);
+    for (int i = 0; i < PARALLEL_ITEMS; ++i) uvec_push(int, v, i % 1000);
+
+    // Empty vectors
+    UVec(int) *empty = uvec_alloc(int);
+    uvec_assert(uvec_parallel_reduce(int, pool, empty, parallel_sum, 7, NULL) == 7);
+    uvec_assert(uvec_parallel_index_of(int, pool, empty, 0) == UVEC_INDEX_NOT_FOUND);
+    uvec_assert(uvec_parallel_index_of_min(int, pool, empty) == UVEC_INDEX_NOT_FOUND);
+    uvec_free(int, empty);
+
+    // Foreach, map and reduce
+    int inc = 1;
+    uvec_parallel_foreach(int, pool, v, parallel_increment, &inc);
+    long long expected = 0;
+    for (int i = 0; i < PARALLEL_ITEMS; ++i) expected += i % 1000 + 1;
+
+    UVec(int) *dest = uvec_alloc(int);
+    uvec_assert(uvec_parallel_map(int, pool, v, dest, parallel_double, NULL) == UVEC_OK);
+    uvec_assert(dest->count == PARALLEL_ITEMS);
+
+    bool equal = true;
+    for (uvec_uint i = 0; i < dest->count && equal; ++i) {
+        equal = dest->storage[i] == 2 * v->storage[i];
+    }
+    uvec_assert(equal);
+
+    int sum = uvec_parallel_reduce(int, pool, v, parallel_sum, 0, NULL);
+    uvec_assert(sum == (int)expected);
+    int last = uvec_parallel_reduce(int, pool, v, parallel_last, -1, NULL);
+    uvec_assert(last == uvec_last(v));
+
+    // In-place map
+    uvec_assert(uvec_parallel_map(int, pool, dest, dest, parallel_double, NULL) == UVEC_OK);
+    uvec_assert(dest->storage[PARALLEL_ITEMS - 1] == 4 * v->storage[PARALLEL_ITEMS - 1]);
+
+    // Deep copy
+    UVec(int) *copy = uvec_parallel_deep_copy(int, pool, v, parallel_copy);
+    uvec_assert(copy && copy->count == v->count);
+
+    equal = true;
+    for (uvec_uint i = 0; i < copy->count && equal; ++i) {
+        equal = copy->storage[i] == v->storage[i] + 1;
+    }
+    uvec_assert(equal);
+
+    // Search
+    uvec_set(v, PARALLEL_ITEMS - 2, -5);
+    uvec_set(v, PARALLEL_ITEMS / 2, 5000);
+    uvec_set(v, PARALLEL_ITEMS - 1, 5000);
+    uvec_assert(uvec_parallel_index_of(int, pool, v, 1) == 0);
+    uvec_assert(uvec_parallel_index_of(int, pool, v, 5000) == PARALLEL_ITEMS / 2);
+    uvec_assert(uvec_parallel_index_of(int, pool, v, -5) == PARALLEL_ITEMS - 2);
+    uvec_assert(uvec_parallel_index_of(int, pool, v, 12345) == UVEC_INDEX_NOT_FOUND);
+    uvec_assert(uvec_parallel_index_of(int, pool, v, 7) == uvec_index_of(int, v, 7));
+    uvec_assert(uvec_parallel_index_of_min(int, pool, v) == PARALLEL_ITEMS - 2);
+    uvec_assert(uvec_parallel_index_of_max(int, pool, v) == PARALLEL_ITEMS / 2);
+    uvec_assert(uvec_parallel_index_of_min(int, pool, copy) == uvec_index_of_min(int, copy));
+    uvec_assert(uvec_parallel_index_of_max(int, pool, copy) == uvec_index_of_max(int, copy));
+
+    // Sequential fallback
+    uvec_assert(uvec_parallel_reduce(int, NULL, copy, parallel_sum, 0, NULL) ==
+                uvec_parallel_reduce(int, pool, copy, parallel_sum, 0, NULL));
+
+    // Merge
+    UVec(int) *runs[37];
+    unsigned seed = 1;
+
+    for (unsigned i = 0; i < array_size(runs); ++i) {
+        runs[i] = uvec_alloc(int);
+        uvec_assert(runs[i]);
+
+        for (unsigned j = (i * 7919) % 5000; j > 0; --j) {
+            seed = seed * 1103515245 + 12345;
+            uvec_assert(uvec_push(int, runs[i], (int)(seed >> 16) % 1000) == UVEC_OK);
+        }
+
+        uvec_sort(int, runs[i]);
+    }
+
+    UVec(int) *seq = uvec_alloc(int), *par = uvec_alloc(int);
+    uvec_assert(uvec_merge_sorted_k(int, seq, runs, array_size(runs)) == UVEC_OK);
+    uvec_assert(uvec_parallel_merge_sorted_k(int, pool, par, runs, array_size(runs)) == UVEC_OK);
+    uvec_assert(seq->count == par->count && seq->count > 0);
+    uvec_assert(memcmp(seq->storage, par->storage, seq->count * sizeof(int)) == 0);
+
+    bool sorted = true;
+    for (uvec_uint i = 1; i < seq->count && sorted; ++i) {
+        sorted = seq->storage[i - 1] <= seq->storage[i];
+    }
+    uvec_assert(sorted);
+
+    for (unsigned i = 0; i < array_size(runs); ++i) uvec_free(int, runs[i]);
+    uvec_free(int, seq);
+    uvec_free(int, par);
+
+    uvec_free(int, copy);
+    uvec_free(int, dest);
+    uvec_free(int, v);
+    uvec_pool_free(pool);
+    return true;
+}
+
+#endif
+
+#ifdef UVEC_TEST_PTHREADS
+
+typedef struct ShardedProducer {
+    UVecSharded(int) *sv;
+    int base;
+} ShardedProducer;
+
+static void* sharded_producer(void *data) {
+    UVecSharded(int) *sv = ((ShardedProducer *)data)->sv;
+    int base = ((ShardedProducer *)data)->base;
+    int block[100];
+
+    for (int i = 0; i < CONCURRENT_ITEMS / 4; ++i) {
+        if (uvec_sharded_push(int, sv, base + i)) return sv;
+    }
+
+    for (int i = CONCURRENT_ITEMS / 4; i < CONCURRENT_ITEMS / 2; ++i) {
+        if (uvec_sharded_push_hash(int, sv, (size_t)i, base + i)) return sv;
+    }
+
+    for (int i = CONCURRENT_ITEMS / 2; i < CONCURRENT_ITEMS; i += 100) {
+        for (int j = 0; j < 100; ++j) block[j] = base + i + j;
+        if (uvec_sharded_append_array(int, sv, block, 100)) return sv;
+    }
+
+    return NULL;
+}
+
+static void sharded_sum(int *item, void *ctx) {
+    p_uvec_atomic_fetch_add((P_UVEC_ATOMIC(long long) *)ctx, *item, P_UVEC_MO_RELAXED);
+}
+
+static bool test_sharded(void) {
+    UVecSharded(int) *sv = uvec_sharded_alloc(int, 3);
+    uvec_assert(sv && uvec_sharded_shards(sv) == 4);
+    uvec_assert(uvec_sharded_count(int, sv) == 0);
+
+    pthread_t threads[CONCURRENT_THREADS];
+    ShardedProducer producers[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        producers[i] = (ShardedProducer){ .sv = sv, .base = (int)i * CONCURRENT_ITEMS };
+        uvec_assert(pthread_create(&threads[i], NULL, sharded_producer, &producers[i]) == 0);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    uvec_uint const total = CONCURRENT_THREADS * CONCURRENT_ITEMS;
+    uvec_assert(uvec_sharded_count(int, sv) == total);
+
+    // Parallel iteration
+    UVecPool *pool = uvec_pool_alloc(CONCURRENT_THREADS);
+    uvec_assert(pool);
+    P_UVEC_ATOMIC(long long) sum;
+    p_uvec_atomic_init(&sum, 0);
+    uvec_sharded_foreach(int, pool, sv, sharded_sum, &sum);
+    uvec_pool_free(pool);
+    uvec_assert(p_uvec_atomic_load(&sum, P_UVEC_MO_RELAXED) == (long long)total * (total - 1) / 2);
+
+    // Drain
+    UVec(int) *v = uvec_alloc(int);
+    uvec_assert(uvec_push(int, v, -1) == UVEC_OK);
+    uvec_assert(uvec_sharded_drain(int, sv, v) == UVEC_OK);
+    uvec_assert(v->count == total + 1);
+    uvec_assert(uvec_sharded_count(int, sv) == 0);
+    uvec_sort(int, v);
+
+    bool ordered = true;
+    for (uvec_uint i = 0; i < v->count && ordered; ++i) ordered = v->storage[i] == (int)i - 1;
+    uvec_assert(ordered);
+
+    uvec_free(int, v);
+    uvec_sharded_free(int, sv);
+    return true;
+}
+
+#endif
+
+#define IO_TEST_FILE "uvec_io_test.bin"
+
+typedef struct IOChunkCheck {
+    uint64_t next;
+    uvec_uint window;
+    unsigned chunks;
+    unsigned stop_after;
+} IOChunkCheck;
+
+static uvec_ret io_chunk_check(UVec(int) *chunk, uint64_t offset, void *ctx) {
+    IOChunkCheck *check = ctx;
+    if (offset != check->next || !chunk->count || chunk->count > check->window) return UVEC_ERR;
+
+    uvec_iterate(int, chunk, item, i, {
+        if (item != (int)(offset + i)) return UVEC_ERR;
+    });
+
+    check->next += chunk->count;
+    uvec_remove_all(int, chunk);
+    uvec_shrink(int, chunk);
+    return ++check->chunks == check->stop_after ? UVEC_NO : UVEC_OK;
+}
+
+static bool test_io(void) {
+    UVec(int) *v = uvec_alloc(int);
+    for (int i = 0; i < 100000; ++i) uvec_assert(uvec_push(int, v, i * 7 - 3) == UVEC_OK);
+
+    // File descriptors
+    int fd = open(IO_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(fd >= 0);
+    unlink(IO_TEST_FILE);
+
+    UVec(int) *empty = uvec_alloc(int);
+    uvec_assert(uvec_write_fd(int, v, fd) == UVEC_OK);
+    uvec_assert(uvec_write_fd(int, empty, fd) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    UVec(int) *r = uvec_alloc(int);
+    uvec_assert(uvec_push(int, r, 42) == UVEC_OK);
+    uvec_assert(uvec_read_fd(int, r, fd) == UVEC_OK);
+    uvec_assert(r->count == v->count + 1 && r->storage[0] == 42);
+    uvec_assert(memcmp(r->storage + 1, v->storage, v->count * sizeof(int)) == 0);
+    uvec_assert(uvec_read_fd(int, empty, fd) == UVEC_OK);
+    uvec_assert(empty->count == 0);
+    uvec_assert(uvec_read_fd(int, r, fd) == UVEC_NO);
+    close(fd);
+
+    // Streams
+    FILE *file = tmpfile();
+    uvec_assert(file);
+    uvec_assert(uvec_write_file(int, v, file) == UVEC_OK);
+    rewind(file);
+
+    uvec_remove_all(int, r);
+    uvec_assert(uvec_read_file(int, r, file) == UVEC_OK);
+    uvec_assert(uvec_equals(int, r, v));
+
+    // Corrupted storage
+    uvec_assert(fseek(file, P_UVEC_IO_HEADER_SIZE + 1000, SEEK_SET) == 0);
+    uvec_assert(fputc(0xFF, file) != EOF);
+    rewind(file);
+    uvec_remove_all(int, r);
+    uvec_assert(uvec_read_file(int, r, file) == UVEC_NO);
+    uvec_assert(r->count == 0);
+
+    // Truncated data
+    rewind(file);
+    unsigned char buf[P_UVEC_IO_HEADER_SIZE + 4 * sizeof(int)];
+    uvec_assert(fread(buf, 1, sizeof(buf), file) == sizeof(buf));
+    fclose(file);
+
+    file = tmpfile();
+    uvec_assert(file && fwrite(buf, 1, sizeof(buf), file) == sizeof(buf));
+    rewind(file);
+    uvec_assert(uvec_read_file(int, r, file) == UVEC_NO);
+    fclose(file);
+
+    // Opposite byte order
+    uvec_remove_all(int, v);
+    uvec_assert(uvec_append_items(int, v, 1, -2, 0x01020304) == UVEC_OK);
+    p_uvec_io_swap(v->storage, sizeof(int), v->count);
+
+    p_uvec_fletcher f = { 0, 0 };
+    p_uvec_fletcher_update(&f, v->storage, v->count * sizeof(int));
+    unsigned char header[P_UVEC_IO_HEADER_SIZE];
+    p_uvec_io_header_init(header, sizeof(int), v->count, p_uvec_fletcher_value(f));
+    p_uvec_io_swap(header + 8, 4, 2);
+    p_uvec_io_swap(header + 16, 8, 3);
+
+    file = tmpfile();
+    uvec_assert(file);
+    uvec_assert(fwrite(header, 1, sizeof(header), file) == sizeof(header));
+    uvec_assert(fwrite(v->storage, sizeof(int), v->count, file) == v->count);
+    rewind(file);
+
+    uvec_remove_all(int, r);
+    uvec_assert(uvec_read_file(int, r, file) == UVEC_OK);
+    uvec_assert_elements(int, r, 1, -2, 0x01020304);
+    fclose(file);
+
+    // Streaming
+    fd = open(IO_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(fd >= 0);
+    unlink(IO_TEST_FILE);
+
+    UVecWriter *w = uvec_writer_open(int, fd, 10);
+    uvec_assert(w);
+
+    uvec_uint const sizes[] = { 1, 5, 100, 7, 0, 1000, 3 };
+    int next = 0;
+
+    for (unsigned i = 0; i < array_size(sizes); ++i) {
+        uvec_remove_all(int, v);
+        for (uvec_uint j = 0; j < sizes[i]; ++j) uvec_assert(uvec_push(int, v, next++) == UVEC_OK);
+        uvec_assert(uvec_writer_append(int, w, v) == UVEC_OK);
+    }
+
+    uvec_assert(uvec_writer_close(w) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    uvec_remove_all(int, r);
+    uvec_assert(uvec_read_fd(int, r, fd) == UVEC_OK);
+    uvec_assert(r->count == (uvec_uint)next);
+    uvec_iterate(int, r, item, i, { uvec_assert(item == (int)i); });
+
+    IOChunkCheck check = { .window = 100 };
+    uvec_assert(lseek(fd, 0, SEEK_SET) == 0);
+    uvec_assert(uvec_read_fd_chunked(int, fd, 100, io_chunk_check, &check) == UVEC_OK);
+    uvec_assert(check.next == (uint64_t)next && check.chunks == (unsigned)(next + 99) / 100);
+
+    check = (IOChunkCheck){ .window = 0x10000, .stop_after = 1 };
+    uvec_assert(lseek(fd, 0, SEEK_SET) == 0);
+    uvec_assert(uvec_read_fd_chunked(int, fd, 0, io_chunk_check, &check) == UVEC_NO);
+    uvec_assert(check.next == (uint64_t)next && check.chunks == 1);
+    close(fd);
+
+    // Scatter/gather, split across multiple system calls
+    fd = open(IO_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    uvec_assert(fd >= 0);
+    unlink(IO_TEST_FILE);
+
+    size_t const nvecs = P_UVEC_IO_IOV_MAX * 2 + 3;
+    UVec(int) **vecs = malloc(2 * nvecs * sizeof(*vecs));
+    uvec_uint *counts = malloc(nvecs * sizeof(*counts));
+    uvec_assert(vecs && counts);
+    next = 0;
+
+    for (size_t i = 0; i < 2 * nvecs; ++i) {
+        vecs[i] = uvec_alloc(int);
+        uvec_assert(vecs[i]);
+        if (i >= nvecs) continue;
+        counts[i] = (uvec_uint)(i % 7);
+        for (uvec_uint j = 0; j < counts[i]; ++j) uvec_assert(uvec_push(int, vecs[i], next++) == 0);
+    }
+
+    uvec_assert(uvec_writev(int, fd, (UVec(int) const *const *)vecs, nvecs) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_END) == (off_t)(next * sizeof(int)));
+    uvec_assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    uvec_assert(uvec_push(int, vecs[nvecs], 42) == UVEC_OK);
+    uvec_assert(uvec_readv(int, fd, vecs + nvecs, counts, nvecs) == UVEC_OK);
+    uvec_assert(vecs[nvecs]->count == 1 && vecs[nvecs]->storage[0] == 42);
+    uvec_assert(uvec_remove_at(int, vecs[nvecs], 0) == 42);
+
+    for (size_t i = 0; i < nvecs; ++i) uvec_assert(uvec_equals(int, vecs[i], vecs[nvecs + i]));
+
+    // Truncated data
+    uvec_assert(lseek(fd, sizeof(int), SEEK_SET) == sizeof(int));
+    uvec_assert(uvec_readv(int, fd, vecs + nvecs, counts, nvecs) == UVEC_NO);
+    uvec_assert(uvec_equals(int, vecs[nvecs + 10], vecs[10]));
+
+    for (size_t i = 0; i < 2 * nvecs; ++i) uvec_free(int, vecs[i]);
+    free(counts);
+    free(vecs);
+    close(fd);
+
+    uvec_free(int, empty);
+    uvec_free(int, r);
+    uvec_free(int, v);
+    return true;
+}
+
+#define MAPPED_TEST_FILE "uvec_mapped_test.bin"
+#define MAPPED_ITEMS 50000
+
+static bool test_mapped(void) {
+    UVecMapped(int) *mv = uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_CREATE);
+    uvec_assert(mv);
+    uvec_assert(uvec_count(uvec_mapped_vec(mv)) == 0);
+
+    int const items[] = { 0, 3, 6 };
+    uvec_assert(uvec_mapped_append_array(int, mv, items, array_size(items)) == UVEC_OK);
+    for (int i = 3; i < MAPPED_ITEMS; ++i) uvec_assert(uvec_mapped_push(int, mv, i * 3) == UVEC_OK);
+    uvec_assert(uvec_mapped_close(int, mv) == UVEC_OK);
+
+    // Files are in the serialization format
+    UVec(int) *v = uvec_alloc(int);
+    int fd = open(MAPPED_TEST_FILE, O_RDONLY);
+    uvec_assert(fd >= 0);
+    uvec_assert(uvec_read_fd(int, v, fd) == UVEC_OK);
+    uvec_assert(lseek(fd, 0, SEEK_END) == P_UVEC_IO_HEADER_SIZE + MAPPED_ITEMS * sizeof(int));
+    close(fd);
+    uvec_assert(uvec_count(v) == MAPPED_ITEMS);
+
+    // Read-only mapping
+    mv = uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_READ | UVEC_MAPPED_VERIFY);
+    uvec_assert(mv);
+
+    UVec(int) *view = uvec_mapped_vec(mv);
+    uvec_assert(uvec_equals(int, view, v));
+    uvec_assert(uvec_get(view, 1000) == 3000);
+    uvec_assert(uvec_index_of_sorted(int, view, 4500) == 1500);
+    uvec_assert(uvec_index_of_sorted(int, view, 4501) == UVEC_INDEX_NOT_FOUND);
+
+    long long sum = 0;
+    uvec_foreach(int, view, item, sum += item);
+    uvec_assert(sum == 3LL * MAPPED_ITEMS * (MAPPED_ITEMS - 1) / 2);
+    uvec_assert(uvec_mapped_push(int, mv, 0) == UVEC_ERR);
+
+    // Read-write mapping, observed by the read-only mapping after syncing
+    UVecMapped(int) *wv = uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_WRITE);
+    uvec_assert(wv);
+    uvec_set(uvec_mapped_vec(wv), 0, -1);
+    uvec_assert(uvec_get(view, 0) == -1);
+
+    for (int i = 0; i < MAPPED_ITEMS; ++i) {
+        uvec_assert(uvec_mapped_push(int, wv, (MAPPED_ITEMS + i) * 3) == UVEC_OK);
+    }
+
+    uvec_assert(uvec_mapped_sync(int, wv) == UVEC_OK);
+    uvec_assert(uvec_mapped_close(int, mv) == UVEC_OK);
+
+    mv = uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_READ | UVEC_MAPPED_VERIFY);
+    uvec_assert(mv);
+    view = uvec_mapped_vec(mv);
+    uvec_assert(uvec_count(view) == 2 * MAPPED_ITEMS);
+    uvec_assert(uvec_index_of_sorted(int, view, 3 * (2 * MAPPED_ITEMS - 1)) == 2 * MAPPED_ITEMS - 1);
+    uvec_assert(uvec_mapped_close(int, mv) == UVEC_OK);
+
+    // Corrupted storage
+    uvec_set(uvec_mapped_vec(wv), 10, 0);
+    uvec_assert(uvec_mapped_close(int, wv) == UVEC_OK);
+
+    fd = open(MAPPED_TEST_FILE, O_WRONLY);
+    uvec_assert(fd >= 0);
+    uvec_assert(lseek(fd, P_UVEC_IO_HEADER_SIZE + 11 * sizeof(int), SEEK_SET) >= 0);
+    uvec_assert(write(fd, "\xFF", 1) == 1);
+    close(fd);
+
+    errno = 0;
+    uvec_assert(!uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_VERIFY));
+    uvec_assert(errno == EINVAL);
+
+    mv = uvec_mapped_open(int, MAPPED_TEST_FILE, UVEC_MAPPED_READ);
+    uvec_assert(mv);
+    uvec_assert(uvec_get(uvec_mapped_vec(mv), 10) == 0);
+    uvec_assert(uvec_mapped_close(int, mv) == UVEC_OK);
+
+    // Invalid files
+    errno = 0;
+    uvec_assert(!uvec_mapped_open(int, "uvec_mapped_missing.bin", UVEC_MAPPED_READ));
+    uvec_assert(errno == ENOENT);
+
+    unlink(MAPPED_TEST_FILE);
+    uvec_free(int, v);
+    return true;
+}
+
+#define SHARED_TEST_NAME "/uvec_shared_test"
+#define SHARED_ITEMS 100000
+
+#ifdef UVEC_TEST_PTHREADS
+
+static void* shared_writer(void *sv) {
+    for (int i = 0; i < SHARED_ITEMS; ++i) {
+        if (uvec_shared_push(int, sv, i)) return sv;
+    }
+    return NULL;
+}
+
+#endif
+
+static bool test_shared(void) {
+    // Anonymous objects, shared via their file descriptor
+    UVecShared(int) *wv = uvec_shared_create(int, NULL);
+    uvec_assert(wv);
+    UVecShared(int) *rv = uvec_shared_open_fd(int, uvec_shared_fd(wv));
+    uvec_assert(rv);
+    uvec_assert(uvec_count(uvec_shared_vec(rv)) == 0);
+
+    for (int i = 0; i < 10; ++i) uvec_assert(uvec_shared_push(int, wv, i) == UVEC_OK);
+    uvec_assert(uvec_count(uvec_shared_vec(rv)) == 0);
+    uvec_assert(uvec_shared_refresh(int, rv) == UVEC_OK);
+    uvec_assert_elements(int, uvec_shared_vec(rv), 0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    uvec_assert(uvec_shared_vec(rv)->storage != uvec_shared_vec(wv)->storage);
+
+    UVec(int) *v = uvec_alloc(int);
+    for (int i = 10; i < SHARED_ITEMS; ++i) uvec_assert(uvec_push(int, v, i) == UVEC_OK);
+    uvec_assert(uvec_shared_append_array(int, wv, v->storage, v->count) == UVEC_OK);
+    uvec_assert(uvec_shared_refresh(int, rv) == UVEC_OK);
+
+    UVec(int) *view = uvec_shared_vec(rv);
+    uvec_assert(uvec_count(view) == SHARED_ITEMS);
+    uvec_assert(uvec_index_of_sorted(int, view, SHARED_ITEMS / 3) == SHARED_ITEMS / 3);
+    uvec_iterate(int, view, item, i, { uvec_assert(item == (int)i); });
+    uvec_assert(uvec_shared_push(int, rv, 0) == UVEC_ERR);
+
+    uvec_assert(uvec_shared_close(int, rv) == UVEC_OK);
+    uvec_assert(uvec_shared_close(int, wv) == UVEC_OK);
+
+    // Named objects
+    shm_unlink(SHARED_TEST_NAME);
+    wv = uvec_shared_create(int, SHARED_TEST_NAME);
+    uvec_assert(wv);
+    uvec_assert(!uvec_shared_create(int, SHARED_TEST_NAME));
+    uvec_assert(uvec_shared_append_array(int, wv, v->storage, 100) == UVEC_OK);
+
+    rv = uvec_shared_open(int, SHARED_TEST_NAME);
+    uvec_assert(rv);
+    uvec_assert(memcmp(uvec_shared_vec(rv)->storage, v->storage, 100 * sizeof(int)) == 0);
+    uvec_assert(uvec_count(uvec_shared_vec(rv)) == 100);
+    uvec_assert(uvec_shared_close(int, rv) == UVEC_OK);
+    uvec_assert(uvec_shared_close(int, wv) == UVEC_OK);
+    uvec_assert(shm_unlink(SHARED_TEST_NAME) == 0);
+
+    // Invalid objects
+    FILE *file = tmpfile();
+    uvec_assert(file);
+    errno = 0;
+    uvec_assert(!uvec_shared_open_fd(int, fileno(file)));
+    uvec_assert(errno == EINVAL);
+    fclose(file);
+
+#ifdef UVEC_TEST_PTHREADS
+    // Concurrent writer and reader
+    wv = uvec_shared_create(int, NULL);
+    uvec_assert(wv);
+
+#ifdef __SANITIZE_THREAD__
+    // ThreadSanitizer does not track mremap, so avoid remapping while both threads run.
+    uvec_assert(uvec_shared_reserve(int, wv, SHARED_ITEMS) == UVEC_OK);
+#endif
+
+    rv = uvec_shared_open_fd(int, uvec_shared_fd(wv));
+    uvec_assert(rv);
+
+    pthread_t writer;
+    uvec_assert(pthread_create(&writer, NULL, shared_writer, wv) == 0);
+
+    for (uvec_uint seen = 0; seen < SHARED_ITEMS;) {
+        uvec_assert(uvec_shared_refresh(int, rv) == UVEC_OK);
+        view = uvec_shared_vec(rv);
+        for (; seen < view->count; ++seen) uvec_assert(view->storage[seen] == (int)seen);
+    }
+
+    void *failed;
+    uvec_assert(pthread_join(writer, &failed) == 0 && !failed);
+    uvec_assert(uvec_shared_close(int, rv) == UVEC_OK);
+    uvec_assert(uvec_shared_close(int, wv) == UVEC_OK);
+#endif
+
+    uvec_free(int, v);
+    return true;
+}
+
 static bool test_higher_order(void) {
     UVec(int) *v = uvec_alloc(int);
     uvec_ret ret = uvec_append_items(int, v, 3, 2, 4, 1);
@@ -280,11 +1830,229 @@ static bool test_comparable(void) {
     uvec_assert(ret == UVEC_NO);
     uvec_assert(idx == 3);
 
+    UVec(int) runs[] = { uvec_init(int), uvec_init(int), uvec_init(int), uvec_init(int) };
+    UVec(int) *run_ptrs[] = { &runs[0], &runs[1], &runs[2], &runs[3] };
+    uvec_assert(uvec_append_items(int, &runs[0], 1, 4, 7) == UVEC_OK);
+    uvec_assert(uvec_append_items(int, &runs[2], 2, 2, 9) == UVEC_OK);
+    uvec_assert(uvec_append_items(int, &runs[3], 0, 4, 10, 11) == UVEC_OK);
+
+    uvec_remove_all(int, v);
+    uvec_assert(uvec_push(int, v, -1) == UVEC_OK);
+    uvec_assert(uvec_merge_sorted_k(int, v, run_ptrs, 4) == UVEC_OK);
+    uvec_assert_elements(int, v, -1, 0, 1, 2, 2, 4, 4, 7, 9, 10, 11);
+    uvec_assert(uvec_merge_sorted_k(int, v, run_ptrs + 1, 1) == UVEC_OK);
+    uvec_assert(v->count == 11);
+
+    for (unsigned i = 0; i < array_size(runs); ++i) uvec_deinit(runs[i]);
     uvec_free(int, v);
     uvec_free(int, values);
     return true;
 }
 
+#ifdef UVEC_STATS
+
+typedef struct StatsTrace {
+    unsigned events;
+    uint64_t amounts[UVEC_STATS_SCAN + 1];
+} StatsTrace;
+
+static void stats_trace(char const *type, uvec_stats_event event, uint64_t amount, void *ctx) {
+    StatsTrace *trace = ctx;
+    if (strcmp(type, "int")) return;
+    trace->events++;
+    trace->amounts[event] += amount;
+}
+
+static UVecStats stats_diff(UVecStats a, UVecStats b) {
+    return (UVecStats) {
+        .reallocs = b.reallocs - a.reallocs,
+        .realloc_bytes = b.realloc_bytes - a.realloc_bytes,
+        .moved_bytes = b.moved_bytes - a.moved_bytes,
+        .comparisons = b.comparisons - a.comparisons,
+        .scanned = b.scanned - a.scanned,
+    };
+}
+
+#ifdef UVEC_TEST_PTHREADS
+
+static void* stats_worker(void *data) {
+    UVec(int) v = uvec_init(int);
+    for (int i = 0; i < 16; ++i) uvec_push(int, &v, i);
+    uvec_deinit(v);
+    return data;
+}
+
+#endif
+
+static bool test_stats(void) {
+    StatsTrace trace = { 0 };
+    UVecStats start = uvec_stats_snapshot(int);
+    UVecStats local = uvec_stats_local(int);
+    uvec_stats_set_trace(int, stats_trace, &trace);
+
+    UVec(int) *v = uvec_alloc(int);
+    for (int i = 0; i < 10; ++i) uvec_assert(uvec_push(int, v, 9 - i) == UVEC_OK);
+
+    UVecStats diff = stats_diff(start, uvec_stats_snapshot(int));
+    uvec_assert(diff.reallocs == 4);
+    uvec_assert(diff.realloc_bytes == (2 + 4 + 8 + 16) * sizeof(int));
+
+    uvec_assert(uvec_insert_at(int, v, 0, 10) == UVEC_OK);
+    uvec_remove_at(int, v, 0);
+    uvec_remove_at(int, v, 9);
+    diff = stats_diff(start, uvec_stats_snapshot(int));
+    uvec_assert(diff.moved_bytes == 20 * sizeof(int));
+
+    uvec_assert(uvec_index_of(int, v, 6) == 3);
+    uvec_assert(uvec_index_of(int, v, 42) == UVEC_INDEX_NOT_FOUND);
+    uvec_assert(uvec_index_of_reverse(int, v, 6) == 3);
+    diff = stats_diff(start, uvec_stats_snapshot(int));
+    uvec_assert(diff.scanned == 4 + 9 + 6);
+    uvec_assert(diff.comparisons == 0);
+
+    uvec_sort(int, v);
+    uvec_assert(uvec_index_of_sorted(int, v, 5) == 4);
+    diff = stats_diff(start, uvec_stats_snapshot(int));
+    uvec_assert(diff.comparisons > 0);
+
+    uvec_stats_set_trace(int, NULL, NULL);
+    uvec_assert(uvec_push(int, v, 0) == UVEC_OK);
+    uvec_assert(trace.events == 4 + 2 + 3 + 2);
+    uvec_assert(trace.amounts[UVEC_STATS_REALLOC] == diff.realloc_bytes);
+    uvec_assert(trace.amounts[UVEC_STATS_MOVE] == diff.moved_bytes);
+    uvec_assert(trace.amounts[UVEC_STATS_COMPARE] == diff.comparisons);
+    uvec_assert(trace.amounts[UVEC_STATS_SCAN] == diff.scanned);
+
+    UVecStats local_diff = stats_diff(local, uvec_stats_local(int));
+    diff = stats_diff(start, uvec_stats_snapshot(int));
+    uvec_assert(memcmp(&local_diff, &diff, sizeof(diff)) == 0);
+
+#ifdef UVEC_TEST_PTHREADS
+    pthread_t threads[CONCURRENT_THREADS];
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        uvec_assert(pthread_create(&threads[i], NULL, stats_worker, NULL) == 0);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        uvec_assert(pthread_join(threads[i], NULL) == 0);
+    }
+
+    UVecStats threads_diff = stats_diff(diff, stats_diff(start, uvec_stats_snapshot(int)));
+    uvec_assert(threads_diff.reallocs == 4 * CONCURRENT_THREADS);
+    local_diff = stats_diff(local, uvec_stats_local(int));
+    uvec_assert(local_diff.reallocs == diff.reallocs);
+#endif
+
+    uvec_free(int, v);
+    return true;
+}
+
+#endif
+
+#ifdef UVEC_REGISTRY
+
+#ifdef UVEC_TEST_PTHREADS
+
+static void* registry_shrinker(void *data) {
+    P_UVEC_ATOMIC(bool) *stop = data;
+
+    while (!p_uvec_atomic_load(stop, P_UVEC_MO_RELAXED)) {
+        uvec_shrink_all_idle(0);
+        uvec_memory_usage(NULL);
+    }
+
+    return NULL;
+}
+
+#endif
+
+static bool test_registry(void) {
+    UVecMemoryUsage base = uvec_memory_usage("int");
+    UVec(int) *v = uvec_alloc(int);
+    UVec(int) *active = uvec_alloc(int);
+    UVec(int) idle = uvec_init(int);
+
+    UVecMemoryUsage usage = uvec_memory_usage("int");
+    uvec_assert(usage.vectors == base.vectors + 2);
+    uvec_assert(usage.allocated_bytes == base.allocated_bytes);
+
+    for (int i = 0; i < 5; ++i) uvec_assert(uvec_push(int, v, i) == UVEC_OK);
+    uvec_assert(uvec_reserve_capacity(int, &idle, 100) == UVEC_OK);
+    uvec_assert(uvec_reserve_capacity(int, active, 100) == UVEC_OK);
+
+    usage = uvec_memory_usage("int");
+    uvec_assert(usage.vectors == base.vectors + 3);
+    uvec_assert(usage.allocated_bytes == base.allocated_bytes + (8 + 128 + 128) * sizeof(int));
+    uvec_assert(usage.used_bytes == base.used_bytes + 5 * sizeof(int));
+    uvec_assert(uvec_memory_usage("missing").vectors == 0);
+
+    FILE *file = tmpfile();
+    char buf[4096] = { 0 };
+    uvec_assert(file);
+    uvec_assert(uvec_memory_report(file) == UVEC_OK);
+    rewind(file);
+    uvec_assert(fread(buf, 1, sizeof(buf) - 1, file) > 0);
+    fclose(file);
+    uvec_assert(strstr(buf, "Capacity histogram (int)"));
+    uvec_assert(strstr(buf, "Largest wasters"));
+
+    uvec_assert(uvec_shrink_all_idle(0) == 0);
+    uvec_assert(uvec_reserve_capacity(int, active, 200) == UVEC_OK);
+    uvec_assert(uvec_shrink_all_idle(64) == 128 * sizeof(int));
+    uvec_assert(idle.allocated == 0);
+    uvec_assert(active->allocated == 256);
+    uvec_assert(v->allocated == 8);
+
+    uvec_deinit(idle);
+    uvec_free(int, active);
+    uvec_free(int, v);
+
+#ifdef UVEC_TEST_PTHREADS
+    // Vectors owned by containers are neither inspected nor shrunk
+    unlink(LOG_TEST_FILE);
+    UVecLog(int) *lg = uvec_log_open(int, LOG_TEST_FILE, 1000);
+    UVecSharded(int) *sv = uvec_sharded_alloc(int, 2);
+    uvec_assert(lg && sv);
+
+    pthread_t threads[CONCURRENT_THREADS + 1];
+    ShardedProducer producers[CONCURRENT_THREADS];
+    uvec_assert(pthread_create(&threads[0], NULL, log_producer, lg) == 0);
+
+    for (unsigned i = 0; i < CONCURRENT_THREADS; ++i) {
+        producers[i] = (ShardedProducer){ .sv = sv, .base = (int)i * CONCURRENT_ITEMS };
+        uvec_assert(pthread_create(&threads[i + 1], NULL, sharded_producer, &producers[i]) == 0);
+    }
+
+    P_UVEC_ATOMIC(bool) stop;
+    p_uvec_atomic_init(&stop, false);
+    pthread_t shrinker;
+    uvec_assert(pthread_create(&shrinker, NULL, registry_shrinker, &stop) == 0);
+
+    for (unsigned i = 0; i < array_size(threads); ++i) {
+        void *failed;
+        uvec_assert(pthread_join(threads[i], &failed) == 0 && !failed);
+    }
+
+    p_uvec_atomic_store(&stop, true, P_UVEC_MO_RELAXED);
+    uvec_assert(pthread_join(shrinker, NULL) == 0);
+    usage = uvec_memory_usage("int");
+    uvec_assert(usage.vectors == base.vectors);
+
+    uvec_assert(uvec_log_sync(int, lg) == UVEC_OK && uvec_log_count(lg) == LOG_ITEMS);
+    uvec_assert(uvec_sharded_count(int, sv) == CONCURRENT_THREADS * CONCURRENT_ITEMS);
+    uvec_assert(uvec_log_close(int, lg) == UVEC_OK);
+    uvec_sharded_free(int, sv);
+    unlink(LOG_TEST_FILE);
+#endif
+
+    usage = uvec_memory_usage("int");
+    uvec_assert(memcmp(&usage, &base, sizeof(base)) == 0);
+    return true;
+}
+
+#endif
+
 int main(void) {
     printf("Starting tests...\n");
     
@@ -296,7 +2064,32 @@ int main(void) {
         test_contains,
         test_comparable,
         test_qsort_reverse,
-        test_higher_order
+        test_higher_order,
+        test_persistent,
+        test_concurrent,
+        test_incremental,
+#ifdef UVEC_TEST_PTHREADS
+        test_collector,
+        test_external,
+        test_async,
+        test_log,
+        test_parallel,
+        test_rcu,
+        test_sharded,
+#endif
+        test_queue,
+        test_io,
+        test_mapped,
+        test_shared,
+#ifdef UVEC_COW
+        test_cow,
+#endif
+#ifdef UVEC_STATS
+        test_stats,
+#endif
+#ifdef UVEC_REGISTRY
+        test_registry,
+#endif
     };
 
     for (uint32_t i = 0; i < array_size(tests); ++i) {